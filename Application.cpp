@@ -26,6 +26,7 @@
 // #include "tutorials/lighting-tutorial-02/lightingCastersTutorial-01/lightingCastersTutorial-01.h"
 // #include "tutorials/lighting-tutorial-02/MultipleLights/multipleLightingTutorial-01.h"
 #include "tutorials/modelLoading-tutorials-04/modelLoadingTutorial-01.h"
+// #include "tutorials/modelLoading-tutorials-04/modelLoadingBenchmarks.h"
 // #include "tutorials/example-skybox/Skybox.h"
 
 int main(int argc, char** argv){
@@ -84,6 +85,30 @@ int main(int argc, char** argv){
     // LightingCastersExample(window);
     // MultipleLightingExample(window);
     ModelLoadingExample(window);
+    // MeshCacheBenchmark(window);
+    // ParallelExtractionBenchmark(window);
+    // AsyncTextureBenchmark(window);
+    // GeometryArenaBenchmark(window);
+    // PackedVertexBenchmark(window);
+    // MeshOptimizationBenchmark(window);
+    // LodBenchmark(window);
+    // MeshletBenchmark(window);
+    // StreamingLoadBenchmark(window);
+    // ModelReloadBenchmark(window);
+    // VertexWeldBenchmark(window);
+    // TangentFrameBenchmark(window);
+    // GltfLoadBenchmark(window);
+    // ObjParseBenchmark(window);
+    // InstancingBenchmark(window);
+    // MeshMergeBenchmark(window);
+    // SceneHierarchyBenchmark(window);
+    // AssetBakeBenchmark(window);
+    // AssetPackBenchmark(window);
+    // TextureCompressionBenchmark(window);
+    // CubemapLoadBenchmark(window);
+    // TextureArrayBenchmark(window);
+    // VirtualTextureBenchmark(window);
+    // TextureResidencyBenchmark(window);
 
 
     // ExampleSkybox(window, width, height);
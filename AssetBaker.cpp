@@ -0,0 +1,46 @@
+#include <cstdio>
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <string>
+#include "tutorials/modelLoading-tutorials-04/AssetBaker.h"
+
+/**
+ * @note asset-baker [source directory] [output directory] [--force] [--quiet] [--pack] [--virtual <size>]
+ * @note Bakes basics/ into baked/ by default (see AssetBaker.h), only assets whose inputs changed since the last run are rebaked
+ * @note --pack also writes <source>.pack and <output>.pack, the single-file trees the runtime mounts (see AssetPack.h)
+ * @note --virtual also tiles textures at least <size> texels wide or tall into <texture>.vtex for VirtualTexture.h
+ * @note No window or GL context is needed, everything here runs on the CPU
+*/
+int main(int argc, char** argv){
+    AssetBakeSettings settings;
+    std::vector<std::string> directories;
+    for(int i = 1; i < argc; i++){
+        if(std::strcmp(argv[i], "--force") == 0){
+            settings.force = true;
+        }
+        else if(std::strcmp(argv[i], "--quiet") == 0){
+            settings.verbose = false;
+        }
+        else if(std::strcmp(argv[i], "--pack") == 0){
+            settings.writePacks = true;
+        }
+        else if(std::strcmp(argv[i], "--virtual") == 0 && i + 1 < argc){
+            settings.virtualTextureMinSize = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if(argv[i][0] == '-'){
+            printf("usage: %s [source directory] [output directory] [--force] [--quiet] [--pack] [--virtual <size>]\n", argv[0]);
+            return 1;
+        }
+        else{
+            directories.push_back(argv[i]);
+        }
+    }
+    if(directories.size() > 0) settings.sourceRoot = directories[0];
+    if(directories.size() > 1) settings.outputRoot = directories[1];
+
+    printf("Baking %s -> %s on %u threads\n", settings.sourceRoot.c_str(), settings.outputRoot.c_str(), SharedThreadPool().ThreadCount() + 1);
+    AssetBakeReport report = BakeAssets(settings);
+    PrintAssetBakeReport(report);
+    return report.failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,24 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+// the model's textures packed by Model::packTextureArrays: an array, the layer in it and where the texture sits in that layer
+uniform sampler2DArray texture_diffuse1;
+uniform float texture_diffuse1Layer;
+uniform vec4 texture_diffuse1Rect; // offset xy, scale zw
+
+// a texture the arrays left out (ex. block compressed) is sampled as it is
+uniform sampler2D texture_diffuse1Plain;
+uniform bool texture_diffuse1Packed;
+
+void main()
+{
+    if (!texture_diffuse1Packed)
+    {
+        FragColor = texture(texture_diffuse1Plain, TexCoords);
+        return;
+    }
+    vec2 uv = texture_diffuse1Rect.xy + TexCoords * texture_diffuse1Rect.zw;
+    FragColor = texture(texture_diffuse1, vec3(uv, texture_diffuse1Layer));
+}
\ No newline at end of file
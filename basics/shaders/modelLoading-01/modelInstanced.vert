@@ -0,0 +1,19 @@
+#version 330 core
+// Vertex shader for models loaded with ModelLoadOptions::instanceMeshes (see MeshInstancing.h)
+// Every mesh is drawn instanced, aInstance is the node transform of the occurrence being drawn
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+layout (location = 5) in mat4 aInstance;      // locations 5-8, one column each
+
+out vec2 TexCoords;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+void main()
+{
+    TexCoords = aTexCoords;
+    gl_Position = projection * view * model * aInstance * vec4(aPos, 1.0);
+}
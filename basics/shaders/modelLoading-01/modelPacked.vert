@@ -0,0 +1,37 @@
+#version 330 core
+// Vertex shader for meshes uploaded with ModelLoadOptions::packedVertices (see PackedVertex.h)
+// Every attribute arrives normalized, positions and uvs are rebuilt from the per-mesh bounds
+layout (location = 0) in vec3 aPos;           // unorm16 within [positionMin, positionMin + positionExtent]
+layout (location = 1) in vec2 aNormal;        // snorm16 octahedral
+layout (location = 2) in vec2 aTexCoords;     // unorm16 within [uvMin, uvMin + uvExtent]
+layout (location = 3) in vec2 aTangent;       // snorm16 octahedral
+layout (location = 4) in float aBitangentSign;
+
+out vec2 TexCoords;
+out vec3 Normal;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+uniform vec3 positionMin;
+uniform vec3 positionExtent;
+uniform vec2 uvMin;
+uniform vec2 uvExtent;
+
+vec3 OctahedralDecode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
+void main()
+{
+    vec3 position = positionMin + aPos * positionExtent;
+    TexCoords = uvMin + aTexCoords * uvExtent;
+    Normal = mat3(model) * OctahedralDecode(aNormal);
+    gl_Position = projection * view * model * vec4(position, 1.0);
+}
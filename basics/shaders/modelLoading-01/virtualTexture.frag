@@ -0,0 +1,36 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+// VirtualTexture (VirtualTexture.h): tiles stream into virtualCache, virtualPageTable has one texel per tile of every level (its mip chain)
+// holding the cache page and level of the finest resident tile covering it
+uniform sampler2D virtualCache;
+uniform sampler2D virtualPageTable;
+uniform vec4 virtualSize;       // image width, height, tile size, border (texels)
+uniform vec2 virtualCacheSize;  // texels
+uniform float virtualMaxLevel;
+
+vec4 SampleVirtual(vec2 uv)
+{
+    // same level as virtualTextureFeedback.frag asks for
+    vec2 texel = uv * virtualSize.xy;
+    vec2 dx = dFdx(texel), dy = dFdy(texel);
+    int level = int(clamp(0.5 * log2(max(dot(dx, dx), dot(dy, dy))), 0.0, virtualMaxLevel));
+
+    texel = clamp(texel, vec2(0.5), virtualSize.xy - 0.5);
+    ivec2 grid = textureSize(virtualPageTable, level);
+    ivec2 tile = clamp(ivec2(texel / (virtualSize.z * exp2(float(level)))), ivec2(0), grid - 1);
+    vec3 entry = floor(texelFetch(virtualPageTable, tile, level).rgb * 255.0 + 0.5);
+
+    // the entry may be a coarser level than asked for while the tile streams in
+    vec2 levelTexel = texel / exp2(entry.b);
+    vec2 inTile = levelTexel - floor(levelTexel / virtualSize.z) * virtualSize.z;
+    vec2 cacheTexel = entry.rg * (virtualSize.z + 2.0 * virtualSize.w) + virtualSize.w + inTile;
+    return textureLod(virtualCache, cacheTexel / virtualCacheSize, 0.0);
+}
+
+void main()
+{
+    FragColor = SampleVirtual(TexCoords);
+}
\ No newline at end of file
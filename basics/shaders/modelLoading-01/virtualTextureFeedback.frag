@@ -0,0 +1,21 @@
+#version 330 core
+layout (location = 0) out uvec4 Feedback;
+
+in vec2 TexCoords;
+
+// drawn into VirtualTextureFeedback's target: the tile and level this pixel samples, and which texture (0 is nothing)
+uniform vec4 virtualSize;       // image width, height, tile size, border (texels)
+uniform float virtualMaxLevel;
+uniform float virtualLodBias;   // VirtualTextureFeedback::LodBias, the target is smaller than the screen
+uniform int virtualTextureID;
+
+void main()
+{
+    vec2 texel = TexCoords * virtualSize.xy;
+    vec2 dx = dFdx(texel), dy = dFdy(texel);
+    int level = int(clamp(0.5 * log2(max(dot(dx, dx), dot(dy, dy))) + virtualLodBias, 0.0, virtualMaxLevel));
+
+    texel = clamp(texel, vec2(0.5), virtualSize.xy - 0.5);
+    ivec2 tile = ivec2(texel / (virtualSize.z * exp2(float(level))));
+    Feedback = uvec4(uvec2(tile), uint(level), uint(virtualTextureID));
+}
\ No newline at end of file
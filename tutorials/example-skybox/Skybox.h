@@ -4,6 +4,7 @@
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
+#undef STB_IMAGE_IMPLEMENTATION // the cubemap loader includes stb_image.h again, for its declarations only
 
 #include <string>
 #include <fstream>
@@ -15,6 +16,8 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "../modelLoading-tutorials-04/CubemapLoader.h"
+
 struct Shader{
     Shader(const std::string& vertex, const std::string& fragment){
         std::unordered_map<GLenum, std::string> sources = ParseShader(vertex, fragment);
@@ -345,7 +348,7 @@ void ExampleSkybox(GLFWwindow* window, uint32_t width, uint32_t height){
     //     parentPath + "earthIllumination.jpg"
     // };
 
-    std::string faces[] = {
+    std::array<std::string, 6> faces = {
         parentPath + "right.bmp",
         parentPath + "left.bmp",
         parentPath + "top.bmp",
@@ -354,32 +357,15 @@ void ExampleSkybox(GLFWwindow* window, uint32_t width, uint32_t height){
         parentPath + "back.bmp"
     };
 
-
-    uint32_t cubeTextureID;
-    glGenTextures(1, &cubeTextureID);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, cubeTextureID);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-    glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
-
-    for(uint32_t i = 0; i < 6; i++){
-        int w, h, channels;
-        unsigned char* data = stbi_load(faces[i].c_str(), &w, &h, &channels, 0);
-
-        if(data){
-            stbi_set_flip_vertically_on_load(false);
-            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, w, h, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-
-            stbi_image_free(data);
-        }
-        else{
-            printf("Tried to load texture filepath at ===> %s\n", faces[i].c_str());
-            printf("Could not load textures!\n");
-        }
+    //! @note The six faces are decoded in parallel, then uploaded through one staging buffer into storage allocated once (see CubemapLoader.h)
+    CubemapLoadStats cubemapStats;
+    GLTexture cubeTexture = LoadCubemap(faces, CubemapLoadOptions(), &cubemapStats);
+    if(!cubeTexture){
+        printf("Could not load textures!\n");
     }
+    PrintCubemapLoadStats("Skybox", cubemapStats);
+    uint32_t cubeTextureID = cubeTexture.Get();
+
     glm::vec4 lightColor = {1.0f, 1.0f, 1.0f, 1.0f};
     glm::vec3 lightPos = {0.5f, 0.5f, 0.5f};
 
@@ -0,0 +1,541 @@
+#pragma once
+#include <mutex>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <filesystem>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "modelLoadingTutorial-01.h"
+#include "BakedAssets.h"
+#include "AssetPack.h"
+#include "TextureCompression.h"
+#include "CubemapLoader.h"
+#include "VirtualTexture.h"
+
+/**
+ * @param AssetBaker
+ * @note Offline half of BakedAssets.h, used by the asset-baker executable (AssetBaker.cpp) and AssetBakeBenchmark
+ * @note Walks the source tree (basics/) and bakes every model, texture (cubemap faces included) and shader into the output tree, one asset per
+ * @note task on the thread pool (models also spread their meshes over the same pool)
+ *
+ * @note Incremental: the output tree holds a manifest with, per asset, the files it was built from and a hash of their contents plus the bake
+ * @note settings. An asset is only rebaked when that hash changes (or its output is gone), so touching a file without changing it costs nothing,
+ * @note and editing a .mtl rebakes the models that read it. Outputs of sources that no longer exist are deleted.
+ * @note .gltf/.glb files are left alone, the runtime already uploads them as they are (see GltfLoader.h)
+ * @note Textures get a block compressed .dds next to their raw .tex (TextureCompression.h), the report has the PSNR that costs
+ * @note A directory holding the six faces of a cubemap (CubemapLoader.h) is also baked as one asset, <directory>.cubemap, into a single
+ * @note <directory>.cubemap.dds with every face and its mip chain, so LoadCubemap has nothing to decode or mipmap
+ * @note With virtualTextureMinSize set, textures at least that large are also cut into the tiles of a <texture>.vtex (VirtualTexture.h)
+ * @note With writePacks both trees are also packed (basics/ -> basics.pack, baked/ -> baked.pack next to them, see AssetPack.h), rewritten on every run
+*/
+
+static constexpr uint32_t ASSET_BAKER_VERSION = 1;
+static constexpr const char* ASSET_BAKE_MANIFEST = "bake-manifest.txt";
+
+enum class BakeAssetKind : uint8_t{ None, Model, Texture, Shader, Cubemap };
+
+//! @note Processing applied to baked models. Model::loadModel only takes the baked meshes when its own options give the same ComputeBakedMeshKey,
+//! @note so this matches ModelLoadingExample's options
+static ModelLoadOptions BakedModelOptions(){
+    ModelLoadOptions options;
+    options.computeTangentFrames = true;
+    options.nativeObj = true;
+    options.weldVertices = true;
+    options.optimizeMeshes = true;
+    options.lodLevels = 3;
+    return options;
+}
+
+struct AssetBakeSettings{
+    std::string sourceRoot = "basics";
+    std::string outputRoot = "baked";
+    bool force = false;                             // rebake everything, ignoring the manifest
+    bool verbose = true;                            // one line per baked asset
+    bool writePacks = false;                        // pack the source and output trees into <root>.pack each
+    bool compressTextures = true;                   // also write <texture>.dds with BC blocks, the runtime prefers it over the .tex, and the cubemap containers
+    uint32_t virtualTextureMinSize = 0;             // textures at least this wide or tall also get <texture>.vtex tiles (VirtualTexture.h), 0 writes none
+    ModelLoadOptions modelOptions = BakedModelOptions();
+    ThreadPool* pool = nullptr;                     // nullptr uses SharedThreadPool()
+};
+
+struct AssetBakeReport{
+    uint32_t baked = 0;
+    uint32_t upToDate = 0;
+    uint32_t failed = 0;
+    uint32_t removed = 0;       // outputs of deleted sources
+    uint64_t sourceBytes = 0;   // of the assets baked this run
+    uint64_t bakedBytes = 0;
+    uint64_t packBytes = 0;     // both packs, when writePacks is set
+    uint32_t compressedTextures = 0;    // textures compressed this run
+    uint32_t virtualTextures = 0;       // .vtex written this run
+    uint64_t uncompressedBytes = 0;     // their mip chains raw, i.e. what the raw path keeps in VRAM
+    uint64_t compressedBytes = 0;       // and block compressed
+    double lowestPsnr = 99.0;
+    double psnrSum = 0.0;
+    double milliseconds = 0.0;
+};
+
+//! @note One manifest line: hash, then the source and its dependencies, tab separated, all relative to the source root
+struct AssetBakeRecord{
+    std::string source;
+    uint64_t hash = 0;
+    std::vector<std::string> dependencies;
+};
+
+static double ElapsedBakeMilliseconds(std::chrono::steady_clock::time_point start){
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static BakeAssetKind ClassifyBakeAsset(const std::filesystem::path& path){
+    std::string extension = path.extension().string();
+    for(char& c : extension) c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+    if(extension == CUBEMAP_EXTENSION) return BakeAssetKind::Cubemap;
+
+    static const char* models[] = {".obj", ".fbx", ".dae", ".3ds", ".blend", ".ply", ".stl", ".x"};
+    static const char* textures[] = {".png", ".jpg", ".jpeg", ".bmp", ".tga"};
+    static const char* shaders[] = {".vert", ".frag", ".geom", ".comp", ".tesc", ".tese", ".glsl"};
+    for(const char* candidate : models) if(extension == candidate) return BakeAssetKind::Model;
+    for(const char* candidate : textures) if(extension == candidate) return BakeAssetKind::Texture;
+    for(const char* candidate : shaders) if(extension == candidate) return BakeAssetKind::Shader;
+    return BakeAssetKind::None;
+}
+
+static const char* BakedExtension(BakeAssetKind kind){
+    switch(kind){
+        case BakeAssetKind::Model: return BAKED_MESH_EXTENSION;
+        case BakeAssetKind::Texture: return BAKED_TEXTURE_EXTENSION;
+        case BakeAssetKind::Cubemap: return COMPRESSED_TEXTURE_EXTENSION;
+        default: return "";
+    }
+}
+
+//! @note Everything besides the inputs' contents that changes an asset's output
+static uint64_t BakeSettingsHash(BakeAssetKind kind, const AssetBakeSettings& settings){
+    uint64_t hash = HashValue(ASSET_BAKER_VERSION, 14695981039346656037ull);
+    hash = HashValue(kind, hash);
+    if(kind == BakeAssetKind::Model){
+        hash = HashValue(ComputeBakedMeshKey(Model::importFlags(settings.modelOptions), Model::processFlags(settings.modelOptions)), hash);
+    }
+    else if(kind == BakeAssetKind::Texture){
+        hash = HashValue(BAKED_TEXTURE_VERSION, hash);
+        hash = HashValue(settings.compressTextures ? COMPRESSED_TEXTURE_VERSION : 0u, hash);
+        hash = HashValue(settings.virtualTextureMinSize ? VIRTUAL_TEXTURE_VERSION : 0u, hash);
+        hash = HashValue(settings.virtualTextureMinSize, hash);
+    }
+    else if(kind == BakeAssetKind::Cubemap){
+        hash = HashValue(COMPRESSED_TEXTURE_VERSION, hash);
+    }
+    return hash;
+}
+
+//! @note Content hash of every dependency (a missing one hashes differently from any content, so deleting it rebakes)
+static uint64_t HashBakeDependencies(uint64_t settingsHash, const std::filesystem::path& sourceRoot, const std::vector<std::string>& dependencies){
+    uint64_t hash = settingsHash;
+    for(const std::string& dependency : dependencies){
+        hash = HashBytes(dependency.data(), dependency.size(), hash);
+        MappedFile file((sourceRoot / dependency).string());
+        hash = file.IsOpen() ? HashBytes(file.data, file.size, hash) : HashValue(~0ull, hash);
+    }
+    return hash;
+}
+
+static std::unordered_map<std::string, AssetBakeRecord> ReadBakeManifest(const std::filesystem::path& path){
+    std::unordered_map<std::string, AssetBakeRecord> records;
+    std::ifstream file(path);
+    std::string line;
+    while(std::getline(file, line)){
+        std::stringstream fields(line);
+        std::string hash, field;
+        AssetBakeRecord record;
+        if(!std::getline(fields, hash, '\t') || !std::getline(fields, record.source, '\t')){
+            continue;
+        }
+        record.hash = std::strtoull(hash.c_str(), nullptr, 16);
+        while(std::getline(fields, field, '\t')){
+            record.dependencies.push_back(field);
+        }
+        records[record.source] = std::move(record);
+    }
+    return records;
+}
+
+static bool WriteBakeManifest(const std::filesystem::path& path, const std::vector<AssetBakeRecord>& records){
+    std::ofstream file(path, std::ios::trunc);
+    for(const AssetBakeRecord& record : records){
+        char hash[17];
+        snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(record.hash));
+        file << hash << '\t' << record.source;
+        for(const std::string& dependency : record.dependencies){
+            file << '\t' << dependency;
+        }
+        file << '\n';
+    }
+    return static_cast<bool>(file);
+}
+
+//! @note Drops comments, indentation and blank lines. Preprocessor lines stay on lines of their own.
+static std::string StripShaderSource(const std::string& source){
+    std::string out, line;
+    out.reserve(source.size());
+    bool blockComment = false;
+
+    auto flushLine = [&](){
+        size_t first = line.find_first_not_of(" \t\r");
+        size_t last = line.find_last_not_of(" \t\r");
+        if(first != std::string::npos){
+            out.append(line, first, last - first + 1);
+            out += '\n';
+        }
+        line.clear();
+    };
+
+    for(size_t i = 0; i < source.size(); i++){
+        char c = source[i];
+        char next = i + 1 < source.size() ? source[i + 1] : '\0';
+        if(blockComment){
+            if(c == '*' && next == '/'){
+                blockComment = false;
+                i++;
+            }
+            else if(c == '\n'){
+                flushLine();
+            }
+            continue;
+        }
+        if(c == '/' && next == '/'){
+            while(i + 1 < source.size() && source[i + 1] != '\n') i++;
+            continue;
+        }
+        if(c == '/' && next == '*'){
+            blockComment = true;
+            line += ' ';
+            i++;
+            continue;
+        }
+        if(c == '\n'){
+            flushLine();
+            continue;
+        }
+        line += c;
+    }
+    flushLine();
+    return out;
+}
+
+//! @note compressedDestination and virtualDestination empty skip the .dds and the .vtex, compression (optional) receives the .dds sizes and PSNR
+static bool BakeTextureAsset(const std::string& source, const std::string& destination, const std::string& compressedDestination,
+                             const std::string& virtualDestination, ThreadPool* pool, TextureCompressionReport* compression, std::string& error){
+    int w, h, channels;
+    unsigned char* pixels = stbi_load(source.c_str(), &w, &h, &channels, 0);
+    if(!pixels){
+        error = stbi_failure_reason() ? stbi_failure_reason() : "decode failed";
+        return false;
+    }
+    size_t written = WriteBakedTexture(destination, pixels, static_cast<uint32_t>(w), static_cast<uint32_t>(h), static_cast<uint32_t>(channels));
+    bool compressed = compressedDestination.empty() ||
+                      WriteCompressedTexture(compressedDestination, pixels, static_cast<uint32_t>(w), static_cast<uint32_t>(h), static_cast<uint32_t>(channels),
+                                             compression, pool);
+    bool tiled = virtualDestination.empty() ||
+                 WriteVirtualTexture(virtualDestination, pixels, static_cast<uint32_t>(w), static_cast<uint32_t>(h), static_cast<uint32_t>(channels), 128, 4,
+                                     pool) != 0;
+    stbi_image_free(pixels);
+    if(written == 0 || !compressed || !tiled){
+        error = "could not write " + (written == 0 ? destination : !compressed ? compressedDestination : virtualDestination);
+        return false;
+    }
+    return true;
+}
+
+//! @note faces in +X -X +Y -Y +Z -Z order, all square and of the same size and channel count
+static bool BakeCubemapAsset(const std::array<std::string, 6>& faces, const std::string& destination, ThreadPool* pool,
+                             TextureCompressionReport* compression, std::string& error){
+    unsigned char* pixels[6] = {};
+    int w[6], h[6], channels[6];
+    bool valid = true;
+    for(uint32_t i = 0; i < 6 && valid; i++){
+        pixels[i] = stbi_load(faces[i].c_str(), &w[i], &h[i], &channels[i], 0);
+        if(!pixels[i]){
+            error = faces[i] + ": " + (stbi_failure_reason() ? stbi_failure_reason() : "decode failed");
+            valid = false;
+        }
+        else if(w[i] != h[i] || w[i] != w[0] || channels[i] != channels[0]){
+            error = faces[i] + ": faces must be square and match the first face";
+            valid = false;
+        }
+    }
+    if(valid && !WriteCompressedImages(destination, pixels, 6, static_cast<uint32_t>(w[0]), static_cast<uint32_t>(h[0]),
+                                       static_cast<uint32_t>(channels[0]), compression, pool)){
+        error = "could not write " + destination;
+        valid = false;
+    }
+    for(unsigned char* face : pixels){
+        stbi_image_free(face);
+    }
+    return valid;
+}
+
+static bool BakeShaderAsset(const std::string& source, const std::string& destination, std::string& error){
+    std::ifstream input(source, std::ios::binary);
+    if(!input){
+        error = "could not open " + source;
+        return false;
+    }
+    std::stringstream text;
+    text << input.rdbuf();
+
+    std::ofstream output(destination, std::ios::binary | std::ios::trunc);
+    output << StripShaderSource(text.str());
+    if(!output){
+        error = "could not write " + destination;
+        return false;
+    }
+    return true;
+}
+
+static uint64_t FileSizeOrZero(const std::filesystem::path& path){
+    std::error_code error;
+    uint64_t size = std::filesystem::file_size(path, error);
+    return error ? 0 : size;
+}
+
+static AssetBakeReport BakeAssets(const AssetBakeSettings& settings){
+    auto start = std::chrono::steady_clock::now();
+    AssetBakeReport report;
+    ThreadPool& pool = settings.pool ? *settings.pool : SharedThreadPool();
+
+    std::error_code error;
+    std::filesystem::path sourceRoot = std::filesystem::absolute(settings.sourceRoot, error).lexically_normal();
+    std::filesystem::path outputRoot = std::filesystem::absolute(settings.outputRoot, error).lexically_normal();
+    std::filesystem::create_directories(outputRoot, error);
+
+    struct Asset{
+        std::string source; // relative to sourceRoot
+        BakeAssetKind kind;
+        AssetBakeRecord record;
+        bool baked = false;
+        bool failed = false;
+        double milliseconds = 0.0;
+        TextureCompressionReport compression;
+    };
+    std::vector<Asset> assets;
+    for(auto it = std::filesystem::recursive_directory_iterator(sourceRoot, error); !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error)){
+        if(it->is_directory() && settings.compressTextures && !FindCubemapFaceExtension(it->path()).empty()){
+            Asset asset;
+            asset.source = it->path().lexically_relative(sourceRoot).generic_string() + CUBEMAP_EXTENSION;
+            asset.kind = BakeAssetKind::Cubemap;
+            assets.push_back(std::move(asset));
+        }
+        if(!it->is_regular_file()) continue;
+        BakeAssetKind kind = ClassifyBakeAsset(it->path());
+        if(kind != BakeAssetKind::None){
+            Asset asset;
+            asset.source = it->path().lexically_relative(sourceRoot).generic_string();
+            asset.kind = kind;
+            assets.push_back(std::move(asset));
+        }
+    }
+    std::sort(assets.begin(), assets.end(), [](const Asset& a, const Asset& b){ return a.source < b.source; });
+
+    std::filesystem::path manifestPath = outputRoot / ASSET_BAKE_MANIFEST;
+    std::unordered_map<std::string, AssetBakeRecord> previous = settings.force ? std::unordered_map<std::string, AssetBakeRecord>() : ReadBakeManifest(manifestPath);
+    std::mutex printMutex;
+
+    pool.ParallelFor(static_cast<uint32_t>(assets.size()), [&](uint32_t i){
+        Asset& asset = assets[i];
+        std::filesystem::path source = sourceRoot / asset.source;
+        std::filesystem::path destination = outputRoot / asset.source;
+        destination += BakedExtension(asset.kind);
+        uint64_t settingsHash = BakeSettingsHash(asset.kind, settings);
+        std::filesystem::path compressedDestination;
+        if(asset.kind == BakeAssetKind::Texture && settings.compressTextures){
+            compressedDestination = outputRoot / asset.source;
+            compressedDestination += COMPRESSED_TEXTURE_EXTENSION;
+        }
+        //! @note Only the header is read to decide, the bake itself decodes the image once for every output
+        std::filesystem::path virtualDestination;
+        int width = 0, height = 0, channels = 0;
+        if(asset.kind == BakeAssetKind::Texture && settings.virtualTextureMinSize && stbi_info(source.string().c_str(), &width, &height, &channels) &&
+           std::max(width, height) >= static_cast<int>(settings.virtualTextureMinSize)){
+            virtualDestination = outputRoot / asset.source;
+            virtualDestination += VIRTUAL_TEXTURE_EXTENSION;
+        }
+
+        auto found = previous.find(asset.source);
+        std::error_code exists;
+        if(found != previous.end() && std::filesystem::is_regular_file(destination, exists) &&
+           (compressedDestination.empty() || std::filesystem::is_regular_file(compressedDestination, exists)) &&
+           (virtualDestination.empty() || std::filesystem::is_regular_file(virtualDestination, exists)) &&
+           HashBakeDependencies(settingsHash, sourceRoot, found->second.dependencies) == found->second.hash){
+            asset.record = found->second;
+            return;
+        }
+
+        auto bakeStart = std::chrono::steady_clock::now();
+        std::error_code directoryError;
+        std::filesystem::create_directories(destination.parent_path(), directoryError);
+
+        std::string bakeError;
+        std::vector<std::string> dependencies;
+        bool succeeded = false;
+        if(asset.kind == BakeAssetKind::Model){
+            std::vector<std::string> files;
+            succeeded = Model::bakeMeshCache(source.generic_string(), settings.modelOptions, destination.string(), pool, files, bakeError);
+            for(const std::string& file : files){
+                dependencies.push_back(std::filesystem::absolute(file, directoryError).lexically_normal().lexically_relative(sourceRoot).generic_string());
+            }
+        }
+        else if(asset.kind == BakeAssetKind::Cubemap){
+            std::filesystem::path directory = source;
+            directory.replace_extension();
+            std::array<std::string, 6> faces = CubemapFacePaths(directory.string(), FindCubemapFaceExtension(directory));
+            succeeded = BakeCubemapAsset(faces, destination.string(), &pool, &asset.compression, bakeError);
+            for(const std::string& face : faces){
+                dependencies.push_back(std::filesystem::path(face).lexically_relative(sourceRoot).generic_string());
+            }
+        }
+        else{
+            succeeded = asset.kind == BakeAssetKind::Texture ? BakeTextureAsset(source.string(), destination.string(), compressedDestination.string(),
+                                                                               virtualDestination.string(), &pool, &asset.compression, bakeError)
+                                                              : BakeShaderAsset(source.string(), destination.string(), bakeError);
+            dependencies.push_back(asset.source);
+        }
+
+        asset.milliseconds = ElapsedBakeMilliseconds(bakeStart);
+        asset.baked = succeeded;
+        asset.failed = !succeeded;
+        if(succeeded){
+            asset.record.source = asset.source;
+            asset.record.dependencies = std::move(dependencies);
+            asset.record.hash = HashBakeDependencies(settingsHash, sourceRoot, asset.record.dependencies);
+        }
+
+        std::lock_guard<std::mutex> lock(printMutex);
+        if(!succeeded){
+            printf("  failed  %s: %s\n", asset.source.c_str(), bakeError.c_str());
+        }
+        else if(settings.verbose && asset.compression.format != BlockFormat::None){
+            printf("  baked   %-60s %8.2f ms  %s, PSNR %.2f dB\n", asset.source.c_str(), asset.milliseconds, BlockFormatName(asset.compression.format),
+                   asset.compression.psnr);
+        }
+        else if(settings.verbose){
+            printf("  baked   %-60s %8.2f ms\n", asset.source.c_str(), asset.milliseconds);
+        }
+    });
+
+    std::vector<AssetBakeRecord> records;
+    for(const Asset& asset : assets){
+        if(asset.failed){
+            report.failed++;
+            continue;
+        }
+        records.push_back(asset.record);
+        if(!asset.baked){
+            report.upToDate++;
+            continue;
+        }
+        std::filesystem::path destination = outputRoot / asset.source;
+        destination += BakedExtension(asset.kind);
+        report.baked++;
+        if(asset.kind == BakeAssetKind::Cubemap){
+            for(const std::string& face : asset.record.dependencies) report.sourceBytes += FileSizeOrZero(sourceRoot / face);
+        }
+        else{
+            report.sourceBytes += FileSizeOrZero(sourceRoot / asset.source);
+        }
+        report.bakedBytes += FileSizeOrZero(destination);
+        if(asset.kind == BakeAssetKind::Texture){
+            std::filesystem::path virtualDestination = outputRoot / asset.source;
+            virtualDestination += VIRTUAL_TEXTURE_EXTENSION;
+            uint64_t virtualBytes = FileSizeOrZero(virtualDestination);
+            report.bakedBytes += virtualBytes;
+            report.virtualTextures += virtualBytes != 0;
+        }
+        if(asset.compression.format != BlockFormat::None){
+            //! @note A cubemap's .dds is its only output, already counted above
+            if(asset.kind == BakeAssetKind::Texture){
+                std::filesystem::path compressedDestination = outputRoot / asset.source;
+                compressedDestination += COMPRESSED_TEXTURE_EXTENSION;
+                report.bakedBytes += FileSizeOrZero(compressedDestination);
+            }
+            report.compressedTextures++;
+            report.uncompressedBytes += asset.compression.rawBytes;
+            report.compressedBytes += asset.compression.compressedBytes;
+            report.lowestPsnr = std::min(report.lowestPsnr, asset.compression.psnr);
+            report.psnrSum += asset.compression.psnr;
+        }
+    }
+
+    //! @note Sources that disappeared since the last bake take their outputs with them
+    std::unordered_set<std::string> current;
+    for(const Asset& asset : assets){
+        current.insert(asset.source);
+    }
+    for(const auto& [source, record] : previous){
+        if(current.count(source)) continue;
+        std::filesystem::path destination = outputRoot / source;
+        destination += BakedExtension(ClassifyBakeAsset(source));
+        if(std::filesystem::remove(destination, error)){
+            report.removed++;
+        }
+        std::filesystem::path compressedDestination = outputRoot / source;
+        compressedDestination += COMPRESSED_TEXTURE_EXTENSION;
+        std::filesystem::remove(compressedDestination, error);
+        std::filesystem::path virtualDestination = outputRoot / source;
+        virtualDestination += VIRTUAL_TEXTURE_EXTENSION;
+        std::filesystem::remove(virtualDestination, error);
+    }
+
+    if(!WriteBakeManifest(manifestPath, records)){
+        printf("Could not write bake manifest ====> %s\n", manifestPath.string().c_str());
+    }
+
+    //! @note Runtime mesh caches written next to the sources and the manifest are not assets, they stay out of the packs
+    if(settings.writePacks){
+        std::string extension = BAKED_MESH_EXTENSION;
+        auto notMeshCache = [&extension](const std::string& path){
+            return path.size() < extension.size() || path.compare(path.size() - extension.size(), extension.size(), extension) != 0;
+        };
+        auto notManifest = [](const std::string& path){ return path != ASSET_BAKE_MANIFEST; };
+
+        std::pair<std::filesystem::path, std::function<bool(const std::string&)>> trees[] = {{sourceRoot, notMeshCache}, {outputRoot, notManifest}};
+        for(const auto& [root, include] : trees){
+            std::string packPath = root.string() + ASSET_PACK_EXTENSION;
+            AssetPackReport packReport;
+            if(!WriteAssetPack(root.string(), packPath, &packReport, include)){
+                printf("Could not write asset pack ====> %s\n", packPath.c_str());
+                report.failed++;
+                continue;
+            }
+            report.packBytes += packReport.packBytes;
+            if(settings.verbose){
+                PrintAssetPackReport(packPath, packReport);
+            }
+        }
+    }
+    report.milliseconds = ElapsedBakeMilliseconds(start);
+    return report;
+}
+
+static void PrintAssetBakeReport(const AssetBakeReport& report){
+    printf("Asset bake: %u baked, %u up to date, %u failed, %u removed in %.2f ms (%.2f MB of sources -> %.2f MB baked)\n",
+           report.baked, report.upToDate, report.failed, report.removed, report.milliseconds,
+           report.sourceBytes / (1024.0 * 1024.0), report.bakedBytes / (1024.0 * 1024.0));
+    if(report.compressedTextures){
+        printf("Texture compression: %u textures, %.2f MB -> %.2f MB of VRAM (%.1fx smaller), PSNR %.2f dB average, %.2f dB lowest\n",
+               report.compressedTextures, report.uncompressedBytes / (1024.0 * 1024.0), report.compressedBytes / (1024.0 * 1024.0),
+               double(report.uncompressedBytes) / std::max<double>(double(report.compressedBytes), 1.0), report.psnrSum / report.compressedTextures,
+               report.lowestPsnr);
+    }
+    if(report.virtualTextures){
+        printf("Virtual textures: %u tiled\n", report.virtualTextures);
+    }
+    if(report.packBytes){
+        printf("Asset packs: %.2f MB\n", report.packBytes / (1024.0 * 1024.0));
+    }
+}
@@ -0,0 +1,343 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+#include <functional>
+#include <filesystem>
+#include <string_view>
+
+#include "MappedFile.h"
+
+/**
+ * @param AssetPack
+ * @note One file holding a whole asset tree (ex. basics/ -> basics.pack, baked/ -> baked.pack), built by the asset-baker with --pack
+ * @note Layout: header, table of contents sorted by path, path strings, then every file's bytes as one blob aligned to ASSET_PACK_ALIGNMENT
+ *
+ * @note At runtime Assets().Mount() maps the pack once and from then on every file under its root is a binary search in the table of contents
+ * @note plus a pointer into the mapping: no open, no read and no copy per asset. Shader::ParseShader, TextureCache, the skybox faces, the mesh
+ * @note cache, the OBJ/glTF loaders and assimp (through AssetIOSystem) all read through Assets().Open()
+ * @note Files the mounted packs do not have (nothing mounted during development, or an asset added since the pack was built) are mapped
+ * @note from disk as loose files, so the same code runs with and without packs
+*/
+
+static constexpr uint32_t ASSET_PACK_VERSION = 1;
+static constexpr char ASSET_PACK_MAGIC[4] = {'A', 'P', 'A', 'K'};
+static constexpr uint64_t ASSET_PACK_ALIGNMENT = 64; // blobs start on a cache line, so mesh cache and baked texture data inside stays aligned
+static constexpr const char* ASSET_PACK_EXTENSION = ".pack";
+
+struct AssetPackHeader{
+    char magic[4];
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t stringTableSize;
+    uint64_t entryTableOffset;
+    uint64_t stringTableOffset;
+    uint64_t fileSize;
+};
+
+struct AssetPackEntry{
+    uint32_t pathOffset;    // into the string table, '/' separated and relative to the packed root
+    uint32_t pathLength;
+    uint64_t dataOffset;    // from the start of the pack
+    uint64_t size;
+};
+
+struct AssetPackReport{
+    uint32_t files = 0;
+    uint64_t dataBytes = 0;
+    uint64_t packBytes = 0;     // data plus header, table of contents and alignment padding
+    double milliseconds = 0.0;
+};
+
+static uint64_t AlignPackOffset(uint64_t offset){
+    return (offset + ASSET_PACK_ALIGNMENT - 1) & ~(ASSET_PACK_ALIGNMENT - 1);
+}
+
+static uint64_t FileSizeForPack(const std::filesystem::path& path){
+    std::error_code error;
+    uint64_t size = std::filesystem::file_size(path, error);
+    return error ? 0 : size;
+}
+
+/**
+ * @note Packs every regular file under root (include, when given, gets each path relative to root and returns false to leave it out)
+ * @note The pack itself is skipped when it lives under root. Returns false when root cannot be walked or the pack cannot be written.
+*/
+static bool WriteAssetPack(const std::string& root, const std::string& packPath, AssetPackReport* report = nullptr,
+                           const std::function<bool(const std::string&)>& include = nullptr){
+    auto start = std::chrono::steady_clock::now();
+    std::error_code error;
+    std::filesystem::path rootPath = std::filesystem::absolute(root, error).lexically_normal();
+    std::filesystem::path packFile = std::filesystem::absolute(packPath, error).lexically_normal();
+    if(!std::filesystem::is_directory(rootPath, error)){
+        return false;
+    }
+
+    std::vector<std::string> paths;
+    for(auto it = std::filesystem::recursive_directory_iterator(rootPath, error); !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error)){
+        if(!it->is_regular_file() || it->path().lexically_normal() == packFile) continue;
+        std::string relative = it->path().lexically_relative(rootPath).generic_string();
+        if(!include || include(relative)){
+            paths.push_back(relative);
+        }
+    }
+    if(error){
+        return false;
+    }
+    std::sort(paths.begin(), paths.end());
+
+    AssetPackHeader header = {};
+    std::memcpy(header.magic, ASSET_PACK_MAGIC, sizeof(header.magic));
+    header.version = ASSET_PACK_VERSION;
+    header.entryCount = static_cast<uint32_t>(paths.size());
+    header.entryTableOffset = sizeof(AssetPackHeader);
+
+    std::vector<AssetPackEntry> entries(paths.size());
+    std::string strings;
+    for(size_t i = 0; i < paths.size(); i++){
+        entries[i].pathOffset = static_cast<uint32_t>(strings.size());
+        entries[i].pathLength = static_cast<uint32_t>(paths[i].size());
+        entries[i].size = FileSizeForPack(rootPath / paths[i]);
+        strings += paths[i];
+    }
+    header.stringTableOffset = header.entryTableOffset + entries.size() * sizeof(AssetPackEntry);
+    header.stringTableSize = static_cast<uint32_t>(strings.size());
+
+    uint64_t offset = header.stringTableOffset + strings.size();
+    for(AssetPackEntry& entry : entries){
+        offset = AlignPackOffset(offset);
+        entry.dataOffset = offset;
+        offset += entry.size;
+    }
+    header.fileSize = offset;
+
+    //! @note Written next to the destination first, so a running program never maps a half written pack
+    std::string temporaryPath = packFile.string() + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        if(!file){
+            return false;
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(AssetPackEntry)));
+        file.write(strings.data(), static_cast<std::streamsize>(strings.size()));
+
+        static const char padding[ASSET_PACK_ALIGNMENT] = {};
+        uint64_t written = header.stringTableOffset + strings.size();
+        for(size_t i = 0; i < entries.size(); i++){
+            file.write(padding, static_cast<std::streamsize>(entries[i].dataOffset - written));
+            MappedFile source((rootPath / paths[i]).string());
+            //! @note A file that changed size since it was listed would shift every blob after it
+            if(entries[i].size != 0 && (!source.IsOpen() || source.size != entries[i].size)){
+                printf("Could not pack ====> %s\n", paths[i].c_str());
+                return false;
+            }
+            file.write(reinterpret_cast<const char*>(source.data), static_cast<std::streamsize>(entries[i].size));
+            written = entries[i].dataOffset + entries[i].size;
+        }
+        if(!file){
+            return false;
+        }
+    }
+    std::filesystem::rename(temporaryPath, packFile, error);
+    if(error){
+        std::filesystem::remove(temporaryPath, error);
+        return false;
+    }
+
+    if(report){
+        report->files = header.entryCount;
+        report->dataBytes = 0;
+        for(const AssetPackEntry& entry : entries) report->dataBytes += entry.size;
+        report->packBytes = header.fileSize;
+        report->milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+    return true;
+}
+
+struct AssetFileStats{
+    uint64_t packHits = 0;      // opens answered from a mounted pack
+    uint64_t looseOpens = 0;    // opens that mapped a loose file from disk
+    uint64_t missing = 0;       // opens of files that exist nowhere
+};
+
+/**
+ * @note A file's bytes: a span into a mounted pack (zero copy, valid while the pack stays mounted) or a loose file mapped for as long as any
+ * @note copy of the AssetFile lives. Copies are cheap, they share the mapping.
+*/
+struct AssetFile{
+    AssetFile() = default;
+    explicit AssetFile(const std::string& path){
+        Open(path);
+    }
+
+    bool Open(const std::string& path);
+
+    void Close(){
+        *this = AssetFile();
+    }
+
+    bool IsOpen() const { return data != nullptr; }
+    std::string_view Text() const { return std::string_view(reinterpret_cast<const char*>(data), size); }
+
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    bool packed = false;
+    std::shared_ptr<const MappedFile> loose;
+};
+
+class AssetFileSystem{
+public:
+    /**
+     * @note Serves files under mountRoot (ex. "basics") from packPath (ex. "basics.pack") from now on, later mounts take precedence
+     * @note Returns false, and changes nothing, when the pack is missing or invalid: the loose files are used instead
+     * @note Mount before any load starts, lookups from worker threads do not lock
+    */
+    bool Mount(const std::string& packPath, const std::string& mountRoot){
+        std::unique_ptr<MappedFile> file = std::make_unique<MappedFile>(packPath);
+        if(!file->IsOpen() || file->size < sizeof(AssetPackHeader)){
+            return false;
+        }
+
+        const AssetPackHeader* header = reinterpret_cast<const AssetPackHeader*>(file->data);
+        if(std::memcmp(header->magic, ASSET_PACK_MAGIC, sizeof(header->magic)) != 0 || header->version != ASSET_PACK_VERSION ||
+           header->fileSize != file->size || header->entryTableOffset + uint64_t(header->entryCount) * sizeof(AssetPackEntry) > file->size ||
+           header->stringTableOffset + header->stringTableSize > file->size){
+            printf("Ignoring invalid asset pack ====> %s\n", packPath.c_str());
+            return false;
+        }
+
+        Mounted mount;
+        mount.entries = reinterpret_cast<const AssetPackEntry*>(file->data + header->entryTableOffset);
+        mount.strings = reinterpret_cast<const char*>(file->data + header->stringTableOffset);
+        mount.count = header->entryCount;
+        for(uint32_t i = 0; i < mount.count; i++){
+            const AssetPackEntry& entry = mount.entries[i];
+            if(entry.dataOffset + entry.size > file->size || uint64_t(entry.pathOffset) + entry.pathLength > header->stringTableSize){
+                printf("Ignoring invalid asset pack ====> %s\n", packPath.c_str());
+                return false;
+            }
+        }
+
+        if(mounts.empty()){
+            std::error_code error;
+            workingDirectory = std::filesystem::current_path(error);
+        }
+        mount.root = Normalize(mountRoot);
+        if(mount.root.empty() || mount.root.back() != '/') mount.root += '/';
+        mount.file = std::move(file);
+        mounts.insert(mounts.begin(), std::move(mount));
+        return true;
+    }
+
+    void UnmountAll(){
+        mounts.clear();
+    }
+
+    size_t MountCount() const { return mounts.size(); }
+
+    //! @note path as the loaders spell it (relative to the working directory or absolute), see AssetFile
+    AssetFile Open(const std::string& path) const{
+        AssetFile file;
+        if(!mounts.empty() && Lookup(path, file.data, file.size)){
+            file.packed = true;
+            packHits.fetch_add(1, std::memory_order_relaxed);
+            return file;
+        }
+
+        std::shared_ptr<MappedFile> mapped = std::make_shared<MappedFile>(path);
+        if(!mapped->IsOpen()){
+            missing.fetch_add(1, std::memory_order_relaxed);
+            return file;
+        }
+        file.data = mapped->data;
+        file.size = mapped->size;
+        file.loose = std::move(mapped);
+        looseOpens.fetch_add(1, std::memory_order_relaxed);
+        return file;
+    }
+
+    bool Exists(const std::string& path) const{
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+        if(!mounts.empty() && Lookup(path, data, size)){
+            return true;
+        }
+        std::error_code error;
+        return std::filesystem::is_regular_file(path, error);
+    }
+
+    AssetFileStats GetStats() const{
+        return {packHits.load(), looseOpens.load(), missing.load()};
+    }
+
+    void ResetStats(){
+        packHits = 0;
+        looseOpens = 0;
+        missing = 0;
+    }
+
+private:
+    struct Mounted{
+        std::unique_ptr<MappedFile> file;
+        std::string root;   // normalized absolute path with a trailing '/'
+        const AssetPackEntry* entries = nullptr;
+        const char* strings = nullptr;
+        uint32_t count = 0;
+    };
+
+    //! @note Absolute and normalized without touching the file system (the working directory is read once, at the first Mount)
+    std::string Normalize(const std::string& path) const{
+        std::filesystem::path absolute(path);
+        if(!absolute.is_absolute()) absolute = workingDirectory / absolute;
+        return absolute.lexically_normal().generic_string();
+    }
+
+    bool Lookup(const std::string& path, const uint8_t*& data, size_t& size) const{
+        std::string normalized = Normalize(path);
+        for(const Mounted& mount : mounts){
+            if(normalized.size() <= mount.root.size() || normalized.compare(0, mount.root.size(), mount.root) != 0) continue;
+            std::string_view relative(normalized.data() + mount.root.size(), normalized.size() - mount.root.size());
+
+            const AssetPackEntry* end = mount.entries + mount.count;
+            const AssetPackEntry* found = std::lower_bound(mount.entries, end, relative, [&mount](const AssetPackEntry& entry, std::string_view value){
+                return std::string_view(mount.strings + entry.pathOffset, entry.pathLength) < value;
+            });
+            if(found != end && std::string_view(mount.strings + found->pathOffset, found->pathLength) == relative){
+                data = mount.file->data + found->dataOffset;
+                size = static_cast<size_t>(found->size);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::vector<Mounted> mounts;
+    std::filesystem::path workingDirectory;
+    mutable std::atomic<uint64_t> packHits{0};
+    mutable std::atomic<uint64_t> looseOpens{0};
+    mutable std::atomic<uint64_t> missing{0};
+};
+
+//! @note Process-wide, nothing is mounted until Mount is called (every file is then a loose file)
+static AssetFileSystem& Assets(){
+    static AssetFileSystem fileSystem;
+    return fileSystem;
+}
+
+inline bool AssetFile::Open(const std::string& path){
+    *this = Assets().Open(path);
+    return IsOpen();
+}
+
+static void PrintAssetPackReport(const std::string& packPath, const AssetPackReport& report){
+    printf("Asset pack %s: %u files, %.2f MB of data -> %.2f MB pack in %.2f ms\n", packPath.c_str(), report.files,
+           report.dataBytes / (1024.0 * 1024.0), report.packBytes / (1024.0 * 1024.0), report.milliseconds);
+}
@@ -0,0 +1,235 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <memory>
+#include <functional>
+#include <condition_variable>
+#include <glad/glad.h>
+
+#include "stb_image.h"
+#include "ThreadPool.h"
+#include "GLResources.h"
+#include "AssetPack.h"
+
+/**
+ * @param AsyncTextureLoader
+ * @note Splits texture loading into three stages instead of blocking on stbi_load + glTexImage2D for every texture in turn
+ * @note 1. Load() creates the GL texture right away holding a 1x1 placeholder texel, so meshes using it are drawable immediately
+ * @note 2. A worker thread decodes the image file (the slow part, JPEG/PNG decoding)
+ * @note 3. Update(), called once per frame on the GL thread, copies decoded images into a pixel unpack buffer and uploads them, up to a byte budget per frame
+ * @note The texture id never changes, the placeholder storage is simply replaced once the real image arrives
+*/
+class AsyncTextureLoader{
+public:
+    AsyncTextureLoader(ThreadPool& pool) : pool(pool){
+        for(GLBuffer& pixelBuffer : pixelBuffers){
+            pixelBuffer = GLBuffer::Create();
+        }
+    }
+
+    ~AsyncTextureLoader(){
+        //! @note Decode jobs point back at this loader, so every one of them has to finish before we go away
+        std::unique_lock<std::mutex> lock(mutex);
+        decodeFinished.wait(lock, [this](){ return decodesInFlight == 0; });
+
+        for(DecodedImage& image : decoded){
+            stbi_image_free(image.pixels);
+        }
+    }
+
+    AsyncTextureLoader(const AsyncTextureLoader&) = delete;
+    AsyncTextureLoader& operator=(const AsyncTextureLoader&) = delete;
+
+    //! @note Returns a usable texture immediately, the image itself shows up after a later Update()
+    //! @note onUploaded (optional) is called from Update() with the GPU bytes the image occupies (mips included)
+    //! @note owner (optional) is whatever keeps the returned texture alive, once it expires the decoded image is dropped instead of uploaded
+    GLTexture Load(const std::string& filepath, bool srgb = false, std::function<void(size_t)> onUploaded = nullptr, std::weak_ptr<const void> owner = {}){
+        return Start(filepath, srgb, std::move(onUploaded), std::move(owner), [filepath](int* width, int* height, int* channels){
+            //! @note Read through Assets() on the worker, so a mounted pack serves the bytes (AssetPack.h)
+            AssetFile file(filepath);
+            return file.IsOpen() ? stbi_load_from_memory(file.data, static_cast<int>(file.size), width, height, channels, 0) : nullptr;
+        });
+    }
+
+    //! @note Same as Load() for an encoded image (PNG/JPEG...) already in memory, ex. embedded in a .glb
+    //! @note keepAlive owns bytes, the decode job holds on to it until it is done, name is only used for error messages
+    GLTexture LoadFromMemory(const std::string& name, const uint8_t* bytes, size_t size, std::shared_ptr<const void> keepAlive, bool srgb = false,
+                             std::function<void(size_t)> onUploaded = nullptr, std::weak_ptr<const void> owner = {}){
+        return Start(name, srgb, std::move(onUploaded), std::move(owner), [bytes, size, keepAlive](int* width, int* height, int* channels){
+            return stbi_load_from_memory(bytes, static_cast<int>(size), width, height, channels, 0);
+        });
+    }
+
+    /**
+     * @note Uploads decoded images until byteBudget is spent, returns how many textures were uploaded this call
+     * @note At least one image is uploaded per call, so a single texture larger than the budget can never get stuck
+    */
+    uint32_t Update(size_t byteBudget = 8 * 1024 * 1024){
+        uint32_t uploaded = 0;
+        size_t bytesUploaded = 0;
+
+        while(bytesUploaded < byteBudget){
+            DecodedImage image;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if(decoded.empty()) break;
+
+                image = decoded.front();
+                decoded.pop_front();
+            }
+
+            if(!image.pixels){
+                printf("Could not load imaged texture ====> %s\n", image.filepath.c_str());
+                continue;
+            }
+
+            //! @note The texture may have been released while its image was still decoding (its name may even have been reused since)
+            if(image.owned ? image.owner.expired() : !glIsTexture(image.textureID)){
+                stbi_image_free(image.pixels);
+                continue;
+            }
+
+            size_t size = Upload(image);
+            stbi_image_free(image.pixels);
+            bytesUploaded += size;
+            uploaded++;
+
+            if(image.onUploaded){
+                image.onUploaded(size + size / 3);
+            }
+        }
+
+        return uploaded;
+    }
+
+    //! @note True once every texture requested so far has been decoded and uploaded
+    bool Idle(){
+        std::lock_guard<std::mutex> lock(mutex);
+        return decodesInFlight == 0 && decoded.empty();
+    }
+
+    uint32_t Pending(){
+        std::lock_guard<std::mutex> lock(mutex);
+        return decodesInFlight + static_cast<uint32_t>(decoded.size());
+    }
+
+private:
+    GLTexture Start(const std::string& name, bool srgb, std::function<void(size_t)> onUploaded, std::weak_ptr<const void> owner,
+                    std::function<unsigned char*(int*, int*, int*)> decode){
+        GLTexture texture = GLTexture::Create();
+        uint32_t textureID = texture.Get();
+
+        const unsigned char placeholder[4] = {128, 128, 128, 255};
+        glBindTexture(GL_TEXTURE_2D, textureID);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, placeholder);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        //! @note A 1x1 image is already mipmap complete, so the final filter can be set now and callers may override it
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            decodesInFlight++;
+        }
+
+        bool owned = !owner.expired(); // without an owner Update() falls back to glIsTexture
+        pool.Submit([this, name, textureID, srgb, onUploaded, owner, owned, decode](){
+            DecodedImage image;
+            image.textureID = textureID;
+            image.owner = owner;
+            image.owned = owned;
+            image.filepath = name;
+            image.srgb = srgb;
+            image.onUploaded = onUploaded;
+            image.pixels = decode(&image.width, &image.height, &image.channels);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            decoded.push_back(image);
+            if(--decodesInFlight == 0){
+                decodeFinished.notify_all();
+            }
+        });
+
+        return texture;
+    }
+
+    struct DecodedImage{
+        uint32_t textureID = 0;
+        std::string filepath;
+        unsigned char* pixels = nullptr;
+        int width = 0, height = 0, channels = 0;
+        bool srgb = false;
+        std::function<void(size_t)> onUploaded;
+        std::weak_ptr<const void> owner;
+        bool owned = false;
+    };
+
+    size_t Upload(const DecodedImage& image){
+        GLenum format = GL_RGBA;
+        if(image.channels == 1){
+            format = GL_RED;
+        }
+        else if(image.channels == 2){
+            format = GL_RG;
+        }
+        else if(image.channels == 3){
+            format = GL_RGB;
+        }
+
+        GLenum internalFormat = format;
+        if(image.srgb && image.channels == 3){
+            internalFormat = GL_SRGB8;
+        }
+        else if(image.srgb && image.channels == 4){
+            internalFormat = GL_SRGB8_ALPHA8;
+        }
+
+        size_t size = static_cast<size_t>(image.width) * image.height * image.channels;
+
+        //! @note Cycling through a few unpack buffers and orphaning each one before mapping it,
+        //! @note so writing this frame's image never waits on the driver still reading the previous one
+        uint32_t pixelBuffer = pixelBuffers[nextPixelBuffer].Get();
+        nextPixelBuffer = (nextPixelBuffer + 1) % PIXEL_BUFFER_COUNT;
+
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+        void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+
+        const void* source = nullptr; // offset 0 into the bound unpack buffer
+        if(mapped){
+            std::memcpy(mapped, image.pixels, size);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        }
+        else{
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            source = image.pixels;
+        }
+
+        //! @note Rows of 1 and 3 channel images are not 4-byte aligned in general
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glBindTexture(GL_TEXTURE_2D, image.textureID);
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, source);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return size;
+    }
+
+    static constexpr uint32_t PIXEL_BUFFER_COUNT = 3;
+
+    ThreadPool& pool;
+    GLBuffer pixelBuffers[PIXEL_BUFFER_COUNT];
+    uint32_t nextPixelBuffer = 0;
+
+    std::mutex mutex;
+    std::condition_variable decodeFinished;
+    std::deque<DecodedImage> decoded;
+    uint32_t decodesInFlight = 0;
+};
@@ -0,0 +1,247 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+#include <initializer_list>
+#include <filesystem>
+#include <glad/glad.h>
+
+#include "AssetPack.h"
+#include "GLResources.h"
+
+/**
+ * @param BakedAssets
+ * @note Runtime side of the asset baker (AssetBaker.h, the asset-baker executable): the baked tree mirrors the source tree (ex. basics/ -> baked/)
+ * @note and every asset has a runtime-ready counterpart next to where its source would be
+ * @note    models   -> <path>.meshcache   processed meshes in the MeshCache.h format, keyed by the processing options only (ComputeBakedMeshKey)
+ * @note    textures -> <path>.tex         decoded pixels plus the full mip chain, uploaded level by level with no decode and no glGenerateMipmap
+ * @note                <path>.dds         the same chain block compressed (TextureCompression.h), preferred when the driver supports its format
+ * @note    shaders  -> <path>             comments and blank lines stripped
+ * @note    cubemaps -> <directory>.cubemap.dds   the six faces of a directory and their mip chains in one block compressed container (CubemapLoader.h)
+ * @note    large textures -> <path>.vtex  every level cut into bordered tiles for VirtualTexture.h, only with the baker's --virtual
+ *
+ * @note Once BakedAssets().SetRoots() is called, TextureCache, Shader and Model::loadModel look up the baked file first and only fall back to
+ * @note the source when there is none. With requireBaked set every fallback is reported, so a missing bake step shows up right away.
+ * @note Baked files are looked up through Assets() (AssetPack.h), so a mounted baked.pack answers them without touching the disk.
+*/
+
+static constexpr uint32_t BAKED_TEXTURE_VERSION = 1;
+static constexpr char BAKED_TEXTURE_MAGIC[4] = {'B', 'T', 'E', 'X'};
+static constexpr uint32_t BAKED_TEXTURE_MAX_LEVELS = 16;
+static constexpr const char* BAKED_TEXTURE_EXTENSION = ".tex";
+static constexpr const char* BAKED_MESH_EXTENSION = ".meshcache";
+
+struct BakedTextureLevel{
+    uint64_t offset;    // from the start of the file
+    uint32_t width;
+    uint32_t height;
+};
+
+struct BakedTextureHeader{
+    char magic[4];
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t channels;  // 1 to 4 bytes per pixel, tightly packed rows
+    uint32_t levelCount;
+    BakedTextureLevel levels[BAKED_TEXTURE_MAX_LEVELS];
+};
+
+//! @note Next level of a mip chain, 2x2 box filter (the odd last row/column of a non power of two level folds into its neighbour)
+static void DownsampleLevel(const uint8_t* source, uint32_t width, uint32_t height, uint32_t channels, std::vector<uint8_t>& out){
+    uint32_t outWidth = std::max(1u, width / 2), outHeight = std::max(1u, height / 2);
+    out.resize(size_t(outWidth) * outHeight * channels);
+    for(uint32_t y = 0; y < outHeight; y++){
+        uint32_t y0 = std::min(y * 2, height - 1), y1 = std::min(y * 2 + 1, height - 1);
+        for(uint32_t x = 0; x < outWidth; x++){
+            uint32_t x0 = std::min(x * 2, width - 1), x1 = std::min(x * 2 + 1, width - 1);
+            for(uint32_t c = 0; c < channels; c++){
+                uint32_t sum = source[(size_t(y0) * width + x0) * channels + c] + source[(size_t(y0) * width + x1) * channels + c] +
+                               source[(size_t(y1) * width + x0) * channels + c] + source[(size_t(y1) * width + x1) * channels + c];
+                out[(size_t(y) * outWidth + x) * channels + c] = static_cast<uint8_t>((sum + 2) / 4);
+            }
+        }
+    }
+}
+
+//! @note Writes pixels (width * height * channels bytes) and its whole mip chain down to 1x1, returns the file size or 0 on failure
+static size_t WriteBakedTexture(const std::string& path, const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t channels){
+    BakedTextureHeader header = {};
+    std::memcpy(header.magic, BAKED_TEXTURE_MAGIC, sizeof(header.magic));
+    header.version = BAKED_TEXTURE_VERSION;
+    header.width = width;
+    header.height = height;
+    header.channels = channels;
+
+    std::vector<std::vector<uint8_t>> levels;
+    levels.emplace_back(pixels, pixels + size_t(width) * height * channels);
+    uint32_t levelWidth = width, levelHeight = height;
+    while((levelWidth > 1 || levelHeight > 1) && levels.size() < BAKED_TEXTURE_MAX_LEVELS){
+        std::vector<uint8_t> next;
+        DownsampleLevel(levels.back().data(), levelWidth, levelHeight, channels, next);
+        levels.push_back(std::move(next));
+        levelWidth = std::max(1u, levelWidth / 2);
+        levelHeight = std::max(1u, levelHeight / 2);
+    }
+
+    uint64_t offset = sizeof(BakedTextureHeader);
+    levelWidth = width;
+    levelHeight = height;
+    header.levelCount = static_cast<uint32_t>(levels.size());
+    for(uint32_t i = 0; i < header.levelCount; i++){
+        header.levels[i] = {offset, levelWidth, levelHeight};
+        offset += levels[i].size();
+        levelWidth = std::max(1u, levelWidth / 2);
+        levelHeight = std::max(1u, levelHeight / 2);
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if(!file){
+        return 0;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for(const std::vector<uint8_t>& level : levels){
+        file.write(reinterpret_cast<const char*>(level.data()), static_cast<std::streamsize>(level.size()));
+    }
+    return file ? static_cast<size_t>(offset) : 0;
+}
+
+//! @note A mapped baked texture, header and levels point into the mapping
+struct BakedTextureFile{
+    bool Open(const std::string& path){
+        if(!file.Open(path) || file.size < sizeof(BakedTextureHeader)){
+            return false;
+        }
+        header = reinterpret_cast<const BakedTextureHeader*>(file.data);
+        if(std::memcmp(header->magic, BAKED_TEXTURE_MAGIC, sizeof(header->magic)) != 0 || header->version != BAKED_TEXTURE_VERSION ||
+           header->channels < 1 || header->channels > 4 || header->levelCount < 1 || header->levelCount > BAKED_TEXTURE_MAX_LEVELS){
+            return false;
+        }
+        for(uint32_t i = 0; i < header->levelCount; i++){
+            if(header->levels[i].offset + LevelSize(i) > file.size){
+                return false;
+            }
+        }
+        return true;
+    }
+
+    size_t LevelSize(uint32_t level) const{
+        return size_t(header->levels[level].width) * header->levels[level].height * header->channels;
+    }
+
+    const uint8_t* LevelData(uint32_t level) const{
+        return file.data + header->levels[level].offset;
+    }
+
+    AssetFile file;
+    const BakedTextureHeader* header = nullptr;
+};
+
+//! @note Uploads every level of a baked texture to target (GL_TEXTURE_2D, or a cubemap face with its cubemap bound), returns the bytes uploaded
+//! @note firstLevel > 0 leaves the larger levels out and makes firstLevel the base level (2D only, see TextureResidency.h)
+static size_t UploadBakedTexture(GLenum target, const BakedTextureFile& baked, bool gamma, uint32_t firstLevel = 0){
+    static const GLenum formats[] = {GL_RED, GL_RG, GL_RGB, GL_RGBA};
+    GLenum format = formats[baked.header->channels - 1];
+    GLenum internalFormat = format;
+    if(gamma && baked.header->channels == 3){
+        internalFormat = GL_SRGB8;
+    }
+    else if(gamma && baked.header->channels == 4){
+        internalFormat = GL_SRGB8_ALPHA8;
+    }
+
+    size_t bytes = 0;
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    firstLevel = target == GL_TEXTURE_2D ? std::min(firstLevel, baked.header->levelCount - 1) : 0;
+    for(uint32_t i = firstLevel; i < baked.header->levelCount; i++){
+        const BakedTextureLevel& level = baked.header->levels[i];
+        glTexImage2D(target, static_cast<GLint>(i), internalFormat, level.width, level.height, 0, format, GL_UNSIGNED_BYTE, baked.LevelData(i));
+        bytes += baked.LevelSize(i);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    //! @note A chain cut short by BAKED_TEXTURE_MAX_LEVELS must not leave the texture incomplete
+    if(target == GL_TEXTURE_2D){
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, static_cast<GLint>(firstLevel));
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(baked.header->levelCount - 1));
+    }
+    return bytes;
+}
+
+struct BakedAssetStats{
+    uint32_t found = 0;     // lookups answered by a baked file
+    uint32_t fallbacks = 0; // lookups under the source root without a baked file
+};
+
+class BakedAssetRegistry{
+public:
+    //! @note Files under sourceRoot are looked up under bakedRoot from now on, an empty bakedRoot turns the lookups off again
+    void SetRoots(const std::string& sourceRoot, const std::string& bakedRoot, bool requireBaked = false){
+        source = bakedRoot.empty() ? std::filesystem::path() : Absolute(sourceRoot);
+        baked = bakedRoot.empty() ? std::filesystem::path() : Absolute(bakedRoot);
+        require = requireBaked;
+        stats = BakedAssetStats();
+    }
+
+    bool Enabled() const { return !baked.empty(); }
+
+    //! @note The baked file for sourcePath (its path with extension appended), or an empty string when there is none
+    std::string Find(const std::string& sourcePath, const std::string& extension = "") const{
+        return FindFirst(sourcePath, {extension.c_str()});
+    }
+
+    //! @note Find for several kinds of baked file (ex. compressed before raw textures), the first extension that exists wins
+    std::string FindFirst(const std::string& sourcePath, std::initializer_list<const char*> extensions) const{
+        if(!Enabled()){
+            return "";
+        }
+        std::filesystem::path relative = Absolute(sourcePath).lexically_relative(source);
+        if(relative.empty() || *relative.begin() == ".."){
+            return "";
+        }
+
+        for(const char* extension : extensions){
+            std::filesystem::path candidate = baked / relative;
+            candidate += extension;
+            if(Assets().Exists(candidate.string())){
+                stats.found++;
+                return candidate.string();
+            }
+        }
+        stats.fallbacks++;
+        if(require){
+            printf("Asset is not baked, loading the source instead ====> %s\n", sourcePath.c_str());
+        }
+        return "";
+    }
+
+    //! @note Find, but returns sourcePath itself when there is no baked file
+    std::string Resolve(const std::string& sourcePath, const std::string& extension = "") const{
+        std::string path = Find(sourcePath, extension);
+        return path.empty() ? sourcePath : path;
+    }
+
+    const BakedAssetStats& GetStats() const { return stats; }
+
+private:
+    static std::filesystem::path Absolute(const std::string& path){
+        std::error_code error;
+        std::filesystem::path absolute = std::filesystem::absolute(path, error);
+        return (error ? std::filesystem::path(path) : absolute).lexically_normal();
+    }
+
+    std::filesystem::path source;
+    std::filesystem::path baked;
+    bool require = false;
+    mutable BakedAssetStats stats;
+};
+
+//! @note Process-wide, lookups are off until SetRoots is called
+static BakedAssetRegistry& BakedAssets(){
+    static BakedAssetRegistry registry;
+    return registry;
+}
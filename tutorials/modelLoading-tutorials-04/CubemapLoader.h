@@ -0,0 +1,297 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <glad/glad.h>
+
+#include "stb_image.h"
+#include "ThreadPool.h"
+#include "GLResources.h"
+#include "AssetPack.h"
+#include "BakedAssets.h"
+#include "TextureCompression.h"
+
+/**
+ * @param CubemapLoader
+ * @note Loads the six faces of a cubemap (ex. a skybox) into one GL_TEXTURE_CUBE_MAP
+ * @note    1. the faces are read through Assets() and decoded in parallel on a thread pool, instead of one stbi_load after another
+ * @note    2. the texture's storage is allocated once for every face and level (glTexStorage2D on GL 4.2+)
+ * @note    3. all six faces go through a single pixel unpack buffer, filled once, then uploaded face by face from their offsets in it
+ * @note    4. mipmaps (optional) are generated once for the whole cubemap
+ *
+ * @note When the asset baker ran, the faces of a directory (right, left, top, bottom, front, back) are baked into one block compressed
+ * @note container, <directory>.cubemap.dds (TextureCompression.h), with every face's mip chain prefiltered offline. Loading it is one mapping,
+ * @note one buffer upload and one glCompressedTexSubImage2D per face and level: nothing is decoded and nothing is mipmapped at load time.
+ * @note Faces are never flipped, the cubemap convention already has their rows top down.
+*/
+
+static constexpr const char* CUBEMAP_EXTENSION = ".cubemap";
+static constexpr const char* CUBEMAP_FACE_NAMES[6] = {"right", "left", "top", "bottom", "front", "back"};
+
+struct CubemapLoadOptions{
+    ThreadPool* pool = nullptr; // decodes the faces, nullptr uses SharedThreadPool()
+    bool mipmaps = true;        // full mip chain and trilinear filtering, otherwise level 0 only
+    bool gamma = false;         // stored as sRGB
+    bool useBaked = true;       // prefer the baked container when BakedAssets() has one
+};
+
+struct CubemapLoadStats{
+    double decodeMilliseconds = 0.0;    // reading and decoding the faces, or mapping the baked container
+    double uploadMilliseconds = 0.0;    // staging, storage, upload and mipmaps
+    uint32_t size = 0;                  // width and height of a face
+    uint32_t levels = 0;
+    size_t bytes = 0;                   // uploaded (generated mipmaps not included)
+    bool baked = false;
+};
+
+//! @note directory/right<extension>, directory/left<extension>... in the order GL_TEXTURE_CUBE_MAP_POSITIVE_X + i expects
+static std::array<std::string, 6> CubemapFacePaths(const std::string& directory, const std::string& extension){
+    std::array<std::string, 6> faces;
+    for(uint32_t i = 0; i < 6; i++){
+        faces[i] = (std::filesystem::path(directory) / (std::string(CUBEMAP_FACE_NAMES[i]) + extension)).generic_string();
+    }
+    return faces;
+}
+
+//! @note The extension all six faces share when directory holds a complete cubemap (ex. ".bmp"), an empty string otherwise
+static std::string FindCubemapFaceExtension(const std::filesystem::path& directory){
+    static const char* extensions[] = {".png", ".jpg", ".jpeg", ".bmp", ".tga"};
+    for(const char* extension : extensions){
+        bool complete = true;
+        for(const std::string& face : CubemapFacePaths(directory.string(), extension)){
+            std::error_code error;
+            complete = complete && std::filesystem::is_regular_file(face, error);
+        }
+        if(complete) return extension;
+    }
+    return "";
+}
+
+//! @note Immutable storage needs glTexStorage2D, core since 4.2. Checked once, needs a current context.
+static bool TextureStorageSupported(){
+#if defined(GL_VERSION_4_2)
+    static bool supported = [](){
+        GLint major = 0, minor = 0;
+        glGetIntegerv(GL_MAJOR_VERSION, &major);
+        glGetIntegerv(GL_MINOR_VERSION, &minor);
+        return major > 4 || (major == 4 && minor >= 2);
+    }();
+    return supported;
+#else
+    return false;
+#endif
+}
+
+static void AllocateCubemapStorage(GLsizei levels, GLenum internalFormat, GLsizei size){
+#if defined(GL_VERSION_4_2)
+    glTexStorage2D(GL_TEXTURE_CUBE_MAP, levels, internalFormat, size, size);
+#endif
+}
+
+static void SetCubemapParameters(uint32_t levels){
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(levels - 1));
+    glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+}
+
+//! @note Offset into the bound pixel unpack buffer, in the form glTexSubImage2D takes it
+static const void* UnpackOffset(const uint8_t* base, size_t offset){
+    return base ? static_cast<const void*>(base + offset) : reinterpret_cast<const void*>(static_cast<uintptr_t>(offset));
+}
+
+//! @note The baked container at path, an empty texture when it is invalid or the driver lacks its format (the caller then decodes the faces)
+static GLTexture LoadBakedCubemap(const std::string& path, const CubemapLoadOptions& options, CubemapLoadStats& stats){
+    auto start = std::chrono::steady_clock::now();
+    CompressedTextureFile container;
+    if(!container.Open(path) || !container.IsCubemap()){
+        printf("Could not read baked cubemap ====> %s\n", path.c_str());
+        return GLTexture();
+    }
+    GLenum internalFormat = CompressedInternalFormat(container.format, options.gamma);
+    if(!CompressedFormatSupported(internalFormat)){
+        return GLTexture();
+    }
+    stats.decodeMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    start = std::chrono::steady_clock::now();
+
+    //! @note Faces and their levels are contiguous in the file, so the whole payload is staged with one copy
+    uint32_t levels = options.mipmaps ? container.levelCount : 1;
+    size_t first = container.GetLevel(0, 0).offset;
+    const CompressedTextureFile::Level& last = container.GetLevel(5, container.levelCount - 1);
+    size_t payload = last.offset + last.size - first;
+
+    GLBuffer staging = GLBuffer::Create();
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, staging.Get());
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(payload), container.file.data + first, GL_STREAM_DRAW);
+
+    GLTexture texture = GLTexture::Create();
+    glBindTexture(GL_TEXTURE_CUBE_MAP, texture.Get());
+    bool storage = TextureStorageSupported();
+    if(storage){
+        AllocateCubemapStorage(static_cast<GLsizei>(levels), internalFormat, static_cast<GLsizei>(container.header.width));
+    }
+    for(uint32_t face = 0; face < 6; face++){
+        for(uint32_t i = 0; i < levels; i++){
+            const CompressedTextureFile::Level& level = container.GetLevel(face, i);
+            const void* source = UnpackOffset(nullptr, level.offset - first);
+            if(storage){
+                glCompressedTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, static_cast<GLint>(i), 0, 0, level.width, level.height, internalFormat,
+                                          static_cast<GLsizei>(level.size), source);
+            }
+            else{
+                glCompressedTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, static_cast<GLint>(i), internalFormat, level.width, level.height, 0,
+                                       static_cast<GLsizei>(level.size), source);
+            }
+            stats.bytes += level.size;
+        }
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    SetCubemapParameters(levels);
+
+    stats.uploadMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    stats.size = container.header.width;
+    stats.levels = levels;
+    stats.baked = true;
+    return texture;
+}
+
+/**
+ * @note faces in +X -X +Y -Y +Z -Z order (see CubemapFacePaths), every face square and of the same size and channel count
+ * @note The baked container is looked up for the directory of the first face, returns an empty texture when a face cannot be loaded
+ * @note stats (optional) receives the timings, must be called on the GL thread
+*/
+static GLTexture LoadCubemap(const std::array<std::string, 6>& faces, const CubemapLoadOptions& options = {}, CubemapLoadStats* stats = nullptr){
+    CubemapLoadStats local;
+    CubemapLoadStats& out = stats ? *stats : local;
+    out = CubemapLoadStats();
+
+    if(options.useBaked){
+        std::string directory = std::filesystem::path(faces[0]).parent_path().string();
+        std::string bakedPath = BakedAssets().Find(directory + CUBEMAP_EXTENSION, COMPRESSED_TEXTURE_EXTENSION);
+        if(!bakedPath.empty()){
+            GLTexture texture = LoadBakedCubemap(bakedPath, options, out);
+            if(texture) return texture;
+            out = CubemapLoadStats();
+        }
+    }
+
+    //! @note 1. every face decoded on the pool at once
+    auto start = std::chrono::steady_clock::now();
+    struct Face{
+        unsigned char* pixels = nullptr;
+        int width = 0, height = 0, channels = 0;
+    };
+    std::array<Face, 6> decoded;
+    ThreadPool& pool = options.pool ? *options.pool : SharedThreadPool();
+    pool.ParallelFor(6, [&](uint32_t i){
+        AssetFile file(faces[i]);
+        Face& face = decoded[i];
+        face.pixels = file.IsOpen() ? stbi_load_from_memory(file.data, static_cast<int>(file.size), &face.width, &face.height, &face.channels, 0) : nullptr;
+    });
+
+    bool valid = true;
+    for(uint32_t i = 0; i < 6; i++){
+        const Face& face = decoded[i];
+        if(!face.pixels){
+            printf("Tried to load cubemap face at ===> %s\n", faces[i].c_str());
+            valid = false;
+        }
+        else if(face.width != face.height || face.width != decoded[0].width || face.channels != decoded[0].channels){
+            printf("Cubemap face is not square or does not match the first face ===> %s\n", faces[i].c_str());
+            valid = false;
+        }
+    }
+    auto freeFaces = [&decoded](){
+        for(Face& face : decoded){
+            stbi_image_free(face.pixels);
+        }
+    };
+    if(!valid){
+        freeFaces();
+        return GLTexture();
+    }
+    out.decodeMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    start = std::chrono::steady_clock::now();
+
+    static const GLenum formats[] = {GL_RED, GL_RG, GL_RGB, GL_RGBA};
+    static const GLenum internalFormats[] = {GL_R8, GL_RG8, GL_RGB8, GL_RGBA8};
+    int channels = decoded[0].channels;
+    GLenum format = formats[channels - 1];
+    GLenum internalFormat = internalFormats[channels - 1];
+    if(options.gamma && channels == 3){
+        internalFormat = GL_SRGB8;
+    }
+    else if(options.gamma && channels == 4){
+        internalFormat = GL_SRGB8_ALPHA8;
+    }
+    uint32_t size = static_cast<uint32_t>(decoded[0].width);
+    uint32_t levels = options.mipmaps ? static_cast<uint32_t>(std::floor(std::log2(size))) + 1 : 1;
+    size_t faceBytes = size_t(size) * size * channels;
+
+    //! @note 2. one staging buffer for all six faces, filled in parallel when it can be mapped
+    GLBuffer staging = GLBuffer::Create();
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, staging.Get());
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(faceBytes * 6), nullptr, GL_STREAM_DRAW);
+    uint8_t* mapped = static_cast<uint8_t*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, static_cast<GLsizeiptr>(faceBytes * 6),
+                                                              GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+    std::vector<uint8_t> fallback;
+    const uint8_t* base = nullptr; // offsets into the bound unpack buffer
+    if(mapped){
+        pool.ParallelFor(6, [&](uint32_t i){ std::memcpy(mapped + faceBytes * i, decoded[i].pixels, faceBytes); });
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    }
+    else{
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        fallback.resize(faceBytes * 6);
+        for(uint32_t i = 0; i < 6; i++) std::memcpy(fallback.data() + faceBytes * i, decoded[i].pixels, faceBytes);
+        base = fallback.data();
+    }
+    freeFaces();
+
+    //! @note 3. storage allocated once, then every face uploaded from its offset
+    GLTexture texture = GLTexture::Create();
+    glBindTexture(GL_TEXTURE_CUBE_MAP, texture.Get());
+    bool storage = TextureStorageSupported();
+    if(storage){
+        AllocateCubemapStorage(static_cast<GLsizei>(levels), internalFormat, static_cast<GLsizei>(size));
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for(uint32_t i = 0; i < 6; i++){
+        if(storage){
+            glTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, 0, 0, size, size, format, GL_UNSIGNED_BYTE, UnpackOffset(base, faceBytes * i));
+        }
+        else{
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, internalFormat, size, size, 0, format, GL_UNSIGNED_BYTE, UnpackOffset(base, faceBytes * i));
+        }
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    //! @note 4. one glGenerateMipmap for all six faces
+    if(levels > 1){
+        glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+    }
+    SetCubemapParameters(levels);
+
+    out.uploadMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    out.size = size;
+    out.levels = levels;
+    out.bytes = faceBytes * 6;
+    return texture;
+}
+
+static void PrintCubemapLoadStats(const std::string& name, const CubemapLoadStats& stats){
+    printf("%s: %ux%u x 6 faces, %u levels, %s, %.2f ms %s + %.2f ms upload (%.2f MB)\n", name.c_str(), stats.size, stats.size, stats.levels,
+           stats.baked ? "baked" : "decoded", stats.decodeMilliseconds, stats.baked ? "mapping" : "decoding", stats.uploadMilliseconds,
+           stats.bytes / (1024.0 * 1024.0));
+}
@@ -0,0 +1,209 @@
+#pragma once
+#include <deque>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <glad/glad.h>
+
+/**
+ * @param GLResources
+ * @note Move-only owners for GL object names (buffers, vertex arrays, textures, programs, framebuffers), so Mesh, GeometryArena, textures and shaders can no longer leak them
+ * @note Destroying (or overwriting) a handle does not call glDelete* right away, the name is handed to the GLDeletionQueue instead
+ * @note The queue tags every frame's releases with a fence and only deletes them once that fence has signaled and a few frames have gone by,
+ * @note so unloading a model mid-frame never makes the driver wait on draws that still reference its buffers
+ * @note All of this runs on the GL thread, no locking needed
+*/
+
+enum class GLResourceType : uint8_t{
+    Buffer,
+    VertexArray,
+    Texture,
+    Program,
+    Framebuffer,
+};
+
+struct GLDeletionStats{
+    uint64_t queued = 0;
+    uint64_t deleted = 0;
+    uint32_t pending = 0;   // released but not deleted yet
+};
+
+class GLDeletionQueue{
+public:
+    static constexpr uint32_t FRAMES_IN_FLIGHT = 2; // a batch is never deleted before this many EndFrame() calls, even if its fence signaled earlier
+
+    GLDeletionQueue() = default;
+    GLDeletionQueue(const GLDeletionQueue&) = delete;
+    GLDeletionQueue& operator=(const GLDeletionQueue&) = delete;
+
+    //! @note The context is usually gone by the time static destructors run, whatever is still queued is left for the driver to clean up
+    ~GLDeletionQueue() = default;
+
+    void Enqueue(GLResourceType type, uint32_t id){
+        if(id == 0) return;
+        current.push_back({type, id});
+        stats.queued++;
+        stats.pending++;
+    }
+
+    //! @note Call once per frame after swapping buffers, closes this frame's batch with a fence and deletes every batch the GPU is done with
+    void EndFrame(){
+        frame++;
+
+        if(!current.empty()){
+            Batch batch;
+            batch.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            batch.frame = frame;
+            batch.resources.swap(current);
+            batches.push_back(std::move(batch));
+        }
+
+        while(!batches.empty()){
+            Batch& batch = batches.front();
+            if(frame - batch.frame < FRAMES_IN_FLIGHT) break;
+
+            GLenum status = glClientWaitSync(batch.fence, 0, 0);
+            if(status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) break;
+
+            glDeleteSync(batch.fence);
+            Delete(batch.resources);
+            batches.pop_front();
+        }
+    }
+
+    //! @note Deletes everything right now, waiting for the GPU if it has to. For shutdown (before the context goes away) and loading screens.
+    void Flush(){
+        for(Batch& batch : batches){
+            glClientWaitSync(batch.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+            glDeleteSync(batch.fence);
+            Delete(batch.resources);
+        }
+        batches.clear();
+
+        glFinish();
+        Delete(current);
+        current.clear();
+    }
+
+    const GLDeletionStats& GetStats() const { return stats; }
+
+private:
+    struct Resource{
+        GLResourceType type;
+        uint32_t id;
+    };
+
+    struct Batch{
+        GLsync fence = nullptr;
+        uint64_t frame = 0;
+        std::vector<Resource> resources;
+    };
+
+    //! @note One glDelete* call per type instead of one per name
+    void Delete(const std::vector<Resource>& resources){
+        std::vector<uint32_t> buffers, vertexArrays, textures, framebuffers;
+        for(const Resource& resource : resources){
+            switch(resource.type){
+                case GLResourceType::Buffer: buffers.push_back(resource.id); break;
+                case GLResourceType::VertexArray: vertexArrays.push_back(resource.id); break;
+                case GLResourceType::Texture: textures.push_back(resource.id); break;
+                case GLResourceType::Program: glDeleteProgram(resource.id); break;
+                case GLResourceType::Framebuffer: framebuffers.push_back(resource.id); break;
+            }
+        }
+
+        if(!buffers.empty()) glDeleteBuffers(static_cast<GLsizei>(buffers.size()), buffers.data());
+        if(!vertexArrays.empty()) glDeleteVertexArrays(static_cast<GLsizei>(vertexArrays.size()), vertexArrays.data());
+        if(!textures.empty()) glDeleteTextures(static_cast<GLsizei>(textures.size()), textures.data());
+        if(!framebuffers.empty()) glDeleteFramebuffers(static_cast<GLsizei>(framebuffers.size()), framebuffers.data());
+
+        stats.deleted += resources.size();
+        stats.pending -= static_cast<uint32_t>(resources.size());
+    }
+
+    std::vector<Resource> current;
+    std::deque<Batch> batches;
+    uint64_t frame = 0;
+    GLDeletionStats stats;
+};
+
+//! @note Process-wide queue, created on first use
+static GLDeletionQueue& GlobalDeletionQueue(){
+    static GLDeletionQueue queue;
+    return queue;
+}
+
+//! @note Owns one GL object name, Create() generates a new one. Moving transfers ownership, copying is not allowed.
+template<GLResourceType Type>
+class GLHandle{
+public:
+    GLHandle() = default;
+    explicit GLHandle(uint32_t id) : id(id){}
+
+    ~GLHandle(){
+        Reset();
+    }
+
+    GLHandle(const GLHandle&) = delete;
+    GLHandle& operator=(const GLHandle&) = delete;
+
+    GLHandle(GLHandle&& other) noexcept : id(other.id){
+        other.id = 0;
+    }
+
+    GLHandle& operator=(GLHandle&& other) noexcept{
+        if(this != &other){
+            Reset();
+            id = other.id;
+            other.id = 0;
+        }
+        return *this;
+    }
+
+    static GLHandle Create(){
+        uint32_t name = 0;
+        if constexpr(Type == GLResourceType::Buffer){
+            glGenBuffers(1, &name);
+        }
+        else if constexpr(Type == GLResourceType::VertexArray){
+            glGenVertexArrays(1, &name);
+        }
+        else if constexpr(Type == GLResourceType::Texture){
+            glGenTextures(1, &name);
+        }
+        else if constexpr(Type == GLResourceType::Framebuffer){
+            glGenFramebuffers(1, &name);
+        }
+        else{
+            name = glCreateProgram();
+        }
+        return GLHandle(name);
+    }
+
+    //! @note Queues the current name for deletion and takes over replacement (0 leaves the handle empty)
+    void Reset(uint32_t replacement = 0){
+        if(id != 0){
+            GlobalDeletionQueue().Enqueue(Type, id);
+        }
+        id = replacement;
+    }
+
+    //! @note Gives up ownership without deleting, the caller is responsible for the name from now on
+    uint32_t Release(){
+        uint32_t name = id;
+        id = 0;
+        return name;
+    }
+
+    uint32_t Get() const { return id; }
+    explicit operator bool() const { return id != 0; }
+
+private:
+    uint32_t id = 0;
+};
+
+using GLBuffer = GLHandle<GLResourceType::Buffer>;
+using GLVertexArray = GLHandle<GLResourceType::VertexArray>;
+using GLTexture = GLHandle<GLResourceType::Texture>;
+using GLProgram = GLHandle<GLResourceType::Program>;
+using GLFramebuffer = GLHandle<GLResourceType::Framebuffer>;
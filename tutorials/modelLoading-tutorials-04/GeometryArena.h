@@ -0,0 +1,136 @@
+#pragma once
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+#include <glad/glad.h>
+
+#include "MeshData.h"
+#include "GLResources.h"
+#include "RenderStats.h"
+
+/**
+ * @param GeometryArena
+ * @note One vertex buffer + one index buffer behind a single VAO, shared by every mesh added to it (one Model, or several)
+ * @note Each mesh only remembers where its data landed (GeometryRange) and draws with glDrawElementsBaseVertex,
+ * @note so the indices keep referring to the mesh's own vertices and drawing a whole model needs one VAO bind instead of one per mesh
+ * @note Buffers grow by doubling, existing contents are moved over on the GPU with glCopyBufferSubData
+*/
+
+struct GeometryRange{
+    int32_t baseVertex = 0;     // added to every index by glDrawElementsBaseVertex
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+};
+
+class GeometryArena{
+public:
+    GeometryArena(size_t reserveVertices = 0, size_t reserveIndices = 0){
+        vao = GLVertexArray::Create();
+        Reserve(reserveVertices, reserveIndices);
+    }
+
+    GeometryArena(const GeometryArena&) = delete;
+    GeometryArena& operator=(const GeometryArena&) = delete;
+
+    GeometryRange Add(const Vertex* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount){
+        if(vertexCount == 0 || indexCount == 0){
+            return GeometryRange();
+        }
+
+        Reserve(vertexUsed + vertexCount, indexUsed + indexCount);
+
+        GeometryRange range;
+        range.baseVertex = static_cast<int32_t>(vertexUsed);
+        range.firstIndex = static_cast<uint32_t>(indexUsed);
+        range.indexCount = static_cast<uint32_t>(indexCount);
+
+        glBindBuffer(GL_ARRAY_BUFFER, vbo.Get());
+        glBufferSubData(GL_ARRAY_BUFFER, vertexUsed * sizeof(Vertex), vertexCount * sizeof(Vertex), vertices);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        //! @note Going through GL_COPY_WRITE_BUFFER so the currently bound VAO's element buffer is left alone
+        glBindBuffer(GL_COPY_WRITE_BUFFER, ibo.Get());
+        glBufferSubData(GL_COPY_WRITE_BUFFER, indexUsed * sizeof(uint32_t), indexCount * sizeof(uint32_t), indices);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        vertexUsed += vertexCount;
+        indexUsed += indexCount;
+        return range;
+    }
+
+    void Bind(){
+        glBindVertexArray(vao.Get());
+        FrameRenderStats().vertexArrayBinds++;
+    }
+
+    void Draw(const GeometryRange& range){
+        glDrawElementsBaseVertex(GL_TRIANGLES, range.indexCount, GL_UNSIGNED_INT, (void*)(range.firstIndex * sizeof(uint32_t)), range.baseVertex);
+        FrameRenderStats().drawCalls++;
+        FrameRenderStats().triangles += range.indexCount / 3;
+    }
+
+    size_t VertexCount() const { return vertexUsed; }
+    size_t IndexCount() const { return indexUsed; }
+    size_t ByteSize() const { return vertexUsed * sizeof(Vertex) + indexUsed * sizeof(uint32_t); }
+
+private:
+    void Reserve(size_t vertices, size_t indices){
+        if(vertices > vertexCapacity){
+            size_t capacity = vertexCapacity ? vertexCapacity : 65536;
+            while(capacity < vertices) capacity *= 2;
+            vbo = Grow(vbo, vertexUsed * sizeof(Vertex), capacity * sizeof(Vertex));
+            vertexCapacity = capacity;
+            SetupVertexArray();
+        }
+
+        if(indices > indexCapacity){
+            size_t capacity = indexCapacity ? indexCapacity : 3 * 65536;
+            while(capacity < indices) capacity *= 2;
+            ibo = Grow(ibo, indexUsed * sizeof(uint32_t), capacity * sizeof(uint32_t));
+            indexCapacity = capacity;
+            SetupVertexArray();
+        }
+    }
+
+    //! @note Allocates a bigger buffer and copies the used part of the old one across on the GPU
+    //! @note The old buffer goes to the deletion queue when the returned handle replaces it, draws already issued from it stay valid
+    static GLBuffer Grow(const GLBuffer& buffer, size_t usedBytes, size_t newBytes){
+        GLBuffer grown = GLBuffer::Create();
+        glBindBuffer(GL_COPY_WRITE_BUFFER, grown.Get());
+        glBufferData(GL_COPY_WRITE_BUFFER, newBytes, nullptr, GL_STATIC_DRAW);
+
+        if(buffer && usedBytes){
+            glBindBuffer(GL_COPY_READ_BUFFER, buffer.Get());
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, usedBytes);
+            glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        }
+
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        return grown;
+    }
+
+    void SetupVertexArray(){
+        if(!vbo || !ibo) return;
+
+        glBindVertexArray(vao.Get());
+        glBindBuffer(GL_ARRAY_BUFFER, vbo.Get());
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo.Get());
+
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)0);
+
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)offsetof(Vertex, normal));
+
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
+
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    GLVertexArray vao;
+    GLBuffer vbo, ibo;
+    size_t vertexCapacity = 0, indexCapacity = 0;
+    size_t vertexUsed = 0, indexUsed = 0;
+};
@@ -0,0 +1,540 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "Json.h"
+#include "AssetPack.h"
+
+/**
+ * @param GltfLoader
+ * @note Native glTF 2.0 reader (.gltf + .bin/.png files, or a single .glb), used by Model instead of Assimp for those files
+ * @note glTF buffers are already laid out the way a GPU wants them (accessors are typed views into byte buffers, component types are GL enums),
+ * @note so nothing here converts vertices. The .glb (or external .bin) is memory mapped and the loader only records where each
+ * @note attribute and index list lives, Model then uploads those byte ranges straight out of the mapping (see Model::loadGltf)
+ * @note Only what Model draws is read: POSITION / NORMAL / TEXCOORD_0 / indices of triangle primitives, base color and normal textures,
+ * @note and the node tree. Node transforms (matrix or TRS, see ReadNodeTransform) go into Model::nodes (SceneHierarchy.h) and are applied by
+ * @note Model::DrawHierarchy, the plain Model::Draw still ignores them like the Assimp path in processNode.
+ * @note Touches no GL, so it can be parsed on a worker thread
+*/
+
+//! @note glTF componentType values, they are the GL enums of the same name
+static constexpr uint32_t GLTF_BYTE = 5120;
+static constexpr uint32_t GLTF_UNSIGNED_BYTE = 5121;
+static constexpr uint32_t GLTF_SHORT = 5122;
+static constexpr uint32_t GLTF_UNSIGNED_SHORT = 5123;
+static constexpr uint32_t GLTF_UNSIGNED_INT = 5125;
+static constexpr uint32_t GLTF_FLOAT = 5126;
+
+static constexpr uint32_t GLTF_MODE_TRIANGLES = 4;
+
+static constexpr uint32_t GLB_MAGIC = 0x46546C67;       // "glTF"
+static constexpr uint32_t GLB_CHUNK_JSON = 0x4E4F534A;  // "JSON"
+static constexpr uint32_t GLB_CHUNK_BIN = 0x004E4942;   // "BIN\0"
+
+struct GltfBufferView{
+    uint32_t buffer = 0;
+    size_t byteOffset = 0;
+    size_t byteLength = 0;
+    uint32_t byteStride = 0; // 0 = tightly packed
+};
+
+struct GltfAccessor{
+    int32_t bufferView = -1; // -1 = all zeros (sparse accessors are not supported)
+    size_t byteOffset = 0;
+    uint32_t componentType = GLTF_FLOAT;
+    uint32_t components = 1; // SCALAR 1, VEC2 2, VEC3 3, VEC4 4, MAT4 16
+    uint32_t count = 0;
+    bool normalized = false;
+    bool hasBounds = false;
+    glm::vec3 min = glm::vec3(0.0f);
+    glm::vec3 max = glm::vec3(0.0f);
+};
+
+struct GltfPrimitive{
+    int32_t position = -1;
+    int32_t normal = -1;
+    int32_t texcoord = -1;
+    int32_t indices = -1;
+    int32_t material = -1;
+    uint32_t mode = GLTF_MODE_TRIANGLES;
+};
+
+struct GltfMesh{
+    std::vector<GltfPrimitive> primitives;
+};
+
+struct GltfMaterial{
+    int32_t baseColorTexture = -1;
+    int32_t normalTexture = -1;
+};
+
+struct GltfImage{
+    std::string uri;          // file next to the .gltf, empty for embedded images
+    int32_t bufferView = -1;  // embedded image bytes (PNG/JPEG), decoded on worker threads by Model
+    std::string mimeType;
+};
+
+struct GltfNode{
+    int32_t mesh = -1;
+    std::vector<int32_t> children;
+    glm::vec3 translation = glm::vec3(0.0f);    // a "matrix" is decomposed into these
+    glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+    glm::vec3 scale = glm::vec3(1.0f);
+};
+
+//! @note A node as the default scene reaches it, parent indexes sceneNodes (SceneHierarchy::NO_PARENT for the scene's roots)
+struct GltfSceneNode{
+    uint32_t node = 0;
+    int32_t parent = -1;
+};
+
+class GltfAsset{
+public:
+    static bool IsGltfPath(const std::string& path){
+        auto endsWith = [&](const char* suffix){
+            size_t length = std::strlen(suffix);
+            if(path.size() < length) return false;
+            for(size_t i = 0; i < length; i++){
+                char c = path[path.size() - length + i];
+                if(c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+                if(c != suffix[i]) return false;
+            }
+            return true;
+        };
+        return endsWith(".gltf") || endsWith(".glb");
+    }
+
+    //! @note Maps the file (and any external buffers) and parses the JSON, returns false with error set when the asset is not usable
+    bool Load(const std::string& path, std::string& error){
+        directory = path.substr(0, path.find_last_of('/'));
+        if(directory == path) directory = ".";
+
+        if(!file.Open(path)){
+            error = "could not open " + path;
+            return false;
+        }
+
+        const char* json = reinterpret_cast<const char*>(file.data);
+        size_t jsonSize = file.size;
+        const uint8_t* binChunk = nullptr;
+        size_t binSize = 0;
+
+        uint32_t magic = 0;
+        if(file.size >= 4) std::memcpy(&magic, file.data, 4);
+        if(magic == GLB_MAGIC){
+            if(!ReadGlbChunks(json, jsonSize, binChunk, binSize, error)) return false;
+        }
+
+        JsonValue root;
+        if(!JsonParser::Parse(json, jsonSize, root, error)){
+            error = "invalid JSON: " + error;
+            return false;
+        }
+
+        const std::string& version = root["asset"]["version"].String();
+        if(version.empty() || version[0] != '2'){
+            error = "unsupported glTF version '" + version + "'";
+            return false;
+        }
+
+        return ReadBuffers(root, binChunk, binSize, error) && ReadViews(root, error) && ReadAccessors(root, error)
+            && ReadMeshes(root, error) && ReadMaterials(root) && ReadImages(root) && ReadScene(root);
+    }
+
+    //! @note Bytes of a buffer view, valid as long as this asset is alive
+    const uint8_t* ViewData(uint32_t view) const{
+        const GltfBufferView& bufferView = bufferViews[view];
+        return buffers[bufferView.buffer].data + bufferView.byteOffset;
+    }
+
+    //! @note Tight element size of an accessor, the stride when its buffer view does not give one
+    static uint32_t ElementSize(const GltfAccessor& accessor){
+        uint32_t componentSize = accessor.componentType == GLTF_FLOAT || accessor.componentType == GLTF_UNSIGNED_INT ? 4
+                               : accessor.componentType == GLTF_SHORT || accessor.componentType == GLTF_UNSIGNED_SHORT ? 2 : 1;
+        return componentSize * accessor.components;
+    }
+
+    uint32_t Stride(const GltfAccessor& accessor) const{
+        uint32_t stride = accessor.bufferView >= 0 ? bufferViews[accessor.bufferView].byteStride : 0;
+        return stride ? stride : ElementSize(accessor);
+    }
+
+    //! @note Image index used by a texture, -1 if it has none
+    int32_t TextureImage(int32_t texture) const{
+        return texture >= 0 && texture < static_cast<int32_t>(textureSources.size()) ? textureSources[texture] : -1;
+    }
+
+    std::string directory;
+    std::vector<GltfBufferView> bufferViews;
+    std::vector<GltfAccessor> accessors;
+    std::vector<GltfMesh> meshes;
+    std::vector<GltfMaterial> materials;
+    std::vector<GltfImage> images;
+    std::vector<int32_t> textureSources;
+    std::vector<GltfNode> nodes;
+    std::vector<uint32_t> meshOrder; // glTF meshes in the depth-first order of the default scene, a mesh used by several nodes appears once per node
+    std::vector<GltfSceneNode> sceneNodes; // the default scene's nodes in the same order, parents first
+    std::vector<uint32_t> meshOrderNodes;  // sceneNodes entry of every meshOrder entry, empty for files without a scene
+
+private:
+    struct BufferBytes{
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+    };
+
+    bool ReadGlbChunks(const char*& json, size_t& jsonSize, const uint8_t*& bin, size_t& binSize, std::string& error){
+        uint32_t header[3];
+        if(file.size < sizeof(header)){
+            error = "truncated GLB header";
+            return false;
+        }
+        std::memcpy(header, file.data, sizeof(header));
+        if(header[1] != 2 || header[2] > file.size){
+            error = "unsupported GLB version or bad length";
+            return false;
+        }
+
+        json = nullptr;
+        size_t offset = sizeof(header);
+        while(offset + 8 <= header[2]){
+            uint32_t chunk[2];
+            std::memcpy(chunk, file.data + offset, sizeof(chunk));
+            offset += 8;
+            if(offset + chunk[0] > header[2]){
+                error = "GLB chunk runs past the end of the file";
+                return false;
+            }
+
+            if(chunk[1] == GLB_CHUNK_JSON && !json){
+                json = reinterpret_cast<const char*>(file.data + offset);
+                jsonSize = chunk[0];
+            }
+            else if(chunk[1] == GLB_CHUNK_BIN && !bin){
+                bin = file.data + offset;
+                binSize = chunk[0];
+            }
+            offset += (chunk[0] + 3) & ~size_t(3);
+        }
+
+        if(!json){
+            error = "GLB has no JSON chunk";
+            return false;
+        }
+        return true;
+    }
+
+    static std::string DecodeUri(const std::string& uri){
+        std::string decoded;
+        for(size_t i = 0; i < uri.size(); i++){
+            if(uri[i] == '%' && i + 2 < uri.size()){
+                decoded += static_cast<char>(std::strtol(uri.substr(i + 1, 2).c_str(), nullptr, 16));
+                i += 2;
+            }
+            else{
+                decoded += uri[i];
+            }
+        }
+        return decoded;
+    }
+
+    static bool DecodeBase64(const char* text, size_t length, std::vector<uint8_t>& out){
+        auto value = [](char c) -> int{
+            if(c >= 'A' && c <= 'Z') return c - 'A';
+            if(c >= 'a' && c <= 'z') return c - 'a' + 26;
+            if(c >= '0' && c <= '9') return c - '0' + 52;
+            if(c == '+' || c == '-') return 62;
+            if(c == '/' || c == '_') return 63;
+            return -1;
+        };
+
+        out.reserve(length / 4 * 3);
+        uint32_t bits = 0;
+        int count = 0;
+        for(size_t i = 0; i < length && text[i] != '='; i++){
+            int v = value(text[i]);
+            if(v < 0) return false;
+            bits = (bits << 6) | static_cast<uint32_t>(v);
+            if(++count == 4){
+                out.push_back(static_cast<uint8_t>(bits >> 16));
+                out.push_back(static_cast<uint8_t>(bits >> 8));
+                out.push_back(static_cast<uint8_t>(bits));
+                bits = 0;
+                count = 0;
+            }
+        }
+        if(count == 3){
+            out.push_back(static_cast<uint8_t>(bits >> 10));
+            out.push_back(static_cast<uint8_t>(bits >> 2));
+        }
+        else if(count == 2){
+            out.push_back(static_cast<uint8_t>(bits >> 4));
+        }
+        return true;
+    }
+
+    bool ReadBuffers(const JsonValue& root, const uint8_t* binChunk, size_t binSize, std::string& error){
+        const JsonValue& list = root["buffers"];
+        buffers.resize(list.Size());
+
+        for(size_t i = 0; i < list.Size(); i++){
+            const JsonValue& buffer = list[i];
+            size_t byteLength = static_cast<size_t>(buffer["byteLength"].Int());
+            const std::string& uri = buffer["uri"].String();
+
+            if(uri.empty()){
+                //! @note A buffer without uri is the GLB's BIN chunk (only the first buffer may do that)
+                if(i != 0 || !binChunk){
+                    error = "buffer without uri outside of a GLB";
+                    return false;
+                }
+                buffers[i] = {binChunk, binSize};
+            }
+            else if(uri.compare(0, 5, "data:") == 0){
+                size_t comma = uri.find(',');
+                embeddedBuffers.emplace_back();
+                if(comma == std::string::npos || !DecodeBase64(uri.data() + comma + 1, uri.size() - comma - 1, embeddedBuffers.back())){
+                    error = "invalid data uri in buffer " + std::to_string(i);
+                    return false;
+                }
+                buffers[i] = {embeddedBuffers.back().data(), embeddedBuffers.back().size()};
+            }
+            else{
+                externalFiles.emplace_back();
+                std::string path = directory + "/" + DecodeUri(uri);
+                if(!externalFiles.back().Open(path)){
+                    error = "could not open buffer " + path;
+                    return false;
+                }
+                buffers[i] = {externalFiles.back().data, externalFiles.back().size};
+            }
+
+            if(buffers[i].size < byteLength){
+                error = "buffer " + std::to_string(i) + " is shorter than its byteLength";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool ReadViews(const JsonValue& root, std::string& error){
+        const JsonValue& list = root["bufferViews"];
+        bufferViews.resize(list.Size());
+
+        for(size_t i = 0; i < list.Size(); i++){
+            GltfBufferView& view = bufferViews[i];
+            view.buffer = static_cast<uint32_t>(list[i]["buffer"].Int(-1));
+            view.byteOffset = static_cast<size_t>(list[i]["byteOffset"].Int());
+            view.byteLength = static_cast<size_t>(list[i]["byteLength"].Int());
+            view.byteStride = static_cast<uint32_t>(list[i]["byteStride"].Int());
+
+            if(view.buffer >= buffers.size() || view.byteOffset + view.byteLength > buffers[view.buffer].size){
+                error = "buffer view " + std::to_string(i) + " is out of range";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool ReadAccessors(const JsonValue& root, std::string& error){
+        const JsonValue& list = root["accessors"];
+        accessors.resize(list.Size());
+
+        for(size_t i = 0; i < list.Size(); i++){
+            const JsonValue& json = list[i];
+            GltfAccessor& accessor = accessors[i];
+            accessor.bufferView = static_cast<int32_t>(json["bufferView"].Int(-1));
+            accessor.byteOffset = static_cast<size_t>(json["byteOffset"].Int());
+            accessor.componentType = static_cast<uint32_t>(json["componentType"].Int());
+            accessor.count = static_cast<uint32_t>(json["count"].Int());
+            accessor.normalized = json["normalized"].Bool();
+
+            const std::string& type = json["type"].String();
+            accessor.components = type == "VEC2" ? 2 : type == "VEC3" ? 3 : type == "VEC4" ? 4 : type == "MAT2" ? 4 : type == "MAT3" ? 9 : type == "MAT4" ? 16 : 1;
+
+            const JsonValue& min = json["min"];
+            const JsonValue& max = json["max"];
+            if(min.Size() >= 3 && max.Size() >= 3){
+                accessor.hasBounds = true;
+                accessor.min = glm::vec3(float(min[0].Number()), float(min[1].Number()), float(min[2].Number()));
+                accessor.max = glm::vec3(float(max[0].Number()), float(max[1].Number()), float(max[2].Number()));
+            }
+
+            //! @note The whole accessor has to fit inside its view, uploads read straight from the mapped bytes
+            if(accessor.bufferView >= 0){
+                if(accessor.bufferView >= static_cast<int32_t>(bufferViews.size())){
+                    error = "accessor " + std::to_string(i) + " references a missing buffer view";
+                    return false;
+                }
+                const GltfBufferView& view = bufferViews[accessor.bufferView];
+                size_t stride = view.byteStride ? view.byteStride : ElementSize(accessor);
+                size_t needed = accessor.count ? accessor.byteOffset + stride * (accessor.count - 1) + ElementSize(accessor) : 0;
+                if(needed > view.byteLength){
+                    error = "accessor " + std::to_string(i) + " runs past its buffer view";
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    bool ReadMeshes(const JsonValue& root, std::string& error){
+        const JsonValue& list = root["meshes"];
+        meshes.resize(list.Size());
+
+        auto accessorIndex = [&](const JsonValue& value) -> int32_t{
+            int64_t index = value.Int(-1);
+            return index >= 0 && index < static_cast<int64_t>(accessors.size()) ? static_cast<int32_t>(index) : -1;
+        };
+
+        for(size_t i = 0; i < list.Size(); i++){
+            const JsonValue& primitives = list[i]["primitives"];
+            for(size_t p = 0; p < primitives.Size(); p++){
+                const JsonValue& json = primitives[p];
+                GltfPrimitive primitive;
+                primitive.position = accessorIndex(json["attributes"]["POSITION"]);
+                primitive.normal = accessorIndex(json["attributes"]["NORMAL"]);
+                primitive.texcoord = accessorIndex(json["attributes"]["TEXCOORD_0"]);
+                primitive.indices = accessorIndex(json["indices"]);
+                primitive.material = static_cast<int32_t>(json["material"].Int(-1));
+                primitive.mode = static_cast<uint32_t>(json["mode"].Int(GLTF_MODE_TRIANGLES));
+
+                if(primitive.position < 0){
+                    error = "mesh " + std::to_string(i) + " has a primitive without POSITION";
+                    return false;
+                }
+                meshes[i].primitives.push_back(primitive);
+            }
+        }
+        return true;
+    }
+
+    bool ReadMaterials(const JsonValue& root){
+        const JsonValue& list = root["materials"];
+        materials.resize(list.Size());
+        for(size_t i = 0; i < list.Size(); i++){
+            materials[i].baseColorTexture = static_cast<int32_t>(list[i]["pbrMetallicRoughness"]["baseColorTexture"]["index"].Int(-1));
+            materials[i].normalTexture = static_cast<int32_t>(list[i]["normalTexture"]["index"].Int(-1));
+        }
+
+        const JsonValue& textures = root["textures"];
+        textureSources.resize(textures.Size());
+        for(size_t i = 0; i < textures.Size(); i++){
+            textureSources[i] = static_cast<int32_t>(textures[i]["source"].Int(-1));
+        }
+        return true;
+    }
+
+    bool ReadImages(const JsonValue& root){
+        const JsonValue& list = root["images"];
+        images.resize(list.Size());
+        for(size_t i = 0; i < list.Size(); i++){
+            images[i].bufferView = static_cast<int32_t>(list[i]["bufferView"].Int(-1));
+            images[i].mimeType = list[i]["mimeType"].String();
+
+            const std::string& uri = list[i]["uri"].String();
+            if(uri.compare(0, 5, "data:") == 0){
+                //! @note base64 images become one more embedded buffer with a synthetic view, so they decode like GLB images
+                size_t comma = uri.find(',');
+                std::vector<uint8_t> bytes;
+                if(comma != std::string::npos && DecodeBase64(uri.data() + comma + 1, uri.size() - comma - 1, bytes)){
+                    embeddedBuffers.push_back(std::move(bytes));
+                    buffers.push_back({embeddedBuffers.back().data(), embeddedBuffers.back().size()});
+                    bufferViews.push_back({static_cast<uint32_t>(buffers.size() - 1), 0, embeddedBuffers.back().size(), 0});
+                    images[i].bufferView = static_cast<int32_t>(bufferViews.size() - 1);
+                }
+            }
+            else if(!uri.empty()){
+                images[i].uri = DecodeUri(uri);
+            }
+        }
+        return true;
+    }
+
+    bool ReadScene(const JsonValue& root){
+        const JsonValue& list = root["nodes"];
+        nodes.resize(list.Size());
+        for(size_t i = 0; i < list.Size(); i++){
+            nodes[i].mesh = static_cast<int32_t>(list[i]["mesh"].Int(-1));
+            ReadNodeTransform(list[i], nodes[i]);
+            const JsonValue& children = list[i]["children"];
+            for(size_t c = 0; c < children.Size(); c++){
+                nodes[i].children.push_back(static_cast<int32_t>(children[c].Int()));
+            }
+        }
+
+        const JsonValue& scene = root["scenes"][static_cast<size_t>(root["scene"].Int(0))];
+        const JsonValue& roots = scene["nodes"];
+        std::vector<uint8_t> visited(nodes.size(), 0);
+        for(size_t i = 0; i < roots.Size(); i++){
+            CollectMeshes(static_cast<int32_t>(roots[i].Int(-1)), -1, visited);
+        }
+
+        //! @note Files without a scene still get their meshes drawn, in declaration order
+        if(meshOrder.empty()){
+            meshOrderNodes.clear();
+            for(uint32_t i = 0; i < meshes.size(); i++){
+                meshOrder.push_back(i);
+            }
+        }
+        return true;
+    }
+
+    //! @note translation / rotation (x, y, z, w) / scale, or a column-major matrix split into the same (no shear, as glTF requires)
+    static void ReadNodeTransform(const JsonValue& json, GltfNode& node){
+        const JsonValue& matrix = json["matrix"];
+        if(matrix.Size() >= 16){
+            glm::mat3 basis(1.0f);
+            for(int column = 0; column < 3; column++){
+                glm::vec3 axis(float(matrix[column * 4 + 0].Number()), float(matrix[column * 4 + 1].Number()), float(matrix[column * 4 + 2].Number()));
+                node.scale[column] = glm::length(axis);
+                basis[column] = node.scale[column] > 0.0f ? axis / node.scale[column] : axis;
+            }
+            if(glm::determinant(basis) < 0.0f){ // a mirroring matrix keeps a proper rotation with one negative scale
+                node.scale.x = -node.scale.x;
+                basis[0] = -basis[0];
+            }
+            node.translation = glm::vec3(float(matrix[12].Number()), float(matrix[13].Number()), float(matrix[14].Number()));
+            node.rotation = glm::normalize(glm::quat_cast(basis));
+            return;
+        }
+
+        const JsonValue& translation = json["translation"];
+        const JsonValue& rotation = json["rotation"];
+        const JsonValue& scale = json["scale"];
+        if(translation.Size() >= 3){
+            node.translation = glm::vec3(float(translation[0].Number()), float(translation[1].Number()), float(translation[2].Number()));
+        }
+        if(rotation.Size() >= 4){
+            node.rotation = glm::quat(float(rotation[3].Number()), float(rotation[0].Number()), float(rotation[1].Number()), float(rotation[2].Number()));
+        }
+        if(scale.Size() >= 3){
+            node.scale = glm::vec3(float(scale[0].Number()), float(scale[1].Number()), float(scale[2].Number()));
+        }
+    }
+
+    void CollectMeshes(int32_t node, int32_t parent, std::vector<uint8_t>& visited){
+        if(node < 0 || node >= static_cast<int32_t>(nodes.size()) || visited[node]) return; // guards against malformed cycles
+        visited[node] = 1;
+
+        int32_t index = static_cast<int32_t>(sceneNodes.size());
+        sceneNodes.push_back({static_cast<uint32_t>(node), parent});
+        if(nodes[node].mesh >= 0 && nodes[node].mesh < static_cast<int32_t>(meshes.size())){
+            meshOrder.push_back(static_cast<uint32_t>(nodes[node].mesh));
+            meshOrderNodes.push_back(static_cast<uint32_t>(index));
+        }
+        for(int32_t child : nodes[node].children){
+            CollectMeshes(child, index, visited);
+        }
+    }
+
+    AssetFile file;
+    std::vector<AssetFile> externalFiles;   // a span stays put when the vector grows, buffers can point into them
+    std::vector<std::vector<uint8_t>> embeddedBuffers;
+    std::vector<BufferBytes> buffers;
+};
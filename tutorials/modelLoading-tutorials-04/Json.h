@@ -0,0 +1,317 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <utility>
+
+/**
+ * @param Json
+ * @note Small DOM style JSON reader, enough for glTF's JSON chunk (see GltfLoader.h) without pulling in a library
+ * @note Objects keep their members in file order in a vector, glTF objects are small so a linear lookup is cheaper than a map
+ * @note Missing members and out of range indices return a shared null value, so lookups can be chained (ex. json["asset"]["version"].String())
+*/
+
+struct JsonValue{
+    enum class Type : uint8_t{ Null, Bool, Number, String, Array, Object };
+
+    Type type = Type::Null;
+    bool boolean = false;
+    double number = 0.0;
+    std::string string;
+    std::vector<JsonValue> array;
+    std::vector<std::pair<std::string, JsonValue>> object;
+
+    bool IsNull() const { return type == Type::Null; }
+    bool IsArray() const { return type == Type::Array; }
+    bool IsObject() const { return type == Type::Object; }
+
+    size_t Size() const { return type == Type::Array ? array.size() : type == Type::Object ? object.size() : 0; }
+
+    const JsonValue* Find(const char* key) const{
+        if(type != Type::Object) return nullptr;
+        for(const auto& [name, value] : object){
+            if(name == key) return &value;
+        }
+        return nullptr;
+    }
+
+    const JsonValue& operator[](const char* key) const{
+        const JsonValue* value = Find(key);
+        return value ? *value : Null();
+    }
+
+    const JsonValue& operator[](size_t index) const{
+        return type == Type::Array && index < array.size() ? array[index] : Null();
+    }
+
+    //! @note Without it a literal 0 is ambiguous between the key and index overloads
+    const JsonValue& operator[](int index) const{
+        return index < 0 ? Null() : (*this)[static_cast<size_t>(index)];
+    }
+
+    double Number(double fallback = 0.0) const { return type == Type::Number ? number : fallback; }
+    int64_t Int(int64_t fallback = 0) const { return type == Type::Number ? static_cast<int64_t>(number) : fallback; }
+    bool Bool(bool fallback = false) const { return type == Type::Bool ? boolean : fallback; }
+
+    const std::string& String() const{
+        static const std::string empty;
+        return type == Type::String ? string : empty;
+    }
+
+    static const JsonValue& Null(){
+        static const JsonValue null;
+        return null;
+    }
+};
+
+class JsonParser{
+public:
+    //! @note Parses text[0, size), which does not need to be null terminated. Returns false and fills error on malformed input.
+    static bool Parse(const char* text, size_t size, JsonValue& out, std::string& error){
+        JsonParser parser(text, size);
+        if(!parser.ParseValue(out, 0)){
+            error = parser.error;
+            return false;
+        }
+        parser.SkipWhitespace();
+        if(parser.cursor != parser.end){
+            error = parser.Error("trailing characters");
+            return false;
+        }
+        return true;
+    }
+
+private:
+    static constexpr uint32_t MAX_DEPTH = 256;
+
+    JsonParser(const char* text, size_t size) : begin(text), cursor(text), end(text + size){}
+
+    std::string Error(const char* message) const{
+        char buffer[128];
+        snprintf(buffer, sizeof(buffer), "%s at offset %zu", message, static_cast<size_t>(cursor - begin));
+        return buffer;
+    }
+
+    bool Fail(const char* message){
+        if(error.empty()) error = Error(message);
+        return false;
+    }
+
+    void SkipWhitespace(){
+        while(cursor < end && (*cursor == ' ' || *cursor == '\t' || *cursor == '\n' || *cursor == '\r')) cursor++;
+    }
+
+    bool Match(const char* literal){
+        const char* c = cursor;
+        for(; *literal; literal++, c++){
+            if(c >= end || *c != *literal) return false;
+        }
+        cursor = c;
+        return true;
+    }
+
+    bool ParseValue(JsonValue& value, uint32_t depth){
+        if(depth > MAX_DEPTH) return Fail("nesting too deep");
+
+        SkipWhitespace();
+        if(cursor >= end) return Fail("unexpected end of input");
+
+        switch(*cursor){
+            case '{': return ParseObject(value, depth);
+            case '[': return ParseArray(value, depth);
+            case '"':
+                value.type = JsonValue::Type::String;
+                return ParseString(value.string);
+            case 't':
+                value.type = JsonValue::Type::Bool;
+                value.boolean = true;
+                return Match("true") || Fail("invalid literal");
+            case 'f':
+                value.type = JsonValue::Type::Bool;
+                value.boolean = false;
+                return Match("false") || Fail("invalid literal");
+            case 'n':
+                value.type = JsonValue::Type::Null;
+                return Match("null") || Fail("invalid literal");
+            default:
+                return ParseNumber(value);
+        }
+    }
+
+    bool ParseObject(JsonValue& value, uint32_t depth){
+        value.type = JsonValue::Type::Object;
+        cursor++; // {
+
+        SkipWhitespace();
+        if(cursor < end && *cursor == '}'){
+            cursor++;
+            return true;
+        }
+
+        while(true){
+            SkipWhitespace();
+            if(cursor >= end || *cursor != '"') return Fail("expected member name");
+
+            value.object.emplace_back();
+            if(!ParseString(value.object.back().first)) return false;
+
+            SkipWhitespace();
+            if(cursor >= end || *cursor != ':') return Fail("expected ':'");
+            cursor++;
+
+            if(!ParseValue(value.object.back().second, depth + 1)) return false;
+
+            SkipWhitespace();
+            if(cursor < end && *cursor == ','){
+                cursor++;
+                continue;
+            }
+            if(cursor < end && *cursor == '}'){
+                cursor++;
+                return true;
+            }
+            return Fail("expected ',' or '}'");
+        }
+    }
+
+    bool ParseArray(JsonValue& value, uint32_t depth){
+        value.type = JsonValue::Type::Array;
+        cursor++; // [
+
+        SkipWhitespace();
+        if(cursor < end && *cursor == ']'){
+            cursor++;
+            return true;
+        }
+
+        while(true){
+            value.array.emplace_back();
+            if(!ParseValue(value.array.back(), depth + 1)) return false;
+
+            SkipWhitespace();
+            if(cursor < end && *cursor == ','){
+                cursor++;
+                continue;
+            }
+            if(cursor < end && *cursor == ']'){
+                cursor++;
+                return true;
+            }
+            return Fail("expected ',' or ']'");
+        }
+    }
+
+    bool ParseHex4(uint32_t& code){
+        if(end - cursor < 4) return Fail("truncated \\u escape");
+        code = 0;
+        for(int i = 0; i < 4; i++){
+            char c = *cursor++;
+            code <<= 4;
+            if(c >= '0' && c <= '9') code |= c - '0';
+            else if(c >= 'a' && c <= 'f') code |= c - 'a' + 10;
+            else if(c >= 'A' && c <= 'F') code |= c - 'A' + 10;
+            else return Fail("invalid \\u escape");
+        }
+        return true;
+    }
+
+    static void AppendUtf8(std::string& out, uint32_t code){
+        if(code < 0x80){
+            out += static_cast<char>(code);
+        }
+        else if(code < 0x800){
+            out += static_cast<char>(0xc0 | (code >> 6));
+            out += static_cast<char>(0x80 | (code & 0x3f));
+        }
+        else if(code < 0x10000){
+            out += static_cast<char>(0xe0 | (code >> 12));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+            out += static_cast<char>(0x80 | (code & 0x3f));
+        }
+        else{
+            out += static_cast<char>(0xf0 | (code >> 18));
+            out += static_cast<char>(0x80 | ((code >> 12) & 0x3f));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+            out += static_cast<char>(0x80 | (code & 0x3f));
+        }
+    }
+
+    bool ParseString(std::string& out){
+        cursor++; // opening quote
+
+        while(cursor < end){
+            //! @note Copying unescaped runs in one go, most glTF strings have no escapes at all
+            const char* run = cursor;
+            while(cursor < end && *cursor != '"' && *cursor != '\\') cursor++;
+            out.append(run, cursor);
+
+            if(cursor >= end) break;
+            if(*cursor == '"'){
+                cursor++;
+                return true;
+            }
+
+            cursor++; // backslash
+            if(cursor >= end) break;
+            char escape = *cursor++;
+            switch(escape){
+                case '"': out += '"'; break;
+                case '\\': out += '\\'; break;
+                case '/': out += '/'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u':{
+                    uint32_t code;
+                    if(!ParseHex4(code)) return false;
+                    //! @note Characters outside the BMP come as a surrogate pair
+                    if(code >= 0xd800 && code < 0xdc00 && end - cursor >= 6 && cursor[0] == '\\' && cursor[1] == 'u'){
+                        cursor += 2;
+                        uint32_t low;
+                        if(!ParseHex4(low)) return false;
+                        code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+                    }
+                    AppendUtf8(out, code);
+                    break;
+                }
+                default:
+                    return Fail("invalid escape");
+            }
+        }
+        return Fail("unterminated string");
+    }
+
+    bool ParseNumber(JsonValue& value){
+        //! @note strtod needs a terminated string, numbers are short so they are copied out first
+        char buffer[64];
+        size_t length = 0;
+        while(cursor + length < end && length + 1 < sizeof(buffer)){
+            char c = cursor[length];
+            if((c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E'){
+                buffer[length++] = c;
+            }
+            else{
+                break;
+            }
+        }
+        if(length == 0) return Fail("unexpected character");
+
+        buffer[length] = '\0';
+        char* parsedEnd = nullptr;
+        value.type = JsonValue::Type::Number;
+        value.number = std::strtod(buffer, &parsedEnd);
+        if(parsedEnd != buffer + length) return Fail("invalid number");
+
+        cursor += length;
+        return true;
+    }
+
+    const char* begin;
+    const char* cursor;
+    const char* end;
+    std::string error;
+};
@@ -0,0 +1,110 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @param MappedFile
+ * @note Read-only memory mapping of a whole file
+ * @note The OS pages the file in on demand, so reading a large binary asset costs no copy into a std::vector or std::stringstream
+ * @note The mapping stays valid until Close() is called or the MappedFile goes out of scope
+*/
+struct MappedFile{
+    MappedFile() = default;
+
+    MappedFile(const std::string& filepath){
+        Open(filepath);
+    }
+
+    ~MappedFile(){
+        Close();
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const std::string& filepath){
+        Close();
+#ifdef _WIN32
+        fileHandle = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if(fileHandle == INVALID_HANDLE_VALUE){
+            return false;
+        }
+
+        LARGE_INTEGER fileSize;
+        if(!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0){
+            Close();
+            return false;
+        }
+
+        mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if(!mappingHandle){
+            Close();
+            return false;
+        }
+
+        data = static_cast<const uint8_t*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+        size = static_cast<size_t>(fileSize.QuadPart);
+#else
+        int fd = open(filepath.c_str(), O_RDONLY);
+        if(fd < 0){
+            return false;
+        }
+
+        struct stat info;
+        if(fstat(fd, &info) != 0 || info.st_size == 0){
+            close(fd);
+            return false;
+        }
+
+        void* mapped = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        //! @note The mapping keeps its own reference to the file, so we can close the descriptor right away
+        close(fd);
+
+        if(mapped == MAP_FAILED){
+            return false;
+        }
+
+        data = static_cast<const uint8_t*>(mapped);
+        size = static_cast<size_t>(info.st_size);
+#endif
+        return data != nullptr;
+    }
+
+    void Close(){
+#ifdef _WIN32
+        if(data) UnmapViewOfFile(data);
+        if(mappingHandle) CloseHandle(mappingHandle);
+        if(fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+        mappingHandle = nullptr;
+        fileHandle = INVALID_HANDLE_VALUE;
+#else
+        if(data) munmap(const_cast<uint8_t*>(data), size);
+#endif
+        data = nullptr;
+        size = 0;
+    }
+
+    bool IsOpen() const { return data != nullptr; }
+
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+
+private:
+#ifdef _WIN32
+    HANDLE fileHandle = INVALID_HANDLE_VALUE;
+    HANDLE mappingHandle = nullptr;
+#endif
+};
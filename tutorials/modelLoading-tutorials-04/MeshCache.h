@@ -0,0 +1,473 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+
+#include "MeshData.h"
+#include "AssetPack.h"
+#include "SceneHierarchy.h"
+
+/**
+ * @param MeshCache
+ * @note Binary cache of the processed output of Model::loadModel
+ * @note After the first Assimp import we write every mesh's Vertex/index arrays, its material texture paths and a mesh table into one file
+ * @note Warm starts map that file and hand the vertex/index arrays straight to Mesh::SetupMesh, so Assimp never runs
+ *
+ * @note File layout (every offset is in bytes from the start of the file)
+ * @note MeshCacheHeader | MeshCacheMesh[meshCount] | MeshCacheTexture[textureCount] | MeshLod[lodCount] | MeshCacheNode[nodeCount] |
+ * @note MeshCacheDependency[dependencyCount] | string table | Vertex data (16-byte aligned) | uint32_t index data
+ * @note The node table is the file's node tree (parents first) with every mesh's node, so warm loads get the same Model::nodes as an import
+ *
+ * @note The cache is keyed by a hash of the source file's bytes, the Assimp import flags, our own processing flags and the cache version
+ * @note Any change to one of those produces a different key (and a different cache file), so a stale cache is never read
+ * @note Files the import read besides the source (ex. the OBJ's .mtl, a glTF's .bin) are stored with their hashes in the dependency table
+ * @note and rehashed by MeshCacheReader::Open, so editing one of them invalidates the cache just like editing the model
+*/
+
+static constexpr uint32_t MESH_CACHE_VERSION = 4;
+static constexpr char MESH_CACHE_MAGIC[4] = {'M', 'D', 'L', 'C'};
+
+struct MeshCacheHeader{
+    char magic[4];
+    uint32_t version;
+    uint64_t key;
+    uint32_t vertexStride;  // sizeof(Vertex) at the time of writing, the layout is stored raw
+    uint32_t meshCount;
+    uint32_t textureCount;
+    uint32_t stringTableSize;
+    uint32_t lodCount;
+    uint32_t nodeCount;     // 0 when the meshes carry no node tree
+    uint32_t dependencyCount;
+    uint32_t reserved;      // keeps the header free of uninitialized padding
+    uint64_t meshTableOffset;
+    uint64_t textureTableOffset;
+    uint64_t lodTableOffset;
+    uint64_t nodeTableOffset;
+    uint64_t dependencyTableOffset;
+    uint64_t stringTableOffset;
+    uint64_t vertexDataOffset;
+    uint64_t indexDataOffset;
+    uint64_t fileSize;
+};
+
+struct MeshCacheMesh{
+    uint64_t firstVertex;   // in vertices, relative to vertexDataOffset
+    uint64_t firstIndex;    // in indices, relative to indexDataOffset
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t firstTexture;
+    uint32_t textureCount;
+    uint32_t firstLod;
+    uint32_t lodCount;      // index ranges within this mesh's indices, relative to firstIndex
+    uint32_t node;          // into the node table, unused when nodeCount is 0
+    uint32_t reserved;      // keeps the entry free of uninitialized padding
+};
+
+//! @note A SceneHierarchy node, local translation / rotation (w, x, y, z) / scale
+struct MeshCacheNode{
+    int32_t parent;         // SceneHierarchy::NO_PARENT or an earlier node
+    float translation[3];
+    float rotation[4];
+    float scale[3];
+};
+
+//! @note A file the cached meshes were built from, path in the string table
+struct MeshCacheDependency{
+    uint32_t pathOffset;
+    uint32_t pathLength;
+    uint64_t hash;          // HashFile at the time of writing, 0 if the file was missing then
+};
+
+struct MeshCacheTexture{
+    uint32_t typeOffset;    // offsets into the string table
+    uint32_t typeLength;
+    uint32_t pathOffset;
+    uint32_t pathLength;
+};
+
+//! @note Bits of the processFlags passed to ComputeMeshCacheKey, one per optional processing step that changes the stored meshes
+static constexpr uint32_t MESH_PROCESS_OPTIMIZE = 1u << 0; // MeshOptimizer.h vertex cache / overdraw / vertex fetch pass
+static constexpr uint32_t MESH_PROCESS_WELD = 1u << 1;     // MeshWelder.h duplicate vertex merge
+static constexpr uint32_t MESH_PROCESS_NATIVE_OBJ = 1u << 2; // meshes came from ObjLoader.h instead of assimp's OBJ importer
+static constexpr uint32_t MESH_PROCESS_LOD_SHIFT = 8;       // bits 8-15, number of generated LOD levels (MeshSimplifier.h)
+static constexpr uint32_t MESH_PROCESS_WELD_SHIFT = 16;     // bits 16-31, hash of the weld tolerances
+
+//! @note 64-bit FNV-1a, consuming eight bytes per step so hashing a large model file stays cheap compared to importing it
+static uint64_t HashBytes(const void* bytes, size_t size, uint64_t seed = 14695981039346656037ull){
+    const uint64_t prime = 1099511628211ull;
+    const uint8_t* data = static_cast<const uint8_t*>(bytes);
+    uint64_t hash = seed;
+
+    size_t i = 0;
+    for(; i + 8 <= size; i += 8){
+        uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        hash = (hash ^ word) * prime;
+    }
+
+    for(; i < size; i++){
+        hash = (hash ^ data[i]) * prime;
+    }
+
+    return hash;
+}
+
+template<typename T>
+static uint64_t HashValue(const T& value, uint64_t seed){
+    return HashBytes(&value, sizeof(T), seed);
+}
+
+//! @note Hash of a file's bytes, 0 when it cannot be read
+static uint64_t HashFile(const std::string& path){
+    AssetFile file(path);
+    if(!file.IsOpen()){
+        return 0;
+    }
+    uint64_t hash = HashBytes(file.data, file.size);
+    return hash == 0 ? 1 : hash;
+}
+
+//! @note Returns 0 when the source file cannot be read, which callers treat as "do not use the cache"
+static uint64_t ComputeMeshCacheKey(const std::string& sourcePath, uint32_t importFlags, uint32_t processFlags){
+    AssetFile source(sourcePath);
+    if(!source.IsOpen()){
+        return 0;
+    }
+
+    uint64_t key = HashBytes(source.data, source.size);
+    key = HashValue(importFlags, key);
+    key = HashValue(processFlags, key);
+    key = HashValue(MESH_CACHE_VERSION, key);
+    key = HashValue(static_cast<uint32_t>(sizeof(Vertex)), key);
+    return key == 0 ? 1 : key;
+}
+
+//! @note Key of a baked mesh cache (BakedAssets.h): the runtime may not have the source to hash, so only the settings that shaped the meshes count
+static uint64_t ComputeBakedMeshKey(uint32_t importFlags, uint32_t processFlags){
+    uint64_t key = HashValue(importFlags, 0x62616b65646d7368ull);
+    key = HashValue(processFlags, key);
+    key = HashValue(MESH_CACHE_VERSION, key);
+    key = HashValue(static_cast<uint32_t>(sizeof(Vertex)), key);
+    return key == 0 ? 1 : key;
+}
+
+//! @note Cache files sit next to the source model, named after the key (ex. backpack.obj.3f2a9c...meshcache)
+static std::string MeshCachePath(const std::string& sourcePath, uint64_t key){
+    char hex[17];
+    snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(key));
+    return sourcePath + "." + hex + ".meshcache";
+}
+
+static uint64_t AlignOffset(uint64_t offset, uint64_t alignment){
+    return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+/**
+ * @note Collects views of the meshes produced by an import and writes them out as one cache file
+ * @note Only pointers are stored, so the vectors passed to AddMesh must outlive Write()
+*/
+struct MeshCacheWriter{
+    //! @note node indexes the hierarchy passed to SetNodes, if there is one
+    void AddMesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const std::vector<MeshLod>& lods, const std::vector<Texture>& textures,
+                 uint32_t node = 0){
+        meshes.push_back({&vertices, &indices, &lods, &textures, node});
+    }
+
+    //! @note The node tree the meshes' node indices refer to, copied right away
+    void SetNodes(const SceneHierarchy& hierarchy){
+        nodes.clear();
+        for(uint32_t i = 0; i < hierarchy.Size(); i++){
+            const glm::vec3& translation = hierarchy.Translation(i);
+            const glm::quat& rotation = hierarchy.Rotation(i);
+            const glm::vec3& scale = hierarchy.Scale(i);
+            nodes.push_back({hierarchy.Parent(i), {translation.x, translation.y, translation.z}, {rotation.w, rotation.x, rotation.y, rotation.z},
+                             {scale.x, scale.y, scale.z}});
+        }
+    }
+
+    //! @note A file besides the source that the meshes depend on, hashed right away. Baked caches (ComputeBakedMeshKey) leave this out,
+    //! @note the runtime may not ship the sources at all
+    void AddDependency(const std::string& path){
+        dependencies.push_back({path, HashFile(path)});
+    }
+
+    bool Write(const std::string& cachePath, uint64_t key) const{
+        std::vector<MeshCacheMesh> meshTable;
+        std::vector<MeshCacheTexture> textureTable;
+        std::vector<MeshLod> lodTable;
+        std::string stringTable;
+
+        uint64_t vertexTotal = 0;
+        uint64_t indexTotal = 0;
+        for(const PendingMesh& mesh : meshes){
+            MeshCacheMesh entry;
+            entry.firstVertex = vertexTotal;
+            entry.firstIndex = indexTotal;
+            entry.vertexCount = static_cast<uint32_t>(mesh.vertices->size());
+            entry.indexCount = static_cast<uint32_t>(mesh.indices->size());
+            entry.firstTexture = static_cast<uint32_t>(textureTable.size());
+            entry.textureCount = static_cast<uint32_t>(mesh.textures->size());
+            entry.firstLod = static_cast<uint32_t>(lodTable.size());
+            entry.lodCount = static_cast<uint32_t>(mesh.lods->size());
+            entry.node = nodes.empty() ? 0 : mesh.node;
+            entry.reserved = 0;
+            meshTable.push_back(entry);
+            lodTable.insert(lodTable.end(), mesh.lods->begin(), mesh.lods->end());
+
+            for(const Texture& texture : *mesh.textures){
+                MeshCacheTexture textureEntry;
+                textureEntry.typeOffset = static_cast<uint32_t>(stringTable.size());
+                textureEntry.typeLength = static_cast<uint32_t>(texture.type.size());
+                stringTable += texture.type;
+                textureEntry.pathOffset = static_cast<uint32_t>(stringTable.size());
+                textureEntry.pathLength = static_cast<uint32_t>(texture.path.size());
+                stringTable += texture.path;
+                textureTable.push_back(textureEntry);
+            }
+
+            vertexTotal += entry.vertexCount;
+            indexTotal += entry.indexCount;
+        }
+
+        std::vector<MeshCacheDependency> dependencyTable;
+        for(const PendingDependency& dependency : dependencies){
+            dependencyTable.push_back({static_cast<uint32_t>(stringTable.size()), static_cast<uint32_t>(dependency.path.size()), dependency.hash});
+            stringTable += dependency.path;
+        }
+
+        MeshCacheHeader header = {};
+        std::memcpy(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic));
+        header.version = MESH_CACHE_VERSION;
+        header.key = key;
+        header.vertexStride = sizeof(Vertex);
+        header.meshCount = static_cast<uint32_t>(meshTable.size());
+        header.textureCount = static_cast<uint32_t>(textureTable.size());
+        header.stringTableSize = static_cast<uint32_t>(stringTable.size());
+        header.lodCount = static_cast<uint32_t>(lodTable.size());
+        header.nodeCount = static_cast<uint32_t>(nodes.size());
+        header.dependencyCount = static_cast<uint32_t>(dependencyTable.size());
+        header.meshTableOffset = sizeof(MeshCacheHeader);
+        header.textureTableOffset = header.meshTableOffset + meshTable.size() * sizeof(MeshCacheMesh);
+        header.lodTableOffset = header.textureTableOffset + textureTable.size() * sizeof(MeshCacheTexture);
+        header.nodeTableOffset = header.lodTableOffset + lodTable.size() * sizeof(MeshLod);
+        header.dependencyTableOffset = header.nodeTableOffset + nodes.size() * sizeof(MeshCacheNode);
+        header.stringTableOffset = header.dependencyTableOffset + dependencyTable.size() * sizeof(MeshCacheDependency);
+        header.vertexDataOffset = AlignOffset(header.stringTableOffset + stringTable.size(), 16);
+        header.indexDataOffset = AlignOffset(header.vertexDataOffset + vertexTotal * sizeof(Vertex), 16);
+        header.fileSize = header.indexDataOffset + indexTotal * sizeof(uint32_t);
+
+        //! @note Writing into a temporary file first and renaming it, so a crash mid-write never leaves a truncated cache behind
+        std::string tempPath = cachePath + ".tmp";
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if(!out){
+            printf("Could not open mesh cache for writing ====> %s\n", tempPath.c_str());
+            return false;
+        }
+
+        const char padding[16] = {};
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(meshTable.data()), meshTable.size() * sizeof(MeshCacheMesh));
+        out.write(reinterpret_cast<const char*>(textureTable.data()), textureTable.size() * sizeof(MeshCacheTexture));
+        out.write(reinterpret_cast<const char*>(lodTable.data()), lodTable.size() * sizeof(MeshLod));
+        out.write(reinterpret_cast<const char*>(nodes.data()), nodes.size() * sizeof(MeshCacheNode));
+        out.write(reinterpret_cast<const char*>(dependencyTable.data()), dependencyTable.size() * sizeof(MeshCacheDependency));
+        out.write(stringTable.data(), stringTable.size());
+        out.write(padding, header.vertexDataOffset - (header.stringTableOffset + stringTable.size()));
+
+        for(const PendingMesh& mesh : meshes){
+            out.write(reinterpret_cast<const char*>(mesh.vertices->data()), mesh.vertices->size() * sizeof(Vertex));
+        }
+        out.write(padding, header.indexDataOffset - (header.vertexDataOffset + vertexTotal * sizeof(Vertex)));
+
+        for(const PendingMesh& mesh : meshes){
+            out.write(reinterpret_cast<const char*>(mesh.indices->data()), mesh.indices->size() * sizeof(uint32_t));
+        }
+
+        out.close();
+        if(!out){
+            std::remove(tempPath.c_str());
+            return false;
+        }
+
+        std::remove(cachePath.c_str());
+        return std::rename(tempPath.c_str(), cachePath.c_str()) == 0;
+    }
+
+private:
+    struct PendingMesh{
+        const std::vector<Vertex>* vertices;
+        const std::vector<uint32_t>* indices;
+        const std::vector<MeshLod>* lods;
+        const std::vector<Texture>* textures;
+        uint32_t node;
+    };
+    struct PendingDependency{
+        std::string path;
+        uint64_t hash;
+    };
+    std::vector<PendingMesh> meshes;
+    std::vector<MeshCacheNode> nodes;
+    std::vector<PendingDependency> dependencies;
+};
+
+/**
+ * @note Read side of the cache, every accessor returns a pointer into the mapped file (no copies, no parsing)
+ * @note Open() validates the header against the expected key and rejects anything truncated or written by another version,
+ * @note or whose dependencies changed since it was written
+*/
+struct MeshCacheReader{
+    bool Open(const std::string& cachePath, uint64_t key){
+        if(!file.Open(cachePath)){
+            return false;
+        }
+
+        if(file.size < sizeof(MeshCacheHeader)){
+            return Reject(cachePath);
+        }
+
+        header = reinterpret_cast<const MeshCacheHeader*>(file.data);
+
+        bool valid = std::memcmp(header->magic, MESH_CACHE_MAGIC, sizeof(header->magic)) == 0 &&
+                     header->version == MESH_CACHE_VERSION &&
+                     header->key == key &&
+                     header->vertexStride == sizeof(Vertex) &&
+                     header->fileSize == file.size &&
+                     header->meshTableOffset + uint64_t(header->meshCount) * sizeof(MeshCacheMesh) <= header->textureTableOffset &&
+                     header->textureTableOffset + uint64_t(header->textureCount) * sizeof(MeshCacheTexture) <= header->lodTableOffset &&
+                     header->lodTableOffset + uint64_t(header->lodCount) * sizeof(MeshLod) <= header->nodeTableOffset &&
+                     header->nodeTableOffset + uint64_t(header->nodeCount) * sizeof(MeshCacheNode) <= header->dependencyTableOffset &&
+                     header->dependencyTableOffset + uint64_t(header->dependencyCount) * sizeof(MeshCacheDependency) <= header->stringTableOffset &&
+                     header->stringTableOffset + header->stringTableSize <= header->vertexDataOffset &&
+                     header->vertexDataOffset <= header->indexDataOffset &&
+                     header->indexDataOffset <= file.size;
+
+        if(!valid){
+            return Reject(cachePath);
+        }
+
+        for(uint32_t i = 0; i < header->meshCount; i++){
+            const MeshCacheMesh& mesh = GetMesh(i);
+            if(header->vertexDataOffset + (mesh.firstVertex + mesh.vertexCount) * sizeof(Vertex) > header->indexDataOffset ||
+               header->indexDataOffset + (mesh.firstIndex + mesh.indexCount) * sizeof(uint32_t) > file.size ||
+               uint64_t(mesh.firstTexture) + mesh.textureCount > header->textureCount ||
+               uint64_t(mesh.firstLod) + mesh.lodCount > header->lodCount ||
+               (header->nodeCount != 0 && mesh.node >= header->nodeCount)){
+                return Reject(cachePath);
+            }
+
+            for(uint32_t j = 0; j < mesh.lodCount; j++){
+                const MeshLod& lod = GetLod(mesh.firstLod + j);
+                if(uint64_t(lod.firstIndex) + lod.indexCount > mesh.indexCount){
+                    return Reject(cachePath);
+                }
+            }
+        }
+
+        for(uint32_t i = 0; i < header->nodeCount; i++){
+            if(GetNode(i).parent >= static_cast<int32_t>(i)){
+                return Reject(cachePath);
+            }
+        }
+
+        for(uint32_t i = 0; i < header->textureCount; i++){
+            const MeshCacheTexture& texture = GetTexture(i);
+            if(uint64_t(texture.typeOffset) + texture.typeLength > header->stringTableSize ||
+               uint64_t(texture.pathOffset) + texture.pathLength > header->stringTableSize){
+                return Reject(cachePath);
+            }
+        }
+
+        for(uint32_t i = 0; i < header->dependencyCount; i++){
+            const MeshCacheDependency& dependency = GetDependency(i);
+            if(uint64_t(dependency.pathOffset) + dependency.pathLength > header->stringTableSize){
+                return Reject(cachePath);
+            }
+        }
+
+        //! @note Checked last, the bounds above guarantee every path is readable
+        for(uint32_t i = 0; i < header->dependencyCount; i++){
+            const MeshCacheDependency& dependency = GetDependency(i);
+            std::string path = GetString(dependency.pathOffset, dependency.pathLength);
+            if(HashFile(path) != dependency.hash){
+                printf("Mesh cache is out of date, %s changed ====> %s\n", path.c_str(), cachePath.c_str());
+                Close();
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void Close(){
+        file.Close();
+        header = nullptr;
+    }
+
+    uint32_t MeshCount() const { return header->meshCount; }
+
+    const MeshCacheMesh& GetMesh(uint32_t index) const{
+        return reinterpret_cast<const MeshCacheMesh*>(file.data + header->meshTableOffset)[index];
+    }
+
+    const Vertex* GetVertices(const MeshCacheMesh& mesh) const{
+        return reinterpret_cast<const Vertex*>(file.data + header->vertexDataOffset) + mesh.firstVertex;
+    }
+
+    const uint32_t* GetIndices(const MeshCacheMesh& mesh) const{
+        return reinterpret_cast<const uint32_t*>(file.data + header->indexDataOffset) + mesh.firstIndex;
+    }
+
+    const MeshCacheTexture& GetTexture(uint32_t index) const{
+        return reinterpret_cast<const MeshCacheTexture*>(file.data + header->textureTableOffset)[index];
+    }
+
+    const MeshLod& GetLod(uint32_t index) const{
+        return reinterpret_cast<const MeshLod*>(file.data + header->lodTableOffset)[index];
+    }
+
+    uint32_t NodeCount() const { return header->nodeCount; }
+
+    const MeshCacheNode& GetNode(uint32_t index) const{
+        return reinterpret_cast<const MeshCacheNode*>(file.data + header->nodeTableOffset)[index];
+    }
+
+    uint32_t DependencyCount() const { return header->dependencyCount; }
+
+    const MeshCacheDependency& GetDependency(uint32_t index) const{
+        return reinterpret_cast<const MeshCacheDependency*>(file.data + header->dependencyTableOffset)[index];
+    }
+
+    //! @note Rebuilds the stored node tree into hierarchy and every mesh's node into meshNodes, both stay empty when the cache has no tree
+    void ReadNodes(SceneHierarchy& hierarchy, std::vector<uint32_t>& meshNodes) const{
+        hierarchy.Clear();
+        meshNodes.clear();
+        if(header->nodeCount == 0) return;
+
+        hierarchy.Reserve(header->nodeCount);
+        for(uint32_t i = 0; i < header->nodeCount; i++){
+            const MeshCacheNode& node = GetNode(i);
+            hierarchy.AddNode(node.parent, glm::vec3(node.translation[0], node.translation[1], node.translation[2]),
+                              glm::quat(node.rotation[0], node.rotation[1], node.rotation[2], node.rotation[3]), glm::vec3(node.scale[0], node.scale[1], node.scale[2]));
+        }
+        for(uint32_t i = 0; i < header->meshCount; i++){
+            meshNodes.push_back(GetMesh(i).node);
+        }
+    }
+
+    std::string GetString(uint32_t offset, uint32_t length) const{
+        return std::string(reinterpret_cast<const char*>(file.data + header->stringTableOffset) + offset, length);
+    }
+
+private:
+    bool Reject(const std::string& cachePath){
+        printf("Ignoring invalid mesh cache ====> %s\n", cachePath.c_str());
+        Close();
+        return false;
+    }
+
+    AssetFile file;    // mapped on its own, or a span into a mounted asset pack (AssetPack.h)
+    const MeshCacheHeader* header = nullptr;
+};
@@ -0,0 +1,72 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+/**
+ * @param MeshData
+ * @note CPU-side vertex and texture types shared by Mesh, Model and the loaders that feed them
+ * @note Kept separate from modelLoadingTutorial-01.h so the mesh cache (and other import stages) can read and write them without pulling in OpenGL
+*/
+
+// NEW ---- Creating our vertex
+struct Vertex{
+    glm::vec3 position;
+    glm::vec3 normal;
+    glm::vec2 TexCoords;
+    // tangent
+    glm::vec3 Tangent;
+    // tangent
+    glm::vec3 BitTangent;
+};
+
+struct TextureResource; // TextureCache.h
+
+// NEW ---- Creating our texture class
+struct Texture{
+    uint32_t id;
+    std::string type;
+    std::string path; // Storing path of our texture in comparison to other textures
+    std::shared_ptr<TextureResource> handle; // keeps the cached GL texture alive while any mesh uses it
+    // NEW ---- once packed into a texture array (Model::packTextureArrays, TextureArrays.h) id and handle are cleared and these are used instead
+    uint32_t arrayID = 0;
+    float layer = 0.0f;
+    glm::vec4 uvRect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f); // offset xy, scale zw within the layer (atlased textures)
+};
+
+//! @note One level of detail, a range of the mesh's index array drawn over the same vertices as every other level
+struct MeshLod{
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+    float error = 0.0f; // how far the simplified surface may deviate from the full mesh, in model units (0 for the full mesh)
+};
+
+/**
+ * @note Clusters ("meshlets") of up to MESHLET_MAX_VERTICES vertices / MESHLET_MAX_TRIANGLES triangles covering a mesh's full detail level, see Meshlets.h
+ * @note Structure of arrays, so a culling loop only streams the bounds it tests, the triangle data is touched only for clusters that survive
+*/
+struct MeshletSet{
+    // one entry per meshlet
+    std::vector<glm::vec4> boundingSpheres; // xyz center, w radius (model space)
+    std::vector<glm::vec4> normalCones;     // xyz axis, w cutoff (sine of the cone's half angle, 1 = cannot be cone culled)
+    std::vector<uint32_t> vertexOffsets;    // into vertices
+    std::vector<uint32_t> triangleOffsets;  // into triangles, in bytes (3 per triangle)
+    std::vector<uint8_t> vertexCounts;
+    std::vector<uint8_t> triangleCounts;
+
+    // shared by all meshlets
+    std::vector<uint32_t> vertices;         // meshlet-local vertex -> index into the mesh's vertex buffer
+    std::vector<uint8_t> triangles;         // meshlet-local vertex numbers, three per triangle
+
+    size_t Count() const { return boundingSpheres.size(); }
+};
+
+//! @note CPU-side geometry of one mesh, filled on worker threads before Mesh uploads it on the GL thread
+struct MeshData{
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;  // every level of detail, back to back
+    std::vector<MeshLod> lods;      // empty when the mesh has a single level covering all indices
+    MeshletSet meshlets;            // empty unless meshlets were requested
+};
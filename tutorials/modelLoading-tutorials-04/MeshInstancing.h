@@ -0,0 +1,83 @@
+#pragma once
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <glm/glm.hpp>
+
+#include "MeshData.h"
+#include "MeshCache.h"
+
+/**
+ * @param MeshInstancing
+ * @note Finds meshes of a model whose content is identical (same vertices, indices, levels of detail and material), so the model
+ * @note can keep one copy and draw it once per occurrence with glDrawElementsInstanced (see ModelLoadOptions::instanceMeshes)
+ * @note CAD and FBX exports typically repeat the same bolt or panel under hundreds of nodes, either as one aiMesh referenced by many
+ * @note nodes or as separate but byte-identical aiMeshes. Both end up in one group here.
+ * @note Meshes are hashed first and only compared byte for byte when the hashes match, so a false hash collision never merges two meshes
+*/
+
+struct InstancingReport{
+    size_t occurrences = 0;         // meshes the node tree references, i.e. draw calls without instancing
+    size_t uniqueMeshes = 0;        // meshes actually uploaded, i.e. draw calls with instancing
+    size_t savedVertexBytes = 0;    // vertex/index bytes of the duplicates that were not uploaded
+    size_t instanceBytes = 0;       // per-instance transforms uploaded instead
+};
+
+static uint64_t HashMeshContent(const MeshData& data, uint32_t material){
+    uint64_t hash = HashValue(material, 14695981039346656037ull);
+    hash = HashBytes(data.vertices.data(), data.vertices.size() * sizeof(Vertex), hash);
+    hash = HashBytes(data.indices.data(), data.indices.size() * sizeof(uint32_t), hash);
+    return HashBytes(data.lods.data(), data.lods.size() * sizeof(MeshLod), hash);
+}
+
+static bool SameMeshContent(const MeshData& a, const MeshData& b){
+    return a.vertices.size() == b.vertices.size() && a.indices.size() == b.indices.size() && a.lods.size() == b.lods.size() &&
+           std::memcmp(a.vertices.data(), b.vertices.data(), a.vertices.size() * sizeof(Vertex)) == 0 &&
+           std::memcmp(a.indices.data(), b.indices.data(), a.indices.size() * sizeof(uint32_t)) == 0 &&
+           std::memcmp(a.lods.data(), b.lods.data(), a.lods.size() * sizeof(MeshLod)) == 0;
+}
+
+/**
+ * @note Returns for every mesh the index of the first mesh with the same content and material (itself when it is the first)
+ * @note materials[i] is any key for meshes[i]'s textures (ex. the assimp material index), meshes with different keys are never grouped
+*/
+static std::vector<uint32_t> FindIdenticalMeshes(const std::vector<MeshData>& meshes, const std::vector<uint32_t>& materials){
+    size_t count = meshes.size();
+    std::vector<uint32_t> leaders(count);
+    std::vector<uint64_t> hashes(count);
+    for(size_t i = 0; i < count; i++){
+        hashes[i] = HashMeshContent(meshes[i], materials[i]);
+    }
+
+    //! @note Open addressing over the group leaders, at most half full
+    size_t capacity = 1;
+    while(capacity < count * 2) capacity <<= 1;
+    const uint32_t empty = ~0u;
+    std::vector<uint32_t> table(capacity, empty);
+
+    for(size_t i = 0; i < count; i++){
+        size_t slot = static_cast<size_t>(hashes[i] ^ (hashes[i] >> 32)) & (capacity - 1);
+        while(true){
+            uint32_t leader = table[slot];
+            if(leader == empty){
+                table[slot] = static_cast<uint32_t>(i);
+                leaders[i] = static_cast<uint32_t>(i);
+                break;
+            }
+            if(hashes[leader] == hashes[i] && materials[leader] == materials[i] && SameMeshContent(meshes[leader], meshes[i])){
+                leaders[i] = leader;
+                break;
+            }
+            slot = (slot + 1) & (capacity - 1);
+        }
+    }
+    return leaders;
+}
+
+static void PrintInstancingReport(const InstancingReport& report){
+    double savedMegabytes = (double(report.savedVertexBytes) - double(report.instanceBytes)) / (1024.0 * 1024.0);
+    printf("Instancing: %zu mesh occurrences -> %zu unique meshes, %zu -> %zu draw calls, %.2f MB of vertex/index data saved (%.2f MB duplicates, %.2f KB transforms)\n",
+           report.occurrences, report.uniqueMeshes, report.occurrences, report.uniqueMeshes, savedMegabytes,
+           report.savedVertexBytes / (1024.0 * 1024.0), report.instanceBytes / 1024.0);
+}
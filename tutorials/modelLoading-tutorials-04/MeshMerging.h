@@ -0,0 +1,158 @@
+#pragma once
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <algorithm>
+#include <glm/glm.hpp>
+
+#include "MeshData.h"
+
+/**
+ * @param MeshMerging
+ * @note Merges static meshes that share a material into one mesh (one draw call, one round of texture binds) at load time
+ * @note Vertices are pre-transformed by their node transform (normals and tangents by its inverse transpose), mirrored transforms get
+ * @note their winding flipped so culling still works
+ * @note Levels of detail are kept: level k of the merged mesh is level k of every source back to back (sources with fewer levels repeat their last one)
+ * @note Each merged mesh keeps a MeshMergeSource per original mesh, so a picked triangle can be traced back to the mesh it came from
+*/
+
+struct MeshMergeSource{
+    uint32_t sourceMesh = 0;    // index the mesh would have had in Model::meshes without merging
+    uint32_t firstIndex = 0;    // its triangles in the merged mesh's full detail level
+    uint32_t indexCount = 0;
+    uint32_t firstVertex = 0;
+    uint32_t vertexCount = 0;
+};
+
+struct MeshMergeInput{
+    const MeshData* data = nullptr;
+    glm::mat4 transform = glm::mat4(1.0f);
+    uint32_t material = 0;      // any key, only inputs with the same key are merged
+    uint32_t sourceMesh = 0;
+};
+
+struct MergedMesh{
+    uint32_t material = 0;
+    uint32_t firstInput = 0;    // first input merged into it, ex. to look up the material's textures
+    MeshData data;              // meshlets are left empty
+    std::vector<MeshMergeSource> sources;
+};
+
+struct MeshMergeReport{
+    size_t inputMeshes = 0;     // draw calls without merging
+    size_t outputMeshes = 0;    // draw calls with merging
+    size_t vertices = 0;
+};
+
+//! @note Appends source's vertices to out, transformed
+static void AppendTransformedVertices(const MeshData& source, const glm::mat4& transform, std::vector<Vertex>& out){
+    glm::mat3 linear = glm::mat3(transform);
+    glm::mat3 normalMatrix = glm::transpose(glm::inverse(linear));
+
+    auto direction = [](const glm::mat3& matrix, const glm::vec3& v){
+        glm::vec3 result = matrix * v;
+        float length = glm::length(result);
+        return length > 0.0f ? result / length : result;
+    };
+
+    for(const Vertex& vertex : source.vertices){
+        Vertex transformed = vertex;
+        transformed.position = glm::vec3(transform * glm::vec4(vertex.position, 1.0f));
+        transformed.normal = direction(normalMatrix, vertex.normal);
+        transformed.Tangent = direction(linear, vertex.Tangent);
+        transformed.BitTangent = direction(linear, vertex.BitTangent);
+        out.push_back(transformed);
+    }
+}
+
+//! @note Index range of level k of a mesh, the last level stands in for levels a mesh does not have
+static MeshLod MergeSourceLevel(const MeshData& data, size_t level){
+    if(data.lods.empty()) return {0, static_cast<uint32_t>(data.indices.size()), 0.0f};
+    return data.lods[std::min(level, data.lods.size() - 1)];
+}
+
+//! @note One merged mesh per material key, in the order each key first appears in inputs
+static std::vector<MergedMesh> MergeMeshesByMaterial(const std::vector<MeshMergeInput>& inputs){
+    std::vector<MergedMesh> merged;
+    std::vector<std::vector<uint32_t>> groups;
+    for(uint32_t i = 0; i < inputs.size(); i++){
+        size_t group = 0;
+        while(group < merged.size() && merged[group].material != inputs[i].material) group++;
+        if(group == merged.size()){
+            merged.push_back({});
+            merged.back().material = inputs[i].material;
+            merged.back().firstInput = i;
+            groups.emplace_back();
+        }
+        groups[group].push_back(i);
+    }
+
+    for(size_t g = 0; g < merged.size(); g++){
+        MergedMesh& mesh = merged[g];
+        const std::vector<uint32_t>& members = groups[g];
+
+        size_t vertexCount = 0, indexCount = 0, levels = 1;
+        for(uint32_t input : members){
+            const MeshData& data = *inputs[input].data;
+            vertexCount += data.vertices.size();
+            indexCount += data.indices.size();
+            levels = std::max(levels, data.lods.size());
+        }
+        mesh.data.vertices.reserve(vertexCount);
+        mesh.data.indices.reserve(indexCount);
+
+        std::vector<uint32_t> vertexBases;
+        std::vector<uint8_t> mirrored;
+        for(uint32_t input : members){
+            const MeshMergeInput& source = inputs[input];
+            vertexBases.push_back(static_cast<uint32_t>(mesh.data.vertices.size()));
+            mirrored.push_back(glm::determinant(glm::mat3(source.transform)) < 0.0f ? 1 : 0);
+            AppendTransformedVertices(*source.data, source.transform, mesh.data.vertices);
+        }
+
+        for(size_t level = 0; level < levels; level++){
+            MeshLod mergedLevel{static_cast<uint32_t>(mesh.data.indices.size()), 0, 0.0f};
+            for(size_t m = 0; m < members.size(); m++){
+                const MeshMergeInput& source = inputs[members[m]];
+                MeshLod range = MergeSourceLevel(*source.data, level);
+                uint32_t first = static_cast<uint32_t>(mesh.data.indices.size());
+
+                const uint32_t* indices = source.data->indices.data() + range.firstIndex;
+                for(uint32_t i = 0; i + 2 < range.indexCount; i += 3){
+                    uint32_t a = indices[i] + vertexBases[m], b = indices[i + 1] + vertexBases[m], c = indices[i + 2] + vertexBases[m];
+                    mesh.data.indices.insert(mesh.data.indices.end(), {a, mirrored[m] ? c : b, mirrored[m] ? b : c});
+                }
+                mergedLevel.error = std::max(mergedLevel.error, range.error);
+
+                if(level == 0){
+                    MeshMergeSource entry;
+                    entry.sourceMesh = source.sourceMesh;
+                    entry.firstIndex = first;
+                    entry.indexCount = range.indexCount;
+                    entry.firstVertex = vertexBases[m];
+                    entry.vertexCount = static_cast<uint32_t>(source.data->vertices.size());
+                    mesh.sources.push_back(entry);
+                }
+            }
+            mergedLevel.indexCount = static_cast<uint32_t>(mesh.data.indices.size()) - mergedLevel.firstIndex;
+            if(levels > 1) mesh.data.lods.push_back(mergedLevel);
+        }
+    }
+    return merged;
+}
+
+//! @note Which original mesh a triangle of the merged full detail level came from (-1 when out of range), sources are sorted by firstIndex
+static int32_t FindMergeSource(const std::vector<MeshMergeSource>& sources, uint32_t triangle){
+    uint32_t index = triangle * 3;
+    auto it = std::upper_bound(sources.begin(), sources.end(), index, [](uint32_t value, const MeshMergeSource& source){
+        return value < source.firstIndex;
+    });
+    if(it == sources.begin()) return -1;
+    --it;
+    return index < it->firstIndex + it->indexCount ? static_cast<int32_t>(it->sourceMesh) : -1;
+}
+
+static void PrintMeshMergeReport(const MeshMergeReport& report){
+    printf("Mesh merging: %zu static meshes -> %zu merged meshes (%zu draw calls saved), %zu vertices pre-transformed\n",
+           report.inputMeshes, report.outputMeshes, report.inputMeshes - report.outputMeshes, report.vertices);
+}
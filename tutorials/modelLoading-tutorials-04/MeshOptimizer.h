@@ -0,0 +1,384 @@
+#pragma once
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+#include "MeshData.h"
+
+/**
+ * @param MeshOptimizer
+ * @note Post-import pass over a mesh's index/vertex arrays, run after extraction and before the upload (or the mesh cache write)
+ * @note 1. Vertex cache: triangles are reordered so recently transformed vertices get reused (Forsyth's linear-speed algorithm)
+ * @note 2. Overdraw: the cache-ordered triangles are cut into clusters, which are sorted so outward facing clusters draw first
+ * @note 3. Vertex fetch: vertices are renumbered in first-use order, so the vertex buffer is read front to back
+ *
+ * @note Every step is deterministic (no hashing of pointers, stable sorts, fixed tie-breaking), the same input always gives the same bytes,
+ * @note so the result can be stored in the mesh cache
+ * @note SimulateVertexCache() models the post-transform cache on the CPU, so the effect can be measured without a GPU
+*/
+
+//! @note Typical post-transform cache size of current GPUs, used for the simulation and the reports
+static constexpr uint32_t VERTEX_CACHE_SIZE = 16;
+
+struct VertexCacheStats{
+    uint32_t misses = 0;        // vertices transformed
+    float acmr = 0.0f;          // average cache miss ratio, transformed vertices per triangle (0.5 is ideal for large grids, 3.0 is the worst)
+    float atvr = 0.0f;          // average transformed vertex ratio, transformed vertices per referenced vertex (1.0 is ideal)
+};
+
+struct MeshOptimizationReport{
+    uint32_t vertexCount = 0;
+    uint32_t triangleCount = 0;
+    uint32_t clusterCount = 0;  // overdraw clusters
+    VertexCacheStats before;
+    VertexCacheStats after;
+};
+
+//! @note Runs the index buffer through a FIFO cache of cacheSize entries, the way the fixed-function post-transform cache behaves
+static VertexCacheStats SimulateVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize = VERTEX_CACHE_SIZE){
+    VertexCacheStats stats;
+    if(indexCount == 0 || vertexCount == 0) return stats;
+
+    //! @note Timestamp FIFO: a vertex is in the cache while fewer than cacheSize misses happened since it was last loaded
+    std::vector<uint32_t> loadedAt(vertexCount, 0);
+    std::vector<uint8_t> referenced(vertexCount, 0);
+    uint32_t timestamp = cacheSize + 1;
+    uint32_t uniqueVertices = 0;
+
+    for(size_t i = 0; i < indexCount; i++){
+        uint32_t vertex = indices[i];
+        if(timestamp - loadedAt[vertex] > cacheSize){
+            loadedAt[vertex] = timestamp++;
+            stats.misses++;
+        }
+        if(!referenced[vertex]){
+            referenced[vertex] = 1;
+            uniqueVertices++;
+        }
+    }
+
+    stats.acmr = float(stats.misses) / float(indexCount / 3);
+    stats.atvr = float(stats.misses) / float(uniqueVertices);
+    return stats;
+}
+
+//! @note Scores from Forsyth's "Linear-Speed Vertex Cache Optimisation", for an LRU cache of VERTEX_SCORE_CACHE_SIZE entries
+static constexpr uint32_t VERTEX_SCORE_CACHE_SIZE = 32;
+
+static float VertexCacheScore(int32_t cachePosition, uint32_t liveTriangles){
+    if(liveTriangles == 0) return -1.0f; // nothing left to draw with this vertex
+
+    float score = 0.0f;
+    if(cachePosition >= 0){
+        //! @note The three most recent vertices belong to the triangle just drawn, a fixed score stops it from being favoured too much
+        if(cachePosition < 3){
+            score = 0.75f;
+        }
+        else{
+            float scale = 1.0f / float(VERTEX_SCORE_CACHE_SIZE - 3);
+            score = std::pow(1.0f - float(cachePosition - 3) * scale, 1.5f);
+        }
+    }
+
+    //! @note Vertices with few triangles left get a boost, so they are finished off instead of being left behind as lone triangles
+    score += 2.0f * std::pow(float(liveTriangles), -0.5f);
+    return score;
+}
+
+//! @note Writes the triangles of indices into out (same size), reordered for post-transform cache reuse. out must not alias indices.
+static void OptimizeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t* out){
+    const uint32_t triangleCount = static_cast<uint32_t>(indexCount / 3);
+    const uint32_t invalid = ~0u;
+    if(triangleCount == 0) return;
+
+    // triangles using each vertex
+    std::vector<uint32_t> liveTriangles(vertexCount, 0);
+    for(size_t i = 0; i < indexCount; i++){
+        liveTriangles[indices[i]]++;
+    }
+
+    std::vector<uint32_t> adjacencyOffset(vertexCount + 1, 0);
+    for(size_t v = 0; v < vertexCount; v++){
+        adjacencyOffset[v + 1] = adjacencyOffset[v] + liveTriangles[v];
+    }
+
+    std::vector<uint32_t> adjacency(indexCount);
+    {
+        std::vector<uint32_t> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+        for(uint32_t t = 0; t < triangleCount; t++){
+            for(uint32_t k = 0; k < 3; k++){
+                adjacency[fill[indices[t * 3 + k]]++] = t;
+            }
+        }
+    }
+
+    std::vector<int32_t> cachePosition(vertexCount, -1);
+    std::vector<float> vertexScore(vertexCount);
+    for(size_t v = 0; v < vertexCount; v++){
+        vertexScore[v] = VertexCacheScore(-1, liveTriangles[v]);
+    }
+
+    std::vector<float> triangleScore(triangleCount);
+    std::vector<uint8_t> emitted(triangleCount, 0);
+    uint32_t best = 0;
+    for(uint32_t t = 0; t < triangleCount; t++){
+        triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+        if(triangleScore[t] > triangleScore[best]) best = t;
+    }
+
+    std::vector<uint32_t> cache, nextCache;
+    cache.reserve(VERTEX_SCORE_CACHE_SIZE + 3);
+    nextCache.reserve(VERTEX_SCORE_CACHE_SIZE + 3);
+    uint32_t cursor = 0; // first triangle that may still be unemitted, used when the cache has nothing left to offer
+
+    for(uint32_t written = 0; written < triangleCount; written++){
+        if(best == invalid){
+            while(emitted[cursor]) cursor++;
+            best = cursor;
+        }
+
+        const uint32_t* triangle = indices + best * 3;
+        out[written * 3 + 0] = triangle[0];
+        out[written * 3 + 1] = triangle[1];
+        out[written * 3 + 2] = triangle[2];
+        emitted[best] = 1;
+
+        //! @note Dropping the triangle from its vertices' live lists (swap with the last live entry)
+        for(uint32_t k = 0; k < 3; k++){
+            uint32_t vertex = triangle[k];
+            uint32_t* begin = adjacency.data() + adjacencyOffset[vertex];
+            uint32_t* end = begin + liveTriangles[vertex];
+            uint32_t* found = std::find(begin, end, best);
+            if(found != end){
+                *found = *(end - 1);
+                liveTriangles[vertex]--;
+            }
+        }
+
+        // the triangle's vertices move to the front of the LRU cache
+        nextCache.clear();
+        for(uint32_t k = 0; k < 3; k++){
+            if(std::find(nextCache.begin(), nextCache.end(), triangle[k]) == nextCache.end()){
+                nextCache.push_back(triangle[k]);
+            }
+        }
+        for(uint32_t vertex : cache){
+            if(vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2]){
+                nextCache.push_back(vertex);
+            }
+        }
+
+        //! @note Rescoring every vertex that entered, moved within or fell out of the cache, and pushing the change onto its live triangles
+        for(uint32_t i = 0; i < nextCache.size(); i++){
+            uint32_t vertex = nextCache[i];
+            cachePosition[vertex] = i < VERTEX_SCORE_CACHE_SIZE ? int32_t(i) : -1;
+
+            float score = VertexCacheScore(cachePosition[vertex], liveTriangles[vertex]);
+            float delta = score - vertexScore[vertex];
+            vertexScore[vertex] = score;
+
+            const uint32_t* live = adjacency.data() + adjacencyOffset[vertex];
+            for(uint32_t j = 0; j < liveTriangles[vertex]; j++){
+                triangleScore[live[j]] += delta;
+            }
+        }
+
+        if(nextCache.size() > VERTEX_SCORE_CACHE_SIZE){
+            nextCache.resize(VERTEX_SCORE_CACHE_SIZE);
+        }
+        std::swap(cache, nextCache);
+
+        //! @note Only triangles touching the cache are candidates, which keeps the whole pass linear in the triangle count
+        best = invalid;
+        float bestScore = 0.0f;
+        for(uint32_t vertex : cache){
+            const uint32_t* live = adjacency.data() + adjacencyOffset[vertex];
+            for(uint32_t j = 0; j < liveTriangles[vertex]; j++){
+                if(triangleScore[live[j]] > bestScore){
+                    bestScore = triangleScore[live[j]];
+                    best = live[j];
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @note Reorders clusters of an already cache-optimized index buffer to reduce overdraw, writing into out (must not alias indices)
+ * @note Clusters end wherever the cache order restarts (a triangle with three misses), long ones are cut again once their running ACMR
+ * @note is within threshold of the cluster's own, so the cache efficiency lost to the reordering stays bounded by threshold
+ * @note Clusters are then sorted by how far they face away from the mesh center, drawing the outer shell first lets the depth test reject what lies behind it
+*/
+static uint32_t OptimizeOverdraw(const uint32_t* indices, size_t indexCount, const Vertex* vertices, size_t vertexCount, uint32_t* out, float threshold = 1.05f){
+    const uint32_t triangleCount = static_cast<uint32_t>(indexCount / 3);
+    if(triangleCount == 0) return 0;
+
+    //! @note One timestamp array for both passes, bumping the timestamp by VERTEX_CACHE_SIZE + 1 empties the cache without touching it,
+    //! @note so the cost stays linear however many clusters there are (unwelded meshes make nearly every triangle one)
+    std::vector<uint32_t> loadedAt(vertexCount, 0);
+    uint32_t timestamp = VERTEX_CACHE_SIZE + 1;
+
+    // hard boundaries, where the cache order starts over, and each hard cluster's ACMR as if it started with a cold cache
+    std::vector<uint32_t> hardClusters;
+    std::vector<uint32_t> hardMisses;
+    for(uint32_t t = 0; t < triangleCount; t++){
+        uint32_t misses = 0;
+        for(uint32_t k = 0; k < 3; k++){
+            uint32_t vertex = indices[t * 3 + k];
+            if(timestamp - loadedAt[vertex] > VERTEX_CACHE_SIZE){
+                loadedAt[vertex] = timestamp++;
+                misses++;
+            }
+        }
+        if(t == 0 || misses == 3){
+            // all three missed either way, restamping them after a cold start leaves exactly the cache a fresh simulation would have
+            timestamp += VERTEX_CACHE_SIZE + 1;
+            for(uint32_t k = 0; k < 3; k++){
+                uint32_t vertex = indices[t * 3 + k];
+                if(timestamp - loadedAt[vertex] > VERTEX_CACHE_SIZE){
+                    loadedAt[vertex] = timestamp++;
+                }
+            }
+            hardClusters.push_back(t);
+            hardMisses.push_back(0);
+        }
+        hardMisses.back() += misses;
+    }
+    hardClusters.push_back(triangleCount);
+
+    // soft boundaries, inside each hard cluster
+    std::vector<uint32_t> clusters;
+    {
+        const uint32_t minimumClusterSize = 16;
+        for(size_t c = 0; c + 1 < hardClusters.size(); c++){
+            uint32_t start = hardClusters[c], end = hardClusters[c + 1];
+            float target = float(hardMisses[c]) / float(end - start) * threshold;
+
+            timestamp += VERTEX_CACHE_SIZE + 1;
+            uint32_t misses = 0;
+            uint32_t begin = start;
+            clusters.push_back(start);
+
+            for(uint32_t t = start; t < end; t++){
+                for(uint32_t k = 0; k < 3; k++){
+                    uint32_t vertex = indices[t * 3 + k];
+                    if(timestamp - loadedAt[vertex] > VERTEX_CACHE_SIZE){
+                        loadedAt[vertex] = timestamp++;
+                        misses++;
+                    }
+                }
+
+                uint32_t size = t + 1 - begin;
+                if(size >= minimumClusterSize && t + 1 < end && float(misses) / float(size) <= target){
+                    begin = t + 1;
+                    clusters.push_back(begin);
+                    timestamp += VERTEX_CACHE_SIZE + 1; // the next cluster starts with a cold cache
+                    misses = 0;
+                }
+            }
+        }
+    }
+    clusters.push_back(triangleCount);
+    uint32_t clusterCount = static_cast<uint32_t>(clusters.size() - 1);
+
+    // area weighted centroid of the whole mesh
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+    std::vector<glm::vec3> clusterCentroid(clusterCount, glm::vec3(0.0f));
+    std::vector<glm::vec3> clusterNormal(clusterCount, glm::vec3(0.0f));
+    std::vector<float> clusterArea(clusterCount, 0.0f);
+
+    for(uint32_t c = 0; c < clusterCount; c++){
+        for(uint32_t t = clusters[c]; t < clusters[c + 1]; t++){
+            const glm::vec3& a = vertices[indices[t * 3 + 0]].position;
+            const glm::vec3& b = vertices[indices[t * 3 + 1]].position;
+            const glm::vec3& d = vertices[indices[t * 3 + 2]].position;
+            glm::vec3 normal = glm::cross(b - a, d - a); // length = twice the area
+            float area = glm::length(normal);
+            glm::vec3 center = (a + b + d) * (1.0f / 3.0f);
+
+            clusterCentroid[c] += center * area;
+            clusterNormal[c] += normal;
+            clusterArea[c] += area;
+        }
+        meshCentroid += clusterCentroid[c];
+        meshArea += clusterArea[c];
+    }
+    meshCentroid = meshArea > 0.0f ? meshCentroid / meshArea : glm::vec3(0.0f);
+
+    std::vector<float> sortKey(clusterCount, 0.0f);
+    for(uint32_t c = 0; c < clusterCount; c++){
+        float normalLength = glm::length(clusterNormal[c]);
+        if(clusterArea[c] > 0.0f && normalLength > 0.0f){
+            glm::vec3 centroid = clusterCentroid[c] / clusterArea[c];
+            sortKey[c] = glm::dot(centroid - meshCentroid, clusterNormal[c] / normalLength);
+        }
+    }
+
+    std::vector<uint32_t> order(clusterCount);
+    for(uint32_t c = 0; c < clusterCount; c++) order[c] = c;
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b){ return sortKey[a] > sortKey[b]; });
+
+    size_t written = 0;
+    for(uint32_t c : order){
+        size_t begin = size_t(clusters[c]) * 3, end = size_t(clusters[c + 1]) * 3;
+        std::copy(indices + begin, indices + end, out + written);
+        written += end - begin;
+    }
+    // a trailing partial triangle (never drawn) is kept as is
+    std::copy(indices + written, indices + indexCount, out + written);
+    return clusterCount;
+}
+
+//! @note Renumbers vertices in the order the index buffer first uses them, vertices no triangle references are dropped
+static void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices){
+    const uint32_t unused = ~0u;
+    std::vector<uint32_t> remap(vertices.size(), unused);
+    std::vector<Vertex> reordered;
+    reordered.reserve(vertices.size());
+
+    for(uint32_t& index : indices){
+        if(remap[index] == unused){
+            remap[index] = static_cast<uint32_t>(reordered.size());
+            reordered.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+
+    vertices = std::move(reordered);
+}
+
+//! @note Runs all three passes over one mesh in place, report (optional) gets the cache statistics before and after
+static void OptimizeMesh(MeshData& mesh, MeshOptimizationReport* report = nullptr, float overdrawThreshold = 1.05f){
+    if(report){
+        report->vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+        report->triangleCount = static_cast<uint32_t>(mesh.indices.size() / 3);
+        report->before = SimulateVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+    }
+
+    if(mesh.indices.size() < 3 || mesh.vertices.empty()){
+        if(report) report->after = report->before;
+        return;
+    }
+
+    std::vector<uint32_t> cacheOrdered(mesh.indices.size());
+    OptimizeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size(), cacheOrdered.data());
+    uint32_t clusterCount = OptimizeOverdraw(cacheOrdered.data(), cacheOrdered.size(), mesh.vertices.data(), mesh.vertices.size(), mesh.indices.data(), overdrawThreshold);
+    OptimizeVertexFetch(mesh.vertices, mesh.indices);
+
+    if(report){
+        report->clusterCount = clusterCount;
+        report->after = SimulateVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+    }
+}
+
+static void PrintMeshOptimizationReport(const std::vector<MeshOptimizationReport>& reports){
+    printf("  %5s %9s %9s %8s | %7s %7s | %7s %7s\n", "mesh", "vertices", "triangles", "clusters", "ACMR", "ATVR", "ACMR'", "ATVR'");
+    for(size_t i = 0; i < reports.size(); i++){
+        const MeshOptimizationReport& report = reports[i];
+        printf("  %5zu %9u %9u %8u | %7.3f %7.3f | %7.3f %7.3f\n", i, report.vertexCount, report.triangleCount, report.clusterCount,
+               report.before.acmr, report.before.atvr, report.after.acmr, report.after.atvr);
+    }
+}
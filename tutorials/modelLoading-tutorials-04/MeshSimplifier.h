@@ -0,0 +1,298 @@
+#pragma once
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <unordered_set>
+
+#include "MeshData.h"
+#include "MeshOptimizer.h"
+
+/**
+ * @param MeshSimplifier
+ * @note Edge-collapse simplification driven by quadric error metrics (Garland & Heckbert), used to build the LOD chain of a mesh
+ * @note Collapses are half-edge collapses (u moves onto its neighbour v), so no vertex is ever created or changed,
+ * @note every level of detail is just another index list over the same vertex buffer
+ *
+ * @note Seams: vertices sharing a position with another vertex (split by a uv or normal discontinuity) and vertices on open borders are locked,
+ * @note they can be collapsed onto but never moved, which keeps texture seams, hard edges and silhouettes of open meshes intact
+ * @note Error: quadrics are built from unweighted triangle planes, so sqrt(error) is the distance (model units) the surface moved, summed over the planes it touches
+*/
+
+//! @note Symmetric 4x4 matrix of plane equations, error(p) = sum over planes of (dot(n, p) + d)^2
+struct Quadric{
+    double a00 = 0, a01 = 0, a02 = 0, a03 = 0;
+    double a11 = 0, a12 = 0, a13 = 0;
+    double a22 = 0, a23 = 0;
+    double a33 = 0;
+
+    static Quadric FromPlane(const glm::vec3& n, float d){
+        Quadric q;
+        q.a00 = double(n.x) * n.x; q.a01 = double(n.x) * n.y; q.a02 = double(n.x) * n.z; q.a03 = double(n.x) * d;
+        q.a11 = double(n.y) * n.y; q.a12 = double(n.y) * n.z; q.a13 = double(n.y) * d;
+        q.a22 = double(n.z) * n.z; q.a23 = double(n.z) * d;
+        q.a33 = double(d) * d;
+        return q;
+    }
+
+    void Add(const Quadric& q){
+        a00 += q.a00; a01 += q.a01; a02 += q.a02; a03 += q.a03;
+        a11 += q.a11; a12 += q.a12; a13 += q.a13;
+        a22 += q.a22; a23 += q.a23;
+        a33 += q.a33;
+    }
+
+    double Error(const glm::vec3& p) const{
+        double x = p.x, y = p.y, z = p.z;
+        double error = a00 * x * x + 2 * a01 * x * y + 2 * a02 * x * z + 2 * a03 * x
+                     + a11 * y * y + 2 * a12 * y * z + 2 * a13 * y
+                     + a22 * z * z + 2 * a23 * z
+                     + a33;
+        return error > 0.0 ? error : 0.0;
+    }
+};
+
+class MeshSimplifier{
+public:
+    MeshSimplifier(const Vertex* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount)
+        : vertices(vertices), vertexCount(vertexCount), indices(indices, indices + indexCount - indexCount % 3){
+        quadrics.resize(vertexCount);
+        locked.assign(vertexCount, 0);
+
+        for(size_t t = 0; t < this->indices.size(); t += 3){
+            const glm::vec3& a = vertices[this->indices[t]].position;
+            const glm::vec3& b = vertices[this->indices[t + 1]].position;
+            const glm::vec3& c = vertices[this->indices[t + 2]].position;
+            glm::vec3 normal = glm::cross(b - a, c - a);
+            float length = glm::length(normal);
+            if(length == 0.0f) continue;
+
+            normal /= length;
+            Quadric plane = Quadric::FromPlane(normal, -glm::dot(normal, a));
+            for(uint32_t k = 0; k < 3; k++){
+                quadrics[this->indices[t + k]].Add(plane);
+            }
+        }
+
+        LockSeamsAndBorders();
+    }
+
+    /**
+     * @note Collapses edges until at most targetIndexCount indices are left, or until no collapse is possible without flipping a triangle
+     * @note Can be called repeatedly with decreasing targets, each call continues from the previous result (that is how the LOD chain is built)
+    */
+    void SimplifyTo(size_t targetIndexCount){
+        size_t targetTriangles = targetIndexCount / 3;
+
+        while(indices.size() / 3 > targetTriangles){
+            size_t collapses = CollapsePass(indices.size() / 3 - targetTriangles);
+            if(collapses == 0) break;
+        }
+    }
+
+    const std::vector<uint32_t>& Indices() const { return indices; }
+
+    //! @note Largest collapse error so far (model units), grows monotonically with every call to SimplifyTo
+    float Error() const { return static_cast<float>(std::sqrt(maxError)); }
+
+    //! @note Vertices on seams or borders, on unwelded input (every triangle owning its corners) that is all of them and nothing can collapse
+    size_t LockedCount() const { return static_cast<size_t>(std::count(locked.begin(), locked.end(), uint8_t(1))); }
+
+private:
+    struct Collapse{
+        uint32_t from;
+        uint32_t to;
+        double cost;
+    };
+
+    //! @note Vertices sharing a position are found by sorting, open edges by looking for the opposite half-edge (on welded positions, so uv seams are not mistaken for borders)
+    void LockSeamsAndBorders(){
+        std::vector<uint32_t> order(vertexCount);
+        for(uint32_t v = 0; v < vertexCount; v++) order[v] = v;
+        auto less = [&](uint32_t a, uint32_t b){
+            const glm::vec3& pa = vertices[a].position;
+            const glm::vec3& pb = vertices[b].position;
+            if(pa.x != pb.x) return pa.x < pb.x;
+            if(pa.y != pb.y) return pa.y < pb.y;
+            if(pa.z != pb.z) return pa.z < pb.z;
+            return a < b;
+        };
+        std::sort(order.begin(), order.end(), less);
+
+        std::vector<uint32_t> welded(vertexCount);
+        for(size_t i = 0; i < order.size(); i++){
+            bool sameAsPrevious = i > 0 && vertices[order[i]].position == vertices[order[i - 1]].position;
+            welded[order[i]] = sameAsPrevious ? welded[order[i - 1]] : order[i];
+            if(sameAsPrevious){
+                locked[order[i]] = 1;
+                locked[order[i - 1]] = 1;
+            }
+        }
+
+        std::unordered_set<uint64_t> halfEdges;
+        halfEdges.reserve(indices.size());
+        for(size_t t = 0; t < indices.size(); t += 3){
+            for(uint32_t k = 0; k < 3; k++){
+                uint64_t a = welded[indices[t + k]], b = welded[indices[t + (k + 1) % 3]];
+                halfEdges.insert((a << 32) | b);
+            }
+        }
+
+        for(size_t t = 0; t < indices.size(); t += 3){
+            for(uint32_t k = 0; k < 3; k++){
+                uint32_t a = indices[t + k], b = indices[t + (k + 1) % 3];
+                if(!halfEdges.count((uint64_t(welded[b]) << 32) | welded[a])){
+                    locked[a] = 1;
+                    locked[b] = 1;
+                }
+            }
+        }
+    }
+
+    /**
+     * @note One round of collapses, cheapest first, never touching a vertex twice in the same round (so the flip checks stay valid)
+     * @note Candidates are sorted by (cost, from, to), which keeps the result deterministic
+    */
+    size_t CollapsePass(size_t trianglesToRemove){
+        std::vector<uint32_t> adjacencyOffset(vertexCount + 1, 0);
+        for(uint32_t index : indices) adjacencyOffset[index + 1]++;
+        for(size_t v = 0; v < vertexCount; v++) adjacencyOffset[v + 1] += adjacencyOffset[v];
+
+        std::vector<uint32_t> adjacency(indices.size());
+        {
+            std::vector<uint32_t> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+            for(size_t i = 0; i < indices.size(); i++){
+                adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+            }
+        }
+
+        std::vector<Collapse> candidates;
+        candidates.reserve(indices.size());
+        for(size_t t = 0; t < indices.size(); t += 3){
+            for(uint32_t k = 0; k < 3; k++){
+                uint32_t a = indices[t + k], b = indices[t + (k + 1) % 3];
+                if(!locked[a]) candidates.push_back({a, b, quadrics[a].Error(vertices[b].position)});
+                if(!locked[b]) candidates.push_back({b, a, quadrics[b].Error(vertices[a].position)});
+            }
+        }
+        std::sort(candidates.begin(), candidates.end(), [](const Collapse& a, const Collapse& b){
+            if(a.cost != b.cost) return a.cost < b.cost;
+            if(a.from != b.from) return a.from < b.from;
+            return a.to < b.to;
+        });
+
+        //! @note Each collapse removes about two triangles, stopping a little early avoids overshooting the target by a whole round
+        size_t collapseLimit = std::max<size_t>(1, (trianglesToRemove + 1) / 2);
+        std::vector<uint8_t> touched(vertexCount, 0);
+        std::vector<uint32_t> remap(vertexCount);
+        for(uint32_t v = 0; v < vertexCount; v++) remap[v] = v;
+
+        size_t collapses = 0;
+        for(const Collapse& collapse : candidates){
+            if(collapses >= collapseLimit) break;
+            if(touched[collapse.from] || touched[collapse.to]) continue;
+            if(Flips(collapse, adjacency, adjacencyOffset)) continue;
+
+            remap[collapse.from] = collapse.to;
+            quadrics[collapse.to].Add(quadrics[collapse.from]);
+            maxError = std::max(maxError, collapse.cost);
+
+            //! @note The whole one-ring of the moved vertex is frozen for this round, its triangles changed shape
+            for(uint32_t j = adjacencyOffset[collapse.from]; j < adjacencyOffset[collapse.from + 1]; j++){
+                const uint32_t* triangle = indices.data() + adjacency[j] * 3;
+                touched[triangle[0]] = touched[triangle[1]] = touched[triangle[2]] = 1;
+            }
+            collapses++;
+        }
+
+        if(collapses == 0) return 0;
+
+        size_t written = 0;
+        for(size_t t = 0; t < indices.size(); t += 3){
+            uint32_t a = remap[indices[t]], b = remap[indices[t + 1]], c = remap[indices[t + 2]];
+            if(a == b || b == c || a == c) continue; // collapsed away
+
+            indices[written++] = a;
+            indices[written++] = b;
+            indices[written++] = c;
+        }
+        indices.resize(written);
+        return collapses;
+    }
+
+    //! @note True when moving from onto to would turn one of from's remaining triangles over (or make it degenerate)
+    bool Flips(const Collapse& collapse, const std::vector<uint32_t>& adjacency, const std::vector<uint32_t>& adjacencyOffset) const{
+        const glm::vec3& target = vertices[collapse.to].position;
+
+        for(uint32_t j = adjacencyOffset[collapse.from]; j < adjacencyOffset[collapse.from + 1]; j++){
+            const uint32_t* triangle = indices.data() + adjacency[j] * 3;
+            if(triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to) continue; // removed by the collapse
+
+            glm::vec3 before[3], after[3];
+            for(uint32_t k = 0; k < 3; k++){
+                before[k] = vertices[triangle[k]].position;
+                after[k] = triangle[k] == collapse.from ? target : before[k];
+            }
+
+            glm::vec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+            glm::vec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+            if(glm::dot(normalBefore, normalAfter) <= 0.0f) return true;
+        }
+        return false;
+    }
+
+    const Vertex* vertices;
+    size_t vertexCount;
+    std::vector<uint32_t> indices;
+    std::vector<Quadric> quadrics;
+    std::vector<uint8_t> locked;
+    double maxError = 0.0;
+};
+
+/**
+ * @note Appends levelCount simplified index lists to mesh.indices, each aiming at ratio times the triangles of the level before
+ * @note mesh.lods gets one entry per level, level 0 being the original triangles, the chain stops early once simplification stalls
+ * @note With optimizeCache every level is also reordered for the vertex cache (the vertex buffer is shared, so its order is left alone)
+ * @note Needs welded vertices (MeshWelder.h), see LockedCount. Returns the number of simplified levels built and reports a mesh that got none.
+*/
+static uint32_t BuildLodChain(MeshData& mesh, uint32_t levelCount, float ratio = 0.5f, bool optimizeCache = false){
+    mesh.lods.clear();
+    mesh.lods.push_back({0, static_cast<uint32_t>(mesh.indices.size()), 0.0f});
+    if(levelCount == 0 || mesh.indices.size() < 3) return 0;
+
+    MeshSimplifier simplifier(mesh.vertices.data(), mesh.vertices.size(), mesh.indices.data(), mesh.indices.size());
+    size_t previousCount = mesh.indices.size();
+
+    for(uint32_t level = 0; level < levelCount; level++){
+        size_t target = static_cast<size_t>(previousCount * ratio) / 3 * 3;
+        simplifier.SimplifyTo(target);
+
+        const std::vector<uint32_t>& simplified = simplifier.Indices();
+        //! @note A level that removed less than a tenth of the triangles is not worth its index memory
+        if(simplified.empty() || simplified.size() * 10 > previousCount * 9) break;
+
+        MeshLod lod;
+        lod.firstIndex = static_cast<uint32_t>(mesh.indices.size());
+        lod.indexCount = static_cast<uint32_t>(simplified.size());
+        lod.error = simplifier.Error();
+
+        if(optimizeCache){
+            mesh.indices.resize(mesh.indices.size() + simplified.size());
+            OptimizeVertexCache(simplified.data(), simplified.size(), mesh.vertices.size(), mesh.indices.data() + lod.firstIndex);
+        }
+        else{
+            mesh.indices.insert(mesh.indices.end(), simplified.begin(), simplified.end());
+        }
+
+        mesh.lods.push_back(lod);
+        previousCount = simplified.size();
+    }
+
+    if(mesh.lods.size() == 1){
+        printf("No LOD level could be built for a mesh of %zu triangles, %zu of %zu vertices are locked on seams or borders%s\n",
+               mesh.indices.size() / 3, simplifier.LockedCount(), mesh.vertices.size(),
+               simplifier.LockedCount() == mesh.vertices.size() ? " (unwelded input? see WeldVertices)" : "");
+    }
+    return static_cast<uint32_t>(mesh.lods.size() - 1);
+}
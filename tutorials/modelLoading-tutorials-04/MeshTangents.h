@@ -0,0 +1,385 @@
+#pragma once
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+#include "MeshData.h"
+#include "MeshWelder.h"
+#include "ThreadPool.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MESH_TANGENTS_SSE2 1
+#endif
+
+/**
+ * @param MeshTangents
+ * @note Smooth normals and tangent frames computed on our extracted Vertex arrays, replacing aiProcess_GenSmoothNormals + aiProcess_CalcTangentSpace
+ * @note (ModelLoadOptions::computeTangentFrames drops both flags from the import and runs this inside buildMeshData instead)
+ *
+ * @note 1. Per triangle: unit face normal plus the tangent/bitangent directions from the uv derivatives, four triangles at a time with SSE2
+ * @note 2. Normals (only when the file had none, like assimp): every vertex gets the average unit normal of all triangles touching its position
+ * @note 3. Tangents the way MikkTSpace builds them: the face tangent is projected onto each corner's normal plane, weighted by the corner angle,
+ * @note    and summed over corners sharing position, normal, uv and handedness. Vertices used with both handedness (mirrored uv seams) are split.
+ * @note    The bitangent is stored as sign * cross(normal, tangent), so it is always orthogonal to the other two
+ *
+ * @note Every phase is a loop over independent triangles, groups or vertices, split into chunks on the ThreadPool when one is passed
+ * @note The sums are gathered per group (corners listed per group first) instead of scattered, so no atomics are needed and the result is the same for any thread count
+*/
+
+struct TangentFrameSettings{
+    bool generateNormals = true;    // false keeps the normals already in the vertices (assimp only generates them when the file has none)
+    bool generateTangents = true;   // only meaningful with texture coordinates, like aiProcess_CalcTangentSpace
+};
+
+struct TangentFrameStats{
+    size_t splitVertices = 0;       // duplicated because they sit on a mirrored uv seam
+    size_t degenerateTriangles = 0; // zero area in uv space, they do not contribute a tangent
+};
+
+static constexpr size_t TANGENT_CHUNK_SIZE = 4096;
+
+//! @note Runs function(begin, end) over [0, count), in chunks on the pool when there is one and more than one chunk
+template<typename Function>
+static void ForEachTangentChunk(ThreadPool* pool, size_t count, Function&& function){
+    uint32_t chunks = static_cast<uint32_t>((count + TANGENT_CHUNK_SIZE - 1) / TANGENT_CHUNK_SIZE);
+    if(!pool || chunks < 2){
+        function(size_t(0), count);
+        return;
+    }
+
+    pool->ParallelFor(chunks, [&](uint32_t chunk){
+        size_t begin = size_t(chunk) * TANGENT_CHUNK_SIZE;
+        function(begin, std::min(count, begin + TANGENT_CHUNK_SIZE));
+    });
+}
+
+//! @note Per triangle results in structure-of-arrays form, so the SIMD path can store four lanes at once
+struct TriangleFrames{
+    std::vector<float> nx, ny, nz;  // unit face normal
+    std::vector<float> tx, ty, tz;  // direction of increasing u (not normalized, zero for degenerate uvs)
+    std::vector<float> bx, by, bz;  // direction of increasing v
+
+    void Resize(size_t count){
+        for(std::vector<float>* component : {&nx, &ny, &nz, &tx, &ty, &tz, &bx, &by, &bz}){
+            component->resize(count);
+        }
+    }
+
+    glm::vec3 Normal(size_t i) const { return glm::vec3(nx[i], ny[i], nz[i]); }
+    glm::vec3 Tangent(size_t i) const { return glm::vec3(tx[i], ty[i], tz[i]); }
+    glm::vec3 Bitangent(size_t i) const { return glm::vec3(bx[i], by[i], bz[i]); }
+};
+
+static void ComputeTriangleFramesScalar(const Vertex* vertices, const uint32_t* indices, size_t begin, size_t end, TriangleFrames& frames){
+    for(size_t t = begin; t < end; t++){
+        const Vertex& v0 = vertices[indices[t * 3 + 0]];
+        const Vertex& v1 = vertices[indices[t * 3 + 1]];
+        const Vertex& v2 = vertices[indices[t * 3 + 2]];
+
+        glm::vec3 e1 = v1.position - v0.position;
+        glm::vec3 e2 = v2.position - v0.position;
+        glm::vec3 normal = glm::cross(e1, e2);
+        float length = glm::length(normal);
+        normal = length > 0.0f ? normal / length : glm::vec3(0.0f);
+
+        float du1 = v1.TexCoords.x - v0.TexCoords.x, dv1 = v1.TexCoords.y - v0.TexCoords.y;
+        float du2 = v2.TexCoords.x - v0.TexCoords.x, dv2 = v2.TexCoords.y - v0.TexCoords.y;
+        float det = du1 * dv2 - du2 * dv1;
+        float r = std::fabs(det) > 1e-20f ? 1.0f / det : 0.0f;
+
+        glm::vec3 tangent = (e1 * dv2 - e2 * dv1) * r;
+        glm::vec3 bitangent = (e2 * du1 - e1 * du2) * r;
+
+        frames.nx[t] = normal.x; frames.ny[t] = normal.y; frames.nz[t] = normal.z;
+        frames.tx[t] = tangent.x; frames.ty[t] = tangent.y; frames.tz[t] = tangent.z;
+        frames.bx[t] = bitangent.x; frames.by[t] = bitangent.y; frames.bz[t] = bitangent.z;
+    }
+}
+
+#ifdef MESH_TANGENTS_SSE2
+//! @note Gathers one float member of corner `corner` from four triangles into the lanes of a register
+static inline __m128 GatherCorner4(const Vertex* vertices, const uint32_t* indices, size_t t, uint32_t corner, size_t memberOffset){
+    auto load = [&](size_t triangle){
+        const Vertex& vertex = vertices[indices[triangle * 3 + corner]];
+        return *reinterpret_cast<const float*>(reinterpret_cast<const char*>(&vertex) + memberOffset);
+    };
+    return _mm_set_ps(load(t + 3), load(t + 2), load(t + 1), load(t));
+}
+#endif
+
+static void ComputeTriangleFrames(const Vertex* vertices, const uint32_t* indices, size_t begin, size_t end, TriangleFrames& frames){
+    size_t t = begin;
+#ifdef MESH_TANGENTS_SSE2
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 epsilon = _mm_set1_ps(1e-20f);
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+
+    for(; t + 4 <= end; t += 4){
+        __m128 p0x = GatherCorner4(vertices, indices, t, 0, offsetof(Vertex, position) + 0);
+        __m128 p0y = GatherCorner4(vertices, indices, t, 0, offsetof(Vertex, position) + 4);
+        __m128 p0z = GatherCorner4(vertices, indices, t, 0, offsetof(Vertex, position) + 8);
+        __m128 e1x = _mm_sub_ps(GatherCorner4(vertices, indices, t, 1, offsetof(Vertex, position) + 0), p0x);
+        __m128 e1y = _mm_sub_ps(GatherCorner4(vertices, indices, t, 1, offsetof(Vertex, position) + 4), p0y);
+        __m128 e1z = _mm_sub_ps(GatherCorner4(vertices, indices, t, 1, offsetof(Vertex, position) + 8), p0z);
+        __m128 e2x = _mm_sub_ps(GatherCorner4(vertices, indices, t, 2, offsetof(Vertex, position) + 0), p0x);
+        __m128 e2y = _mm_sub_ps(GatherCorner4(vertices, indices, t, 2, offsetof(Vertex, position) + 4), p0y);
+        __m128 e2z = _mm_sub_ps(GatherCorner4(vertices, indices, t, 2, offsetof(Vertex, position) + 8), p0z);
+
+        __m128 u0 = GatherCorner4(vertices, indices, t, 0, offsetof(Vertex, TexCoords) + 0);
+        __m128 v0 = GatherCorner4(vertices, indices, t, 0, offsetof(Vertex, TexCoords) + 4);
+        __m128 du1 = _mm_sub_ps(GatherCorner4(vertices, indices, t, 1, offsetof(Vertex, TexCoords) + 0), u0);
+        __m128 dv1 = _mm_sub_ps(GatherCorner4(vertices, indices, t, 1, offsetof(Vertex, TexCoords) + 4), v0);
+        __m128 du2 = _mm_sub_ps(GatherCorner4(vertices, indices, t, 2, offsetof(Vertex, TexCoords) + 0), u0);
+        __m128 dv2 = _mm_sub_ps(GatherCorner4(vertices, indices, t, 2, offsetof(Vertex, TexCoords) + 4), v0);
+
+        // face normal = normalize(cross(e1, e2)), zero for zero area triangles
+        __m128 nx = _mm_sub_ps(_mm_mul_ps(e1y, e2z), _mm_mul_ps(e1z, e2y));
+        __m128 ny = _mm_sub_ps(_mm_mul_ps(e1z, e2x), _mm_mul_ps(e1x, e2z));
+        __m128 nz = _mm_sub_ps(_mm_mul_ps(e1x, e2y), _mm_mul_ps(e1y, e2x));
+        __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)), _mm_mul_ps(nz, nz)));
+        __m128 hasArea = _mm_cmpgt_ps(length, zero);
+        __m128 inverseLength = _mm_and_ps(hasArea, _mm_div_ps(one, _mm_or_ps(length, _mm_andnot_ps(hasArea, one))));
+        nx = _mm_mul_ps(nx, inverseLength);
+        ny = _mm_mul_ps(ny, inverseLength);
+        nz = _mm_mul_ps(nz, inverseLength);
+
+        // r = 1 / det of the uv edge matrix, zero when the uvs are degenerate
+        __m128 det = _mm_sub_ps(_mm_mul_ps(du1, dv2), _mm_mul_ps(du2, dv1));
+        __m128 validUv = _mm_cmpgt_ps(_mm_and_ps(det, absMask), epsilon);
+        __m128 r = _mm_and_ps(validUv, _mm_div_ps(one, _mm_or_ps(_mm_and_ps(validUv, det), _mm_andnot_ps(validUv, one))));
+
+        // tangent = (e1 * dv2 - e2 * dv1) * r, bitangent = (e2 * du1 - e1 * du2) * r
+        __m128 tx = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(e1x, dv2), _mm_mul_ps(e2x, dv1)), r);
+        __m128 ty = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(e1y, dv2), _mm_mul_ps(e2y, dv1)), r);
+        __m128 tz = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(e1z, dv2), _mm_mul_ps(e2z, dv1)), r);
+        __m128 bx = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(e2x, du1), _mm_mul_ps(e1x, du2)), r);
+        __m128 by = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(e2y, du1), _mm_mul_ps(e1y, du2)), r);
+        __m128 bz = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(e2z, du1), _mm_mul_ps(e1z, du2)), r);
+
+        _mm_storeu_ps(&frames.nx[t], nx); _mm_storeu_ps(&frames.ny[t], ny); _mm_storeu_ps(&frames.nz[t], nz);
+        _mm_storeu_ps(&frames.tx[t], tx); _mm_storeu_ps(&frames.ty[t], ty); _mm_storeu_ps(&frames.tz[t], tz);
+        _mm_storeu_ps(&frames.bx[t], bx); _mm_storeu_ps(&frames.by[t], by); _mm_storeu_ps(&frames.bz[t], bz);
+    }
+#endif
+    ComputeTriangleFramesScalar(vertices, indices, t, end, frames);
+}
+
+//! @note Corners listed per group (compressed rows), so each group's sum can be gathered by one thread
+struct CornerGroups{
+    std::vector<uint32_t> offsets;  // groupCount + 1 entries
+    std::vector<uint32_t> corners;
+};
+
+static void BuildCornerGroups(const std::vector<uint32_t>& cornerGroup, uint32_t groupCount, CornerGroups& groups){
+    groups.offsets.assign(groupCount + 1, 0);
+    for(uint32_t group : cornerGroup){
+        groups.offsets[group + 1]++;
+    }
+    for(uint32_t i = 0; i < groupCount; i++){
+        groups.offsets[i + 1] += groups.offsets[i];
+    }
+
+    groups.corners.resize(cornerGroup.size());
+    std::vector<uint32_t> cursor(groups.offsets.begin(), groups.offsets.end() - 1);
+    for(uint32_t corner = 0; corner < cornerGroup.size(); corner++){
+        groups.corners[cursor[cornerGroup[corner]]++] = corner;
+    }
+}
+
+//! @note Interior angle of a triangle at one of its corners, the MikkTSpace weight
+static float CornerAngle(const Vertex* vertices, const uint32_t* indices, uint32_t corner){
+    uint32_t triangle = corner / 3 * 3;
+    uint32_t k = corner - triangle;
+    glm::vec3 p = vertices[indices[corner]].position;
+    glm::vec3 a = vertices[indices[triangle + (k + 1) % 3]].position - p;
+    glm::vec3 b = vertices[indices[triangle + (k + 2) % 3]].position - p;
+
+    float lengths = glm::length(a) * glm::length(b);
+    if(lengths <= 0.0f) return 0.0f;
+    return std::acos(std::clamp(glm::dot(a, b) / lengths, -1.0f, 1.0f));
+}
+
+//! @note Some unit vector orthogonal to n, for vertices whose triangles give no usable tangent
+static glm::vec3 AnyPerpendicular(const glm::vec3& n){
+    glm::vec3 axis = std::fabs(n.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    glm::vec3 tangent = axis - n * glm::dot(n, axis);
+    float length = glm::length(tangent);
+    return length > 0.0f ? tangent / length : glm::vec3(1.0f, 0.0f, 0.0f);
+}
+
+static TangentFrameStats GenerateTangentFrames(MeshData& data, const TangentFrameSettings& settings = {}, ThreadPool* pool = nullptr){
+    TangentFrameStats stats;
+    std::vector<Vertex>& vertices = data.vertices;
+    std::vector<uint32_t>& indices = data.indices;
+    size_t triangleCount = indices.size() / 3;
+    if(triangleCount == 0) return stats;
+
+    TriangleFrames faces;
+    faces.Resize(triangleCount);
+    ForEachTangentChunk(pool, triangleCount, [&](size_t begin, size_t end){
+        ComputeTriangleFrames(vertices.data(), indices.data(), begin, end, faces);
+    });
+
+    std::vector<uint32_t> remap;
+    std::vector<uint32_t> cornerGroup(triangleCount * 3);
+    CornerGroups groups;
+
+    if(settings.generateNormals){
+        uint32_t groupCount = ComputeWeldRemap(vertices.data(), vertices.size(), WeldSettings(), 3, remap);
+        for(size_t corner = 0; corner < cornerGroup.size(); corner++){
+            cornerGroup[corner] = remap[indices[corner]];
+        }
+        BuildCornerGroups(cornerGroup, groupCount, groups);
+
+        std::vector<glm::vec3> groupNormals(groupCount);
+        ForEachTangentChunk(pool, groupCount, [&](size_t begin, size_t end){
+            for(size_t group = begin; group < end; group++){
+                glm::vec3 sum(0.0f);
+                for(uint32_t i = groups.offsets[group]; i < groups.offsets[group + 1]; i++){
+                    sum += faces.Normal(groups.corners[i] / 3);
+                }
+                float length = glm::length(sum);
+                groupNormals[group] = length > 0.0f ? sum / length : glm::vec3(0.0f, 0.0f, 1.0f);
+            }
+        });
+
+        ForEachTangentChunk(pool, vertices.size(), [&](size_t begin, size_t end){
+            for(size_t i = begin; i < end; i++){
+                vertices[i].normal = groupNormals[remap[i]];
+            }
+        });
+    }
+
+    if(!settings.generateTangents) return stats;
+
+    for(size_t t = 0; t < triangleCount; t++){
+        if(faces.tx[t] == 0.0f && faces.ty[t] == 0.0f && faces.tz[t] == 0.0f){
+            stats.degenerateTriangles++;
+        }
+    }
+
+    //! @note Handedness of the uv mapping at every corner, +1 unless the face's v direction points against cross(normal, tangent)
+    std::vector<int8_t> cornerSign(cornerGroup.size());
+    ForEachTangentChunk(pool, cornerSign.size(), [&](size_t begin, size_t end){
+        for(size_t corner = begin; corner < end; corner++){
+            glm::vec3 normal = vertices[indices[corner]].normal;
+            size_t t = corner / 3;
+            cornerSign[corner] = glm::dot(glm::cross(normal, faces.Tangent(t)), faces.Bitangent(t)) < 0.0f ? -1 : 1;
+        }
+    });
+
+    //! @note A vertex can only store one handedness, corners disagreeing with the first one get a copy of the vertex (same as MikkTSpace splitting it)
+    std::vector<int8_t> vertexSign(vertices.size(), 0);
+    {
+        std::vector<uint32_t> mirrored(vertices.size(), ~0u);
+        for(size_t corner = 0; corner < cornerSign.size(); corner++){
+            uint32_t vertex = indices[corner];
+            if(vertexSign[vertex] == 0){
+                vertexSign[vertex] = cornerSign[corner];
+            }
+            else if(vertexSign[vertex] != cornerSign[corner]){
+                if(mirrored[vertex] == ~0u){
+                    Vertex copy = vertices[vertex];
+                    mirrored[vertex] = static_cast<uint32_t>(vertices.size());
+                    vertices.push_back(copy);
+                    vertexSign.push_back(cornerSign[corner]);
+                    stats.splitVertices++;
+                }
+                indices[corner] = mirrored[vertex];
+            }
+        }
+    }
+
+    //! @note Group = position + normal + uv (the first 8 floats of Vertex) and handedness
+    uint32_t groupCount = ComputeWeldRemap(vertices.data(), vertices.size(), WeldSettings(), 8, remap) * 2;
+    for(size_t corner = 0; corner < cornerGroup.size(); corner++){
+        cornerGroup[corner] = remap[indices[corner]] * 2 + (cornerSign[corner] < 0 ? 1 : 0);
+    }
+    BuildCornerGroups(cornerGroup, groupCount, groups);
+
+    std::vector<glm::vec3> groupTangents(groupCount);
+    ForEachTangentChunk(pool, groupCount, [&](size_t begin, size_t end){
+        for(size_t group = begin; group < end; group++){
+            if(groups.offsets[group] == groups.offsets[group + 1]) continue;
+
+            glm::vec3 normal = vertices[indices[groups.corners[groups.offsets[group]]]].normal;
+            glm::vec3 sum(0.0f);
+            for(uint32_t i = groups.offsets[group]; i < groups.offsets[group + 1]; i++){
+                uint32_t corner = groups.corners[i];
+                glm::vec3 tangent = faces.Tangent(corner / 3);
+                tangent -= normal * glm::dot(normal, tangent);
+                float length = glm::length(tangent);
+                if(length > 1e-20f){
+                    sum += tangent / length * CornerAngle(vertices.data(), indices.data(), corner);
+                }
+            }
+
+            float length = glm::length(sum);
+            groupTangents[group] = length > 0.0f ? sum / length : AnyPerpendicular(normal);
+        }
+    });
+
+    ForEachTangentChunk(pool, vertices.size(), [&](size_t begin, size_t end){
+        for(size_t i = begin; i < end; i++){
+            float sign = vertexSign[i] < 0 ? -1.0f : 1.0f;
+            glm::vec3 normal = vertices[i].normal;
+            glm::vec3 tangent = groupTangents[remap[i] * 2 + (sign < 0.0f ? 1 : 0)];
+            if(tangent == glm::vec3(0.0f)){
+                tangent = AnyPerpendicular(normal); // vertex not referenced by any triangle
+            }
+
+            glm::vec3 bitangent = glm::cross(normal, tangent) * sign;
+            float length = glm::length(bitangent);
+            vertices[i].Tangent = tangent;
+            vertices[i].BitTangent = length > 0.0f ? bitangent / length : bitangent;
+        }
+    });
+
+    return stats;
+}
+
+//! @note Angle between two directions in degrees, 180 when either one is zero
+static float AngleBetweenDegrees(const glm::vec3& a, const glm::vec3& b){
+    float lengths = glm::length(a) * glm::length(b);
+    if(lengths <= 0.0f) return 180.0f;
+    return glm::degrees(std::acos(std::clamp(glm::dot(a, b) / lengths, -1.0f, 1.0f)));
+}
+
+struct TangentFrameComparison{
+    size_t vertices = 0;
+    size_t normalsWithin = 0, tangentsWithin = 0, bitangentsWithin = 0;   // angle to the reference at most the tolerance
+    double normalMean = 0.0, tangentMean = 0.0, bitangentMean = 0.0;      // mean angle error in degrees
+    float normalMax = 0.0f, tangentMax = 0.0f, bitangentMax = 0.0f;
+};
+
+//! @note Compares two vertex arrays with the same layout/order (ex. ours against assimp's), vertex by vertex
+static void CompareTangentFrames(const Vertex* ours, const Vertex* reference, size_t count, float toleranceDegrees, TangentFrameComparison& comparison){
+    for(size_t i = 0; i < count; i++){
+        float normal = AngleBetweenDegrees(ours[i].normal, reference[i].normal);
+        float tangent = AngleBetweenDegrees(ours[i].Tangent, reference[i].Tangent);
+        float bitangent = AngleBetweenDegrees(ours[i].BitTangent, reference[i].BitTangent);
+
+        comparison.normalsWithin += normal <= toleranceDegrees;
+        comparison.tangentsWithin += tangent <= toleranceDegrees;
+        comparison.bitangentsWithin += bitangent <= toleranceDegrees;
+        comparison.normalMean += normal;
+        comparison.tangentMean += tangent;
+        comparison.bitangentMean += bitangent;
+        comparison.normalMax = std::max(comparison.normalMax, normal);
+        comparison.tangentMax = std::max(comparison.tangentMax, tangent);
+        comparison.bitangentMax = std::max(comparison.bitangentMax, bitangent);
+    }
+    comparison.vertices += count;
+}
+
+static void PrintTangentFrameComparison(const TangentFrameComparison& comparison, float toleranceDegrees){
+    double count = comparison.vertices ? double(comparison.vertices) : 1.0;
+    printf("  within %.1f deg of the reference over %zu vertices:\n", toleranceDegrees, comparison.vertices);
+    printf("    normals    : %6.2f%%  mean %6.3f deg  max %7.3f deg\n", comparison.normalsWithin * 100.0 / count, comparison.normalMean / count, comparison.normalMax);
+    printf("    tangents   : %6.2f%%  mean %6.3f deg  max %7.3f deg\n", comparison.tangentsWithin * 100.0 / count, comparison.tangentMean / count, comparison.tangentMax);
+    printf("    bitangents : %6.2f%%  mean %6.3f deg  max %7.3f deg\n", comparison.bitangentsWithin * 100.0 / count, comparison.bitangentMean / count, comparison.bitangentMax);
+}
@@ -0,0 +1,166 @@
+#pragma once
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+
+#include "MeshData.h"
+
+/**
+ * @param MeshWelder
+ * @note Merges duplicated vertices of an extracted mesh and remaps its indices, our replacement for aiProcess_JoinIdenticalVertices
+ * @note Without it every triangle corner assimp hands us is its own Vertex, about three times what the index buffer actually needs
+ * @note Vertices are hashed into an open addressing table (one pass, no sorting), the first occurrence of each vertex is kept so the result is deterministic
+ * @note With an epsilon every component is snapped to a grid of that size before hashing, so vertices that only differ by float noise
+ * @note (ex. tangents assimp computed per face) end up in the same cell. Like any grid snap, two values straddling a cell border stay apart.
+ * @note Runs per mesh right after extraction, before the optimizer, LODs and meshlets. Model runs it inside buildMeshData, so with an extractionPool it is parallel across meshes.
+*/
+
+struct WeldSettings{
+    float positionEpsilon = 0.0f;   // 0 only merges bit-identical positions
+    float attributeEpsilon = 0.0f;  // same for normals, texture coords and tangents
+
+    bool operator==(const WeldSettings& other) const{
+        return positionEpsilon == other.positionEpsilon && attributeEpsilon == other.attributeEpsilon;
+    }
+};
+
+struct WeldStats{
+    size_t inputVertices = 0;
+    size_t outputVertices = 0;
+    size_t removedTriangles = 0;    // collapsed by an epsilon weld
+};
+
+//! @note Vertex is a flat run of floats, the weld key has one 32-bit word per float
+static constexpr uint32_t WELD_KEY_WORDS = sizeof(Vertex) / sizeof(float);
+static_assert(sizeof(Vertex) == WELD_KEY_WORDS * sizeof(float), "Vertex must only contain floats for welding");
+
+//! @note Fills the first keyWords words of key, the weld below uses all of them, other stages group vertices by a prefix (3 = position, 8 = position + normal + uv)
+static void ComputeWeldKey(const Vertex& vertex, const WeldSettings& settings, uint32_t* key, uint32_t keyWords = WELD_KEY_WORDS){
+    float values[WELD_KEY_WORDS];
+    std::memcpy(values, &vertex, sizeof(Vertex));
+
+    for(uint32_t i = 0; i < keyWords; i++){
+        float epsilon = i < 3 ? settings.positionEpsilon : settings.attributeEpsilon;
+        if(epsilon > 0.0f){
+            int32_t cell = static_cast<int32_t>(std::floor(values[i] / epsilon + 0.5f));
+            std::memcpy(&key[i], &cell, sizeof(cell));
+        }
+        else{
+            float value = values[i] == 0.0f ? 0.0f : values[i]; // -0 and +0 are the same vertex
+            std::memcpy(&key[i], &value, sizeof(value));
+        }
+    }
+}
+
+static uint32_t HashWeldKey(const uint32_t* key, uint32_t keyWords = WELD_KEY_WORDS){
+    uint32_t hash = 2166136261u;
+    for(uint32_t i = 0; i < keyWords; i++){
+        hash = (hash ^ key[i]) * 16777619u;
+    }
+    //! @note Final avalanche, FNV alone leaves the low bits (the ones used for the table slot) poorly mixed
+    hash ^= hash >> 15;
+    hash *= 0x2c1b3c6du;
+    hash ^= hash >> 12;
+    return hash;
+}
+
+/**
+ * @note Assigns every vertex the id of the first vertex with the same key, ids count up in first-occurrence order
+ * @note Returns the number of distinct keys, remap is resized to vertexCount
+*/
+static uint32_t ComputeWeldRemap(const Vertex* vertices, size_t vertexCount, const WeldSettings& settings, uint32_t keyWords, std::vector<uint32_t>& remap){
+    remap.resize(vertexCount);
+    if(vertexCount == 0) return 0;
+
+    std::vector<uint32_t> keys(vertexCount * keyWords);
+    for(size_t i = 0; i < vertexCount; i++){
+        ComputeWeldKey(vertices[i], settings, &keys[i * keyWords], keyWords);
+    }
+
+    //! @note At most half full, so probe chains stay short
+    size_t capacity = 1;
+    while(capacity < vertexCount * 2) capacity <<= 1;
+    const uint32_t empty = ~0u;
+    std::vector<uint32_t> table(capacity, empty);
+    std::vector<uint32_t> firstSource; // input vertex each id came from, its key is the one compared against
+    firstSource.reserve(vertexCount);
+
+    for(size_t i = 0; i < vertexCount; i++){
+        const uint32_t* key = &keys[i * keyWords];
+        size_t slot = HashWeldKey(key, keyWords) & (capacity - 1);
+
+        while(true){
+            uint32_t entry = table[slot];
+            if(entry == empty){
+                entry = static_cast<uint32_t>(firstSource.size());
+                table[slot] = entry;
+                firstSource.push_back(static_cast<uint32_t>(i));
+                remap[i] = entry;
+                break;
+            }
+            if(std::memcmp(&keys[firstSource[entry] * keyWords], key, keyWords * sizeof(uint32_t)) == 0){
+                remap[i] = entry;
+                break;
+            }
+            slot = (slot + 1) & (capacity - 1);
+        }
+    }
+
+    return static_cast<uint32_t>(firstSource.size());
+}
+
+/**
+ * @note Welds data.vertices in place and rewrites data.indices to match
+ * @note Triangles that an epsilon weld collapsed to a line or point are dropped, unless LOD ranges already point into the index buffer
+*/
+static WeldStats WeldVertices(MeshData& data, const WeldSettings& settings = {}){
+    WeldStats stats;
+    size_t vertexCount = data.vertices.size();
+    stats.inputVertices = vertexCount;
+    stats.outputVertices = vertexCount;
+    if(vertexCount == 0) return stats;
+
+    std::vector<uint32_t> remap;
+    uint32_t uniqueCount = ComputeWeldRemap(data.vertices.data(), vertexCount, settings, WELD_KEY_WORDS, remap);
+
+    //! @note Ids were handed out in first-occurrence order, so the first vertex with each id is simply appended
+    std::vector<Vertex> welded;
+    welded.reserve(uniqueCount);
+    for(size_t i = 0; i < vertexCount; i++){
+        if(remap[i] == welded.size()){
+            welded.push_back(data.vertices[i]);
+        }
+    }
+
+    std::vector<uint32_t>& indices = data.indices;
+    for(uint32_t& index : indices){
+        index = remap[index];
+    }
+
+    if(data.lods.empty()){
+        size_t kept = 0;
+        for(size_t i = 0; i + 2 < indices.size(); i += 3){
+            uint32_t a = indices[i], b = indices[i + 1], c = indices[i + 2];
+            if(a == b || b == c || a == c){
+                stats.removedTriangles++;
+                continue;
+            }
+            indices[kept++] = a;
+            indices[kept++] = b;
+            indices[kept++] = c;
+        }
+        indices.resize(kept);
+    }
+
+    data.vertices.swap(welded);
+    stats.outputVertices = data.vertices.size();
+    return stats;
+}
+
+static void PrintWeldStats(const char* label, const WeldStats& stats){
+    double ratio = stats.inputVertices ? double(stats.outputVertices) / double(stats.inputVertices) : 1.0;
+    printf("%s: %zu -> %zu vertices (%.1f%%), %zu degenerate triangles removed\n",
+           label, stats.inputVertices, stats.outputVertices, ratio * 100.0, stats.removedTriangles);
+}
@@ -0,0 +1,305 @@
+#pragma once
+#include <cmath>
+#include <array>
+#include <cstdio>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+#include "MeshData.h"
+
+/**
+ * @param Meshlets
+ * @note Splits a mesh into small clusters (MeshletSet, see MeshData.h) that can be culled one by one instead of all-or-nothing per mesh
+ * @note Triangles are gathered greedily: the next triangle is the one touching the current cluster that brings in the fewest new vertices,
+ * @note closest to the cluster's center on ties, so clusters grow round (tight spheres and cones, more triangles per vertex)
+ * @note and a new cluster only starts when the vertex or triangle limit is hit
+ * @note 64 vertices / 124 triangles matches what mesh shader hardware prefers, and keeps every local index in a byte
+ *
+ * @note Every cluster carries a bounding sphere (frustum / occlusion tests) and a normal cone (backface rejection of the whole cluster)
+*/
+
+static constexpr uint32_t MESHLET_MAX_VERTICES = 64;
+static constexpr uint32_t MESHLET_MAX_TRIANGLES = 124;
+
+struct MeshletStats{
+    size_t meshletCount = 0;
+    size_t triangleCount = 0;
+    size_t vertexReferences = 0;    // sum of the meshlets' vertex counts, vertices on cluster borders are counted once per cluster
+    float averageVertexFill = 0.0f; // of MESHLET_MAX_VERTICES
+    float averageTriangleFill = 0.0f; // of MESHLET_MAX_TRIANGLES
+    size_t underfilled = 0;         // meshlets below half the triangle limit
+    float vertexDuplication = 0.0f; // vertexReferences / referenced vertices
+};
+
+//! @note Appends one finished cluster to the set, computing its bounds from the mesh vertices
+static void AppendMeshlet(const Vertex* vertices, const std::vector<uint32_t>& meshletVertices, const std::vector<uint8_t>& meshletTriangles, MeshletSet& set){
+    set.vertexOffsets.push_back(static_cast<uint32_t>(set.vertices.size()));
+    set.triangleOffsets.push_back(static_cast<uint32_t>(set.triangles.size()));
+    set.vertexCounts.push_back(static_cast<uint8_t>(meshletVertices.size()));
+    set.triangleCounts.push_back(static_cast<uint8_t>(meshletTriangles.size() / 3));
+    set.vertices.insert(set.vertices.end(), meshletVertices.begin(), meshletVertices.end());
+    set.triangles.insert(set.triangles.end(), meshletTriangles.begin(), meshletTriangles.end());
+
+    // bounding sphere around the box center
+    glm::vec3 minimum = vertices[meshletVertices[0]].position, maximum = minimum;
+    for(uint32_t vertex : meshletVertices){
+        minimum = glm::min(minimum, vertices[vertex].position);
+        maximum = glm::max(maximum, vertices[vertex].position);
+    }
+    glm::vec3 center = (minimum + maximum) * 0.5f;
+    float radius = 0.0f;
+    for(uint32_t vertex : meshletVertices){
+        radius = std::max(radius, glm::length(vertices[vertex].position - center));
+    }
+    set.boundingSpheres.push_back(glm::vec4(center, radius));
+
+    //! @note Cone axis = average face normal, the cutoff is the sine of the widest angle any face makes with it
+    std::vector<glm::vec3> normals;
+    normals.reserve(meshletTriangles.size() / 3);
+    glm::vec3 axis(0.0f);
+    for(size_t t = 0; t < meshletTriangles.size(); t += 3){
+        const glm::vec3& a = vertices[meshletVertices[meshletTriangles[t]]].position;
+        const glm::vec3& b = vertices[meshletVertices[meshletTriangles[t + 1]]].position;
+        const glm::vec3& c = vertices[meshletVertices[meshletTriangles[t + 2]]].position;
+        glm::vec3 normal = glm::cross(b - a, c - a);
+        float length = glm::length(normal);
+        if(length == 0.0f) continue;
+
+        normals.push_back(normal / length);
+        axis += normals.back();
+    }
+
+    float axisLength = glm::length(axis);
+    if(axisLength == 0.0f){
+        set.normalCones.push_back(glm::vec4(0.0f, 0.0f, 1.0f, 1.0f));
+        return;
+    }
+    axis /= axisLength;
+
+    float minimumDot = 1.0f;
+    for(const glm::vec3& normal : normals){
+        minimumDot = std::min(minimumDot, glm::dot(normal, axis));
+    }
+
+    //! @note A cone of 90 degrees or wider contains front faces from every direction, 1 disables the cone test for it
+    float cutoff = minimumDot <= 0.0f ? 1.0f : std::sqrt(std::max(0.0f, 1.0f - minimumDot * minimumDot));
+    set.normalCones.push_back(glm::vec4(axis, cutoff));
+}
+
+//! @note Partitions the triangles of indices into meshlets, the result reproduces the exact triangle set (winding included)
+static void BuildMeshlets(const Vertex* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount, MeshletSet& set){
+    set = MeshletSet();
+    const uint32_t triangleCount = static_cast<uint32_t>(indexCount / 3);
+    if(triangleCount == 0) return;
+
+    std::vector<uint32_t> adjacencyOffset(vertexCount + 1, 0);
+    for(size_t i = 0; i < triangleCount * 3; i++) adjacencyOffset[indices[i] + 1]++;
+    for(size_t v = 0; v < vertexCount; v++) adjacencyOffset[v + 1] += adjacencyOffset[v];
+
+    std::vector<uint32_t> adjacency(triangleCount * 3);
+    {
+        std::vector<uint32_t> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+        for(uint32_t i = 0; i < triangleCount * 3; i++){
+            adjacency[fill[indices[i]]++] = i / 3;
+        }
+    }
+
+    const uint8_t notInMeshlet = 0xff;
+    std::vector<uint8_t> localIndex(vertexCount, notInMeshlet);
+    std::vector<uint8_t> used(triangleCount, 0);
+    std::vector<uint32_t> meshletVertices;
+    std::vector<uint8_t> meshletTriangles;
+    meshletVertices.reserve(MESHLET_MAX_VERTICES);
+    meshletTriangles.reserve(MESHLET_MAX_TRIANGLES * 3);
+    uint32_t cursor = 0;
+    glm::vec3 centerSum(0.0f); // of the current cluster's vertices
+
+    auto newVertices = [&](uint32_t triangle){
+        uint32_t count = 0;
+        for(uint32_t k = 0; k < 3; k++){
+            uint32_t vertex = indices[triangle * 3 + k];
+            bool repeated = (k > 0 && indices[triangle * 3] == vertex) || (k > 1 && indices[triangle * 3 + 1] == vertex);
+            if(localIndex[vertex] == notInMeshlet && !repeated) count++;
+        }
+        return count;
+    };
+
+    auto flush = [&](){
+        AppendMeshlet(vertices, meshletVertices, meshletTriangles, set);
+        for(uint32_t vertex : meshletVertices) localIndex[vertex] = notInMeshlet;
+        meshletVertices.clear();
+        meshletTriangles.clear();
+        centerSum = glm::vec3(0.0f);
+    };
+
+    auto distanceToCluster = [&](uint32_t triangle){
+        glm::vec3 center = centerSum / float(meshletVertices.size());
+        glm::vec3 centroid = (vertices[indices[triangle * 3]].position + vertices[indices[triangle * 3 + 1]].position + vertices[indices[triangle * 3 + 2]].position) * (1.0f / 3.0f);
+        glm::vec3 offset = centroid - center;
+        return glm::dot(offset, offset);
+    };
+
+    for(uint32_t emitted = 0; emitted < triangleCount; emitted++){
+        //! @note Best neighbour of the current cluster: fewest new vertices, then closest to the cluster center, then lowest triangle number
+        uint32_t best = ~0u, bestCost = 4;
+        float bestDistance = 0.0f;
+        for(uint32_t vertex : meshletVertices){
+            for(uint32_t j = adjacencyOffset[vertex]; j < adjacencyOffset[vertex + 1]; j++){
+                uint32_t triangle = adjacency[j];
+                if(used[triangle] || triangle == best) continue;
+
+                uint32_t cost = newVertices(triangle);
+                if(cost > bestCost) continue;
+
+                float distance = distanceToCluster(triangle);
+                if(cost < bestCost || distance < bestDistance || (distance == bestDistance && triangle < best)){
+                    best = triangle;
+                    bestCost = cost;
+                    bestDistance = distance;
+                }
+            }
+        }
+
+        if(best == ~0u){
+            while(used[cursor]) cursor++;
+            best = cursor;
+            bestCost = newVertices(best);
+        }
+
+        if(meshletVertices.size() + bestCost > MESHLET_MAX_VERTICES || meshletTriangles.size() / 3 + 1 > MESHLET_MAX_TRIANGLES){
+            flush();
+            bestCost = newVertices(best);
+        }
+
+        for(uint32_t k = 0; k < 3; k++){
+            uint32_t vertex = indices[best * 3 + k];
+            if(localIndex[vertex] == notInMeshlet){
+                localIndex[vertex] = static_cast<uint8_t>(meshletVertices.size());
+                meshletVertices.push_back(vertex);
+                centerSum += vertices[vertex].position;
+            }
+            meshletTriangles.push_back(localIndex[vertex]);
+        }
+        used[best] = 1;
+    }
+
+    if(!meshletTriangles.empty()){
+        flush();
+    }
+}
+
+/**
+ * @note CPU check that set covers exactly the triangles of indices: every triangle once, same winding, nothing extra, all limits respected
+ * @note Triangles are compared rotated so their smallest index comes first, which keeps the winding while ignoring where it starts
+*/
+static bool VerifyMeshlets(const MeshletSet& set, const uint32_t* indices, size_t indexCount){
+    using Triangle = std::array<uint32_t, 3>;
+    auto canonical = [](uint32_t a, uint32_t b, uint32_t c){
+        if(b < a && b <= c) return Triangle{b, c, a};
+        if(c < a && c < b) return Triangle{c, a, b};
+        return Triangle{a, b, c};
+    };
+
+    std::vector<Triangle> expected, produced;
+    expected.reserve(indexCount / 3);
+    for(size_t t = 0; t + 2 < indexCount; t += 3){
+        expected.push_back(canonical(indices[t], indices[t + 1], indices[t + 2]));
+    }
+
+    for(size_t m = 0; m < set.Count(); m++){
+        if(set.vertexCounts[m] > MESHLET_MAX_VERTICES || set.triangleCounts[m] > MESHLET_MAX_TRIANGLES ||
+           size_t(set.vertexOffsets[m]) + set.vertexCounts[m] > set.vertices.size() ||
+           size_t(set.triangleOffsets[m]) + set.triangleCounts[m] * 3 > set.triangles.size()){
+            printf("Meshlet %zu is out of bounds\n", m);
+            return false;
+        }
+
+        const uint32_t* local = set.vertices.data() + set.vertexOffsets[m];
+        const uint8_t* triangles = set.triangles.data() + set.triangleOffsets[m];
+        for(uint32_t t = 0; t < set.triangleCounts[m]; t++){
+            if(triangles[t * 3] >= set.vertexCounts[m] || triangles[t * 3 + 1] >= set.vertexCounts[m] || triangles[t * 3 + 2] >= set.vertexCounts[m]){
+                printf("Meshlet %zu references a vertex it does not own\n", m);
+                return false;
+            }
+            produced.push_back(canonical(local[triangles[t * 3]], local[triangles[t * 3 + 1]], local[triangles[t * 3 + 2]]));
+        }
+    }
+
+    std::sort(expected.begin(), expected.end());
+    std::sort(produced.begin(), produced.end());
+    if(expected != produced){
+        printf("Meshlets hold %zu triangles, the mesh has %zu (or the sets differ)\n", produced.size(), expected.size());
+        return false;
+    }
+    return true;
+}
+
+static MeshletStats ComputeMeshletStats(const MeshletSet& set){
+    MeshletStats stats;
+    stats.meshletCount = set.Count();
+    if(stats.meshletCount == 0) return stats;
+
+    std::vector<uint32_t> unique(set.vertices.begin(), set.vertices.end());
+    std::sort(unique.begin(), unique.end());
+    unique.erase(std::unique(unique.begin(), unique.end()), unique.end());
+
+    for(size_t m = 0; m < set.Count(); m++){
+        stats.triangleCount += set.triangleCounts[m];
+        stats.vertexReferences += set.vertexCounts[m];
+        if(set.triangleCounts[m] < MESHLET_MAX_TRIANGLES / 2) stats.underfilled++;
+    }
+
+    stats.averageVertexFill = float(stats.vertexReferences) / float(stats.meshletCount * MESHLET_MAX_VERTICES);
+    stats.averageTriangleFill = float(stats.triangleCount) / float(stats.meshletCount * MESHLET_MAX_TRIANGLES);
+    stats.vertexDuplication = float(stats.vertexReferences) / float(unique.size());
+    return stats;
+}
+
+static void PrintMeshletStats(const MeshletStats& stats){
+    printf("  %zu meshlets, %zu triangles | vertex fill %.1f%%, triangle fill %.1f%%, %zu under half full | vertex duplication %.2fx\n",
+           stats.meshletCount, stats.triangleCount, stats.averageVertexFill * 100.0f, stats.averageTriangleFill * 100.0f,
+           stats.underfilled, stats.vertexDuplication);
+}
+
+//! @note Frustum planes (xyz pointing inwards, w offset) from a clip matrix, pass projection * view * model to test in model space
+static void ExtractFrustumPlanes(const glm::mat4& clip, glm::vec4 planes[6]){
+    auto row = [&](int r){ return glm::vec4(clip[0][r], clip[1][r], clip[2][r], clip[3][r]); };
+    glm::vec4 x = row(0), y = row(1), z = row(2), w = row(3);
+    planes[0] = glm::vec4(w.x + x.x, w.y + x.y, w.z + x.z, w.w + x.w);
+    planes[1] = glm::vec4(w.x - x.x, w.y - x.y, w.z - x.z, w.w - x.w);
+    planes[2] = glm::vec4(w.x + y.x, w.y + y.y, w.z + y.z, w.w + y.w);
+    planes[3] = glm::vec4(w.x - y.x, w.y - y.y, w.z - y.z, w.w - y.w);
+    planes[4] = glm::vec4(w.x + z.x, w.y + z.y, w.z + z.z, w.w + z.w);
+    planes[5] = glm::vec4(w.x - z.x, w.y - z.y, w.z - z.z, w.w - z.w);
+
+    for(int i = 0; i < 6; i++){
+        float length = glm::length(glm::vec3(planes[i].x, planes[i].y, planes[i].z));
+        planes[i] = glm::vec4(planes[i].x / length, planes[i].y / length, planes[i].z / length, planes[i].w / length);
+    }
+}
+
+/**
+ * @note Writes the meshlets that may be visible into visible and returns how many there are
+ * @note A meshlet is dropped when its sphere is outside a frustum plane, or when the camera (model space) sits inside the backfacing side of its normal cone
+*/
+static size_t CullMeshlets(const MeshletSet& set, const glm::vec4 planes[6], const glm::vec3& cameraPosition, std::vector<uint32_t>& visible){
+    visible.clear();
+    for(size_t m = 0; m < set.Count(); m++){
+        const glm::vec4& sphere = set.boundingSpheres[m];
+        glm::vec3 center(sphere.x, sphere.y, sphere.z);
+
+        bool outside = false;
+        for(int i = 0; i < 6 && !outside; i++){
+            outside = glm::dot(glm::vec3(planes[i].x, planes[i].y, planes[i].z), center) + planes[i].w < -sphere.w;
+        }
+        if(outside) continue;
+
+        const glm::vec4& cone = set.normalCones[m];
+        glm::vec3 toCenter = center - cameraPosition;
+        if(glm::dot(toCenter, glm::vec3(cone.x, cone.y, cone.z)) >= cone.w * glm::length(toCenter) + sphere.w) continue;
+
+        visible.push_back(static_cast<uint32_t>(m));
+    }
+    return visible.size();
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <mutex>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <functional>
+
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+
+#include "MeshData.h"
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
+#include "ObjLoader.h"
+
+/**
+ * @param ModelStreaming
+ * @note Shared state of a Model that loads in the background (see the streaming Model constructor)
+ * @note A pool job parses the file (or opens the mesh cache), then one job per mesh builds its MeshData and flags it ready,
+ * @note while Model::updateStreaming() on the GL thread uploads ready meshes in their original order, a few per frame
+ * @note The jobs hold a reference to this state, so it stays alive even if the Model is destroyed halfway through loading
+*/
+
+struct ModelStreamProgress{
+    uint32_t residentMeshes = 0;
+    uint32_t totalMeshes = 0;       // 0 until the file has been parsed
+    double elapsedMilliseconds = 0.0;
+};
+
+struct ModelStreamCallbacks{
+    std::function<void(const ModelStreamProgress&)> onProgress; // after every update that made more meshes resident
+    std::function<void(double milliseconds)> onFirstFrame;      // the first mesh is resident, i.e. the first frame that shows part of the model
+    std::function<void(double milliseconds)> onFullyLoaded;     // every mesh resident and the texture loader (if any) idle
+};
+
+struct ModelStreamState{
+    std::string path;
+    ModelStreamCallbacks callbacks;
+    std::chrono::steady_clock::time_point start;
+
+    // written by the pool jobs, guarded by mutex
+    std::mutex mutex;
+    bool parsed = false;
+    bool failed = false;
+    std::string error;
+    uint32_t totalMeshes = 0;
+    std::vector<uint8_t> ready;
+
+    // written once before parsed is set (or per mesh before ready[i] is set), read-only afterwards
+    Assimp::Importer importer;
+    const aiScene* scene = nullptr;
+    std::vector<const aiMesh*> sceneMeshes;
+    ObjAsset obj;                   // parsed by ObjLoader.h instead of assimp when fromObj is set
+    bool fromObj = false;
+    MeshCacheReader cache;
+    bool fromCache = false;
+    uint64_t cacheKey = 0;
+    std::vector<std::string> dependencies; // files the import read besides path, stored with the mesh cache
+    std::vector<MeshData> meshData;
+    std::vector<MeshOptimizationReport> reports;
+
+    // GL thread only
+    uint32_t nextUpload = 0;
+    bool geometryFinished = false;
+    bool firstFrameReported = false;
+
+    double ElapsedMilliseconds() const{
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+};
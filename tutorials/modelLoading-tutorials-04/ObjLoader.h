@@ -0,0 +1,674 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cctype>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+
+#include "AssetPack.h"
+#include "MeshData.h"
+#include "ThreadPool.h"
+
+/**
+ * @param ObjLoader
+ * @note Wavefront OBJ/MTL reader that replaces assimp's OBJ importer for Model (see ModelLoadOptions::nativeObj)
+ * @note The mapped file is cut into line-aligned chunks that are parsed in parallel, each into its own v/vt/vn streams and face list,
+ * @note with a float parser that skips strtod for the common case (at most 19 significant digits, exponent within +-22)
+ * @note The streams are then concatenated, relative (negative) indices resolved, and every mesh builds indexed Vertex data straight
+ * @note from its (v, vt, vn) triplets, one Vertex per distinct triplet
+ * @note The meshes follow assimp's importer with aiProcess_Triangulate | aiProcess_FlipUVs: one mesh per object ('o' or 'g') and material,
+ * @note polygons fanned from their first corner (what assimp does for convex polygons), v flipped. Points, lines, smoothing groups
+ * @note and free-form geometry are skipped, and like the assimp path no normals or tangents are generated here (see MeshTangents.h).
+*/
+
+static constexpr size_t OBJ_MIN_CHUNK_BYTES = 256 * 1024;
+static constexpr int32_t OBJ_MISSING = INT32_MIN; // corner without a texture coordinate or normal
+
+struct ObjMaterial{
+    std::string name;
+    std::string diffuseMap;     // map_Kd
+    std::string specularMap;    // map_Ks
+    std::string normalMap;      // map_bump / bump, assimp reports it as aiTextureType_HEIGHT which Model loads as texture_normal
+    std::string ambientMap;     // map_Ka, assimp's aiTextureType_AMBIENT which Model loads as texture_height
+};
+
+struct ObjMesh{
+    std::string object;
+    int32_t material = -1;      // into ObjAsset::materials, -1 when the file never named one (or named an unknown one)
+    bool hasNormals = false;
+    bool hasTexCoords = false;
+    MeshData data;
+};
+
+struct ObjParseStats{
+    size_t bytes = 0;
+    uint32_t chunks = 0;
+    size_t positions = 0;
+    size_t texCoords = 0;
+    size_t normals = 0;
+    size_t faces = 0;
+    size_t skippedFaces = 0;    // points and lines
+    double parseMilliseconds = 0.0;     // chunks, in parallel
+    double mergeMilliseconds = 0.0;     // stream concatenation and index resolution
+    double buildMilliseconds = 0.0;     // indexed vertex data per mesh
+    double totalMilliseconds = 0.0;
+
+    double MegabytesPerSecond() const { return totalMilliseconds > 0.0 ? (bytes / (1024.0 * 1024.0)) / (totalMilliseconds / 1000.0) : 0.0; }
+};
+
+static const double OBJ_POWERS_OF_TEN[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+/**
+ * @note Parses a decimal float at c and returns where it ends
+ * @note Up to 19 significant digits are gathered into an integer, which is exact in a double below 2^53, and scaled by an exact power of ten
+ * @note (one correctly rounded multiply or divide). Anything else (more digits, large exponents, inf/nan) falls back to strtod.
+*/
+static const char* ParseObjFloat(const char* c, const char* end, float& out){
+    const char* start = c;
+    bool negative = false;
+    if(c < end && (*c == '-' || *c == '+')){
+        negative = *c == '-';
+        c++;
+    }
+
+    uint64_t mantissa = 0;
+    int32_t significantDigits = 0;
+    int32_t exponent = 0;
+    bool sawDigit = false;
+    bool truncated = false;
+
+    for(; c < end && static_cast<unsigned>(*c - '0') < 10; c++){
+        sawDigit = true;
+        if(significantDigits < 19){
+            mantissa = mantissa * 10 + static_cast<unsigned>(*c - '0');
+            if(mantissa != 0) significantDigits++;
+        }
+        else{
+            exponent++;
+            truncated = truncated || *c != '0';
+        }
+    }
+    if(c < end && *c == '.'){
+        c++;
+        for(; c < end && static_cast<unsigned>(*c - '0') < 10; c++){
+            sawDigit = true;
+            if(significantDigits < 19){
+                mantissa = mantissa * 10 + static_cast<unsigned>(*c - '0');
+                if(mantissa != 0) significantDigits++;
+                exponent--;
+            }
+            else{
+                truncated = truncated || *c != '0';
+            }
+        }
+    }
+
+    if(sawDigit && c < end && (*c == 'e' || *c == 'E')){
+        const char* e = c + 1;
+        bool negativeExponent = false;
+        if(e < end && (*e == '-' || *e == '+')){
+            negativeExponent = *e == '-';
+            e++;
+        }
+        if(e < end && static_cast<unsigned>(*e - '0') < 10){
+            int32_t value = 0;
+            for(; e < end && static_cast<unsigned>(*e - '0') < 10; e++){
+                if(value < 100000) value = value * 10 + (*e - '0');
+            }
+            exponent += negativeExponent ? -value : value;
+            c = e;
+        }
+    }
+
+    if(sawDigit && !truncated && mantissa < (1ull << 53) && exponent >= -22 && exponent <= 22){
+        double value = static_cast<double>(mantissa);
+        value = exponent < 0 ? value / OBJ_POWERS_OF_TEN[-exponent] : value * OBJ_POWERS_OF_TEN[exponent];
+        out = static_cast<float>(negative ? -value : value);
+        return c;
+    }
+
+    //! @note strtod needs a terminated string, copy the token out
+    const char* tokenEnd = start;
+    while(tokenEnd < end && *tokenEnd != ' ' && *tokenEnd != '\t' && *tokenEnd != '\r' && *tokenEnd != '\n') tokenEnd++;
+    std::string token(start, tokenEnd);
+    char* parsedEnd = nullptr;
+    out = static_cast<float>(std::strtod(token.c_str(), &parsedEnd));
+    return start + (parsedEnd - token.c_str());
+}
+
+class ObjAsset{
+public:
+    static bool IsObjPath(const std::string& path){
+        size_t dot = path.find_last_of('.');
+        if(dot == std::string::npos) return false;
+        std::string extension = path.substr(dot + 1);
+        for(char& c : extension) c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+        return extension == "obj";
+    }
+
+    //! @note Maps path and parses it, material libraries are looked up next to it. pool may be null (everything on this thread).
+    bool Load(const std::string& path, ThreadPool* pool, std::string& error){
+        AssetFile file(path);
+        if(!file.IsOpen()){
+            error = "could not open " + path;
+            return false;
+        }
+        return Parse(reinterpret_cast<const char*>(file.data), file.size, path.substr(0, path.find_last_of('/')), pool, error);
+    }
+
+    //! @note Parses text[0, size) (no terminator needed), an empty directory skips the material libraries
+    bool Parse(const char* text, size_t size, const std::string& directory, ThreadPool* pool, std::string& error){
+        auto start = std::chrono::steady_clock::now();
+        meshes.clear();
+        materials.clear();
+        libraries.clear();
+        stats = ObjParseStats();
+        stats.bytes = size;
+
+        //! @note Enough chunks to keep every worker busy, but not so small that per-chunk overhead shows
+        uint32_t workers = pool ? pool->ThreadCount() : 1;
+        size_t chunkBytes = std::max(OBJ_MIN_CHUNK_BYTES, size / (size_t(workers) * 4) + 1);
+        std::vector<size_t> boundaries{0};
+        while(boundaries.back() < size){
+            size_t next = std::min(size, boundaries.back() + chunkBytes);
+            const void* newline = next < size ? std::memchr(text + next, '\n', size - next) : nullptr;
+            next = newline ? static_cast<const char*>(newline) - text + 1 : size;
+            boundaries.push_back(next);
+        }
+
+        uint32_t chunkCount = static_cast<uint32_t>(boundaries.size() - 1);
+        std::vector<Chunk> chunks(chunkCount);
+        ForEach(pool, chunkCount, [&](uint32_t i){
+            ParseChunk(text + boundaries[i], text + boundaries[i + 1], chunks[i]);
+        });
+        stats.chunks = chunkCount;
+        auto parsed = std::chrono::steady_clock::now();
+
+        for(const Chunk& chunk : chunks){
+            if(!chunk.error.empty()){
+                error = chunk.error;
+                return false;
+            }
+        }
+
+        if(!MergeChunks(chunks, pool, error)) return false;
+        auto merged = std::chrono::steady_clock::now();
+
+        std::vector<MeshRanges> ranges = AssignMeshes(chunks, libraries);
+        if(!directory.empty()){
+            for(const std::string& library : libraries){
+                ParseMaterialLibrary(directory + "/" + library);
+            }
+        }
+        for(size_t i = 0; i < ranges.size(); i++){
+            meshes[i].material = FindMaterial(ranges[i].materialName);
+        }
+
+        ForEach(pool, static_cast<uint32_t>(meshes.size()), [&](uint32_t i){
+            BuildMesh(chunks, ranges[i], meshes[i]);
+        });
+        auto built = std::chrono::steady_clock::now();
+
+        auto milliseconds = [](auto from, auto to){ return std::chrono::duration<double, std::milli>(to - from).count(); };
+        stats.parseMilliseconds = milliseconds(start, parsed);
+        stats.mergeMilliseconds = milliseconds(parsed, merged);
+        stats.buildMilliseconds = milliseconds(merged, built);
+        stats.totalMilliseconds = milliseconds(start, built);
+        return true;
+    }
+
+    std::vector<ObjMesh> meshes;        // in file order, like the depth-first walk over assimp's nodes
+    std::vector<ObjMaterial> materials;
+    std::vector<std::string> libraries; // mtllib names as written in the file, relative to its directory
+    ObjParseStats stats;
+
+    // merged streams, kept after Parse for callers that want the raw data
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec2> texCoords;   // already flipped (1 - v)
+    std::vector<glm::vec3> normals;
+
+private:
+    struct Corner{
+        int32_t position = OBJ_MISSING;
+        int32_t texCoord = OBJ_MISSING;
+        int32_t normal = OBJ_MISSING;
+        uint8_t relative = 0;   // bit per component, set while the index is still relative to the chunk's own streams
+    };
+
+    enum class StatementType : uint8_t{ Object, Material, Library };
+
+    //! @note State changes are recorded with the number of faces the chunk had parsed before them, the merge replays them in order
+    struct Statement{
+        StatementType type;
+        uint32_t face;
+        std::string name;
+    };
+
+    struct Chunk{
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec2> texCoords;
+        std::vector<glm::vec3> normals;
+        std::vector<Corner> corners;
+        std::vector<uint32_t> faceStarts;   // first corner of every face, plus one past the last
+        std::vector<Statement> statements;
+        size_t skippedFaces = 0;
+        std::string error;
+
+        // where this chunk's streams start in the merged ones
+        size_t positionBase = 0, texCoordBase = 0, normalBase = 0;
+    };
+
+    //! @note Faces [faceBegin, faceEnd) of one chunk
+    struct FaceRange{
+        uint32_t chunk;
+        uint32_t faceBegin;
+        uint32_t faceEnd;
+    };
+
+    struct MeshRanges{
+        std::string materialName;
+        std::vector<FaceRange> ranges;
+        size_t faceCount = 0;
+    };
+
+    template<typename Function>
+    static void ForEach(ThreadPool* pool, uint32_t count, Function&& function){
+        if(!pool || count < 2){
+            for(uint32_t i = 0; i < count; i++) function(i);
+            return;
+        }
+        pool->ParallelFor(count, function);
+    }
+
+    static bool IsSpace(char c){ return c == ' ' || c == '\t' || c == '\r'; }
+
+    static const char* SkipSpaces(const char* c, const char* end){
+        while(c < end && IsSpace(*c)) c++;
+        return c;
+    }
+
+    static const char* LineEnd(const char* c, const char* end){
+        if(c >= end) return end;
+        const void* newline = std::memchr(c, '\n', end - c);
+        return newline ? static_cast<const char*>(newline) : end;
+    }
+
+    //! @note Rest of the line without surrounding whitespace (names may contain spaces)
+    static std::string RestOfLine(const char* c, const char* lineEnd){
+        c = SkipSpaces(c, lineEnd);
+        const char* last = lineEnd;
+        while(last > c && (IsSpace(last[-1]) || last[-1] == '\0')) last--;
+        return std::string(c, last);
+    }
+
+    static const char* ParseFloats(const char* c, const char* lineEnd, float* out, uint32_t count){
+        for(uint32_t i = 0; i < count; i++){
+            c = SkipSpaces(c, lineEnd);
+            out[i] = 0.0f;
+            if(c < lineEnd) c = ParseObjFloat(c, lineEnd, out[i]);
+        }
+        return c;
+    }
+
+    //! @note OBJ indices are 1-based, negative ones count back from the last element read so far
+    static const char* ParseIndex(const char* c, const char* end, size_t localCount, int32_t& out, uint8_t& relative, uint8_t bit){
+        bool negative = false;
+        if(c < end && *c == '-'){
+            negative = true;
+            c++;
+        }
+        if(c >= end || static_cast<unsigned>(*c - '0') >= 10) return c; // empty (v//vn), stays OBJ_MISSING
+
+        int64_t value = 0;
+        for(; c < end && static_cast<unsigned>(*c - '0') < 10; c++){
+            if(value < INT32_MAX) value = value * 10 + (*c - '0');
+        }
+
+        if(negative){
+            out = static_cast<int32_t>(static_cast<int64_t>(localCount) - value);
+            relative |= bit;
+        }
+        else{
+            out = static_cast<int32_t>(std::min<int64_t>(value - 1, INT32_MAX));
+        }
+        return c;
+    }
+
+    static void ParseChunk(const char* c, const char* end, Chunk& chunk){
+        while(c < end){
+            c = SkipSpaces(c, end);
+            const char* lineEnd = LineEnd(c, end);
+            size_t length = lineEnd - c;
+
+            if(length >= 2 && c[0] == 'v' && IsSpace(c[1])){
+                glm::vec3 position;
+                ParseFloats(c + 2, lineEnd, &position.x, 3);
+                chunk.positions.push_back(position);
+            }
+            else if(length >= 3 && c[0] == 'v' && c[1] == 't' && IsSpace(c[2])){
+                glm::vec2 texCoord;
+                ParseFloats(c + 3, lineEnd, &texCoord.x, 2);
+                texCoord.y = 1.0f - texCoord.y; // aiProcess_FlipUVs
+                chunk.texCoords.push_back(texCoord);
+            }
+            else if(length >= 3 && c[0] == 'v' && c[1] == 'n' && IsSpace(c[2])){
+                glm::vec3 normal;
+                ParseFloats(c + 3, lineEnd, &normal.x, 3);
+                chunk.normals.push_back(normal);
+            }
+            else if(length >= 2 && c[0] == 'f' && IsSpace(c[1])){
+                uint32_t first = static_cast<uint32_t>(chunk.corners.size());
+                const char* p = c + 2;
+                while(true){
+                    p = SkipSpaces(p, lineEnd);
+                    if(p >= lineEnd) break;
+
+                    Corner corner;
+                    const char* tokenStart = p;
+                    p = ParseIndex(p, lineEnd, chunk.positions.size(), corner.position, corner.relative, 1);
+                    if(p < lineEnd && *p == '/'){
+                        p = ParseIndex(p + 1, lineEnd, chunk.texCoords.size(), corner.texCoord, corner.relative, 2);
+                        if(p < lineEnd && *p == '/'){
+                            p = ParseIndex(p + 1, lineEnd, chunk.normals.size(), corner.normal, corner.relative, 4);
+                        }
+                    }
+                    if(p == tokenStart || corner.position == OBJ_MISSING){
+                        chunk.error = "malformed face '" + RestOfLine(c, lineEnd) + "'";
+                        return;
+                    }
+                    while(p < lineEnd && !IsSpace(*p)) p++;
+                    chunk.corners.push_back(corner);
+                }
+
+                if(chunk.corners.size() - first < 3){
+                    chunk.corners.resize(first);
+                    chunk.skippedFaces++;
+                }
+                else{
+                    chunk.faceStarts.push_back(first);
+                }
+            }
+            else if(length >= 2 && (c[0] == 'o' || c[0] == 'g') && IsSpace(c[1])){
+                chunk.statements.push_back({StatementType::Object, static_cast<uint32_t>(chunk.faceStarts.size()), RestOfLine(c + 2, lineEnd)});
+            }
+            else if(length >= 7 && std::memcmp(c, "usemtl", 6) == 0 && IsSpace(c[6])){
+                chunk.statements.push_back({StatementType::Material, static_cast<uint32_t>(chunk.faceStarts.size()), RestOfLine(c + 7, lineEnd)});
+            }
+            else if(length >= 7 && std::memcmp(c, "mtllib", 6) == 0 && IsSpace(c[6])){
+                chunk.statements.push_back({StatementType::Library, static_cast<uint32_t>(chunk.faceStarts.size()), RestOfLine(c + 7, lineEnd)});
+            }
+            else if(length >= 2 && (c[0] == 'l' || c[0] == 'p') && IsSpace(c[1])){
+                chunk.skippedFaces++;
+            }
+
+            c = lineEnd + (lineEnd < end ? 1 : 0);
+        }
+        chunk.faceStarts.push_back(static_cast<uint32_t>(chunk.corners.size()));
+    }
+
+    //! @note Concatenates the chunk streams (each chunk copies its own part) and turns every corner into an absolute index
+    bool MergeChunks(std::vector<Chunk>& chunks, ThreadPool* pool, std::string& error){
+        size_t positionCount = 0, texCoordCount = 0, normalCount = 0;
+        for(Chunk& chunk : chunks){
+            chunk.positionBase = positionCount;
+            chunk.texCoordBase = texCoordCount;
+            chunk.normalBase = normalCount;
+            positionCount += chunk.positions.size();
+            texCoordCount += chunk.texCoords.size();
+            normalCount += chunk.normals.size();
+            stats.faces += chunk.faceStarts.size() - 1;
+            stats.skippedFaces += chunk.skippedFaces;
+        }
+        stats.positions = positionCount;
+        stats.texCoords = texCoordCount;
+        stats.normals = normalCount;
+
+        positions.resize(positionCount);
+        texCoords.resize(texCoordCount);
+        normals.resize(normalCount);
+
+        std::vector<uint8_t> invalid(chunks.size(), 0);
+        ForEach(pool, static_cast<uint32_t>(chunks.size()), [&](uint32_t i){
+            Chunk& chunk = chunks[i];
+            std::copy(chunk.positions.begin(), chunk.positions.end(), positions.begin() + chunk.positionBase);
+            std::copy(chunk.texCoords.begin(), chunk.texCoords.end(), texCoords.begin() + chunk.texCoordBase);
+            std::copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + chunk.normalBase);
+            std::vector<glm::vec3>().swap(chunk.positions);
+            std::vector<glm::vec2>().swap(chunk.texCoords);
+            std::vector<glm::vec3>().swap(chunk.normals);
+
+            auto resolve = [&](int32_t& index, bool relative, size_t base, size_t count){
+                if(index == OBJ_MISSING){
+                    index = -1;
+                    return;
+                }
+                int64_t absolute = relative ? static_cast<int64_t>(base) + index : index;
+                if(absolute < 0 || absolute >= static_cast<int64_t>(count)){
+                    invalid[i] = 1;
+                    absolute = 0;
+                }
+                index = static_cast<int32_t>(absolute);
+            };
+            for(Corner& corner : chunk.corners){
+                resolve(corner.position, corner.relative & 1, chunk.positionBase, positionCount);
+                resolve(corner.texCoord, corner.relative & 2, chunk.texCoordBase, texCoordCount);
+                resolve(corner.normal, corner.relative & 4, chunk.normalBase, normalCount);
+            }
+        });
+
+        for(uint8_t bad : invalid){
+            if(bad){
+                error = "face index out of range";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @note Replays the o/g/usemtl statements in file order to split the faces into meshes the way assimp does:
+     * @note a new object always starts a new mesh (keeping the current material), usemtl only starts one when the current mesh
+     * @note already has faces and the material actually changes. Meshes that end up without faces are dropped.
+    */
+    std::vector<MeshRanges> AssignMeshes(const std::vector<Chunk>& chunks, std::vector<std::string>& libraries){
+        std::vector<MeshRanges> ranges;
+        std::vector<std::string> objects;
+        std::string objectName = "defaultobject";
+        std::string materialName;
+
+        auto current = [&]() -> MeshRanges& {
+            if(ranges.empty()){
+                ranges.push_back({materialName, {}, 0});
+                objects.push_back(objectName);
+            }
+            return ranges.back();
+        };
+        auto addFaces = [&](uint32_t chunk, uint32_t begin, uint32_t end){
+            if(begin >= end) return;
+            MeshRanges& mesh = current();
+            mesh.ranges.push_back({chunk, begin, end});
+            mesh.faceCount += end - begin;
+        };
+
+        for(uint32_t c = 0; c < chunks.size(); c++){
+            const Chunk& chunk = chunks[c];
+            uint32_t cursor = 0;
+            for(const Statement& statement : chunk.statements){
+                addFaces(c, cursor, statement.face);
+                cursor = statement.face;
+
+                switch(statement.type){
+                    case StatementType::Object:
+                        objectName = statement.name;
+                        ranges.push_back({materialName, {}, 0});
+                        objects.push_back(objectName);
+                        break;
+                    case StatementType::Material:
+                        if(statement.name != materialName){
+                            materialName = statement.name;
+                            if(!ranges.empty() && ranges.back().faceCount > 0){
+                                ranges.push_back({materialName, {}, 0});
+                                objects.push_back(objectName);
+                            }
+                            else{
+                                current().materialName = materialName;
+                            }
+                        }
+                        break;
+                    case StatementType::Library:{
+                        //! @note Several libraries may share one line
+                        const std::string& line = statement.name;
+                        size_t begin = 0;
+                        while(begin < line.size()){
+                            size_t end = line.find_first_of(" \t", begin);
+                            if(end == std::string::npos) end = line.size();
+                            std::string library = line.substr(begin, end - begin);
+                            if(!library.empty() && std::find(libraries.begin(), libraries.end(), library) == libraries.end()){
+                                libraries.push_back(library);
+                            }
+                            begin = end + 1;
+                        }
+                        break;
+                    }
+                }
+            }
+            addFaces(c, cursor, static_cast<uint32_t>(chunk.faceStarts.size() - 1));
+        }
+
+        std::vector<MeshRanges> kept;
+        for(size_t i = 0; i < ranges.size(); i++){
+            if(ranges[i].faceCount == 0) continue;
+            ObjMesh mesh;
+            mesh.object = objects[i];
+            meshes.push_back(std::move(mesh));
+            kept.push_back(std::move(ranges[i]));
+        }
+        return kept;
+    }
+
+    //! @note One Vertex per distinct (v, vt, vn) triplet in first-use order, found through an open addressing table
+    void BuildMesh(const std::vector<Chunk>& chunks, const MeshRanges& mesh, ObjMesh& out) const{
+        size_t cornerCount = 0, triangleCount = 0;
+        for(const FaceRange& range : mesh.ranges){
+            const Chunk& chunk = chunks[range.chunk];
+            cornerCount += chunk.faceStarts[range.faceEnd] - chunk.faceStarts[range.faceBegin];
+            triangleCount += chunk.faceStarts[range.faceEnd] - chunk.faceStarts[range.faceBegin] - 2 * size_t(range.faceEnd - range.faceBegin);
+        }
+
+        size_t capacity = 1;
+        while(capacity < cornerCount * 2) capacity <<= 1;
+        const uint32_t empty = ~0u;
+        std::vector<uint32_t> table(capacity, empty);
+        std::vector<const Corner*> sources; // corner each vertex came from
+        sources.reserve(cornerCount);
+
+        std::vector<uint32_t>& indices = out.data.indices;
+        indices.reserve(triangleCount * 3);
+
+        auto vertexFor = [&](const Corner& corner) -> uint32_t{
+            uint32_t hash = (static_cast<uint32_t>(corner.position) * 0x9e3779b1u) ^ (static_cast<uint32_t>(corner.texCoord) * 0x85ebca77u) ^ (static_cast<uint32_t>(corner.normal) * 0xc2b2ae3du);
+            hash ^= hash >> 15;
+            size_t slot = hash & (capacity - 1);
+            while(true){
+                uint32_t entry = table[slot];
+                if(entry == empty){
+                    entry = static_cast<uint32_t>(sources.size());
+                    table[slot] = entry;
+                    sources.push_back(&corner);
+                    return entry;
+                }
+                const Corner& other = *sources[entry];
+                if(other.position == corner.position && other.texCoord == corner.texCoord && other.normal == corner.normal){
+                    return entry;
+                }
+                slot = (slot + 1) & (capacity - 1);
+            }
+        };
+
+        std::vector<uint32_t> faceVertices;
+        for(const FaceRange& range : mesh.ranges){
+            const Chunk& chunk = chunks[range.chunk];
+            for(uint32_t face = range.faceBegin; face < range.faceEnd; face++){
+                faceVertices.clear();
+                for(uint32_t c = chunk.faceStarts[face]; c < chunk.faceStarts[face + 1]; c++){
+                    faceVertices.push_back(vertexFor(chunk.corners[c]));
+                }
+                for(size_t k = 1; k + 1 < faceVertices.size(); k++){
+                    indices.push_back(faceVertices[0]);
+                    indices.push_back(faceVertices[k]);
+                    indices.push_back(faceVertices[k + 1]);
+                }
+            }
+        }
+
+        std::vector<Vertex>& vertices = out.data.vertices;
+        vertices.resize(sources.size());
+        for(size_t i = 0; i < sources.size(); i++){
+            const Corner& corner = *sources[i];
+            Vertex vertex{};
+            vertex.position = positions[corner.position];
+            if(corner.normal >= 0){
+                vertex.normal = normals[corner.normal];
+                out.hasNormals = true;
+            }
+            if(corner.texCoord >= 0){
+                vertex.TexCoords = texCoords[corner.texCoord];
+                out.hasTexCoords = true;
+            }
+            vertices[i] = vertex;
+        }
+    }
+
+    //! @note The last token of a map_* line is the file, anything before it is an option (-bm 1.0, -clamp on, ...)
+    static std::string TextureFile(const std::string& value){
+        size_t last = value.find_last_of(" \t");
+        return last == std::string::npos ? value : value.substr(last + 1);
+    }
+
+    void ParseMaterialLibrary(const std::string& path){
+        AssetFile file(path);
+        if(!file.IsOpen()){
+            printf("OBJ: could not open material library %s\n", path.c_str());
+            return;
+        }
+
+        const char* c = reinterpret_cast<const char*>(file.data);
+        const char* end = c + file.size;
+        while(c < end){
+            c = SkipSpaces(c, end);
+            const char* lineEnd = LineEnd(c, end);
+
+            const char* keyEnd = c;
+            while(keyEnd < lineEnd && !IsSpace(*keyEnd)) keyEnd++;
+            std::string key(c, keyEnd);
+            std::string value = RestOfLine(keyEnd, lineEnd);
+
+            if(key == "newmtl"){
+                materials.push_back({value, "", "", "", ""});
+            }
+            else if(!materials.empty()){
+                ObjMaterial& material = materials.back();
+                if(key == "map_Kd") material.diffuseMap = TextureFile(value);
+                else if(key == "map_Ks") material.specularMap = TextureFile(value);
+                else if(key == "map_Ka") material.ambientMap = TextureFile(value);
+                else if(key == "map_bump" || key == "map_Bump" || key == "bump") material.normalMap = TextureFile(value);
+            }
+
+            c = lineEnd + (lineEnd < end ? 1 : 0);
+        }
+    }
+
+    int32_t FindMaterial(const std::string& name) const{
+        for(size_t i = 0; i < materials.size(); i++){
+            if(materials[i].name == name) return static_cast<int32_t>(i);
+        }
+        return -1;
+    }
+};
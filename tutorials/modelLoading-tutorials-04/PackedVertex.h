@@ -0,0 +1,369 @@
+#pragma once
+#include <cmath>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+
+#include "MeshData.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PACKED_VERTEX_SSE2 1
+#endif
+
+/**
+ * @param PackedVertex
+ * @note Compact 20 byte alternative to the 56 byte Vertex, holding everything the model shaders need
+ * @note position   -> 3 x unorm16, relative to the mesh bounds (decoded with the positionMin/positionExtent uniforms)
+ * @note normal     -> 2 x snorm16, octahedral encoding of the unit vector
+ * @note uv         -> 2 x unorm16, relative to the mesh uv bounds (so tiled uvs outside [0, 1] still work)
+ * @note tangent    -> 2 x snorm16 octahedral + the bitangent's handedness as a sign, the bitangent is rebuilt as cross(normal, tangent) * sign
+ *
+ * @note Packing and unpacking go through SSE2 four vertices at a time (Vertex arrays are transposed into x/y/z lanes),
+ * @note with a scalar path for the remainder and for non x86 targets
+*/
+
+struct PackedVertex{
+    uint16_t position[3];
+    int16_t bitangentSign;  // +32767 or -32767, read as its own normalized attribute
+    int16_t normal[2];
+    uint16_t uv[2];
+    int16_t tangent[2];
+};
+static_assert(sizeof(PackedVertex) == 20, "PackedVertex is meant to stay 20 bytes");
+
+//! @note Dequantization parameters for one mesh, value = min + normalized * extent
+struct PackedMeshBounds{
+    glm::vec3 positionMin = glm::vec3(0.0f);
+    glm::vec3 positionExtent = glm::vec3(0.0f);
+    glm::vec2 uvMin = glm::vec2(0.0f);
+    glm::vec2 uvExtent = glm::vec2(0.0f);
+};
+
+struct PackedVertexError{
+    float maxPosition = 0.0f;   // in model units
+    float maxNormalDegrees = 0.0f;
+    float maxTangentDegrees = 0.0f;
+    float maxUV = 0.0f;
+    double sumPosition = 0.0;
+    double sumNormalDegrees = 0.0;
+    size_t vertexCount = 0;
+};
+
+static PackedMeshBounds ComputePackedBounds(const Vertex* vertices, size_t count){
+    PackedMeshBounds bounds;
+    if(count == 0) return bounds;
+
+    glm::vec3 positionMin = vertices[0].position, positionMax = vertices[0].position;
+    glm::vec2 uvMin = vertices[0].TexCoords, uvMax = vertices[0].TexCoords;
+    for(size_t i = 1; i < count; i++){
+        positionMin = glm::min(positionMin, vertices[i].position);
+        positionMax = glm::max(positionMax, vertices[i].position);
+        uvMin = glm::min(uvMin, vertices[i].TexCoords);
+        uvMax = glm::max(uvMax, vertices[i].TexCoords);
+    }
+
+    bounds.positionMin = positionMin;
+    bounds.positionExtent = positionMax - positionMin;
+    bounds.uvMin = uvMin;
+    bounds.uvExtent = uvMax - uvMin;
+    return bounds;
+}
+
+static float QuantizeScale(float extent){
+    return extent > 0.0f ? 65535.0f / extent : 0.0f;
+}
+
+static uint16_t QuantizeUnorm16(float value, float minimum, float scale){
+    float q = std::nearbyint((value - minimum) * scale);
+    return static_cast<uint16_t>(std::clamp(q, 0.0f, 65535.0f));
+}
+
+static int16_t QuantizeSnorm16(float value){
+    float q = std::nearbyint(value * 32767.0f);
+    return static_cast<int16_t>(std::clamp(q, -32767.0f, 32767.0f));
+}
+
+static glm::vec2 OctahedralEncode(glm::vec3 n){
+    float l1 = std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z);
+    if(l1 == 0.0f) return glm::vec2(0.0f, 0.0f);
+
+    float inverse = 1.0f / l1;
+    float x = n.x * inverse, y = n.y * inverse;
+    if(n.z < 0.0f){
+        float ox = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        float oy = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = ox;
+        y = oy;
+    }
+    return glm::vec2(x, y);
+}
+
+static glm::vec3 OctahedralDecode(glm::vec2 e){
+    glm::vec3 n(e.x, e.y, 1.0f - std::fabs(e.x) - std::fabs(e.y));
+    float t = std::max(-n.z, 0.0f);
+    n.x += n.x >= 0.0f ? -t : t;
+    n.y += n.y >= 0.0f ? -t : t;
+    return glm::normalize(n);
+}
+
+static float BitangentSign(const Vertex& vertex){
+    return glm::dot(glm::cross(vertex.normal, vertex.Tangent), vertex.BitTangent) < 0.0f ? -1.0f : 1.0f;
+}
+
+static void PackVertexScalar(const Vertex& vertex, const PackedMeshBounds& bounds, const glm::vec3& positionScale, const glm::vec2& uvScale, PackedVertex& out){
+    for(int c = 0; c < 3; c++){
+        out.position[c] = QuantizeUnorm16(vertex.position[c], bounds.positionMin[c], positionScale[c]);
+    }
+    out.bitangentSign = BitangentSign(vertex) < 0.0f ? -32767 : 32767;
+
+    glm::vec2 normal = OctahedralEncode(vertex.normal);
+    out.normal[0] = QuantizeSnorm16(normal.x);
+    out.normal[1] = QuantizeSnorm16(normal.y);
+
+    out.uv[0] = QuantizeUnorm16(vertex.TexCoords.x, bounds.uvMin.x, uvScale.x);
+    out.uv[1] = QuantizeUnorm16(vertex.TexCoords.y, bounds.uvMin.y, uvScale.y);
+
+    glm::vec2 tangent = OctahedralEncode(vertex.Tangent);
+    out.tangent[0] = QuantizeSnorm16(tangent.x);
+    out.tangent[1] = QuantizeSnorm16(tangent.y);
+}
+
+static Vertex UnpackVertexScalar(const PackedVertex& packed, const PackedMeshBounds& bounds){
+    Vertex vertex;
+    for(int c = 0; c < 3; c++){
+        vertex.position[c] = bounds.positionMin[c] + (packed.position[c] / 65535.0f) * bounds.positionExtent[c];
+    }
+    vertex.normal = OctahedralDecode(glm::vec2(std::max(packed.normal[0] / 32767.0f, -1.0f), std::max(packed.normal[1] / 32767.0f, -1.0f)));
+    vertex.TexCoords.x = bounds.uvMin.x + (packed.uv[0] / 65535.0f) * bounds.uvExtent.x;
+    vertex.TexCoords.y = bounds.uvMin.y + (packed.uv[1] / 65535.0f) * bounds.uvExtent.y;
+    vertex.Tangent = OctahedralDecode(glm::vec2(std::max(packed.tangent[0] / 32767.0f, -1.0f), std::max(packed.tangent[1] / 32767.0f, -1.0f)));
+    vertex.BitTangent = glm::cross(vertex.normal, vertex.Tangent) * (packed.bitangentSign < 0 ? -1.0f : 1.0f);
+    return vertex;
+}
+
+#ifdef PACKED_VERTEX_SSE2
+//! @note Loads 4 floats starting at memberOffset from four consecutive vertices and transposes them, so a holds the first float of every vertex, b the second, ...
+//! @note Every load reads 16 bytes, so memberOffset + 16 must stay inside Vertex
+static void LoadLanes4(const Vertex* vertices, size_t memberOffset, __m128& a, __m128& b, __m128& c, __m128& d){
+    static_assert(offsetof(Vertex, BitTangent) + sizeof(glm::vec3) == sizeof(Vertex), "the lane loads below assume BitTangent is the last member");
+    const char* base = reinterpret_cast<const char*>(vertices) + memberOffset;
+    a = _mm_loadu_ps(reinterpret_cast<const float*>(base));
+    b = _mm_loadu_ps(reinterpret_cast<const float*>(base + sizeof(Vertex)));
+    c = _mm_loadu_ps(reinterpret_cast<const float*>(base + 2 * sizeof(Vertex)));
+    d = _mm_loadu_ps(reinterpret_cast<const float*>(base + 3 * sizeof(Vertex)));
+    _MM_TRANSPOSE4_PS(a, b, c, d);
+}
+
+static __m128 Abs4(__m128 v){
+    return _mm_andnot_ps(_mm_set1_ps(-0.0f), v);
+}
+
+//! @note +1 or -1 per lane, +1 for +0.0 like the scalar path
+static __m128 SignNotZero4(__m128 v){
+    __m128 negative = _mm_cmplt_ps(v, _mm_setzero_ps());
+    return _mm_or_ps(_mm_and_ps(negative, _mm_set1_ps(-1.0f)), _mm_andnot_ps(negative, _mm_set1_ps(1.0f)));
+}
+
+static __m128 Select4(__m128 mask, __m128 a, __m128 b){
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+static void OctahedralEncode4(__m128 x, __m128 y, __m128 z, __m128& outX, __m128& outY){
+    __m128 l1 = _mm_add_ps(_mm_add_ps(Abs4(x), Abs4(y)), Abs4(z));
+    __m128 nonZero = _mm_cmpgt_ps(l1, _mm_setzero_ps());
+    __m128 inverse = _mm_and_ps(nonZero, _mm_div_ps(_mm_set1_ps(1.0f), _mm_or_ps(l1, _mm_andnot_ps(nonZero, _mm_set1_ps(1.0f)))));
+    __m128 px = _mm_mul_ps(x, inverse);
+    __m128 py = _mm_mul_ps(y, inverse);
+
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 foldedX = _mm_mul_ps(_mm_sub_ps(one, Abs4(py)), SignNotZero4(px));
+    __m128 foldedY = _mm_mul_ps(_mm_sub_ps(one, Abs4(px)), SignNotZero4(py));
+    __m128 lowerHemisphere = _mm_cmplt_ps(z, _mm_setzero_ps());
+
+    outX = Select4(lowerHemisphere, foldedX, px);
+    outY = Select4(lowerHemisphere, foldedY, py);
+}
+
+static __m128i QuantizeSnorm16x4(__m128 v){
+    __m128 clamped = _mm_max_ps(_mm_min_ps(_mm_mul_ps(v, _mm_set1_ps(32767.0f)), _mm_set1_ps(32767.0f)), _mm_set1_ps(-32767.0f));
+    return _mm_cvtps_epi32(clamped);
+}
+
+static __m128i QuantizeUnorm16x4(__m128 v, float minimum, float scale){
+    __m128 q = _mm_mul_ps(_mm_sub_ps(v, _mm_set1_ps(minimum)), _mm_set1_ps(scale));
+    q = _mm_max_ps(_mm_min_ps(q, _mm_set1_ps(65535.0f)), _mm_setzero_ps());
+    return _mm_cvtps_epi32(q);
+}
+
+static void OctahedralDecode4(__m128 ex, __m128 ey, __m128& x, __m128& y, __m128& z){
+    x = ex;
+    y = ey;
+    z = _mm_sub_ps(_mm_sub_ps(_mm_set1_ps(1.0f), Abs4(ex)), Abs4(ey));
+    __m128 t = _mm_max_ps(_mm_sub_ps(_mm_setzero_ps(), z), _mm_setzero_ps());
+    x = _mm_sub_ps(x, _mm_mul_ps(t, SignNotZero4(x)));
+    y = _mm_sub_ps(y, _mm_mul_ps(t, SignNotZero4(y)));
+
+    __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+    __m128 inverse = _mm_div_ps(_mm_set1_ps(1.0f), length);
+    x = _mm_mul_ps(x, inverse);
+    y = _mm_mul_ps(y, inverse);
+    z = _mm_mul_ps(z, inverse);
+}
+#endif
+
+//! @note Packs count vertices into out (which must hold count elements), returns the bounds needed to decode them
+static PackedMeshBounds PackVertices(const Vertex* vertices, size_t count, PackedVertex* out){
+    PackedMeshBounds bounds = ComputePackedBounds(vertices, count);
+    glm::vec3 positionScale(QuantizeScale(bounds.positionExtent.x), QuantizeScale(bounds.positionExtent.y), QuantizeScale(bounds.positionExtent.z));
+    glm::vec2 uvScale(QuantizeScale(bounds.uvExtent.x), QuantizeScale(bounds.uvExtent.y));
+
+    size_t i = 0;
+#ifdef PACKED_VERTEX_SSE2
+    alignas(16) int32_t lanes[10][4];
+    for(; i + 4 <= count; i += 4){
+        const Vertex* batch = vertices + i;
+        __m128 px, py, pz, nx, ny, nz, tx, ty, tz, bx, by, bz, u, v, unused, unused2;
+        LoadLanes4(batch, offsetof(Vertex, position), px, py, pz, unused);
+        LoadLanes4(batch, offsetof(Vertex, normal), nx, ny, nz, unused);
+        LoadLanes4(batch, offsetof(Vertex, TexCoords), u, v, unused, unused2);
+        LoadLanes4(batch, offsetof(Vertex, Tangent), tx, ty, tz, unused);
+        //! @note BitTangent is the last member, so it is read starting one float early (at Tangent.z) to stay inside the vertex
+        LoadLanes4(batch, offsetof(Vertex, BitTangent) - sizeof(float), unused, bx, by, bz);
+
+        //! @note Handedness: sign(dot(cross(n, t), b))
+        __m128 cx = _mm_sub_ps(_mm_mul_ps(ny, tz), _mm_mul_ps(nz, ty));
+        __m128 cy = _mm_sub_ps(_mm_mul_ps(nz, tx), _mm_mul_ps(nx, tz));
+        __m128 cz = _mm_sub_ps(_mm_mul_ps(nx, ty), _mm_mul_ps(ny, tx));
+        __m128 handedness = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, bx), _mm_mul_ps(cy, by)), _mm_mul_ps(cz, bz));
+        __m128i sign = _mm_cvtps_epi32(_mm_mul_ps(SignNotZero4(handedness), _mm_set1_ps(32767.0f)));
+
+        __m128 onx, ony, otx, oty;
+        OctahedralEncode4(nx, ny, nz, onx, ony);
+        OctahedralEncode4(tx, ty, tz, otx, oty);
+
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes[0]), QuantizeUnorm16x4(px, bounds.positionMin.x, positionScale.x));
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes[1]), QuantizeUnorm16x4(py, bounds.positionMin.y, positionScale.y));
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes[2]), QuantizeUnorm16x4(pz, bounds.positionMin.z, positionScale.z));
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes[3]), sign);
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes[4]), QuantizeSnorm16x4(onx));
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes[5]), QuantizeSnorm16x4(ony));
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes[6]), QuantizeUnorm16x4(u, bounds.uvMin.x, uvScale.x));
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes[7]), QuantizeUnorm16x4(v, bounds.uvMin.y, uvScale.y));
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes[8]), QuantizeSnorm16x4(otx));
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes[9]), QuantizeSnorm16x4(oty));
+
+        for(int k = 0; k < 4; k++){
+            PackedVertex& packed = out[i + k];
+            packed.position[0] = static_cast<uint16_t>(lanes[0][k]);
+            packed.position[1] = static_cast<uint16_t>(lanes[1][k]);
+            packed.position[2] = static_cast<uint16_t>(lanes[2][k]);
+            packed.bitangentSign = static_cast<int16_t>(lanes[3][k]);
+            packed.normal[0] = static_cast<int16_t>(lanes[4][k]);
+            packed.normal[1] = static_cast<int16_t>(lanes[5][k]);
+            packed.uv[0] = static_cast<uint16_t>(lanes[6][k]);
+            packed.uv[1] = static_cast<uint16_t>(lanes[7][k]);
+            packed.tangent[0] = static_cast<int16_t>(lanes[8][k]);
+            packed.tangent[1] = static_cast<int16_t>(lanes[9][k]);
+        }
+    }
+#endif
+    for(; i < count; i++){
+        PackVertexScalar(vertices[i], bounds, positionScale, uvScale, out[i]);
+    }
+    return bounds;
+}
+
+//! @note CPU-side decode, the shader does the same math (see modelPacked.vert). Used to measure the quantization error.
+static void UnpackVertices(const PackedVertex* packed, size_t count, const PackedMeshBounds& bounds, Vertex* out){
+    size_t i = 0;
+#ifdef PACKED_VERTEX_SSE2
+    const __m128 unorm = _mm_set1_ps(1.0f / 65535.0f);
+    const __m128 snorm = _mm_set1_ps(1.0f / 32767.0f);
+    const __m128 minusOne = _mm_set1_ps(-1.0f);
+
+    auto gather = [&](size_t base, auto member){
+        return _mm_cvtepi32_ps(_mm_set_epi32(member(packed[base + 3]), member(packed[base + 2]), member(packed[base + 1]), member(packed[base])));
+    };
+
+    alignas(16) float lanes[14][4];
+    for(; i + 4 <= count; i += 4){
+        __m128 qx = gather(i, [](const PackedVertex& p){ return int(p.position[0]); });
+        __m128 qy = gather(i, [](const PackedVertex& p){ return int(p.position[1]); });
+        __m128 qz = gather(i, [](const PackedVertex& p){ return int(p.position[2]); });
+        __m128 qu = gather(i, [](const PackedVertex& p){ return int(p.uv[0]); });
+        __m128 qv = gather(i, [](const PackedVertex& p){ return int(p.uv[1]); });
+        __m128 enx = _mm_max_ps(_mm_mul_ps(gather(i, [](const PackedVertex& p){ return int(p.normal[0]); }), snorm), minusOne);
+        __m128 eny = _mm_max_ps(_mm_mul_ps(gather(i, [](const PackedVertex& p){ return int(p.normal[1]); }), snorm), minusOne);
+        __m128 etx = _mm_max_ps(_mm_mul_ps(gather(i, [](const PackedVertex& p){ return int(p.tangent[0]); }), snorm), minusOne);
+        __m128 ety = _mm_max_ps(_mm_mul_ps(gather(i, [](const PackedVertex& p){ return int(p.tangent[1]); }), snorm), minusOne);
+
+        _mm_store_ps(lanes[0], _mm_add_ps(_mm_set1_ps(bounds.positionMin.x), _mm_mul_ps(_mm_mul_ps(qx, unorm), _mm_set1_ps(bounds.positionExtent.x))));
+        _mm_store_ps(lanes[1], _mm_add_ps(_mm_set1_ps(bounds.positionMin.y), _mm_mul_ps(_mm_mul_ps(qy, unorm), _mm_set1_ps(bounds.positionExtent.y))));
+        _mm_store_ps(lanes[2], _mm_add_ps(_mm_set1_ps(bounds.positionMin.z), _mm_mul_ps(_mm_mul_ps(qz, unorm), _mm_set1_ps(bounds.positionExtent.z))));
+        _mm_store_ps(lanes[3], _mm_add_ps(_mm_set1_ps(bounds.uvMin.x), _mm_mul_ps(_mm_mul_ps(qu, unorm), _mm_set1_ps(bounds.uvExtent.x))));
+        _mm_store_ps(lanes[4], _mm_add_ps(_mm_set1_ps(bounds.uvMin.y), _mm_mul_ps(_mm_mul_ps(qv, unorm), _mm_set1_ps(bounds.uvExtent.y))));
+
+        __m128 nx, ny, nz, tx, ty, tz;
+        OctahedralDecode4(enx, eny, nx, ny, nz);
+        OctahedralDecode4(etx, ety, tx, ty, tz);
+        _mm_store_ps(lanes[5], nx);
+        _mm_store_ps(lanes[6], ny);
+        _mm_store_ps(lanes[7], nz);
+        _mm_store_ps(lanes[8], tx);
+        _mm_store_ps(lanes[9], ty);
+        _mm_store_ps(lanes[10], tz);
+
+        __m128 sign = SignNotZero4(gather(i, [](const PackedVertex& p){ return int(p.bitangentSign); }));
+        _mm_store_ps(lanes[11], _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(ny, tz), _mm_mul_ps(nz, ty)), sign));
+        _mm_store_ps(lanes[12], _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(nz, tx), _mm_mul_ps(nx, tz)), sign));
+        _mm_store_ps(lanes[13], _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(nx, ty), _mm_mul_ps(ny, tx)), sign));
+
+        for(int k = 0; k < 4; k++){
+            Vertex& vertex = out[i + k];
+            vertex.position = glm::vec3(lanes[0][k], lanes[1][k], lanes[2][k]);
+            vertex.TexCoords = glm::vec2(lanes[3][k], lanes[4][k]);
+            vertex.normal = glm::vec3(lanes[5][k], lanes[6][k], lanes[7][k]);
+            vertex.Tangent = glm::vec3(lanes[8][k], lanes[9][k], lanes[10][k]);
+            vertex.BitTangent = glm::vec3(lanes[11][k], lanes[12][k], lanes[13][k]);
+        }
+    }
+#endif
+    for(; i < count; i++){
+        out[i] = UnpackVertexScalar(packed[i], bounds);
+    }
+}
+
+static float AngleDegrees(glm::vec3 a, glm::vec3 b){
+    float la = glm::length(a), lb = glm::length(b);
+    if(la == 0.0f || lb == 0.0f) return 0.0f;
+    return std::acos(std::clamp(glm::dot(a, b) / (la * lb), -1.0f, 1.0f)) * 57.2957795f;
+}
+
+//! @note Accumulates the round trip error of one mesh into error
+static void MeasurePackedVertexError(const Vertex* original, const Vertex* decoded, size_t count, PackedVertexError& error){
+    for(size_t i = 0; i < count; i++){
+        float position = glm::length(original[i].position - decoded[i].position);
+        float normal = AngleDegrees(original[i].normal, decoded[i].normal);
+        float tangent = AngleDegrees(original[i].Tangent, decoded[i].Tangent);
+        float uv = std::max(std::fabs(original[i].TexCoords.x - decoded[i].TexCoords.x), std::fabs(original[i].TexCoords.y - decoded[i].TexCoords.y));
+
+        error.maxPosition = std::max(error.maxPosition, position);
+        error.maxNormalDegrees = std::max(error.maxNormalDegrees, normal);
+        error.maxTangentDegrees = std::max(error.maxTangentDegrees, tangent);
+        error.maxUV = std::max(error.maxUV, uv);
+        error.sumPosition += position;
+        error.sumNormalDegrees += normal;
+    }
+    error.vertexCount += count;
+}
+
+//! @note Narrows indices to 16 bits, only valid when every index is below 65536
+static std::vector<uint16_t> PackIndices16(const uint32_t* indices, size_t count){
+    std::vector<uint16_t> packed(count);
+    for(size_t i = 0; i < count; i++){
+        packed[i] = static_cast<uint16_t>(indices[i]);
+    }
+    return packed;
+}
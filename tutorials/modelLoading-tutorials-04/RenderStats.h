@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdio>
+#include <cstdint>
+
+/**
+ * @param RenderStats
+ * @note Per-frame counters of the GL calls that cost CPU time on the draw path
+ * @note Mesh/Model increment them while drawing, call Reset() at the start of every frame and read them at the end
+*/
+struct RenderStats{
+    uint32_t drawCalls = 0;
+    uint32_t vertexArrayBinds = 0;
+    uint32_t textureBinds = 0;
+    uint32_t triangles = 0;
+
+    void Reset(){
+        *this = RenderStats();
+    }
+
+    void Print() const{
+        printf("Frame: %u draw calls, %u triangles, %u vertex array binds, %u texture binds\n", drawCalls, triangles, vertexArrayBinds, textureBinds);
+    }
+};
+
+static RenderStats& FrameRenderStats(){
+    static RenderStats stats;
+    return stats;
+}
@@ -0,0 +1,189 @@
+#pragma once
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <algorithm>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SCENE_HIERARCHY_SSE2 1
+#endif
+
+/**
+ * @param SceneHierarchy
+ * @note Transform hierarchy (ex. assimp's node tree, see Model::DrawHierarchy) stored as structure-of-arrays: parent index, local translation,
+ * @note rotation and scale, local matrix and world matrix each live in their own array, indexed by node
+ * @note Nodes are always added after their parent, so one forward pass over the arrays sees every parent before its children
+ *
+ * @note Setting a node's translation/rotation/scale only flags it. Update() then
+ * @note 1. walks the flags from the first flagged node on, a node is out of date when it was flagged or its parent is, and rebuilds the local
+ * @note    matrix of flagged nodes from their TRS
+ * @note 2. recomputes the world matrix of every out of date node in one batch (world = parent world * local), with SSE2 when available
+ * @note Untouched subtrees cost one flag byte per node and no matrix work
+*/
+
+struct SceneUpdateStats{
+    size_t localsRebuilt = 0;   // nodes whose translation/rotation/scale changed
+    size_t worldsUpdated = 0;   // those plus all of their descendants
+};
+
+//! @note Same as glm::translate(translation) * glm::mat4_cast(rotation) * glm::scale(scale), rotation must be normalized
+static glm::mat4 ComposeTransform(const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale){
+    float xx = rotation.x * rotation.x, yy = rotation.y * rotation.y, zz = rotation.z * rotation.z;
+    float xy = rotation.x * rotation.y, xz = rotation.x * rotation.z, yz = rotation.y * rotation.z;
+    float wx = rotation.w * rotation.x, wy = rotation.w * rotation.y, wz = rotation.w * rotation.z;
+
+    return glm::mat4(glm::vec4((1.0f - 2.0f * (yy + zz)) * scale.x, 2.0f * (xy + wz) * scale.x, 2.0f * (xz - wy) * scale.x, 0.0f),
+                     glm::vec4(2.0f * (xy - wz) * scale.y, (1.0f - 2.0f * (xx + zz)) * scale.y, 2.0f * (yz + wx) * scale.y, 0.0f),
+                     glm::vec4(2.0f * (xz + wy) * scale.z, 2.0f * (yz - wx) * scale.z, (1.0f - 2.0f * (xx + yy)) * scale.z, 0.0f),
+                     glm::vec4(translation, 1.0f));
+}
+
+//! @note out = a * b, out must not alias a or b
+static void MultiplyMat4(const glm::mat4& a, const glm::mat4& b, glm::mat4& out){
+#ifdef SCENE_HIERARCHY_SSE2
+    //! @note Each output column is the columns of a weighted by one column of b, four multiply-adds of whole columns
+    const __m128 a0 = _mm_loadu_ps(&a[0][0]), a1 = _mm_loadu_ps(&a[1][0]), a2 = _mm_loadu_ps(&a[2][0]), a3 = _mm_loadu_ps(&a[3][0]);
+    for(int column = 0; column < 4; column++){
+        const float* b0 = &b[column][0];
+        __m128 result = _mm_mul_ps(a0, _mm_set1_ps(b0[0]));
+        result = _mm_add_ps(result, _mm_mul_ps(a1, _mm_set1_ps(b0[1])));
+        result = _mm_add_ps(result, _mm_mul_ps(a2, _mm_set1_ps(b0[2])));
+        result = _mm_add_ps(result, _mm_mul_ps(a3, _mm_set1_ps(b0[3])));
+        _mm_storeu_ps(&out[column][0], result);
+    }
+#else
+    out = a * b;
+#endif
+}
+
+/**
+ * @note worlds[n] = worlds[parents[n]] * locals[n] for each n in nodes (roots just copy their local matrix)
+ * @note nodes must be ascending, so a parent in the batch is always finished before its children read it
+*/
+static void MultiplyWorldMatrices(const uint32_t* nodes, size_t count, const int32_t* parents, const glm::mat4* locals, glm::mat4* worlds){
+    for(size_t i = 0; i < count; i++){
+        uint32_t node = nodes[i];
+        int32_t parent = parents[node];
+        if(parent < 0) worlds[node] = locals[node];
+        else MultiplyMat4(worlds[parent], locals[node], worlds[node]);
+    }
+}
+
+class SceneHierarchy{
+public:
+    static constexpr int32_t NO_PARENT = -1;
+
+    void Reserve(size_t count){
+        parents.reserve(count);
+        translations.reserve(count);
+        rotations.reserve(count);
+        scales.reserve(count);
+        locals.reserve(count);
+        worlds.reserve(count);
+        flags.reserve(count);
+    }
+
+    void Clear(){
+        *this = SceneHierarchy();
+    }
+
+    //! @note parent is NO_PARENT or a node added before, returns the new node's index. Its world matrix is valid after the next Update().
+    uint32_t AddNode(int32_t parent, const glm::vec3& translation = glm::vec3(0.0f), const glm::quat& rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f),
+                     const glm::vec3& scale = glm::vec3(1.0f)){
+        uint32_t node = static_cast<uint32_t>(parents.size());
+        parents.push_back(parent >= 0 && static_cast<uint32_t>(parent) < node ? parent : NO_PARENT);
+        translations.push_back(translation);
+        rotations.push_back(rotation);
+        scales.push_back(scale);
+        locals.push_back(glm::mat4(1.0f));
+        worlds.push_back(glm::mat4(1.0f));
+        flags.push_back(0);
+        MarkChanged(node);
+        return node;
+    }
+
+    void SetTranslation(uint32_t node, const glm::vec3& translation){
+        translations[node] = translation;
+        MarkChanged(node);
+    }
+
+    void SetRotation(uint32_t node, const glm::quat& rotation){
+        rotations[node] = rotation;
+        MarkChanged(node);
+    }
+
+    void SetScale(uint32_t node, const glm::vec3& scale){
+        scales[node] = scale;
+        MarkChanged(node);
+    }
+
+    void SetLocal(uint32_t node, const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale){
+        translations[node] = translation;
+        rotations[node] = rotation;
+        scales[node] = scale;
+        MarkChanged(node);
+    }
+
+    size_t Size() const { return parents.size(); }
+    int32_t Parent(uint32_t node) const { return parents[node]; }
+    const glm::vec3& Translation(uint32_t node) const { return translations[node]; }
+    const glm::quat& Rotation(uint32_t node) const { return rotations[node]; }
+    const glm::vec3& Scale(uint32_t node) const { return scales[node]; }
+    const glm::mat4& Local(uint32_t node) const { return locals[node]; }
+
+    //! @note As of the last Update()
+    const glm::mat4& World(uint32_t node) const { return worlds[node]; }
+    const std::vector<glm::mat4>& Worlds() const { return worlds; }
+
+    SceneUpdateStats Update(){
+        SceneUpdateStats stats;
+        if(firstChanged >= parents.size()) return stats;
+
+        //! @note Nodes before the first flagged one cannot be out of date, their flags are all clear
+        updateList.clear();
+        for(size_t node = firstChanged; node < parents.size(); node++){
+            uint8_t flag = flags[node];
+            int32_t parent = parents[node];
+            if(parent >= 0 && (flags[parent] & WORLD_CHANGED)) flag |= WORLD_CHANGED;
+            if(flag & LOCAL_CHANGED){
+                locals[node] = ComposeTransform(translations[node], rotations[node], scales[node]);
+                flag |= WORLD_CHANGED;
+                stats.localsRebuilt++;
+            }
+            if(flag & WORLD_CHANGED){
+                flags[node] = flag;
+                updateList.push_back(static_cast<uint32_t>(node));
+            }
+        }
+
+        MultiplyWorldMatrices(updateList.data(), updateList.size(), parents.data(), locals.data(), worlds.data());
+
+        //! @note Only the nodes just updated have flags set
+        for(uint32_t node : updateList) flags[node] = 0;
+        firstChanged = SIZE_MAX;
+        stats.worldsUpdated = updateList.size();
+        return stats;
+    }
+
+private:
+    static constexpr uint8_t LOCAL_CHANGED = 1;
+    static constexpr uint8_t WORLD_CHANGED = 2;
+
+    void MarkChanged(uint32_t node){
+        flags[node] |= LOCAL_CHANGED;
+        firstChanged = std::min<size_t>(firstChanged, node);
+    }
+
+    std::vector<int32_t> parents;
+    std::vector<glm::vec3> translations;
+    std::vector<glm::quat> rotations;
+    std::vector<glm::vec3> scales;
+    std::vector<glm::mat4> locals;
+    std::vector<glm::mat4> worlds;
+    std::vector<uint8_t> flags;
+    std::vector<uint32_t> updateList;
+    size_t firstChanged = SIZE_MAX;
+};
@@ -0,0 +1,281 @@
+#pragma once
+#include <cmath>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <map>
+#include <tuple>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "GLResources.h"
+#include "RenderStats.h"
+
+/**
+ * @param TextureArrays
+ * @note Moves a model's textures out of one GL_TEXTURE_2D each into a few GL_TEXTURE_2D_ARRAYs, so meshes sharing an array share its bind
+ * @note    textures of the same size and color space become the layers of one array, sampled with their layer index
+ * @note    small textures (up to atlasMaxSize) are packed into atlas pages, themselves the layers of an array, and sampled through a UV rectangle
+ * @note Each Texture then only carries its array, layer and UV rectangle (MeshData.h), Mesh::Draw sets those as uniforms (modelArray.frag) and
+ * @note TextureBindState skips binding an array a unit already holds. A model whose textures all share a size draws with one bind per unit.
+ *
+ * @note The pixels are read back from the textures already uploaded (level 0, as RGBA8), so files, baked or embedded images all work
+ * @note Block compressed sources (TextureCompression.h) are left out: as RGBA8 layers they would take 4-8x the memory. They stay plain 2D textures,
+ * @note which modelArray.frag samples through its fallback sampler (Mesh::BindTextureArrays), and stay under TextureResidency.h
+ * @note Atlases only take textures whose meshes keep their UVs in [0, 1] (a repeating UV would wrap into the neighbours). Every atlased texture is
+ * @note surrounded by gutter pixels of its own edge, and the atlas mip chain stops once the gutter would shrink below one pixel
+*/
+
+struct TextureArraySettings{
+    uint32_t atlasSize = 1024;      // width and height of an atlas page
+    uint32_t atlasMaxSize = 256;    // textures up to this size on both sides are atlased (when their UVs allow it)
+    uint32_t gutter = 8;            // edge padding around every atlased texture, in pixels
+};
+
+struct TextureArrayReport{
+    uint32_t textures = 0;          // distinct textures packed
+    uint32_t arrays = 0;
+    uint32_t layers = 0;            // over every array, atlas pages included
+    uint32_t atlasPages = 0;
+    uint32_t atlasedTextures = 0;
+    uint32_t skipped = 0;           // could not be read back, they stay plain 2D textures
+    uint32_t compressed = 0;        // block compressed, also left as plain 2D textures
+    size_t bytes = 0;               // level 0 of every layer
+    double milliseconds = 0.0;
+};
+
+struct TextureArrayInput{
+    uint32_t texture = 0;   // GL_TEXTURE_2D
+    bool gamma = false;     // sRGB
+    bool atlasable = false; // every mesh sampling it keeps its UVs in [0, 1]
+};
+
+//! @note Where a packed texture ended up, array 0 when it was not packed
+struct TextureArraySlot{
+    uint32_t array = 0;
+    float layer = 0.0f;
+    glm::vec4 uvRect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f); // offset xy, scale zw
+};
+
+//! @note The arrays bound to each texture unit while drawing, shared by every mesh of a draw so the same array is never bound twice
+struct TextureBindState{
+    static constexpr uint32_t UNITS = 8;
+    static constexpr uint32_t PLAIN_UNIT = UNITS;   // first fallback unit
+
+    void BindArray(uint32_t unit, uint32_t array){
+        if(unit < UNITS && bound[unit] == array) return;
+        Activate(unit);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, array);
+        if(unit < UNITS) bound[unit] = array;
+        FrameRenderStats().textureBinds++;
+    }
+
+    //! @note A texture that was not packed, on the fallback unit PLAIN_UNIT + i next to array unit i (a unit never holds both sampler types)
+    void BindPlain(uint32_t index, uint32_t texture){
+        if(index < UNITS && boundPlain[index] == texture) return;
+        Activate(PLAIN_UNIT + index);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        if(index < UNITS) boundPlain[index] = texture;
+        FrameRenderStats().textureBinds++;
+    }
+
+    //! @note Leaves unit 0 active again, like the per-texture binds did
+    void Finish(){
+        if(activeUnit != 0){
+            glActiveTexture(GL_TEXTURE0);
+            activeUnit = 0;
+        }
+    }
+
+    void Activate(uint32_t unit){
+        if(unit != activeUnit){
+            glActiveTexture(GL_TEXTURE0 + unit);
+            activeUnit = unit;
+        }
+    }
+
+    uint32_t bound[UNITS] = {};
+    uint32_t boundPlain[UNITS] = {};
+    uint32_t activeUnit = 0;
+};
+
+//! @note Copies a w x h RGBA8 image into an atlas page at (x, y) with gutter pixels of repeated edge around it
+static void BlitWithGutter(const uint8_t* source, uint32_t width, uint32_t height, uint8_t* page, uint32_t pageSize, uint32_t x, uint32_t y, uint32_t gutter){
+    for(uint32_t row = 0; row < height + 2 * gutter; row++){
+        uint32_t sourceRow = std::min(static_cast<uint32_t>(std::max<int64_t>(int64_t(row) - gutter, 0)), height - 1);
+        uint8_t* out = page + (size_t(y + row) * pageSize + x) * 4;
+        const uint8_t* in = source + size_t(sourceRow) * width * 4;
+        for(uint32_t column = 0; column < gutter; column++) std::memcpy(out + column * 4, in, 4);
+        std::memcpy(out + gutter * 4, in, size_t(width) * 4);
+        for(uint32_t column = 0; column < gutter; column++) std::memcpy(out + (size_t(gutter) + width + column) * 4, in + size_t(width - 1) * 4, 4);
+    }
+}
+
+class TextureArraySet{
+public:
+    /**
+     * @note Reads every input back and packs it, slots receives one entry per input (same order). Needs a current context.
+     * @note The source textures are left alone, the caller drops them once it switched to the slots
+    */
+    TextureArrayReport Build(const std::vector<TextureArrayInput>& inputs, const TextureArraySettings& settings, std::vector<TextureArraySlot>& slots){
+        auto start = std::chrono::steady_clock::now();
+        TextureArrayReport report;
+        slots.assign(inputs.size(), TextureArraySlot());
+
+        struct Image{
+            uint32_t input;
+            uint32_t width;
+            uint32_t height;
+            std::vector<uint8_t> pixels; // RGBA8
+        };
+        std::vector<Image> images;
+        for(uint32_t i = 0; i < inputs.size(); i++){
+            GLint width = 0, height = 0;
+            glBindTexture(GL_TEXTURE_2D, inputs[i].texture);
+            glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+            glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+            if(width <= 0 || height <= 0){
+                report.skipped++;
+                continue;
+            }
+            GLint compressed = GL_FALSE;
+            glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_COMPRESSED, &compressed);
+            if(compressed == GL_TRUE){
+                report.compressed++;
+                continue;
+            }
+            Image image{i, static_cast<uint32_t>(width), static_cast<uint32_t>(height), {}};
+            image.pixels.resize(size_t(width) * height * 4);
+            glPixelStorei(GL_PACK_ALIGNMENT, 1);
+            glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.pixels.data());
+            glPixelStorei(GL_PACK_ALIGNMENT, 4);
+            images.push_back(std::move(image));
+        }
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        //! @note Same size and color space share an array, small atlasable textures are grouped by color space only
+        std::map<std::tuple<bool, uint32_t, uint32_t>, std::vector<Image*>> layerGroups;
+        std::map<bool, std::vector<Image*>> atlasGroups;
+        uint32_t padded = settings.atlasMaxSize + 2 * settings.gutter;
+        for(Image& image : images){
+            const TextureArrayInput& input = inputs[image.input];
+            bool small = image.width <= settings.atlasMaxSize && image.height <= settings.atlasMaxSize && padded <= settings.atlasSize;
+            if(input.atlasable && small) atlasGroups[input.gamma].push_back(&image);
+            else layerGroups[{input.gamma, image.width, image.height}].push_back(&image);
+        }
+
+        uint32_t maxLayers = MaxArrayLayers();
+        for(auto& [key, group] : layerGroups){
+            auto [gamma, width, height] = key;
+            for(size_t first = 0; first < group.size(); first += maxLayers){
+                uint32_t layers = static_cast<uint32_t>(std::min<size_t>(maxLayers, group.size() - first));
+                uint32_t levels = static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1;
+                uint32_t array = CreateArray(width, height, layers, gamma, levels, GL_REPEAT);
+                for(uint32_t layer = 0; layer < layers; layer++){
+                    Image& image = *group[first + layer];
+                    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, image.pixels.data());
+                    slots[image.input] = {array, float(layer), glm::vec4(0.0f, 0.0f, 1.0f, 1.0f)};
+                }
+                glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+                report.layers += layers;
+                report.bytes += size_t(width) * height * 4 * layers;
+            }
+        }
+
+        //! @note Shelf packing, tallest first: each shelf is as tall as its first texture, a full page starts the next one
+        uint32_t size = settings.atlasSize, gutter = settings.gutter;
+        for(auto& [gamma, group] : atlasGroups){
+            std::sort(group.begin(), group.end(), [](const Image* a, const Image* b){ return a->height != b->height ? a->height > b->height : a->width > b->width; });
+
+            std::vector<std::vector<uint8_t>> pages;
+            uint32_t x = 0, y = 0, shelfHeight = 0;
+            std::vector<std::pair<Image*, uint32_t>> placed; // image, page
+            for(Image* image : group){
+                uint32_t width = image->width + 2 * gutter, height = image->height + 2 * gutter;
+                if(x + width > size){
+                    x = 0;
+                    y += shelfHeight;
+                    shelfHeight = 0;
+                }
+                if(pages.empty() || y + height > size){
+                    pages.emplace_back(size_t(size) * size * 4, 0);
+                    x = y = shelfHeight = 0;
+                }
+                BlitWithGutter(image->pixels.data(), image->width, image->height, pages.back().data(), size, x, y, gutter);
+                slots[image->input].uvRect = glm::vec4(float(x + gutter) / size, float(y + gutter) / size, float(image->width) / size, float(image->height) / size);
+                placed.push_back({image, static_cast<uint32_t>(pages.size() - 1)});
+                x += width;
+                shelfHeight = std::max(shelfHeight, height);
+            }
+
+            //! @note Level n shrinks the gutter to gutter >> n pixels, the chain stops at one
+            uint32_t levels = static_cast<uint32_t>(std::floor(std::log2(std::max(gutter, 1u)))) + 1;
+            for(size_t first = 0; first < pages.size(); first += maxLayers){
+                uint32_t layers = static_cast<uint32_t>(std::min<size_t>(maxLayers, pages.size() - first));
+                uint32_t array = CreateArray(size, size, layers, gamma, levels, GL_CLAMP_TO_EDGE);
+                for(uint32_t layer = 0; layer < layers; layer++){
+                    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, size, size, 1, GL_RGBA, GL_UNSIGNED_BYTE, pages[first + layer].data());
+                }
+                glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+                for(const auto& [image, page] : placed){
+                    if(page < first || page >= first + layers) continue;
+                    slots[image->input].array = array;
+                    slots[image->input].layer = float(page - first);
+                }
+                report.layers += layers;
+                report.bytes += size_t(size) * size * 4 * layers;
+            }
+            report.atlasPages += static_cast<uint32_t>(pages.size());
+            report.atlasedTextures += static_cast<uint32_t>(group.size());
+        }
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+        report.textures = static_cast<uint32_t>(images.size());
+        report.arrays = static_cast<uint32_t>(arrays.size());
+        report.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return report;
+    }
+
+    size_t ArrayCount() const { return arrays.size(); }
+
+    void Clear(){
+        arrays.clear();
+    }
+
+private:
+    //! @note Queried once, needs a current context
+    static uint32_t MaxArrayLayers(){
+        static uint32_t layers = [](){
+            GLint value = 0;
+            glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &value);
+            return static_cast<uint32_t>(std::max(value, 1));
+        }();
+        return layers;
+    }
+
+    //! @note Leaves the new array bound to GL_TEXTURE_2D_ARRAY
+    uint32_t CreateArray(uint32_t width, uint32_t height, uint32_t layers, bool gamma, uint32_t levels, GLenum wrap){
+        arrays.push_back(GLTexture::Create());
+        uint32_t array = arrays.back().Get();
+        glBindTexture(GL_TEXTURE_2D_ARRAY, array);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, gamma ? GL_SRGB8_ALPHA8 : GL_RGBA8, width, height, layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, wrap);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, wrap);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(levels - 1));
+        return array;
+    }
+
+    std::vector<GLTexture> arrays;
+};
+
+static void PrintTextureArrayReport(const TextureArrayReport& report){
+    printf("Texture arrays: %u textures -> %u arrays, %u layers (%u atlas pages holding %u textures), %.2f MB, %u skipped, %u compressed kept, %.2f ms\n",
+           report.textures, report.arrays, report.layers, report.atlasPages, report.atlasedTextures, report.bytes / (1024.0 * 1024.0),
+           report.skipped, report.compressed, report.milliseconds);
+}
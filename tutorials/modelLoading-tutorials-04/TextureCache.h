@@ -0,0 +1,391 @@
+#pragma once
+#include <string>
+#include <memory>
+#include <cstdio>
+#include <cstdint>
+#include <algorithm>
+#include <filesystem>
+#include <functional>
+#include <unordered_map>
+#include <glad/glad.h>
+
+#include "stb_image.h"
+#include "AsyncTextureLoader.h"
+#include "GLResources.h"
+#include "BakedAssets.h"
+#include "TextureCompression.h"
+
+/**
+ * @param TextureCache
+ * @note One process-wide table of every 2D texture loaded from disk, shared by all Model instances and LoadTexture
+ * @note Keyed by the normalized absolute path plus the parameters that change the GL texture (gamma, wrap, filtering), so lookups are a single hash probe
+ * @note Acquire() hands out TextureHandle's (reference counted), the GL texture goes to the deletion queue (GLResources.h) once the last handle is dropped
+ * @note Everything here runs on the GL thread, no locking needed
+*/
+
+struct TextureLoadParams{
+    bool gamma = false; // stored as sRGB so sampling returns linear values
+    GLenum wrap = GL_REPEAT;
+    GLenum minFilter = GL_LINEAR_MIPMAP_LINEAR;
+    GLenum magFilter = GL_LINEAR;
+
+    bool operator==(const TextureLoadParams& other) const{
+        return gamma == other.gamma && wrap == other.wrap && minFilter == other.minFilter && magFilter == other.magFilter;
+    }
+};
+
+struct TextureCacheKey{
+    std::string path;
+    TextureLoadParams params;
+
+    bool operator==(const TextureCacheKey& other) const{
+        return path == other.path && params == other.params;
+    }
+};
+
+struct TextureCacheKeyHash{
+    size_t operator()(const TextureCacheKey& key) const{
+        size_t hash = std::hash<std::string>()(key.path);
+        size_t params = (size_t(key.params.gamma) << 48) ^ (size_t(key.params.wrap) << 32) ^ (size_t(key.params.minFilter) << 16) ^ size_t(key.params.magFilter);
+        return hash ^ (params + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2));
+    }
+};
+
+struct TextureCacheStats{
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint32_t residentTextures = 0;
+    size_t residentBytes = 0; // estimated GPU memory, full mip chains included
+};
+
+class TextureCache;
+
+//! @note Where a texture's levels can be read again, for TextureResidency.h to stream dropped levels back in
+enum class TextureSourceKind : uint8_t{ Memory, Image, Baked, Compressed };
+
+//! @note The GL texture behind a handle, lives exactly as long as somebody holds a TextureHandle to it
+struct TextureResource{
+    ~TextureResource();
+
+    GLTexture texture;
+    size_t bytes = 0;
+    TextureCacheKey key;
+    TextureCache* cache = nullptr;
+    TextureSourceKind sourceKind = TextureSourceKind::Memory;  // Memory (decoded from bytes nobody keeps) cannot be read again
+    std::string sourcePath;                                     // the image, its .tex or its .dds
+};
+
+using TextureHandle = std::shared_ptr<TextureResource>;
+
+class TextureCache{
+public:
+    //! @note Cached and pinned textures hand their names to GlobalDeletionQueue() when the cache goes away. Touching the queue here finishes
+    //! @note constructing it first, so as function-local statics it is destroyed after the cache and never receives names once it is gone.
+    TextureCache(){
+        GlobalDeletionQueue();
+    }
+
+    /**
+     * @note Returns the cached texture for (filepath, params), loading it on a miss
+     * @note With a textureLoader the load is asynchronous (placeholder first), otherwise the image is decoded and uploaded right here
+     * @note A baked texture (BakedAssets.h) needs no decode, it is always uploaded right here with its mip chain
+     * @note Block compressed (.dds, TextureCompression.h) when the driver supports its format, the raw .tex otherwise
+     * @note Returns nullptr when the file cannot be decoded (synchronous loads only)
+    */
+    TextureHandle Acquire(const std::string& filepath, const TextureLoadParams& params = {}, AsyncTextureLoader* textureLoader = nullptr){
+        TextureCacheKey key{NormalizePath(filepath), params};
+        if(TextureHandle handle = Lookup(key)){
+            return handle;
+        }
+
+        TextureHandle handle = std::make_shared<TextureResource>();
+        handle->key = key;
+
+        std::string bakedPath = BakedAssets().FindFirst(key.path, {COMPRESSED_TEXTURE_EXTENSION, BAKED_TEXTURE_EXTENSION});
+        std::string compressedExtension = COMPRESSED_TEXTURE_EXTENSION;
+        if(bakedPath.size() > compressedExtension.size() && bakedPath.compare(bakedPath.size() - compressedExtension.size(), compressedExtension.size(), compressedExtension) == 0){
+            handle->texture = LoadCompressed(bakedPath, params.gamma, initialMaxSize, handle->bytes);
+            if(handle->texture){
+                handle->sourceKind = TextureSourceKind::Compressed;
+                handle->sourcePath = bakedPath;
+            }
+            bakedPath = handle->texture ? "" : BakedAssets().Find(key.path, BAKED_TEXTURE_EXTENSION);
+        }
+        if(!bakedPath.empty()){
+            handle->texture = LoadBaked(bakedPath, params.gamma, initialMaxSize, handle->bytes);
+            if(handle->texture){
+                handle->sourceKind = TextureSourceKind::Baked;
+                handle->sourcePath = bakedPath;
+            }
+        }
+        if(handle->texture){
+            // uploaded from the baked file, nothing to decode
+        }
+        else if(textureLoader){
+            handle->texture = textureLoader->Load(key.path, params.gamma, OnUploaded(handle), handle);
+        }
+        else{
+            handle->texture = LoadImmediate(key.path, params.gamma, handle->bytes);
+            if(!handle->texture){
+                return nullptr;
+            }
+        }
+        if(handle->sourcePath.empty()){
+            handle->sourceKind = TextureSourceKind::Image;
+            handle->sourcePath = key.path;
+        }
+
+        return Insert(handle);
+    }
+
+    /**
+     * @note Textures whose encoded image (PNG/JPEG...) is already in memory, ex. embedded in a .glb. name must be unique per image (ex. file path + "#image3").
+     * @note With a textureLoader the decode runs on its pool and keepAlive (the owner of bytes) is held until it is done
+    */
+    TextureHandle AcquireEncoded(const std::string& name, const uint8_t* bytes, size_t size, std::shared_ptr<const void> keepAlive,
+                                 const TextureLoadParams& params = {}, AsyncTextureLoader* textureLoader = nullptr){
+        TextureCacheKey key{name, params};
+        if(TextureHandle handle = Lookup(key)){
+            return handle;
+        }
+
+        TextureHandle handle = std::make_shared<TextureResource>();
+        handle->key = key;
+
+        if(textureLoader){
+            handle->texture = textureLoader->LoadFromMemory(name, bytes, size, std::move(keepAlive), params.gamma, OnUploaded(handle), handle);
+        }
+        else{
+            int w, h, channels;
+            unsigned char* data = stbi_load_from_memory(bytes, static_cast<int>(size), &w, &h, &channels, 0);
+            if(!data){
+                printf("Could not load imaged texture ====> %s\n", name.c_str());
+                return nullptr;
+            }
+            handle->texture = UploadPixels(data, w, h, channels, params.gamma, handle->bytes);
+            stbi_image_free(data);
+        }
+
+        return Insert(handle);
+    }
+
+    //! @note Uploads pixels decoded somewhere else (ex. on worker threads), the cache frees them. Returns the cached texture instead when name is already resident.
+    TextureHandle AcquireDecoded(const std::string& name, unsigned char* pixels, int width, int height, int channels, const TextureLoadParams& params = {}){
+        TextureCacheKey key{name, params};
+        if(TextureHandle handle = Lookup(key)){
+            stbi_image_free(pixels);
+            return handle;
+        }
+        if(!pixels){
+            printf("Could not load imaged texture ====> %s\n", name.c_str());
+            return nullptr;
+        }
+
+        TextureHandle handle = std::make_shared<TextureResource>();
+        handle->key = key;
+        handle->texture = UploadPixels(pixels, width, height, channels, params.gamma, handle->bytes);
+        stbi_image_free(pixels);
+        return Insert(handle);
+    }
+
+    //! @note True when (name, params) is resident, lets callers skip decoding an image the cache already holds
+    bool Contains(const std::string& name, const TextureLoadParams& params = {}) const{
+        auto found = entries.find(TextureCacheKey{name, params});
+        return found != entries.end() && !found->second.expired();
+    }
+
+    //! @note Keeps a texture alive until ReleasePinned(), for callers that only hold the raw GL id (ex. LoadTexture)
+    uint32_t AcquirePinned(const std::string& filepath, const TextureLoadParams& params = {}){
+        TextureHandle handle = Acquire(filepath, params);
+        if(!handle){
+            return 0;
+        }
+        pinned.push_back(handle);
+        return handle->texture.Get();
+    }
+
+    void ReleasePinned(){
+        pinned.clear();
+    }
+
+    //! @note Baked textures loaded from now on only get the levels no larger than maxSize uploaded (0 uploads everything), TextureResidency streams in the rest
+    void SetInitialMaxSize(uint32_t maxSize){
+        initialMaxSize = maxSize;
+    }
+
+    //! @note For whoever changes a texture's resident levels after loading (TextureResidency.h), keeps residentBytes right
+    void SetResidentBytes(TextureResource& resource, size_t bytes){
+        stats.residentBytes = stats.residentBytes - resource.bytes + bytes;
+        resource.bytes = bytes;
+    }
+
+    const TextureCacheStats& GetStats() const { return stats; }
+
+    void PrintStats() const{
+        printf("Texture cache: %u resident (%.2f MB), %llu hits, %llu misses\n",
+               stats.residentTextures, stats.residentBytes / (1024.0 * 1024.0),
+               static_cast<unsigned long long>(stats.hits), static_cast<unsigned long long>(stats.misses));
+    }
+
+    static std::string NormalizePath(const std::string& filepath){
+        std::error_code error;
+        std::filesystem::path absolute = std::filesystem::absolute(filepath, error);
+        return (error ? std::filesystem::path(filepath) : absolute).lexically_normal().generic_string();
+    }
+
+private:
+    friend struct TextureResource;
+
+    TextureHandle Lookup(const TextureCacheKey& key){
+        auto found = entries.find(key);
+        if(found != entries.end()){
+            if(TextureHandle handle = found->second.lock()){
+                stats.hits++;
+                return handle;
+            }
+        }
+        stats.misses++;
+        return nullptr;
+    }
+
+    //! @note Async loads only know their size once uploaded
+    std::function<void(size_t)> OnUploaded(const TextureHandle& handle){
+        std::weak_ptr<TextureResource> weak = handle;
+        return [this, weak](size_t bytes){
+            if(TextureHandle resource = weak.lock()){
+                resource->bytes = bytes;
+                stats.residentBytes += bytes;
+            }
+        };
+    }
+
+    TextureHandle Insert(const TextureHandle& handle){
+        const TextureLoadParams& params = handle->key.params;
+        glBindTexture(GL_TEXTURE_2D, handle->texture.Get());
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, params.wrap);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, params.wrap);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, params.minFilter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, params.magFilter);
+
+        handle->cache = this;
+        stats.residentTextures++;
+        stats.residentBytes += handle->bytes;
+        entries[handle->key] = handle;
+        return handle;
+    }
+
+    void OnReleased(const TextureResource& resource){
+        stats.residentTextures--;
+        stats.residentBytes -= resource.bytes;
+
+        //! @note The slot may already hold a newer texture for the same key, only erase it if it is really ours (expired)
+        auto found = entries.find(resource.key);
+        if(found != entries.end() && found->second.expired()){
+            entries.erase(found);
+        }
+    }
+
+    static GLTexture LoadImmediate(const std::string& filepath, bool gamma, size_t& bytes){
+        int w, h, channels;
+        AssetFile file(filepath);
+        unsigned char* data = file.IsOpen() ? stbi_load_from_memory(file.data, static_cast<int>(file.size), &w, &h, &channels, 0) : nullptr;
+
+        if(!data){
+            printf("Could not load imaged texture ====> %s\n", filepath.c_str());
+            return GLTexture();
+        }
+
+        GLTexture texture = UploadPixels(data, w, h, channels, gamma, bytes);
+        stbi_image_free(data);
+        return texture;
+    }
+
+    //! @note First level no larger than maxSize (0 is always level 0), the last level when none is that small
+    static uint32_t FirstLevelWithin(uint32_t width, uint32_t height, uint32_t levelCount, uint32_t maxSize){
+        uint32_t level = 0;
+        while(maxSize && level + 1 < levelCount && std::max(width >> level, height >> level) > maxSize){
+            level++;
+        }
+        return level;
+    }
+
+    static GLTexture LoadBaked(const std::string& bakedPath, bool gamma, uint32_t maxSize, size_t& bytes){
+        BakedTextureFile baked;
+        if(!baked.Open(bakedPath)){
+            printf("Could not read baked texture ====> %s\n", bakedPath.c_str());
+            return GLTexture();
+        }
+
+        GLTexture texture = GLTexture::Create();
+        glBindTexture(GL_TEXTURE_2D, texture.Get());
+        bytes = UploadBakedTexture(GL_TEXTURE_2D, baked, gamma, FirstLevelWithin(baked.header->width, baked.header->height, baked.header->levelCount, maxSize));
+        return texture;
+    }
+
+    //! @note An empty texture when the file is invalid or the driver lacks its format, the caller then falls back to the raw texture
+    static GLTexture LoadCompressed(const std::string& compressedPath, bool gamma, uint32_t maxSize, size_t& bytes){
+        CompressedTextureFile compressed;
+        if(!compressed.Open(compressedPath)){
+            printf("Could not read compressed texture ====> %s\n", compressedPath.c_str());
+            return GLTexture();
+        }
+        if(compressed.IsCubemap() || !CompressedFormatSupported(CompressedInternalFormat(compressed.format, gamma))){
+            return GLTexture();
+        }
+
+        GLTexture texture = GLTexture::Create();
+        glBindTexture(GL_TEXTURE_2D, texture.Get());
+        bytes = UploadCompressedTexture(GL_TEXTURE_2D, compressed, gamma,
+                                        FirstLevelWithin(compressed.header.width, compressed.header.height, compressed.levelCount, maxSize));
+        return texture;
+    }
+
+    static GLTexture UploadPixels(const unsigned char* data, int w, int h, int channels, bool gamma, size_t& bytes){
+        GLenum format = GL_RGBA;
+        if(channels == 1){
+            format = GL_RED;
+        }
+        else if(channels == 2){
+            format = GL_RG;
+        }
+        else if(channels == 3){
+            format = GL_RGB;
+        }
+
+        GLenum internalFormat = format;
+        if(gamma && channels == 3){
+            internalFormat = GL_SRGB8;
+        }
+        else if(gamma && channels == 4){
+            internalFormat = GL_SRGB8_ALPHA8;
+        }
+
+        GLTexture texture = GLTexture::Create();
+        glBindTexture(GL_TEXTURE_2D, texture.Get());
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, w, h, 0, format, GL_UNSIGNED_BYTE, data);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glGenerateMipmap(GL_TEXTURE_2D);
+
+        size_t size = static_cast<size_t>(w) * h * channels;
+        bytes = size + size / 3;
+        return texture;
+    }
+
+    std::unordered_map<TextureCacheKey, std::weak_ptr<TextureResource>, TextureCacheKeyHash> entries;
+    std::vector<TextureHandle> pinned;
+    uint32_t initialMaxSize = 0;
+    TextureCacheStats stats;
+};
+
+inline TextureResource::~TextureResource(){
+    if(cache){
+        cache->OnReleased(*this);
+    }
+}
+
+//! @note Process-wide cache, created on first use
+static TextureCache& GlobalTextureCache(){
+    static TextureCache cache;
+    return cache;
+}
@@ -0,0 +1,688 @@
+#pragma once
+#include <cmath>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+#include <glad/glad.h>
+
+#include "AssetPack.h"
+#include "BakedAssets.h"
+#include "ThreadPool.h"
+
+/**
+ * @param TextureCompression
+ * @note Block compression for baked textures: the asset baker encodes every texture and its whole mip chain into BC blocks stored in a .dds
+ * @note next to the raw .tex (BakedAssets.h), TextureCache uploads them with glCompressedTexImage2D when the driver supports the format
+ * @note    1 channel  -> BC4 (RGTC1)      4 bits per pixel
+ * @note    2 channels -> BC5 (RGTC2)      8 bits per pixel, ex. two channel normal maps
+ * @note    3 channels -> BC1 (DXT1)       4 bits per pixel
+ * @note    4 channels -> BC3 (DXT5)       8 bits per pixel, or BC1 when every alpha is 255
+ * @note So a texture takes 1/6 (RGB) to 1/4 (RGBA) of its raw size in VRAM and upload bandwidth, and nothing is decoded or mipmapped at load time
+ *
+ * @note Color endpoints are fit along the block's principal axis, then refined by least squares against the chosen indices
+ * @note Rows are stored in the order the raw path uploads them (no flip), sRGB is decided at upload time like the raw path does
+*/
+
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+
+static constexpr uint32_t COMPRESSED_TEXTURE_VERSION = 1;
+static constexpr const char* COMPRESSED_TEXTURE_EXTENSION = ".dds";
+
+enum class BlockFormat : uint8_t{ None, BC1, BC3, BC4, BC5 };
+
+static size_t BlockBytes(BlockFormat format){
+    return format == BlockFormat::BC1 || format == BlockFormat::BC4 ? 8 : 16;
+}
+
+static size_t CompressedLevelSize(BlockFormat format, uint32_t width, uint32_t height){
+    return size_t((width + 3) / 4) * ((height + 3) / 4) * BlockBytes(format);
+}
+
+static const char* BlockFormatName(BlockFormat format){
+    switch(format){
+        case BlockFormat::BC1: return "BC1";
+        case BlockFormat::BC3: return "BC3";
+        case BlockFormat::BC4: return "BC4";
+        case BlockFormat::BC5: return "BC5";
+        default: return "none";
+    }
+}
+
+//! @note 4x4 pixels as RGBA, edge blocks of sizes that are not a multiple of 4 repeat the last row/column
+static void FetchBlock(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t channels, uint32_t blockX, uint32_t blockY, uint8_t block[16][4]){
+    for(uint32_t y = 0; y < 4; y++){
+        uint32_t row = std::min(blockY * 4 + y, height - 1);
+        for(uint32_t x = 0; x < 4; x++){
+            uint32_t column = std::min(blockX * 4 + x, width - 1);
+            const uint8_t* pixel = pixels + (size_t(row) * width + column) * channels;
+            uint8_t* out = block[y * 4 + x];
+            out[0] = pixel[0];
+            out[1] = channels > 1 ? pixel[1] : 0;
+            out[2] = channels > 2 ? pixel[2] : 0;
+            out[3] = channels > 3 ? pixel[3] : 255;
+        }
+    }
+}
+
+static uint16_t PackColor565(const float color[3]){
+    auto quantize = [](float value, float levels){
+        return static_cast<uint32_t>(std::lround(std::clamp(value, 0.0f, 255.0f) * levels / 255.0f));
+    };
+    return static_cast<uint16_t>((quantize(color[0], 31.0f) << 11) | (quantize(color[1], 63.0f) << 5) | quantize(color[2], 31.0f));
+}
+
+static void UnpackColor565(uint16_t packed, int color[3]){
+    int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+}
+
+//! @note The four colors of a 4 color mode block (c0 > c1), or the three colors plus black of a c0 <= c1 block
+static void ColorPalette(uint16_t c0, uint16_t c1, int palette[4][3]){
+    UnpackColor565(c0, palette[0]);
+    UnpackColor565(c1, palette[1]);
+    for(int c = 0; c < 3; c++){
+        if(c0 > c1){
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        else{
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+    }
+}
+
+//! @note Nearest palette entry per pixel, returns the summed squared error
+static uint32_t PickColorIndices(const uint8_t block[16][4], const int palette[4][3], uint8_t indices[16]){
+    uint32_t total = 0;
+    for(int i = 0; i < 16; i++){
+        uint32_t best = UINT32_MAX;
+        for(uint8_t p = 0; p < 4; p++){
+            int dr = block[i][0] - palette[p][0], dg = block[i][1] - palette[p][1], db = block[i][2] - palette[p][2];
+            uint32_t error = static_cast<uint32_t>(dr * dr + dg * dg + db * db);
+            if(error < best){
+                best = error;
+                indices[i] = p;
+            }
+        }
+        total += best;
+    }
+    return total;
+}
+
+//! @note Endpoints quantized and ordered for 4 color mode, returns the block's squared error
+static uint32_t EncodeColorEndpoints(const uint8_t block[16][4], const float e0[3], const float e1[3], uint16_t& c0, uint16_t& c1, uint8_t indices[16]){
+    c0 = PackColor565(e0);
+    c1 = PackColor565(e1);
+    if(c0 < c1) std::swap(c0, c1);
+    if(c0 == c1){
+        //! @note A flat block, every pixel takes c0 (which is the same in both modes)
+        int palette[4][3];
+        ColorPalette(c0, c1, palette);
+        uint32_t total = 0;
+        for(int i = 0; i < 16; i++){
+            indices[i] = 0;
+            for(int c = 0; c < 3; c++) total += static_cast<uint32_t>((block[i][c] - palette[0][c]) * (block[i][c] - palette[0][c]));
+        }
+        return total;
+    }
+    int palette[4][3];
+    ColorPalette(c0, c1, palette);
+    return PickColorIndices(block, palette, indices);
+}
+
+//! @note The RGB half of BC1/BC3: 2 x 565 endpoints plus 2 bit indices, always in 4 color mode
+static void EncodeColorBlock(const uint8_t block[16][4], uint8_t out[8]){
+    float mean[3] = {}, minimum[3] = {255.0f, 255.0f, 255.0f}, maximum[3] = {};
+    for(int i = 0; i < 16; i++){
+        for(int c = 0; c < 3; c++){
+            mean[c] += block[i][c] / 16.0f;
+            minimum[c] = std::min(minimum[c], float(block[i][c]));
+            maximum[c] = std::max(maximum[c], float(block[i][c]));
+        }
+    }
+
+    //! @note Principal axis of the block's colors by power iteration on their covariance
+    float covariance[6] = {};
+    for(int i = 0; i < 16; i++){
+        float r = block[i][0] - mean[0], g = block[i][1] - mean[1], b = block[i][2] - mean[2];
+        covariance[0] += r * r; covariance[1] += r * g; covariance[2] += r * b;
+        covariance[3] += g * g; covariance[4] += g * b; covariance[5] += b * b;
+    }
+    float axis[3] = {maximum[0] - minimum[0], maximum[1] - minimum[1], maximum[2] - minimum[2]};
+    for(int iteration = 0; iteration < 8; iteration++){
+        float next[3] = {covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2],
+                         covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2],
+                         covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2]};
+        float length = std::max({std::fabs(next[0]), std::fabs(next[1]), std::fabs(next[2])});
+        if(length < 1e-6f) break;
+        for(int c = 0; c < 3; c++) axis[c] = next[c] / length;
+    }
+    float axisLength = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+    if(axisLength < 1e-6f){
+        axis[0] = axis[1] = axis[2] = 0.57735f;
+    }
+    else{
+        for(int c = 0; c < 3; c++) axis[c] /= axisLength;
+    }
+
+    float low = 0.0f, high = 0.0f;
+    for(int i = 0; i < 16; i++){
+        float t = (block[i][0] - mean[0]) * axis[0] + (block[i][1] - mean[1]) * axis[1] + (block[i][2] - mean[2]) * axis[2];
+        low = std::min(low, t);
+        high = std::max(high, t);
+    }
+    float e0[3], e1[3];
+    for(int c = 0; c < 3; c++){
+        e0[c] = mean[c] + axis[c] * high;
+        e1[c] = mean[c] + axis[c] * low;
+    }
+
+    uint16_t c0, c1;
+    uint8_t indices[16];
+    uint32_t error = EncodeColorEndpoints(block, e0, e1, c0, c1, indices);
+
+    //! @note Least squares endpoints for the indices just picked (pixel = w * e0 + (1 - w) * e1), kept only when they lower the error
+    static const float weights[4] = {1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f};
+    for(int iteration = 0; iteration < 2 && error > 0 && c0 != c1; iteration++){
+        float aa = 0.0f, ab = 0.0f, bb = 0.0f, ax[3] = {}, bx[3] = {};
+        for(int i = 0; i < 16; i++){
+            float w = weights[indices[i]], v = 1.0f - w;
+            aa += w * w; ab += w * v; bb += v * v;
+            for(int c = 0; c < 3; c++){
+                ax[c] += w * block[i][c];
+                bx[c] += v * block[i][c];
+            }
+        }
+        float determinant = aa * bb - ab * ab;
+        if(std::fabs(determinant) < 1e-6f) break;
+        for(int c = 0; c < 3; c++){
+            e0[c] = (ax[c] * bb - bx[c] * ab) / determinant;
+            e1[c] = (bx[c] * aa - ax[c] * ab) / determinant;
+        }
+
+        uint16_t r0, r1;
+        uint8_t refined[16];
+        uint32_t refinedError = EncodeColorEndpoints(block, e0, e1, r0, r1, refined);
+        if(refinedError >= error) break;
+        error = refinedError;
+        c0 = r0;
+        c1 = r1;
+        std::memcpy(indices, refined, sizeof(indices));
+    }
+
+    uint32_t bits = 0;
+    for(int i = 0; i < 16; i++) bits |= uint32_t(indices[i]) << (2 * i);
+    std::memcpy(out, &c0, 2);
+    std::memcpy(out + 2, &c1, 2);
+    std::memcpy(out + 4, &bits, 4);
+}
+
+static void AlphaPalette(uint8_t a0, uint8_t a1, int palette[8]){
+    palette[0] = a0;
+    palette[1] = a1;
+    if(a0 > a1){
+        for(int i = 1; i < 7; i++) palette[i + 1] = ((7 - i) * a0 + i * a1) / 7;
+    }
+    else{
+        for(int i = 1; i < 5; i++) palette[i + 1] = ((5 - i) * a0 + i * a1) / 5;
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+}
+
+//! @note One channel block of BC4 (and of BC3's alpha, BC5's red and green): 2 x 8 bit endpoints plus 3 bit indices, 8 value mode
+static void EncodeAlphaBlock(const uint8_t values[16], uint8_t out[8]){
+    uint8_t low = 255, high = 0;
+    for(int i = 0; i < 16; i++){
+        low = std::min(low, values[i]);
+        high = std::max(high, values[i]);
+    }
+
+    int palette[8];
+    AlphaPalette(high, low, palette);
+    uint64_t bits = 0;
+    if(high != low){
+        for(int i = 0; i < 16; i++){
+            int best = INT32_MAX;
+            uint64_t index = 0;
+            for(int p = 0; p < 8; p++){
+                int error = std::abs(values[i] - palette[p]);
+                if(error < best){
+                    best = error;
+                    index = static_cast<uint64_t>(p);
+                }
+            }
+            bits |= index << (3 * i);
+        }
+    }
+    out[0] = high;
+    out[1] = low;
+    for(int i = 0; i < 6; i++) out[2 + i] = static_cast<uint8_t>(bits >> (8 * i));
+}
+
+static void DecodeColorBlock(const uint8_t in[8], uint8_t block[16][4]){
+    uint16_t c0, c1;
+    uint32_t bits;
+    std::memcpy(&c0, in, 2);
+    std::memcpy(&c1, in + 2, 2);
+    std::memcpy(&bits, in + 4, 4);
+    int palette[4][3];
+    ColorPalette(c0, c1, palette);
+    for(int i = 0; i < 16; i++){
+        uint32_t index = (bits >> (2 * i)) & 3;
+        for(int c = 0; c < 3; c++) block[i][c] = static_cast<uint8_t>(palette[index][c]);
+        block[i][3] = (c0 <= c1 && index == 3) ? 0 : 255;
+    }
+}
+
+static void DecodeAlphaBlock(const uint8_t in[8], uint8_t values[16]){
+    int palette[8];
+    AlphaPalette(in[0], in[1], palette);
+    uint64_t bits = 0;
+    for(int i = 0; i < 6; i++) bits |= uint64_t(in[2 + i]) << (8 * i);
+    for(int i = 0; i < 16; i++) values[i] = static_cast<uint8_t>(palette[(bits >> (3 * i)) & 7]);
+}
+
+static void EncodeBlock(BlockFormat format, const uint8_t block[16][4], uint8_t* out){
+    uint8_t channel[16];
+    auto extract = [&](int c){
+        for(int i = 0; i < 16; i++) channel[i] = block[i][c];
+    };
+    switch(format){
+        case BlockFormat::BC1:
+            EncodeColorBlock(block, out);
+            break;
+        case BlockFormat::BC3:
+            extract(3);
+            EncodeAlphaBlock(channel, out);
+            EncodeColorBlock(block, out + 8);
+            break;
+        case BlockFormat::BC4:
+            extract(0);
+            EncodeAlphaBlock(channel, out);
+            break;
+        case BlockFormat::BC5:
+            extract(0);
+            EncodeAlphaBlock(channel, out);
+            extract(1);
+            EncodeAlphaBlock(channel, out + 8);
+            break;
+        default:
+            break;
+    }
+}
+
+static void DecodeBlock(BlockFormat format, const uint8_t* in, uint8_t block[16][4]){
+    uint8_t channel[16];
+    switch(format){
+        case BlockFormat::BC1:
+            DecodeColorBlock(in, block);
+            break;
+        case BlockFormat::BC3:
+            DecodeColorBlock(in + 8, block);
+            DecodeAlphaBlock(in, channel);
+            for(int i = 0; i < 16; i++) block[i][3] = channel[i];
+            break;
+        case BlockFormat::BC4:
+            DecodeAlphaBlock(in, channel);
+            for(int i = 0; i < 16; i++){
+                block[i][0] = channel[i];
+                block[i][1] = block[i][2] = 0;
+                block[i][3] = 255;
+            }
+            break;
+        case BlockFormat::BC5:
+            DecodeAlphaBlock(in, channel);
+            for(int i = 0; i < 16; i++) block[i][0] = channel[i];
+            DecodeAlphaBlock(in + 8, channel);
+            for(int i = 0; i < 16; i++){
+                block[i][1] = channel[i];
+                block[i][2] = 0;
+                block[i][3] = 255;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+//! @note Smallest format that keeps every channel the image has (RGBA with all alpha 255 counts as RGB)
+static BlockFormat ChooseBlockFormat(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t channels){
+    if(channels == 1) return BlockFormat::BC4;
+    if(channels == 2) return BlockFormat::BC5;
+    if(channels == 3) return BlockFormat::BC1;
+    size_t count = size_t(width) * height;
+    for(size_t i = 0; i < count; i++){
+        if(pixels[i * 4 + 3] != 255) return BlockFormat::BC3;
+    }
+    return BlockFormat::BC1;
+}
+
+//! @note Encodes one mip level, block rows are spread over pool when given
+static void CompressLevel(BlockFormat format, const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t channels, std::vector<uint8_t>& out,
+                          ThreadPool* pool = nullptr){
+    uint32_t blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+    size_t blockBytes = BlockBytes(format);
+    out.resize(size_t(blocksX) * blocksY * blockBytes);
+    auto encodeRow = [&](uint32_t blockY){
+        uint8_t block[16][4];
+        for(uint32_t blockX = 0; blockX < blocksX; blockX++){
+            FetchBlock(pixels, width, height, channels, blockX, blockY, block);
+            EncodeBlock(format, block, out.data() + (size_t(blockY) * blocksX + blockX) * blockBytes);
+        }
+    };
+    if(pool) pool->ParallelFor(blocksY, encodeRow);
+    else for(uint32_t y = 0; y < blocksY; y++) encodeRow(y);
+}
+
+//! @note Back to width * height * channels bytes, ex. to measure what the compression cost
+static void DecompressLevel(BlockFormat format, const uint8_t* blocks, uint32_t width, uint32_t height, uint32_t channels, std::vector<uint8_t>& out){
+    uint32_t blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+    size_t blockBytes = BlockBytes(format);
+    out.resize(size_t(width) * height * channels);
+    uint8_t block[16][4];
+    for(uint32_t blockY = 0; blockY < blocksY; blockY++){
+        for(uint32_t blockX = 0; blockX < blocksX; blockX++){
+            DecodeBlock(format, blocks + (size_t(blockY) * blocksX + blockX) * blockBytes, block);
+            for(uint32_t i = 0; i < 16; i++){
+                uint32_t x = blockX * 4 + i % 4, y = blockY * 4 + i / 4;
+                if(x >= width || y >= height) continue;
+                std::memcpy(out.data() + (size_t(y) * width + x) * channels, block[i], channels);
+            }
+        }
+    }
+}
+
+//! @note Peak signal to noise ratio in dB over count bytes, 99 for identical images
+static double ComputePsnr(const uint8_t* a, const uint8_t* b, size_t count){
+    double squared = 0.0;
+    for(size_t i = 0; i < count; i++){
+        double difference = double(a[i]) - double(b[i]);
+        squared += difference * difference;
+    }
+    if(count == 0 || squared == 0.0) return 99.0;
+    return std::min(99.0, 10.0 * std::log10(255.0 * 255.0 / (squared / double(count))));
+}
+
+static uint32_t MakeFourCC(char a, char b, char c, char d){
+    return uint32_t(uint8_t(a)) | (uint32_t(uint8_t(b)) << 8) | (uint32_t(uint8_t(c)) << 16) | (uint32_t(uint8_t(d)) << 24);
+}
+
+struct DdsPixelFormat{
+    uint32_t size;
+    uint32_t flags;
+    uint32_t fourCC;
+    uint32_t rgbBitCount;
+    uint32_t masks[4];
+};
+
+//! @note The legacy DDS header (no DX10 extension), DXT1/DXT5/ATI1/ATI2 four character codes are enough for the formats above
+struct DdsHeader{
+    uint32_t size;
+    uint32_t flags;
+    uint32_t height;
+    uint32_t width;
+    uint32_t linearSize;
+    uint32_t depth;
+    uint32_t mipMapCount;
+    uint32_t reserved1[11];
+    DdsPixelFormat format;
+    uint32_t caps[4];
+    uint32_t reserved2;
+};
+
+static constexpr uint32_t DDS_MAGIC = 0x20534444; // "DDS "
+
+static uint32_t BlockFormatFourCC(BlockFormat format){
+    switch(format){
+        case BlockFormat::BC1: return MakeFourCC('D', 'X', 'T', '1');
+        case BlockFormat::BC3: return MakeFourCC('D', 'X', 'T', '5');
+        case BlockFormat::BC4: return MakeFourCC('A', 'T', 'I', '1');
+        case BlockFormat::BC5: return MakeFourCC('A', 'T', 'I', '2');
+        default: return 0;
+    }
+}
+
+static BlockFormat FourCCBlockFormat(uint32_t fourCC){
+    if(fourCC == MakeFourCC('D', 'X', 'T', '1')) return BlockFormat::BC1;
+    if(fourCC == MakeFourCC('D', 'X', 'T', '5')) return BlockFormat::BC3;
+    if(fourCC == MakeFourCC('A', 'T', 'I', '1') || fourCC == MakeFourCC('B', 'C', '4', 'U')) return BlockFormat::BC4;
+    if(fourCC == MakeFourCC('A', 'T', 'I', '2') || fourCC == MakeFourCC('B', 'C', '5', 'U')) return BlockFormat::BC5;
+    return BlockFormat::None;
+}
+
+struct TextureCompressionReport{
+    BlockFormat format = BlockFormat::None;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t levels = 0;
+    size_t rawBytes = 0;        // the full mip chain uncompressed, what the raw path keeps in VRAM
+    size_t compressedBytes = 0; // the full mip chain in blocks
+    double psnr = 0.0;          // of the full resolution level against the source pixels
+};
+
+//! @note Encodes pixels and every level below it (same box filter as WriteBakedTexture), returns the raw bytes of the whole chain
+static size_t CompressMipChain(BlockFormat format, const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t channels,
+                               std::vector<std::vector<uint8_t>>& levels, ThreadPool* pool){
+    std::vector<uint8_t> current(pixels, pixels + size_t(width) * height * channels), next;
+    uint32_t levelWidth = width, levelHeight = height;
+    size_t rawBytes = 0;
+    for(uint32_t level = 0; level < BAKED_TEXTURE_MAX_LEVELS; level++){
+        rawBytes += current.size();
+        levels.emplace_back();
+        CompressLevel(format, current.data(), levelWidth, levelHeight, channels, levels.back(), pool);
+        if(levelWidth == 1 && levelHeight == 1) break;
+        DownsampleLevel(current.data(), levelWidth, levelHeight, channels, next);
+        current.swap(next);
+        levelWidth = std::max(1u, levelWidth / 2);
+        levelHeight = std::max(1u, levelHeight / 2);
+    }
+    return rawBytes;
+}
+
+/**
+ * @note Writes faceCount images (1, or 6 for a cubemap in +X -X +Y -Y +Z -Z order) of width * height * channels bytes each, with their whole
+ * @note mip chains, as a block compressed .dds. Cubemaps are laid out face by face, every face followed by its levels.
+ * @note report (optional) receives the sizes and the PSNR of level 0 (averaged over the faces). Returns false when the file cannot be written.
+*/
+static bool WriteCompressedImages(const std::string& path, const uint8_t* const* faces, uint32_t faceCount, uint32_t width, uint32_t height,
+                                  uint32_t channels, TextureCompressionReport* report, ThreadPool* pool){
+    BlockFormat format = BlockFormat::BC1;
+    for(uint32_t face = 0; face < faceCount; face++){
+        BlockFormat faceFormat = ChooseBlockFormat(faces[face], width, height, channels);
+        if(faceFormat != BlockFormat::BC1) format = faceFormat;
+    }
+
+    std::vector<std::vector<uint8_t>> levels;
+    size_t rawBytes = 0;
+    for(uint32_t face = 0; face < faceCount; face++){
+        rawBytes += CompressMipChain(format, faces[face], width, height, channels, levels, pool);
+    }
+    uint32_t levelCount = static_cast<uint32_t>(levels.size() / faceCount);
+
+    DdsHeader header = {};
+    header.size = sizeof(DdsHeader);
+    header.flags = 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000 | 0x80000; // caps, height, width, pixel format, mip count, linear size
+    header.height = height;
+    header.width = width;
+    header.linearSize = static_cast<uint32_t>(levels[0].size());
+    header.mipMapCount = levelCount;
+    header.format.size = sizeof(DdsPixelFormat);
+    header.format.flags = 0x4; // four character code
+    header.format.fourCC = BlockFormatFourCC(format);
+    header.caps[0] = 0x1000 | 0x400000 | 0x8; // texture, mipmap, complex
+    if(faceCount == 6){
+        header.caps[1] = 0x200 | 0xFC00; // cubemap, all six faces
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if(!file){
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(&DDS_MAGIC), sizeof(DDS_MAGIC));
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    size_t compressedBytes = 0;
+    for(const std::vector<uint8_t>& level : levels){
+        file.write(reinterpret_cast<const char*>(level.data()), static_cast<std::streamsize>(level.size()));
+        compressedBytes += level.size();
+    }
+    if(!file){
+        return false;
+    }
+
+    if(report){
+        double psnr = 0.0;
+        std::vector<uint8_t> decoded;
+        for(uint32_t face = 0; face < faceCount; face++){
+            DecompressLevel(format, levels[size_t(face) * levelCount].data(), width, height, channels, decoded);
+            psnr += ComputePsnr(faces[face], decoded.data(), decoded.size()) / faceCount;
+        }
+        report->format = format;
+        report->width = width;
+        report->height = height;
+        report->levels = levelCount;
+        report->rawBytes = rawBytes;
+        report->compressedBytes = compressedBytes;
+        report->psnr = psnr;
+    }
+    return true;
+}
+
+//! @note One 2D texture, see WriteCompressedImages
+static bool WriteCompressedTexture(const std::string& path, const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t channels,
+                                   TextureCompressionReport* report = nullptr, ThreadPool* pool = nullptr){
+    return WriteCompressedImages(path, &pixels, 1, width, height, channels, report, pool);
+}
+
+//! @note A .dds written by WriteCompressedImages (or any legacy DDS with the formats above), levels point into the file's bytes
+struct CompressedTextureFile{
+    bool Open(const std::string& path){
+        if(!file.Open(path) || file.size < sizeof(DDS_MAGIC) + sizeof(DdsHeader)){
+            return false;
+        }
+        uint32_t magic;
+        std::memcpy(&magic, file.data, sizeof(magic));
+        std::memcpy(&header, file.data + sizeof(magic), sizeof(header));
+        format = FourCCBlockFormat(header.format.fourCC);
+        if(magic != DDS_MAGIC || header.size != sizeof(DdsHeader) || format == BlockFormat::None || header.width == 0 || header.height == 0){
+            return false;
+        }
+
+        faceCount = (header.caps[1] & 0x200) ? 6 : 1;
+        if(faceCount == 6 && ((header.caps[1] & 0xFC00) != 0xFC00 || header.width != header.height)){
+            return false; // partial or non square cubemaps are not supported
+        }
+        levelCount = std::clamp<uint32_t>(header.mipMapCount, 1, BAKED_TEXTURE_MAX_LEVELS);
+        size_t offset = sizeof(DDS_MAGIC) + sizeof(DdsHeader);
+        levels.clear();
+        for(uint32_t face = 0; face < faceCount; face++){
+            uint32_t levelWidth = header.width, levelHeight = header.height;
+            for(uint32_t i = 0; i < levelCount; i++){
+                size_t size = CompressedLevelSize(format, levelWidth, levelHeight);
+                if(offset + size > file.size){
+                    return false;
+                }
+                levels.push_back({offset, size, levelWidth, levelHeight});
+                offset += size;
+                levelWidth = std::max(1u, levelWidth / 2);
+                levelHeight = std::max(1u, levelHeight / 2);
+            }
+        }
+        return true;
+    }
+
+    bool IsCubemap() const { return faceCount == 6; }
+
+    struct Level{
+        size_t offset;  // from the start of the file
+        size_t size;
+        uint32_t width;
+        uint32_t height;
+    };
+
+    const Level& GetLevel(uint32_t face, uint32_t level) const { return levels[size_t(face) * levelCount + level]; }
+    const uint8_t* LevelData(uint32_t face, uint32_t level) const { return file.data + GetLevel(face, level).offset; }
+
+    AssetFile file;
+    DdsHeader header = {};
+    BlockFormat format = BlockFormat::None;
+    uint32_t faceCount = 1;
+    uint32_t levelCount = 0;
+    std::vector<Level> levels; // faceCount * levelCount, face by face
+};
+
+static GLenum CompressedInternalFormat(BlockFormat format, bool gamma){
+    switch(format){
+        case BlockFormat::BC1: return gamma ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        case BlockFormat::BC3: return gamma ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        case BlockFormat::BC4: return GL_COMPRESSED_RED_RGTC1;
+        case BlockFormat::BC5: return GL_COMPRESSED_RG_RGTC2;
+        default: return 0;
+    }
+}
+
+/**
+ * @note RGTC (BC4/BC5) is core since GL 3.0, S3TC (BC1/BC3) is an extension every desktop driver has but that we still check, through the
+ * @note driver's list of compressed formats. Queried once, needs a current context.
+*/
+static bool CompressedFormatSupported(GLenum internalFormat){
+    if(internalFormat == GL_COMPRESSED_RED_RGTC1 || internalFormat == GL_COMPRESSED_RG_RGTC2){
+        return true;
+    }
+    static std::vector<GLint> formats = [](){
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_COMPRESSED_TEXTURE_FORMATS, &count);
+        std::vector<GLint> list(static_cast<size_t>(std::max(count, 0)));
+        if(count > 0) glGetIntegerv(GL_COMPRESSED_TEXTURE_FORMATS, list.data());
+        return list;
+    }();
+    return std::find(formats.begin(), formats.end(), static_cast<GLint>(internalFormat)) != formats.end();
+}
+
+//! @note Uploads every level of a 2D .dds to target (GL_TEXTURE_2D, or a cubemap face with its cubemap bound), returns the bytes uploaded
+//! @note or 0 when the format is not supported (cubemap files go through LoadCubemap, see CubemapLoader.h)
+//! @note firstLevel > 0 leaves the larger levels out and makes firstLevel the base level (2D only, see TextureResidency.h)
+static size_t UploadCompressedTexture(GLenum target, const CompressedTextureFile& compressed, bool gamma, uint32_t firstLevel = 0){
+    GLenum internalFormat = CompressedInternalFormat(compressed.format, gamma);
+    if(compressed.IsCubemap() || !CompressedFormatSupported(internalFormat)){
+        return 0;
+    }
+
+    size_t bytes = 0;
+    firstLevel = target == GL_TEXTURE_2D ? std::min(firstLevel, compressed.levelCount - 1) : 0;
+    for(uint32_t i = firstLevel; i < compressed.levelCount; i++){
+        const CompressedTextureFile::Level& level = compressed.GetLevel(0, i);
+        glCompressedTexImage2D(target, static_cast<GLint>(i), internalFormat, level.width, level.height, 0, static_cast<GLsizei>(level.size),
+                               compressed.LevelData(0, i));
+        bytes += level.size;
+    }
+    if(target == GL_TEXTURE_2D){
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, static_cast<GLint>(firstLevel));
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(compressed.levelCount - 1));
+    }
+    return bytes;
+}
+
+static void PrintTextureCompressionReport(const std::string& name, const TextureCompressionReport& report){
+    printf("%s: %ux%u %s, %u levels, %.2f MB -> %.2f MB (%.1fx smaller), PSNR %.2f dB\n", name.c_str(), report.width, report.height,
+           BlockFormatName(report.format), report.levels, report.rawBytes / (1024.0 * 1024.0), report.compressedBytes / (1024.0 * 1024.0),
+           double(report.rawBytes) / std::max<double>(double(report.compressedBytes), 1.0), report.psnr);
+}
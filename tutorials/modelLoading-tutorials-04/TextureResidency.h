@@ -0,0 +1,524 @@
+#pragma once
+#include <cmath>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <algorithm>
+#include <unordered_map>
+#include <glad/glad.h>
+
+#include "stb_image.h"
+#include "AssetPack.h"
+#include "BakedAssets.h"
+#include "TextureCache.h"
+#include "TextureCompression.h"
+#include "ThreadPool.h"
+
+/**
+ * @param TextureResidency
+ * @note Keeps the textures drawn through Model::Draw(shader, LodView) within a GPU memory budget, at the resolution the screen needs
+ * @note    requests    Mesh::RequestTextureResidency reports the largest size every texture is seen at this frame, in pixels, and the level it
+ * @note                needs is log2(texture size / screen size) + bias, never coarser than the level of minimumSize
+ * @note    streaming   missing finer levels are read on the pool (the .dds or .tex level by level, or the image decoded and downsampled again)
+ * @note                and uploaded on the GL thread, at most uploadBytesPerFrame per frame
+ * @note    eviction    over budget, the finest level of the least recently used texture goes first. Textures seen this frame keep the levels
+ * @note                they need, if that alone is over budget the bias goes up a level for everything, and back down once there is room.
+ * @note The GL name never changes, so meshes keep their ids: dropped levels are respecified empty below GL_TEXTURE_BASE_LEVEL, streamed
+ * @note levels are filled back in above it. Textures with nothing to read their levels from again (decoded from memory) are left alone.
+ * @note Call EndFrame() once per frame after the draws, GetFrameStats() then holds that frame's numbers
+*/
+
+struct TextureResidencySettings{
+    size_t budgetBytes = size_t(256) << 20;
+    uint32_t minimumSize = 64;                      // levels this small and smaller are never dropped
+    uint32_t initialSize = 256;                     // baked textures start out with only the levels up to this size (TextureCache::SetInitialMaxSize)
+    size_t uploadBytesPerFrame = size_t(16) << 20;  // a single larger load still goes through, alone
+    uint32_t loadsInFlight = 8;
+    uint32_t maxBias = 4;
+    float lowWater = 0.75f;                         // the bias only goes back down if the finer levels fit in budget * lowWater
+    ThreadPool* pool = nullptr;                     // nullptr uses SharedThreadPool()
+};
+
+struct TextureResidencyStats{
+    uint32_t textures = 0;      // tracked
+    uint32_t requested = 0;     // of those, drawn this frame
+    size_t residentBytes = 0;   // levels of tracked textures in VRAM
+    size_t fullBytes = 0;       // what the tracked textures would take with every level
+    uint32_t pending = 0;       // loads in flight
+    uint32_t loadsStarted = 0;
+    uint32_t failedLoads = 0;   // the source could not be read again, that texture keeps its levels from then on
+    uint32_t uploads = 0;       // levels uploaded
+    size_t uploadedBytes = 0;
+    uint32_t evictions = 0;     // levels dropped
+    size_t evictedBytes = 0;
+    uint32_t bias = 0;
+    double milliseconds = 0.0;  // GL thread time of EndFrame
+};
+
+class TextureResidency{
+public:
+    //! @note Same ordering as TextureCache: the cache (and through it the deletion queue) outlives the residency manager that calls into it
+    TextureResidency(){
+        GlobalTextureCache();
+    }
+
+    //! @note Turns the manager on, Request() is ignored until then
+    void Enable(const TextureResidencySettings& options = TextureResidencySettings()){
+        settings = options;
+        enabled = true;
+        GlobalTextureCache().SetInitialMaxSize(settings.initialSize);
+    }
+
+    //! @note Stops tracking, resident levels stay as they are
+    void Disable(){
+        enabled = false;
+        entries.clear();
+        GlobalTextureCache().SetInitialMaxSize(0);
+    }
+
+    bool Enabled() const { return enabled; }
+
+    //! @note handle is drawn covering screenSize pixels across (the whole texture, not just the part the mesh uses) this frame
+    void Request(const TextureHandle& handle, float screenSize){
+        if(!enabled || !handle) return;
+        auto [found, inserted] = entries.try_emplace(handle.get());
+        Entry& entry = found->second;
+        //! @note A rejected handle stays in the map and is only looked at again once its upload or source changed (ex. an async load finished)
+        bool changed = entry.rejected && (entry.kind != handle->sourceKind || entry.sourceBytes != handle->bytes);
+        if((inserted || entry.resource.expired() || changed) && !Register(handle, entry)) return;
+        if(entry.rejected) return;
+        entry.screenSize = std::max(entry.screenSize, screenSize);
+        entry.lastUsed = frame;
+    }
+
+    //! @note Once per frame after the draws: finishes loads, evicts down to the budget and starts the loads this frame's requests need
+    void EndFrame(){
+        if(!enabled) return;
+        auto start = std::chrono::steady_clock::now();
+        uint32_t pendingCount = stats.pending;
+        stats = TextureResidencyStats();
+        stats.pending = pendingCount;
+
+        for(auto it = entries.begin(); it != entries.end();){
+            it = it->second.resource.expired() ? entries.erase(it) : std::next(it);
+        }
+
+        //! @note Levels wanted by what was drawn, what they take, and what they would take one bias step finer (to know when the bias may come down)
+        size_t wantedBytes = 0, finerBytes = 0;
+        for(auto& [key, entry] : entries){
+            if(entry.lastUsed != frame) continue;
+            stats.requested++;
+            float needed = std::log2(float(std::max(entry.width, entry.height)) / std::max(entry.screenSize, 1.0f));
+            uint32_t level = static_cast<uint32_t>(std::max(std::floor(needed), 0.0f));
+            //! @note A source that failed to load cannot give finer levels, it wants what it has
+            if(entry.failed) level = std::max(level, entry.residentLevel);
+            entry.wantedLevel = std::min(level + bias, MinimumLevel(entry));
+            entry.lastScreenSize = entry.screenSize;
+            entry.screenSize = 0.0f;
+            wantedBytes += ChainBytes(entry, entry.wantedLevel);
+            finerBytes += ChainBytes(entry, std::min(level + (bias ? bias - 1 : 0), MinimumLevel(entry)));
+        }
+
+        CompleteLoads();
+        EvictTo(settings.budgetBytes);
+        if(wantedBytes > settings.budgetBytes){
+            bias = std::min(bias + 1, settings.maxBias);
+        }
+        else if(bias > 0 && finerBytes < size_t(double(settings.budgetBytes) * settings.lowWater)){
+            bias--;
+        }
+        StartLoads();
+
+        stats.residentBytes = ResidentBytes();
+        for(const auto& [key, entry] : entries){
+            if(entry.rejected) continue;
+            stats.textures++;
+            stats.fullBytes += ChainBytes(entry, 0);
+        }
+        stats.pending = static_cast<uint32_t>(loads.size());
+        stats.bias = bias;
+        stats.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        frame++;
+    }
+
+    //! @note Checks every tracked texture's levels in GL against the bookkeeping (empty below the base level, full size from it on), returns the mismatches
+    uint32_t Verify() const{
+        uint32_t mismatches = 0;
+        for(const auto& [key, entry] : entries){
+            TextureHandle resource = entry.resource.lock();
+            if(!resource || entry.rejected) continue;
+            GLint base = 0;
+            glBindTexture(GL_TEXTURE_2D, resource->texture.Get());
+            glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, &base);
+            mismatches += static_cast<uint32_t>(base) != entry.residentLevel;
+            for(uint32_t level = 0; level < entry.levelCount; level++){
+                GLint width = 0;
+                glGetTexLevelParameteriv(GL_TEXTURE_2D, static_cast<GLint>(level), GL_TEXTURE_WIDTH, &width);
+                uint32_t expected = level < entry.residentLevel ? 0 : std::max(1u, entry.width >> level);
+                mismatches += static_cast<uint32_t>(width) != expected;
+            }
+        }
+        glBindTexture(GL_TEXTURE_2D, 0);
+        return mismatches;
+    }
+
+    const TextureResidencyStats& GetFrameStats() const { return stats; }
+    const TextureResidencySettings& GetSettings() const { return settings; }
+
+    void PrintFrameStats() const{
+        printf("Texture residency: %.2f of %.2f MB resident (%u textures, %u drawn, %.2f MB with every level), %u pending, %u failed, %u levels uploaded (%.2f MB), "
+               "%u evicted (%.2f MB), bias %u, %.3f ms\n",
+               stats.residentBytes / (1024.0 * 1024.0), settings.budgetBytes / (1024.0 * 1024.0), stats.textures, stats.requested,
+               stats.fullBytes / (1024.0 * 1024.0), stats.pending, stats.failedLoads, stats.uploads, stats.uploadedBytes / (1024.0 * 1024.0), stats.evictions,
+               stats.evictedBytes / (1024.0 * 1024.0), stats.bias, stats.milliseconds);
+    }
+
+private:
+    struct Entry{
+        std::weak_ptr<TextureResource> resource;
+        uint64_t generation = 0;        // a recycled TextureResource address is a new entry, loads for the old one are dropped
+        TextureSourceKind kind = TextureSourceKind::Memory;
+        std::string path;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t levelCount = 0;
+        uint32_t channels = 0;          // raw levels
+        BlockFormat blockFormat = BlockFormat::None;
+        GLenum internalFormat = GL_RGBA;
+        GLenum format = GL_RGBA;
+        uint32_t residentLevel = 0;     // GL_TEXTURE_BASE_LEVEL, every level from here down is resident
+        uint32_t wantedLevel = 0;
+        float screenSize = 0.0f;        // largest request this frame
+        float lastScreenSize = 0.0f;
+        uint64_t lastUsed = 0;          // frame of the last request
+        bool loading = false;
+        size_t bytes = 0;               // resident
+        bool failed = false;            // a load from its source failed (missing or changed file), no more loads or evictions until registered again
+        bool rejected = false;          // Register could not take it, kept so it is not tried again every request
+        size_t sourceBytes = 0;         // the resource's bytes when it was rejected, a change means it was uploaded since
+    };
+
+    //! @note Levels [first, end) read on the pool, uploaded by CompleteLoads
+    struct Load{
+        const TextureResource* key = nullptr;
+        uint64_t generation = 0;
+        uint32_t first = 0;
+        uint32_t end = 0;
+        size_t bytes = 0;
+        std::vector<std::vector<uint8_t>> levels;
+        std::atomic<bool> ready{false};
+        bool failed = false;
+    };
+
+    static GLenum ChannelFormat(uint32_t channels){
+        static const GLenum formats[] = {GL_RED, GL_RG, GL_RGB, GL_RGBA};
+        return formats[std::clamp(channels, 1u, 4u) - 1];
+    }
+
+    //! @note Same formats as TextureCache's uploads, a respecified level has to match the levels already there
+    static GLenum ChannelInternalFormat(uint32_t channels, bool gamma){
+        if(gamma && channels == 3) return GL_SRGB8;
+        if(gamma && channels == 4) return GL_SRGB8_ALPHA8;
+        return ChannelFormat(channels);
+    }
+
+    //! @note Reads the source's header for the full chain's layout, false (and entry marked rejected) for textures this manager cannot stream
+    bool Register(const TextureHandle& handle, Entry& entry){
+        entry = Entry();
+        entry.resource = handle;
+        entry.generation = ++generations;
+        entry.kind = handle->sourceKind;
+        entry.sourceBytes = handle->bytes;
+        entry.rejected = true;
+        if(handle->sourceKind == TextureSourceKind::Memory || handle->bytes == 0 || !handle->texture){
+            return false; // nothing to read levels from, or an async load that is not uploaded yet
+        }
+        entry.path = handle->sourcePath;
+        bool gamma = handle->key.params.gamma;
+
+        if(entry.kind == TextureSourceKind::Compressed){
+            CompressedTextureFile compressed;
+            if(!compressed.Open(entry.path)) return false;
+            entry.width = compressed.header.width;
+            entry.height = compressed.header.height;
+            entry.levelCount = compressed.levelCount;
+            entry.blockFormat = compressed.format;
+            entry.internalFormat = CompressedInternalFormat(compressed.format, gamma);
+        }
+        else if(entry.kind == TextureSourceKind::Baked){
+            BakedTextureFile baked;
+            if(!baked.Open(entry.path)) return false;
+            entry.width = baked.header->width;
+            entry.height = baked.header->height;
+            entry.levelCount = baked.header->levelCount;
+            entry.channels = baked.header->channels;
+        }
+        else{
+            AssetFile file(entry.path);
+            int w = 0, h = 0, channels = 0;
+            if(!file.IsOpen() || !stbi_info_from_memory(file.data, static_cast<int>(file.size), &w, &h, &channels)) return false;
+            entry.width = static_cast<uint32_t>(w);
+            entry.height = static_cast<uint32_t>(h);
+            entry.levelCount = static_cast<uint32_t>(std::log2(std::max(w, h))) + 1; // glGenerateMipmap's chain
+            entry.channels = static_cast<uint32_t>(channels);
+        }
+        if(entry.blockFormat == BlockFormat::None){
+            entry.format = ChannelFormat(entry.channels);
+            entry.internalFormat = ChannelInternalFormat(entry.channels, gamma);
+        }
+
+        GLint base = 0;
+        glBindTexture(GL_TEXTURE_2D, handle->texture.Get());
+        glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, &base);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        entry.residentLevel = std::min(static_cast<uint32_t>(base), entry.levelCount - 1);
+        entry.wantedLevel = entry.residentLevel;
+        entry.bytes = ChainBytes(entry, entry.residentLevel);
+        entry.rejected = false;
+        GlobalTextureCache().SetResidentBytes(*handle, entry.bytes);
+        return true;
+    }
+
+    static size_t LevelBytes(const Entry& entry, uint32_t level){
+        uint32_t w = std::max(1u, entry.width >> level), h = std::max(1u, entry.height >> level);
+        return entry.blockFormat != BlockFormat::None ? CompressedLevelSize(entry.blockFormat, w, h) : size_t(w) * h * entry.channels;
+    }
+
+    //! @note Bytes of every level from first down to 1x1
+    static size_t ChainBytes(const Entry& entry, uint32_t first){
+        size_t bytes = 0;
+        for(uint32_t level = first; level < entry.levelCount; level++){
+            bytes += LevelBytes(entry, level);
+        }
+        return bytes;
+    }
+
+    uint32_t MinimumLevel(const Entry& entry) const{
+        uint32_t level = 0;
+        while(level + 1 < entry.levelCount && std::max(entry.width >> level, entry.height >> level) > settings.minimumSize){
+            level++;
+        }
+        return level;
+    }
+
+    size_t ResidentBytes() const{
+        size_t bytes = 0;
+        for(const auto& [key, entry] : entries){
+            bytes += entry.bytes;
+        }
+        return bytes;
+    }
+
+    //! @note Drops the finest resident level, false when the texture is loading or already down to its minimum
+    bool DropLevel(Entry& entry){
+        TextureHandle resource = entry.resource.lock();
+        if(!resource || entry.loading || entry.residentLevel >= MinimumLevel(entry)){
+            return false;
+        }
+        uint32_t level = entry.residentLevel++;
+        glBindTexture(GL_TEXTURE_2D, resource->texture.Get());
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, static_cast<GLint>(entry.residentLevel));
+        if(entry.blockFormat != BlockFormat::None){
+            glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), entry.internalFormat, 0, 0, 0, 0, nullptr);
+        }
+        else{
+            glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), entry.internalFormat, 0, 0, 0, entry.format, GL_UNSIGNED_BYTE, nullptr);
+        }
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        size_t bytes = LevelBytes(entry, level);
+        entry.bytes -= bytes;
+        GlobalTextureCache().SetResidentBytes(*resource, entry.bytes);
+        stats.evictions++;
+        stats.evictedBytes += bytes;
+        return true;
+    }
+
+    /**
+     * @note Least recently used first, one level at a time, until resident plus pending bytes fit in target
+     * @note A texture drawn this frame only gives up levels finer than it needs
+    */
+    void EvictTo(size_t target){
+        if(ResidentBytes() + pendingBytes <= target) return;
+        std::vector<Entry*> candidates;
+        for(auto& [key, entry] : entries){
+            if(!entry.loading && !entry.failed && entry.residentLevel < MinimumLevel(entry) && (entry.lastUsed != frame || entry.residentLevel < entry.wantedLevel)){
+                candidates.push_back(&entry);
+            }
+        }
+        std::sort(candidates.begin(), candidates.end(), [](const Entry* a, const Entry* b){
+            return a->lastUsed != b->lastUsed ? a->lastUsed < b->lastUsed : a->lastScreenSize < b->lastScreenSize;
+        });
+
+        size_t resident = ResidentBytes();
+        for(Entry* entry : candidates){
+            while(resident + pendingBytes > target && (entry->lastUsed != frame || entry->residentLevel < entry->wantedLevel)){
+                size_t before = entry->bytes;
+                if(!DropLevel(*entry)) break;
+                resident -= before - entry->bytes;
+            }
+            if(resident + pendingBytes <= target) break;
+        }
+    }
+
+    //! @note Uploads finished loads in the order they started, until uploadBytesPerFrame is used up
+    void CompleteLoads(){
+        size_t uploaded = 0;
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        for(std::shared_ptr<Load>& load : loads){
+            if(!load->ready.load(std::memory_order_acquire)) continue;
+            if(uploaded > 0 && uploaded + load->bytes > settings.uploadBytesPerFrame) break;
+
+            pendingBytes -= load->bytes;
+            auto found = entries.find(load->key);
+            TextureHandle resource = found != entries.end() && found->second.generation == load->generation ? found->second.resource.lock() : nullptr;
+            if(resource){
+                Entry& entry = found->second;
+                entry.loading = false;
+                if(load->failed){
+                    printf("Texture residency: could not read levels %u-%u of %s, keeping its resident levels\n", load->first, load->end - 1, entry.path.c_str());
+                    entry.failed = true;
+                    stats.failedLoads++;
+                }
+                else{
+                    glBindTexture(GL_TEXTURE_2D, resource->texture.Get());
+                    for(uint32_t level = load->first; level < load->end; level++){
+                        const std::vector<uint8_t>& data = load->levels[level - load->first];
+                        GLsizei w = static_cast<GLsizei>(std::max(1u, entry.width >> level)), h = static_cast<GLsizei>(std::max(1u, entry.height >> level));
+                        if(entry.blockFormat != BlockFormat::None){
+                            glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), entry.internalFormat, w, h, 0, static_cast<GLsizei>(data.size()),
+                                                   data.data());
+                        }
+                        else{
+                            glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), entry.internalFormat, w, h, 0, entry.format, GL_UNSIGNED_BYTE, data.data());
+                        }
+                        stats.uploads++;
+                    }
+                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, static_cast<GLint>(load->first));
+                    glBindTexture(GL_TEXTURE_2D, 0);
+                    entry.residentLevel = load->first;
+                    entry.bytes += load->bytes;
+                    GlobalTextureCache().SetResidentBytes(*resource, entry.bytes);
+                    stats.uploadedBytes += load->bytes;
+                    uploaded += load->bytes;
+                }
+            }
+            load.reset();
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        loads.erase(std::remove(loads.begin(), loads.end(), nullptr), loads.end());
+    }
+
+    /**
+     * @note Textures drawn this frame that need finer levels, the largest shortfall first. A load takes the finest levels that fit in the budget
+     * @note once textures not drawn this frame have made room, which may be short of the wanted level (the rest comes once there is room)
+    */
+    void StartLoads(){
+        std::vector<std::pair<const TextureResource*, Entry*>> candidates;
+        for(auto& [key, entry] : entries){
+            if(entry.lastUsed == frame && !entry.loading && !entry.failed && entry.wantedLevel < entry.residentLevel){
+                candidates.push_back({key, &entry});
+            }
+        }
+        std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b){
+            uint32_t shortA = a.second->residentLevel - a.second->wantedLevel, shortB = b.second->residentLevel - b.second->wantedLevel;
+            return shortA != shortB ? shortA > shortB : a.second->lastScreenSize > b.second->lastScreenSize;
+        });
+
+        ThreadPool& pool = settings.pool ? *settings.pool : SharedThreadPool();
+        for(auto& [key, entry] : candidates){
+            if(loads.size() >= settings.loadsInFlight) break;
+            size_t cost = 0;
+            uint32_t first = entry->residentLevel;
+            while(first > entry->wantedLevel){
+                cost += LevelBytes(*entry, first - 1);
+                first--;
+            }
+            EvictTo(cost > settings.budgetBytes ? 0 : settings.budgetBytes - cost);
+            size_t room = settings.budgetBytes > ResidentBytes() + pendingBytes ? settings.budgetBytes - ResidentBytes() - pendingBytes : 0;
+            while(first < entry->residentLevel && cost > room){
+                cost -= LevelBytes(*entry, first);
+                first++;
+            }
+            if(first == entry->residentLevel) continue;
+
+            auto load = std::make_shared<Load>();
+            load->key = key;
+            load->generation = entry->generation;
+            load->first = first;
+            load->end = entry->residentLevel;
+            load->bytes = cost;
+            entry->loading = true;
+            pendingBytes += cost;
+            loads.push_back(load);
+            stats.loadsStarted++;
+
+            pool.Submit([load, kind = entry->kind, path = entry->path, channels = entry->channels](){
+                load->failed = !ReadLevels(kind, path, channels, *load);
+                load->ready.store(true, std::memory_order_release);
+            });
+        }
+    }
+
+    //! @note Runs on the pool: the levels [first, end) of the source, decoded and downsampled again for plain images
+    static bool ReadLevels(TextureSourceKind kind, const std::string& path, uint32_t channels, Load& load){
+        load.levels.clear();
+        if(kind == TextureSourceKind::Compressed){
+            CompressedTextureFile compressed;
+            if(!compressed.Open(path) || load.end > compressed.levelCount) return false;
+            for(uint32_t level = load.first; level < load.end; level++){
+                const uint8_t* data = compressed.LevelData(0, level);
+                load.levels.emplace_back(data, data + compressed.GetLevel(0, level).size);
+            }
+            return true;
+        }
+        if(kind == TextureSourceKind::Baked){
+            BakedTextureFile baked;
+            if(!baked.Open(path) || load.end > baked.header->levelCount) return false;
+            for(uint32_t level = load.first; level < load.end; level++){
+                load.levels.emplace_back(baked.LevelData(level), baked.LevelData(level) + baked.LevelSize(level));
+            }
+            return true;
+        }
+
+        AssetFile file(path);
+        int w = 0, h = 0, decodedChannels = 0;
+        unsigned char* pixels = file.IsOpen() ? stbi_load_from_memory(file.data, static_cast<int>(file.size), &w, &h, &decodedChannels, 0) : nullptr;
+        if(!pixels) return false;
+        std::vector<uint8_t> level(pixels, pixels + size_t(w) * h * decodedChannels), next;
+        stbi_image_free(pixels);
+        if(static_cast<uint32_t>(decodedChannels) != channels) return false;
+
+        uint32_t levelWidth = static_cast<uint32_t>(w), levelHeight = static_cast<uint32_t>(h);
+        for(uint32_t i = 0; i < load.end; i++){
+            if(i >= load.first) load.levels.push_back(level);
+            if(i + 1 < load.end){
+                DownsampleLevel(level.data(), levelWidth, levelHeight, channels, next);
+                level.swap(next);
+                levelWidth = std::max(1u, levelWidth / 2);
+                levelHeight = std::max(1u, levelHeight / 2);
+            }
+        }
+        return true;
+    }
+
+    bool enabled = false;
+    TextureResidencySettings settings;
+    std::unordered_map<const TextureResource*, Entry> entries;
+    std::vector<std::shared_ptr<Load>> loads;
+    size_t pendingBytes = 0;
+    uint32_t bias = 0;
+    uint64_t frame = 1;
+    uint64_t generations = 0;
+    TextureResidencyStats stats;
+};
+
+//! @note Process-wide, off until Enable() is called
+static TextureResidency& GlobalTextureResidency(){
+    static TextureResidency residency;
+    return residency;
+}
@@ -0,0 +1,139 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @param ThreadPool
+ * @note Fixed set of worker threads pulling jobs from one shared queue
+ * @note Used by the model loaders for CPU-only work (mesh extraction, image decoding, ...)
+ * @note Jobs must never touch OpenGL, the GL context is only current on the main thread
+*/
+class ThreadPool{
+public:
+    ThreadPool(uint32_t threadCount = std::thread::hardware_concurrency()){
+        if(threadCount == 0) threadCount = 1;
+
+        for(uint32_t i = 0; i < threadCount; i++){
+            workers.emplace_back([this](){ WorkerLoop(); });
+        }
+    }
+
+    ~ThreadPool(){
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        jobAvailable.notify_all();
+
+        for(std::thread& worker : workers){
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void Submit(std::function<void()> job){
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.push_back(std::move(job));
+            pendingJobs++;
+        }
+        jobAvailable.notify_one();
+    }
+
+    //! @note Blocks until every job submitted so far has finished
+    void Wait(){
+        std::unique_lock<std::mutex> lock(mutex);
+        jobsFinished.wait(lock, [this](){ return pendingJobs == 0; });
+    }
+
+    /**
+     * @note Calls function(i) for every i in [0, count) across the workers and returns once all of them are done
+     * @note Indices are handed out dynamically one at a time, so a few very large items (ex. one huge sub-mesh) do not stall a whole chunk
+     * @note The calling thread takes indices too and only waits for indices someone already claimed, so ParallelFor may be called
+     * @note from inside a pool job (ex. the OBJ parser running in a streaming load) without waiting on workers that are all busy
+    */
+    template<typename Function>
+    void ParallelFor(uint32_t count, Function&& function){
+        if(count == 0) return;
+
+        //! @note Helper jobs can start after the caller returned (they then find no index left), so what they touch is shared
+        struct Progress{
+            std::atomic<uint32_t> next{0};
+            std::atomic<uint32_t> finished{0};
+            std::mutex mutex;
+            std::condition_variable done;
+        };
+        std::shared_ptr<Progress> progress = std::make_shared<Progress>();
+        auto* callable = &function; // only called for claimed indices, which the caller waits for
+
+        auto work = [progress, callable, count](){
+            uint32_t completed = 0;
+            for(uint32_t i = progress->next.fetch_add(1); i < count; i = progress->next.fetch_add(1)){
+                (*callable)(i);
+                completed++;
+            }
+
+            if(completed != 0 && progress->finished.fetch_add(completed) + completed == count){
+                std::lock_guard<std::mutex> lock(progress->mutex);
+                progress->done.notify_one();
+            }
+        };
+
+        uint32_t helpers = count - 1 < ThreadCount() ? count - 1 : ThreadCount();
+        for(uint32_t job = 0; job < helpers; job++){
+            Submit(work);
+        }
+        work();
+
+        std::unique_lock<std::mutex> lock(progress->mutex);
+        progress->done.wait(lock, [&](){ return progress->finished.load() == count; });
+    }
+
+    uint32_t ThreadCount() const { return static_cast<uint32_t>(workers.size()); }
+
+private:
+    void WorkerLoop(){
+        while(true){
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                jobAvailable.wait(lock, [this](){ return stopping || !jobs.empty(); });
+
+                if(jobs.empty()) return; // only reached when stopping
+
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+
+            job();
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if(--pendingJobs == 0){
+                jobsFinished.notify_all();
+            }
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> jobs;
+    std::mutex mutex;
+    std::condition_variable jobAvailable;
+    std::condition_variable jobsFinished;
+    uint32_t pendingJobs = 0;
+    bool stopping = false;
+};
+
+//! @note Process-wide pool sized to the machine, created on first use
+static ThreadPool& SharedThreadPool(){
+    static ThreadPool pool;
+    return pool;
+}
@@ -0,0 +1,758 @@
+#pragma once
+#include <list>
+#include <cmath>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+#include <glad/glad.h>
+
+#include "stb_image.h"
+#include "AssetPack.h"
+#include "BakedAssets.h"
+#include "GLResources.h"
+#include "RenderStats.h"
+#include "ThreadPool.h"
+
+/**
+ * @param VirtualTexture
+ * @note Textures far larger than the VRAM they are allowed, without sparse texture extensions (runs on software GL drivers too)
+ * @note    on disk     <texture>.vtex: every mip level cut into tileSize x tileSize tiles, each stored with a border of its neighbours' texels
+ * @note                so bilinear filtering across tile edges is right (WriteVirtualTexture, the asset baker writes them with --virtual)
+ * @note    physical    one cache texture of cachePages x cachePages pages, a page holds any tile of any level, least recently used goes first
+ * @note    page table  one RGBA8 texel per tile of every level (a mipmapped texture) with the page and level of the finest resident tile
+ * @note                covering it, so a tile still streaming samples its parent instead and sharpens once it arrives
+ * @note    feedback    the scene drawn into a small integer target (VirtualTextureFeedback) records the tile and level every pixel wants,
+ * @note                read back a frame later through a PBO and handed to VirtualTexture::Update
+ * @note The shader side is SampleVirtual in virtualTexture.frag, virtualTextureFeedback.frag writes the feedback
+ * @note Tiles are copied out of the file on the thread pool (where the disk reads happen), the GL thread only uploads tiles that are ready
+*/
+
+static constexpr uint32_t VIRTUAL_TEXTURE_VERSION = 1;
+static constexpr char VIRTUAL_TEXTURE_MAGIC[4] = {'V', 'T', 'E', 'X'};
+static constexpr const char* VIRTUAL_TEXTURE_EXTENSION = ".vtex";
+static constexpr uint32_t VIRTUAL_TEXTURE_MAX_LEVELS = 16;
+
+struct VirtualTextureHeader{
+    char magic[4];
+    uint32_t version;
+    uint32_t width;         // of the source image
+    uint32_t height;
+    uint32_t tileSize;      // image texels per tile side
+    uint32_t border;        // texels stored around every tile, a stored tile is tileSize + 2 * border texels wide, RGBA8
+    uint32_t tilesX;        // level 0 tile grid, powers of two so every level's grid is exactly half the previous (the page table's mip chain)
+    uint32_t tilesY;
+    uint32_t levelCount;    // down to a 1x1 grid
+    uint32_t tileCount;     // uint64_t offsets follow the header, every level's grid row by row, 0 for tiles past the image
+};
+
+static uint32_t VirtualGridSize(uint32_t tiles, uint32_t level){
+    return std::max(1u, tiles >> level);
+}
+
+static uint32_t RoundUpToPowerOfTwo(uint32_t value){
+    uint32_t power = 1;
+    while(power < value) power *= 2;
+    return power;
+}
+
+//! @note One stored tile: the tileSize square at (x, y) of a level plus its border, texels past the level's edges repeat the edge
+static void ExtractVirtualTile(const uint8_t* level, uint32_t levelWidth, uint32_t levelHeight, uint32_t x, uint32_t y, uint32_t pageSize,
+                               uint32_t border, uint8_t* out){
+    for(uint32_t row = 0; row < pageSize; row++){
+        int64_t sourceY = std::clamp<int64_t>(int64_t(y) + row - border, 0, levelHeight - 1);
+        const uint8_t* in = level + size_t(sourceY) * levelWidth * 4;
+        for(uint32_t column = 0; column < pageSize; column++){
+            int64_t sourceX = std::clamp<int64_t>(int64_t(x) + column - border, 0, levelWidth - 1);
+            std::memcpy(out + (size_t(row) * pageSize + column) * 4, in + sourceX * 4, 4);
+        }
+    }
+}
+
+//! @note Writes pixels (width * height * channels bytes) as a virtual texture, returns the file size or 0 on failure. Missing channels read as GL would (0, alpha 255).
+static size_t WriteVirtualTexture(const std::string& path, const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t channels,
+                                  uint32_t tileSize = 128, uint32_t border = 4, ThreadPool* pool = nullptr){
+    ThreadPool& workers = pool ? *pool : SharedThreadPool();
+    VirtualTextureHeader header = {};
+    std::memcpy(header.magic, VIRTUAL_TEXTURE_MAGIC, sizeof(header.magic));
+    header.version = VIRTUAL_TEXTURE_VERSION;
+    header.width = width;
+    header.height = height;
+    header.tileSize = tileSize;
+    header.border = border;
+    header.tilesX = RoundUpToPowerOfTwo((width + tileSize - 1) / tileSize);
+    header.tilesY = RoundUpToPowerOfTwo((height + tileSize - 1) / tileSize);
+    header.levelCount = static_cast<uint32_t>(std::log2(std::max(header.tilesX, header.tilesY))) + 1;
+    if(header.levelCount > VIRTUAL_TEXTURE_MAX_LEVELS){
+        return 0;
+    }
+
+    std::vector<std::vector<uint8_t>> levels(1);
+    std::vector<std::pair<uint32_t, uint32_t>> sizes = {{width, height}};
+    levels[0].resize(size_t(width) * height * 4);
+    workers.ParallelFor(height, [&](uint32_t y){
+        for(uint32_t x = 0; x < width; x++){
+            const uint8_t* in = pixels + (size_t(y) * width + x) * channels;
+            uint8_t* out = &levels[0][(size_t(y) * width + x) * 4];
+            out[0] = in[0];
+            out[1] = channels > 1 ? in[1] : 0;
+            out[2] = channels > 2 ? in[2] : 0;
+            out[3] = channels > 3 ? in[3] : 255;
+        }
+    });
+    while(levels.size() < header.levelCount){
+        auto [levelWidth, levelHeight] = sizes.back();
+        std::vector<uint8_t> next;
+        DownsampleLevel(levels.back().data(), levelWidth, levelHeight, 4, next);
+        levels.push_back(std::move(next));
+        sizes.push_back({std::max(1u, levelWidth / 2), std::max(1u, levelHeight / 2)});
+    }
+
+    uint32_t pageSize = tileSize + 2 * border;
+    size_t tileBytes = size_t(pageSize) * pageSize * 4;
+    for(uint32_t level = 0; level < header.levelCount; level++){
+        header.tileCount += VirtualGridSize(header.tilesX, level) * VirtualGridSize(header.tilesY, level);
+    }
+    std::vector<uint64_t> offsets(header.tileCount, 0);
+    std::vector<std::vector<uint32_t>> present(header.levelCount); // tiles of each level that cover some of the image
+    uint64_t offset = sizeof(VirtualTextureHeader) + offsets.size() * sizeof(uint64_t);
+    for(uint32_t level = 0, base = 0; level < header.levelCount; level++){
+        uint32_t gridX = VirtualGridSize(header.tilesX, level), gridY = VirtualGridSize(header.tilesY, level);
+        for(uint32_t y = 0; y < gridY; y++){
+            for(uint32_t x = 0; x < gridX; x++){
+                if(x * tileSize >= sizes[level].first || y * tileSize >= sizes[level].second) continue;
+                offsets[base + y * gridX + x] = offset;
+                present[level].push_back(y * gridX + x);
+                offset += tileBytes;
+            }
+        }
+        base += gridX * gridY;
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if(!file){
+        return 0;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(offsets.data()), static_cast<std::streamsize>(offsets.size() * sizeof(uint64_t)));
+
+    std::vector<uint8_t> tiles;
+    for(uint32_t level = 0; level < header.levelCount; level++){
+        uint32_t gridX = VirtualGridSize(header.tilesX, level);
+        tiles.resize(present[level].size() * tileBytes);
+        workers.ParallelFor(static_cast<uint32_t>(present[level].size()), [&](uint32_t i){
+            uint32_t x = present[level][i] % gridX, y = present[level][i] / gridX;
+            ExtractVirtualTile(levels[level].data(), sizes[level].first, sizes[level].second, x * tileSize, y * tileSize, pageSize, border,
+                               tiles.data() + i * tileBytes);
+        });
+        file.write(reinterpret_cast<const char*>(tiles.data()), static_cast<std::streamsize>(tiles.size()));
+    }
+    return file ? static_cast<size_t>(offset) : 0;
+}
+
+//! @note Decodes source and writes its virtual texture to destination
+static bool BuildVirtualTexture(const std::string& source, const std::string& destination, std::string& error, uint32_t tileSize = 128,
+                                uint32_t border = 4, ThreadPool* pool = nullptr){
+    int w, h, channels;
+    unsigned char* pixels = stbi_load(source.c_str(), &w, &h, &channels, 0);
+    if(!pixels){
+        error = stbi_failure_reason() ? stbi_failure_reason() : "decode failed";
+        return false;
+    }
+    size_t written = WriteVirtualTexture(destination, pixels, static_cast<uint32_t>(w), static_cast<uint32_t>(h), static_cast<uint32_t>(channels),
+                                         tileSize, border, pool);
+    stbi_image_free(pixels);
+    if(written == 0){
+        error = "could not write " + destination;
+        return false;
+    }
+    return true;
+}
+
+//! @note A mapped virtual texture, header and offsets point into the mapping
+struct VirtualTextureFile{
+    bool Open(const std::string& path){
+        if(!file.Open(path) || file.size < sizeof(VirtualTextureHeader)){
+            return false;
+        }
+        header = reinterpret_cast<const VirtualTextureHeader*>(file.data);
+        if(std::memcmp(header->magic, VIRTUAL_TEXTURE_MAGIC, sizeof(header->magic)) != 0 || header->version != VIRTUAL_TEXTURE_VERSION ||
+           header->tileSize == 0 || header->levelCount < 1 || header->levelCount > VIRTUAL_TEXTURE_MAX_LEVELS){
+            return false;
+        }
+        uint32_t tileCount = 0;
+        for(uint32_t level = 0; level < header->levelCount; level++){
+            tileCount += VirtualGridSize(header->tilesX, level) * VirtualGridSize(header->tilesY, level);
+        }
+        if(tileCount != header->tileCount || VirtualGridSize(header->tilesX, header->levelCount - 1) != 1 ||
+           VirtualGridSize(header->tilesY, header->levelCount - 1) != 1 || sizeof(VirtualTextureHeader) + size_t(tileCount) * sizeof(uint64_t) > file.size){
+            return false;
+        }
+        offsets = reinterpret_cast<const uint64_t*>(file.data + sizeof(VirtualTextureHeader));
+        for(uint32_t i = 0; i < tileCount; i++){
+            if(offsets[i] != 0 && offsets[i] + TileBytes() > file.size){
+                return false;
+            }
+        }
+        return offsets[tileCount - 1] != 0; // the last level's single tile, always resident at runtime
+    }
+
+    uint32_t PageSize() const { return header->tileSize + 2 * header->border; }
+    size_t TileBytes() const { return size_t(PageSize()) * PageSize() * 4; }
+
+    //! @note nullptr for tiles past the image
+    const uint8_t* TileData(uint32_t tile) const{
+        return offsets[tile] ? file.data + offsets[tile] : nullptr;
+    }
+
+    AssetFile file;
+    const VirtualTextureHeader* header = nullptr;
+    const uint64_t* offsets = nullptr;
+};
+
+struct VirtualTextureSettings{
+    uint32_t cachePages = 16;       // per side of the physical cache, at most 256 (page table entries are bytes)
+    uint32_t uploadsPerFrame = 16;  // tiles copied into the cache per Update at most, the rest wait for the next frames
+    uint32_t readsInFlight = 64;    // tiles being read on the pool at once
+    bool gamma = true;              // sRGB cache
+    ThreadPool* pool = nullptr;     // nullptr uses SharedThreadPool()
+};
+
+struct VirtualTextureStats{
+    uint32_t requested = 0;     // distinct tiles the last feedback asked for
+    uint32_t missing = 0;       // of those, not resident (drawn from a coarser level meanwhile)
+    uint32_t resident = 0;      // tiles in the cache
+    uint32_t reading = 0;       // tiles being read on the pool
+    uint32_t uploads = 0;       // by the last Update
+    uint32_t evictions = 0;     // by the last Update
+    uint64_t totalUploads = 0;
+    uint64_t totalEvictions = 0;
+    uint64_t uploadedBytes = 0;
+    double updateMilliseconds = 0.0; // GL thread time of the last Update
+};
+
+class VirtualTexture{
+public:
+    static constexpr uint32_t NO_TILE = UINT32_MAX;
+
+    bool Open(const std::string& path, const VirtualTextureSettings& options = VirtualTextureSettings()){
+        if(!file.Open(path)){
+            printf("Could not open virtual texture ====> %s\n", path.c_str());
+            return false;
+        }
+        settings = options;
+        const VirtualTextureHeader& header = *file.header;
+        pageSize = file.PageSize();
+
+        GLint maxSize = 0;
+        glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+        cachePages = std::clamp(settings.cachePages, 2u, 256u);
+        cachePages = std::max(2u, std::min(cachePages, static_cast<uint32_t>(maxSize) / pageSize));
+
+        levelBase.clear();
+        pageTableLevels.clear();
+        dirty.clear();
+        for(uint32_t level = 0, base = 0; level < header.levelCount; level++){
+            levelBase.push_back(base);
+            base += GridX(level) * GridY(level);
+            pageTableLevels.emplace_back(size_t(GridX(level)) * GridY(level), 0u);
+            dirty.push_back({GridX(level), GridY(level), 0, 0});
+        }
+        tileSlots.assign(header.tileCount, NO_SLOT);
+        tileFrames.assign(header.tileCount, 0);
+        tileReading.assign(header.tileCount, 0);
+        slots.assign(size_t(cachePages) * cachePages, Slot());
+        lru.clear();
+        freeSlots.clear();
+        for(uint32_t slot = static_cast<uint32_t>(slots.size()) - 1; slot > 0; slot--){
+            freeSlots.push_back(slot);
+        }
+        pending.clear();
+        frame = 0;
+        stats = VirtualTextureStats();
+
+        cache = GLTexture::Create();
+        glBindTexture(GL_TEXTURE_2D, cache.Get());
+        glTexImage2D(GL_TEXTURE_2D, 0, settings.gamma ? GL_SRGB8_ALPHA8 : GL_RGBA8, cachePages * pageSize, cachePages * pageSize, 0, GL_RGBA,
+                     GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+
+        //! @note The last level's single tile is pinned to page 0, every entry falls back to it at worst
+        uint32_t root = header.tileCount - 1;
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, pageSize, pageSize, GL_RGBA, GL_UNSIGNED_BYTE, file.TileData(root));
+        glBindTexture(GL_TEXTURE_2D, 0);
+        slots[0].tile = root;
+        tileSlots[root] = 0;
+        stats.resident = 1;
+        RefreshPageTable(root);
+
+        pageTable = GLTexture::Create();
+        glBindTexture(GL_TEXTURE_2D, pageTable.Get());
+        for(uint32_t level = 0; level < header.levelCount; level++){
+            glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, GridX(level), GridY(level), 0, GL_RGBA, GL_UNSIGNED_BYTE, pageTableLevels[level].data());
+            dirty[level] = {GridX(level), GridY(level), 0, 0};
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(header.levelCount - 1));
+        glBindTexture(GL_TEXTURE_2D, 0);
+        return true;
+    }
+
+    bool IsOpen() const { return static_cast<bool>(cache); }
+
+    //! @note Tile index of (x, y) in level's grid, NO_TILE when out of range (feedback from a stale frame or a texel on the very edge)
+    uint32_t TileIndex(uint32_t level, uint32_t x, uint32_t y) const{
+        if(level >= levelBase.size() || x >= GridX(level) || y >= GridY(level)) return NO_TILE;
+        return levelBase[level] + y * GridX(level) + x;
+    }
+
+    /**
+     * @note Once per frame with the distinct tiles the feedback asked for: keeps them (and the ancestors they fall back to) in the cache,
+     * @note starts reading the missing ones coarsest first and uploads up to uploadsPerFrame tiles that finished reading
+    */
+    void Update(const std::vector<uint32_t>& requests){
+        auto start = std::chrono::steady_clock::now();
+        frame++;
+        stats.requested = static_cast<uint32_t>(requests.size());
+        stats.missing = 0;
+        stats.uploads = 0;
+        stats.evictions = 0;
+
+        wanted.clear();
+        for(uint32_t tile : requests){
+            if(tileSlots[tile] == NO_SLOT) stats.missing++;
+            //! @note Walks up until a tile this frame already visited, its ancestors are done too
+            for(uint32_t current = tile; current != NO_TILE && tileFrames[current] != frame; current = Parent(current)){
+                tileFrames[current] = frame;
+                if(tileSlots[current] != NO_SLOT){
+                    Touch(tileSlots[current]);
+                }
+                else if(!tileReading[current] && file.TileData(current)){
+                    wanted.push_back(current);
+                }
+            }
+        }
+
+        //! @note Coarse tiles first, they replace the blurriest fallback and cover the most screen
+        std::stable_sort(wanted.begin(), wanted.end(), [this](uint32_t a, uint32_t b){ return Level(a) > Level(b); });
+        ThreadPool& pool = settings.pool ? *settings.pool : SharedThreadPool();
+        for(uint32_t tile : wanted){
+            if(pending.size() >= settings.readsInFlight) break;
+            auto read = std::make_shared<PendingTile>();
+            read->tile = tile;
+            tileReading[tile] = 1;
+            pending.push_back(read);
+            pool.Submit([read, source = file.file, data = file.TileData(tile), bytes = file.TileBytes()](){
+                read->pixels.assign(data, data + bytes);
+                read->ready.store(true, std::memory_order_release);
+            });
+        }
+
+        glBindTexture(GL_TEXTURE_2D, cache.Get());
+        for(std::shared_ptr<PendingTile>& read : pending){
+            if(stats.uploads >= settings.uploadsPerFrame) break;
+            if(!read->ready.load(std::memory_order_acquire)) continue;
+
+            uint32_t tile = read->tile;
+            tileReading[tile] = 0;
+            //! @note A tile no feedback asked for lately would only evict one that is still seen, and with no free page left when every page
+            //! @note holds a tile visible this frame, the tile is dropped too. Both are read again if the feedback asks for them.
+            uint32_t slot = frame - tileFrames[tile] <= STALE_FRAMES ? AcquireSlot() : NO_SLOT;
+            if(slot != NO_SLOT){
+                glTexSubImage2D(GL_TEXTURE_2D, 0, (slot % cachePages) * pageSize, (slot / cachePages) * pageSize, pageSize, pageSize, GL_RGBA,
+                                GL_UNSIGNED_BYTE, read->pixels.data());
+                slots[slot].tile = tile;
+                tileSlots[tile] = slot;
+                Touch(slot);
+                RefreshPageTable(tile);
+                stats.uploads++;
+                stats.uploadedBytes += read->pixels.size();
+            }
+            read.reset();
+        }
+        glBindTexture(GL_TEXTURE_2D, 0);
+        pending.erase(std::remove(pending.begin(), pending.end(), nullptr), pending.end());
+
+        UploadPageTable();
+        stats.totalUploads += stats.uploads;
+        stats.totalEvictions += stats.evictions;
+        stats.reading = static_cast<uint32_t>(pending.size());
+        stats.updateMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    /**
+     * @note Binds the cache and page table and sets the uniforms SampleVirtual (virtualTexture.frag) and the feedback shader read
+     * @note program must be in use. The feedback shader also needs virtualTextureID and virtualLodBias (VirtualTextureFeedback::LodBias).
+    */
+    void Bind(uint32_t program, uint32_t cacheUnit = 0, uint32_t pageTableUnit = 1) const{
+        glActiveTexture(GL_TEXTURE0 + cacheUnit);
+        glBindTexture(GL_TEXTURE_2D, cache.Get());
+        glActiveTexture(GL_TEXTURE0 + pageTableUnit);
+        glBindTexture(GL_TEXTURE_2D, pageTable.Get());
+        glActiveTexture(GL_TEXTURE0);
+        FrameRenderStats().textureBinds += 2;
+
+        const VirtualTextureHeader& header = *file.header;
+        glUniform1i(glGetUniformLocation(program, "virtualCache"), static_cast<GLint>(cacheUnit));
+        glUniform1i(glGetUniformLocation(program, "virtualPageTable"), static_cast<GLint>(pageTableUnit));
+        glUniform4f(glGetUniformLocation(program, "virtualSize"), float(header.width), float(header.height), float(header.tileSize), float(header.border));
+        glUniform2f(glGetUniformLocation(program, "virtualCacheSize"), float(cachePages * pageSize), float(cachePages * pageSize));
+        glUniform1f(glGetUniformLocation(program, "virtualMaxLevel"), float(header.levelCount - 1));
+    }
+
+    //! @note VRAM of the cache and page table, next to what the whole texture and its mips would take
+    size_t ResidentBytes() const{
+        size_t bytes = size_t(cachePages) * pageSize * cachePages * pageSize * 4;
+        for(const std::vector<uint32_t>& level : pageTableLevels) bytes += level.size() * 4;
+        return bytes;
+    }
+
+    size_t FullTextureBytes() const{
+        size_t bytes = 0;
+        for(uint32_t w = file.header->width, h = file.header->height; ; w = std::max(1u, w / 2), h = std::max(1u, h / 2)){
+            bytes += size_t(w) * h * 4;
+            if(w == 1 && h == 1) break;
+        }
+        return bytes;
+    }
+
+    /**
+     * @note Debug check, reads the cache back: every occupied page must hold its tile's texels and every page table entry must point at a resident
+     * @note tile of its own level or an ancestor. Returns the number of mismatches. Waits for the GPU, not for use per frame.
+    */
+    uint32_t Verify() const{
+        uint32_t cacheSize = cachePages * pageSize, mismatches = 0;
+        std::vector<uint8_t> texels(size_t(cacheSize) * cacheSize * 4);
+        glBindTexture(GL_TEXTURE_2D, cache.Get());
+        glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, texels.data());
+        glBindTexture(GL_TEXTURE_2D, 0);
+        for(uint32_t slot = 0; slot < slots.size(); slot++){
+            if(slots[slot].tile == NO_TILE) continue;
+            const uint8_t* expected = file.TileData(slots[slot].tile);
+            for(uint32_t row = 0; row < pageSize; row++){
+                size_t offset = (size_t((slot / cachePages) * pageSize + row) * cacheSize + (slot % cachePages) * pageSize) * 4;
+                if(std::memcmp(texels.data() + offset, expected + size_t(row) * pageSize * 4, size_t(pageSize) * 4) != 0){
+                    mismatches++;
+                    break;
+                }
+            }
+        }
+
+        for(uint32_t level = 0; level < pageTableLevels.size(); level++){
+            for(uint32_t y = 0; y < GridY(level); y++){
+                for(uint32_t x = 0; x < GridX(level); x++){
+                    uint32_t entry = pageTableLevels[level][y * GridX(level) + x];
+                    uint32_t slot = (entry & 0xFF) + ((entry >> 8) & 0xFF) * cachePages, entryLevel = (entry >> 16) & 0xFF;
+                    uint32_t tile = TileIndex(level, x, y);
+                    while(tile != NO_TILE && Level(tile) < entryLevel) tile = Parent(tile);
+                    if(tile == NO_TILE || slots[slot].tile != tile) mismatches++;
+                }
+            }
+        }
+        return mismatches;
+    }
+
+    const VirtualTextureStats& GetStats() const { return stats; }
+    const VirtualTextureHeader& Header() const { return *file.header; }
+    uint32_t CachePages() const { return cachePages; }
+
+private:
+    static constexpr uint32_t NO_SLOT = UINT32_MAX;
+    static constexpr uint64_t STALE_FRAMES = 2; // a finished read is still uploaded if the feedback asked for its tile this many frames ago
+
+    struct Slot{
+        uint32_t tile = NO_TILE;
+        uint64_t lastUsed = 0;
+        std::list<uint32_t>::iterator position; // in lru, for occupied pages other than the pinned page 0
+    };
+
+    struct PendingTile{
+        uint32_t tile = 0;
+        std::vector<uint8_t> pixels;
+        std::atomic<bool> ready{false};
+    };
+
+    //! @note Entries are RGBA8 texels: page x, page y, level of the tile it holds, 255
+    static uint32_t PackEntry(uint32_t slot, uint32_t cachePages, uint32_t level){
+        return (slot % cachePages) | ((slot / cachePages) << 8) | (level << 16) | (0xFFu << 24);
+    }
+
+    uint32_t GridX(uint32_t level) const { return VirtualGridSize(file.header->tilesX, level); }
+    uint32_t GridY(uint32_t level) const { return VirtualGridSize(file.header->tilesY, level); }
+
+    uint32_t Level(uint32_t tile) const{
+        return static_cast<uint32_t>(std::upper_bound(levelBase.begin(), levelBase.end(), tile) - levelBase.begin()) - 1;
+    }
+
+    uint32_t Parent(uint32_t tile) const{
+        uint32_t level = Level(tile);
+        if(level + 1 >= levelBase.size()) return NO_TILE;
+        uint32_t local = tile - levelBase[level];
+        return TileIndex(level + 1, (local % GridX(level)) / 2, (local / GridX(level)) / 2);
+    }
+
+    void Touch(uint32_t slot){
+        slots[slot].lastUsed = frame;
+        if(slot != 0){
+            lru.splice(lru.begin(), lru, slots[slot].position);
+        }
+    }
+
+    //! @note A free page, or the least recently used one if it was not used this frame (its tile is evicted), NO_SLOT otherwise
+    uint32_t AcquireSlot(){
+        if(!freeSlots.empty()){
+            uint32_t slot = freeSlots.back();
+            freeSlots.pop_back();
+            slots[slot].position = lru.insert(lru.begin(), slot);
+            stats.resident++;
+            return slot;
+        }
+        if(lru.empty() || slots[lru.back()].lastUsed == frame){
+            return NO_SLOT;
+        }
+        uint32_t slot = lru.back();
+        uint32_t evicted = slots[slot].tile;
+        slots[slot].tile = NO_TILE;
+        tileSlots[evicted] = NO_SLOT;
+        RefreshPageTable(evicted);
+        stats.evictions++;
+        return slot;
+    }
+
+    /**
+     * @note Rewrites the page table under tile after it became resident or was evicted: its own entry, then its whole subtree level by level,
+     * @note where every non-resident tile takes its parent's (already updated) entry. A coarse tile touches 4^level entries, those change rarely.
+    */
+    void RefreshPageTable(uint32_t tile){
+        uint32_t level = Level(tile), local = tile - levelBase[level];
+        uint32_t x0 = local % GridX(level), y0 = local / GridX(level), x1 = x0 + 1, y1 = y0 + 1;
+        while(true){
+            for(uint32_t y = y0; y < y1; y++){
+                for(uint32_t x = x0; x < x1; x++){
+                    uint32_t slot = tileSlots[levelBase[level] + y * GridX(level) + x];
+                    pageTableLevels[level][y * GridX(level) + x] = slot != NO_SLOT ? PackEntry(slot, cachePages, level)
+                                                                                   : pageTableLevels[level + 1][(y / 2) * GridX(level + 1) + x / 2];
+                }
+            }
+            Region& region = dirty[level];
+            region = {std::min(region.x0, x0), std::min(region.y0, y0), std::max(region.x1, x1), std::max(region.y1, y1)};
+            if(level == 0) break;
+            level--;
+            x0 *= 2;
+            y0 *= 2;
+            x1 = std::min(x1 * 2, GridX(level));
+            y1 = std::min(y1 * 2, GridY(level));
+        }
+    }
+
+    void UploadPageTable(){
+        glBindTexture(GL_TEXTURE_2D, pageTable.Get());
+        for(uint32_t level = 0; level < dirty.size(); level++){
+            Region& region = dirty[level];
+            if(region.x0 >= region.x1 || region.y0 >= region.y1) continue;
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, static_cast<GLint>(GridX(level)));
+            glTexSubImage2D(GL_TEXTURE_2D, level, region.x0, region.y0, region.x1 - region.x0, region.y1 - region.y0, GL_RGBA, GL_UNSIGNED_BYTE,
+                            pageTableLevels[level].data() + size_t(region.y0) * GridX(level) + region.x0);
+            region = {GridX(level), GridY(level), 0, 0};
+        }
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    struct Region{
+        uint32_t x0, y0, x1, y1; // empty when x0 >= x1
+    };
+
+    VirtualTextureFile file;
+    VirtualTextureSettings settings;
+    uint32_t pageSize = 0;
+    uint32_t cachePages = 0;
+    uint64_t frame = 0;
+
+    std::vector<uint32_t> levelBase;        // first tile index of every level
+    std::vector<uint32_t> tileSlots;        // page of every tile, NO_SLOT when not resident
+    std::vector<uint64_t> tileFrames;       // last Update that visited the tile
+    std::vector<uint8_t> tileReading;
+    std::vector<Slot> slots;
+    std::list<uint32_t> lru;                // occupied pages, most recently used first
+    std::vector<uint32_t> freeSlots;
+    std::vector<uint32_t> wanted;
+    std::vector<std::shared_ptr<PendingTile>> pending;
+
+    std::vector<std::vector<uint32_t>> pageTableLevels;
+    std::vector<Region> dirty;
+
+    GLTexture cache;
+    GLTexture pageTable;
+    VirtualTextureStats stats;
+};
+
+struct VirtualFeedbackStats{
+    uint32_t pixels = 0;
+    uint32_t requests = 0;          // distinct tiles over every texture
+    bool stale = false;             // the read back was not finished, the textures kept last frame's requests
+    double resolveMilliseconds = 0.0;
+};
+
+/**
+ * @note The feedback pass: a screen / scale sized RGBA16UI target the scene is drawn into with virtualTextureFeedback.frag, every pixel holding
+ * @note (tile x, tile y, level, virtualTextureID). End() reads it into one of two PBOs, Resolve() maps the one from the frame before, so the
+ * @note GL thread never waits on the read back.
+*/
+class VirtualTextureFeedback{
+public:
+    explicit VirtualTextureFeedback(uint32_t scale = 8) : scale(std::max(1u, scale)){}
+
+    VirtualTextureFeedback(const VirtualTextureFeedback&) = delete;
+    VirtualTextureFeedback& operator=(const VirtualTextureFeedback&) = delete;
+
+    ~VirtualTextureFeedback(){
+        for(GLsync& fence : fences){
+            if(fence) glDeleteSync(fence);
+        }
+    }
+
+    //! @note For virtualLodBias, the target is scale times smaller so its derivatives are scale times larger
+    float LodBias() const { return -std::log2(float(scale)); }
+
+    //! @note Binds and clears the target for a screenWidth x screenHeight frame, draw the scene with the feedback shader next
+    void Begin(uint32_t screenWidth, uint32_t screenHeight){
+        glGetIntegerv(GL_VIEWPORT, previousViewport);
+        uint32_t targetWidth = std::max(1u, screenWidth / scale), targetHeight = std::max(1u, screenHeight / scale);
+        if(targetWidth != width || targetHeight != height){
+            Create(targetWidth, targetHeight);
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer.Get());
+        glViewport(0, 0, width, height);
+        const GLuint zero[4] = {0, 0, 0, 0};
+        glClearBufferuiv(GL_COLOR, 0, zero);
+        glClear(GL_DEPTH_BUFFER_BIT);
+    }
+
+    //! @note Starts reading back what was drawn since Begin, then restores the default framebuffer and viewport
+    void End(){
+        uint32_t index = frames % 2;
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readBuffers[index].Get());
+        glReadPixels(0, 0, width, height, GL_RGBA_INTEGER, GL_UNSIGNED_SHORT, nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        if(fences[index]) glDeleteSync(fences[index]);
+        fences[index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        frames++;
+
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(previousViewport[0], previousViewport[1], previousViewport[2], previousViewport[3]);
+    }
+
+    /**
+     * @note Updates textures[i] (virtualTextureID i + 1) with the tiles the previous frame's feedback asked for
+     * @note A read back still in flight is not waited on, the textures update with the requests they had
+    */
+    void Resolve(VirtualTexture* const* textures, uint32_t count){
+        auto start = std::chrono::steady_clock::now();
+        requests.resize(count);
+        uint32_t index = frames % 2;
+        GLsync fence = fences[index];
+        GLenum status = fence ? glClientWaitSync(fence, 0, 0) : GL_TIMEOUT_EXPIRED;
+        stats.stale = status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED;
+        if(!stats.stale){
+            glDeleteSync(fence);
+            fences[index] = nullptr;
+            for(std::vector<uint32_t>& list : requests) list.clear();
+
+            size_t bytes = size_t(width) * height * 4 * sizeof(uint16_t);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, readBuffers[index].Get());
+            const uint16_t* texels = static_cast<const uint16_t*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(bytes), GL_MAP_READ_BIT));
+            if(texels){
+                for(size_t i = 0; i < size_t(width) * height; i++){
+                    const uint16_t* texel = texels + i * 4;
+                    if(texel[3] == 0 || texel[3] > count) continue;
+                    uint32_t tile = textures[texel[3] - 1]->TileIndex(texel[2], texel[0], texel[1]);
+                    if(tile != VirtualTexture::NO_TILE) requests[texel[3] - 1].push_back(tile);
+                }
+                glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            }
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+            stats.requests = 0;
+            for(std::vector<uint32_t>& list : requests){
+                std::sort(list.begin(), list.end());
+                list.erase(std::unique(list.begin(), list.end()), list.end());
+                stats.requests += static_cast<uint32_t>(list.size());
+            }
+        }
+        stats.pixels = width * height;
+        stats.resolveMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        for(uint32_t i = 0; i < count; i++){
+            textures[i]->Update(requests[i]);
+        }
+    }
+
+    const VirtualFeedbackStats& GetStats() const { return stats; }
+
+private:
+    void Create(uint32_t targetWidth, uint32_t targetHeight){
+        width = targetWidth;
+        height = targetHeight;
+        color = GLTexture::Create();
+        glBindTexture(GL_TEXTURE_2D, color.Get());
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16UI, width, height, 0, GL_RGBA_INTEGER, GL_UNSIGNED_SHORT, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        depth = GLTexture::Create();
+        glBindTexture(GL_TEXTURE_2D, depth.Get());
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, width, height, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        framebuffer = GLFramebuffer::Create();
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer.Get());
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color.Get(), 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depth.Get(), 0);
+        if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE){
+            printf("Virtual texture feedback framebuffer is incomplete (%u x %u)\n", width, height);
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        for(uint32_t i = 0; i < 2; i++){
+            readBuffers[i] = GLBuffer::Create();
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, readBuffers[i].Get());
+            glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(size_t(width) * height * 4 * sizeof(uint16_t)), nullptr, GL_STREAM_READ);
+            if(fences[i]) glDeleteSync(fences[i]);
+            fences[i] = nullptr;
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+    uint32_t scale;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint64_t frames = 0;
+    GLint previousViewport[4] = {};
+    GLTexture color;
+    GLTexture depth;
+    GLFramebuffer framebuffer;
+    GLBuffer readBuffers[2];
+    GLsync fences[2] = {nullptr, nullptr};
+    std::vector<std::vector<uint32_t>> requests;
+    VirtualFeedbackStats stats;
+};
+
+static void PrintVirtualTextureStats(const VirtualTexture& texture, const VirtualFeedbackStats& feedback){
+    const VirtualTextureStats& stats = texture.GetStats();
+    printf("Virtual texture: %u of %u requested tiles missing, %u resident, %u reading, %u uploads, %u evictions (%.3f ms), feedback %u pixels (%.3f ms%s)\n",
+           stats.missing, stats.requested, stats.resident, stats.reading, stats.uploads, stats.evictions, stats.updateMilliseconds, feedback.pixels,
+           feedback.resolveMilliseconds, feedback.stale ? ", stale" : "");
+}
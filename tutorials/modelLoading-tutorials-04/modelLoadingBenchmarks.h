@@ -0,0 +1,1944 @@
+#pragma once
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <fstream>
+#include <filesystem>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+#include "modelLoadingTutorial-01.h"
+#include "AssetBaker.h"
+#include "VirtualTexture.h"
+
+/**
+ * @example Model Loading Benchmarks
+ * @note Timing runs for the model loading paths in modelLoadingTutorial-01.h
+ * @note Each benchmark needs a current OpenGL context (meshes and textures are uploaded), so call them from Application.cpp after the window is created
+ * @note Results are printed to stdout
+*/
+
+static double ElapsedMilliseconds(std::chrono::steady_clock::time_point start){
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+//! @note Cold = no cache file on disk (assimp import + writing the cache), Warm = every following load that reads the mapped cache
+void MeshCacheBenchmark(GLFWwindow* window, const std::string& modelPath = "basics/models/backpack.obj", uint32_t warmRuns = 5){
+    printf("Mesh Cache Benchmark -- %s\n", modelPath.c_str());
+
+    ModelLoadOptions uncached;
+    ModelLoadOptions cached;
+    cached.useMeshCache = true;
+
+    auto start = std::chrono::steady_clock::now();
+    Model assimpModel(modelPath, uncached);
+    double assimpTime = ElapsedMilliseconds(start);
+
+    //! @note Removing any cache left over from previous runs, so the first cached load is really cold
+    uint64_t key = ComputeMeshCacheKey(modelPath, Model::importFlags(), 0);
+    std::remove(MeshCachePath(modelPath, key).c_str());
+
+    start = std::chrono::steady_clock::now();
+    Model coldModel(modelPath, cached);
+    double coldTime = ElapsedMilliseconds(start);
+
+    double warmTime = 0.0;
+    for(uint32_t i = 0; i < warmRuns; i++){
+        start = std::chrono::steady_clock::now();
+        Model warmModel(modelPath, cached);
+        warmTime += ElapsedMilliseconds(start);
+    }
+    warmTime /= warmRuns;
+
+    printf("  meshes                   : %zu\n", assimpModel.meshes.size());
+    printf("  assimp (no cache)        : %.2f ms\n", assimpTime);
+    printf("  cold (import + write)    : %.2f ms\n", coldTime);
+    printf("  warm (mapped cache, avg) : %.2f ms\n", warmTime);
+    printf("  speedup warm vs assimp   : %.2fx\n", assimpTime / warmTime);
+}
+
+//! @note Times only the CPU-side extraction (assimp import done once up front) for 1, 2, 4, ... worker threads against the serial loop
+void ParallelExtractionBenchmark(GLFWwindow* window, const std::string& modelPath = "basics/models/backpack.obj", uint32_t runs = 5){
+    printf("Parallel Mesh Extraction Benchmark -- %s\n", modelPath.c_str());
+
+    Assimp::Importer importer;
+    const aiScene* scene = importer.ReadFile(modelPath, Model::importFlags());
+    if(!scene || !scene->mRootNode){
+        printf("  could not import model: %s\n", importer.GetErrorString());
+        return;
+    }
+
+    std::vector<const aiMesh*> sceneMeshes;
+    Model::collectMeshes(scene->mRootNode, scene, sceneMeshes);
+    printf("  meshes : %zu\n", sceneMeshes.size());
+
+    double serialTime = 0.0;
+    for(uint32_t run = 0; run < runs; run++){
+        std::vector<MeshData> meshData(sceneMeshes.size());
+        auto start = std::chrono::steady_clock::now();
+        for(size_t i = 0; i < sceneMeshes.size(); i++){
+            Model::extractMeshData(sceneMeshes[i], meshData[i]);
+        }
+        serialTime += ElapsedMilliseconds(start);
+    }
+    serialTime /= runs;
+    printf("  serial      : %8.2f ms\n", serialTime);
+
+    uint32_t maxThreads = std::thread::hardware_concurrency();
+    for(uint32_t threads = 1; threads <= maxThreads; threads *= 2){
+        ThreadPool pool(threads);
+
+        double parallelTime = 0.0;
+        for(uint32_t run = 0; run < runs; run++){
+            std::vector<MeshData> meshData(sceneMeshes.size());
+            auto start = std::chrono::steady_clock::now();
+            pool.ParallelFor(static_cast<uint32_t>(sceneMeshes.size()), [&](uint32_t i){
+                Model::extractMeshData(sceneMeshes[i], meshData[i]);
+            });
+            parallelTime += ElapsedMilliseconds(start);
+        }
+        parallelTime /= runs;
+        printf("  %2u threads  : %8.2f ms  (%.2fx)\n", threads, parallelTime, serialTime / parallelTime);
+    }
+}
+
+//! @note Compares blocking texture loads against the AsyncTextureLoader: time until the model is drawable, and until every texture is resident
+void AsyncTextureBenchmark(GLFWwindow* window, const std::string& modelPath = "basics/models/backpack.obj"){
+    printf("Async Texture Loading Benchmark -- %s\n", modelPath.c_str());
+
+    auto start = std::chrono::steady_clock::now();
+    {
+        Model model(modelPath);
+        glFinish();
+    }
+    double blockingTime = ElapsedMilliseconds(start);
+
+    AsyncTextureLoader textureLoader(SharedThreadPool());
+    ModelLoadOptions options;
+    options.textureLoader = &textureLoader;
+
+    start = std::chrono::steady_clock::now();
+    Model model(modelPath, options);
+    double drawableTime = ElapsedMilliseconds(start);
+
+    uint32_t frames = 0;
+    while(!textureLoader.Idle()){
+        textureLoader.Update();
+        frames++;
+    }
+    glFinish();
+    double residentTime = ElapsedMilliseconds(start);
+
+    printf("  blocking load                 : %.2f ms\n", blockingTime);
+    printf("  async, model drawable after   : %.2f ms\n", drawableTime);
+    printf("  async, all textures resident  : %.2f ms (%u update calls)\n", residentTime, frames);
+}
+
+//! @note Per-mesh VAO/VBO/IBO layout against one shared GeometryArena: load time, GL buffer objects, and draw cost per frame
+void GeometryArenaBenchmark(GLFWwindow* window, const std::string& modelPath = "basics/models/backpack.obj", uint32_t frames = 200){
+    printf("Geometry Arena Benchmark -- %s\n", modelPath.c_str());
+
+    Shader modelShader("basics/shaders/modelLoading-01/model.vert", "basics/shaders/modelLoading-01/model.frag");
+    modelShader.Bind();
+    modelShader.Set("projection", glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f));
+    modelShader.Set("view", glm::lookAt(glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+    modelShader.Set("model", glm::mat4(1.0f));
+
+    auto measure = [&](const char* label, Model& model, double loadTime, size_t bufferObjects){
+        FrameRenderStats().Reset();
+        model.Draw(modelShader);
+        RenderStats perFrame = FrameRenderStats();
+        glFinish();
+
+        auto start = std::chrono::steady_clock::now();
+        for(uint32_t i = 0; i < frames; i++){
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            model.Draw(modelShader);
+        }
+        glFinish();
+        double frameTime = ElapsedMilliseconds(start) / frames;
+
+        printf("  %-9s load %8.2f ms | %5zu GL objects | %4u draws, %4u VAO binds, %4u texture binds | %.3f ms/frame\n",
+               label, loadTime, bufferObjects, perFrame.drawCalls, perFrame.vertexArrayBinds, perFrame.textureBinds, frameTime);
+    };
+
+    {
+        auto start = std::chrono::steady_clock::now();
+        Model model(modelPath);
+        glFinish();
+        measure("per-mesh", model, ElapsedMilliseconds(start), model.meshes.size() * 3);
+    }
+
+    {
+        GeometryArena arena;
+        ModelLoadOptions options;
+        options.geometryArena = &arena;
+
+        auto start = std::chrono::steady_clock::now();
+        Model model(modelPath, options);
+        glFinish();
+        measure("arena", model, ElapsedMilliseconds(start), 3);
+    }
+}
+
+//! @note Full 56 byte Vertex against the 20 byte PackedVertex: SIMD vs scalar pack time, decode time, quantization error, and the bytes the GPU has to fetch
+void PackedVertexBenchmark(GLFWwindow* window, const std::string& modelPath = "basics/models/backpack.obj", uint32_t runs = 5, uint32_t frames = 200){
+    printf("Packed Vertex Benchmark -- %s\n", modelPath.c_str());
+
+    Assimp::Importer importer;
+    const aiScene* scene = importer.ReadFile(modelPath, Model::importFlags());
+    if(!scene || !scene->mRootNode){
+        printf("  could not import model: %s\n", importer.GetErrorString());
+        return;
+    }
+
+    std::vector<const aiMesh*> sceneMeshes;
+    Model::collectMeshes(scene->mRootNode, scene, sceneMeshes);
+
+    std::vector<MeshData> meshData(sceneMeshes.size());
+    size_t vertexCount = 0, indexCount = 0, indexBytes16 = 0;
+    for(size_t i = 0; i < sceneMeshes.size(); i++){
+        Model::extractMeshData(sceneMeshes[i], meshData[i]);
+        vertexCount += meshData[i].vertices.size();
+        indexCount += meshData[i].indices.size();
+        indexBytes16 += meshData[i].indices.size() * (meshData[i].vertices.size() < 65536 ? sizeof(uint16_t) : sizeof(uint32_t));
+    }
+
+    std::vector<std::vector<PackedVertex>> packed(meshData.size());
+    std::vector<PackedMeshBounds> bounds(meshData.size());
+    for(size_t i = 0; i < meshData.size(); i++){
+        packed[i].resize(meshData[i].vertices.size());
+    }
+
+    double simdTime = 0.0, scalarTime = 0.0, decodeTime = 0.0;
+    for(uint32_t run = 0; run < runs; run++){
+        auto start = std::chrono::steady_clock::now();
+        for(size_t i = 0; i < meshData.size(); i++){
+            bounds[i] = PackVertices(meshData[i].vertices.data(), meshData[i].vertices.size(), packed[i].data());
+        }
+        simdTime += ElapsedMilliseconds(start);
+
+        start = std::chrono::steady_clock::now();
+        for(size_t i = 0; i < meshData.size(); i++){
+            const std::vector<Vertex>& vertices = meshData[i].vertices;
+            PackedMeshBounds scalarBounds = ComputePackedBounds(vertices.data(), vertices.size());
+            glm::vec3 positionScale(QuantizeScale(scalarBounds.positionExtent.x), QuantizeScale(scalarBounds.positionExtent.y), QuantizeScale(scalarBounds.positionExtent.z));
+            glm::vec2 uvScale(QuantizeScale(scalarBounds.uvExtent.x), QuantizeScale(scalarBounds.uvExtent.y));
+            for(size_t v = 0; v < vertices.size(); v++){
+                PackVertexScalar(vertices[v], scalarBounds, positionScale, uvScale, packed[i][v]);
+            }
+        }
+        scalarTime += ElapsedMilliseconds(start);
+    }
+
+    PackedVertexError error;
+    for(uint32_t run = 0; run < runs; run++){
+        for(size_t i = 0; i < meshData.size(); i++){
+            std::vector<Vertex> decoded(packed[i].size());
+            auto start = std::chrono::steady_clock::now();
+            UnpackVertices(packed[i].data(), packed[i].size(), bounds[i], decoded.data());
+            decodeTime += ElapsedMilliseconds(start);
+
+            if(run == 0){
+                MeasurePackedVertexError(meshData[i].vertices.data(), decoded.data(), decoded.size(), error);
+            }
+        }
+    }
+
+#ifdef PACKED_VERTEX_SSE2
+    const char* simdLabel = "SSE2";
+#else
+    const char* simdLabel = "scalar fallback";
+#endif
+    printf("  meshes %zu, vertices %zu, indices %zu\n", meshData.size(), vertexCount, indexCount);
+    printf("  pack (%s)  : %8.2f ms\n", simdLabel, simdTime / runs);
+    printf("  pack (scalar)  : %8.2f ms  (%.2fx)\n", scalarTime / runs, scalarTime / simdTime);
+    printf("  decode         : %8.2f ms\n", decodeTime / runs);
+    printf("  position error : max %.6f, mean %.6f (model units)\n", error.maxPosition, error.vertexCount ? error.sumPosition / error.vertexCount : 0.0);
+    printf("  normal error   : max %.4f, mean %.4f degrees\n", error.maxNormalDegrees, error.vertexCount ? error.sumNormalDegrees / error.vertexCount : 0.0);
+    printf("  tangent error  : max %.4f degrees\n", error.maxTangentDegrees);
+    printf("  uv error       : max %.6f\n", error.maxUV);
+    printf("  vertex bytes   : %8.2f MB -> %8.2f MB (%zu -> %zu bytes per vertex)\n",
+           vertexCount * sizeof(Vertex) / (1024.0 * 1024.0), vertexCount * sizeof(PackedVertex) / (1024.0 * 1024.0), sizeof(Vertex), sizeof(PackedVertex));
+    printf("  index bytes    : %8.2f MB -> %8.2f MB\n", indexCount * sizeof(uint32_t) / (1024.0 * 1024.0), indexBytes16 / (1024.0 * 1024.0));
+
+    //! @note Same draw loop for both layouts, only the vertex format (and shader) changes
+    auto measure = [&](const char* label, const char* vertexShader, bool packedVertices){
+        Shader shader(vertexShader, "basics/shaders/modelLoading-01/model.frag");
+        shader.Bind();
+        shader.Set("projection", glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f));
+        shader.Set("view", glm::lookAt(glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+        shader.Set("model", glm::mat4(1.0f));
+
+        ModelLoadOptions options;
+        options.packedVertices = packedVertices;
+        Model model(modelPath, options);
+        model.Draw(shader);
+        glFinish();
+
+        auto start = std::chrono::steady_clock::now();
+        for(uint32_t i = 0; i < frames; i++){
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            model.Draw(shader);
+        }
+        glFinish();
+        printf("  %-14s : %.3f ms/frame\n", label, ElapsedMilliseconds(start) / frames);
+    };
+
+    measure("draw (Vertex)", "basics/shaders/modelLoading-01/model.vert", false);
+    measure("draw (packed)", "basics/shaders/modelLoading-01/modelPacked.vert", true);
+}
+
+//! @note Vertex cache / overdraw / vertex fetch optimization: ACMR and ATVR per mesh before and after (CPU cache simulation), time spent, and the draw cost per frame
+void MeshOptimizationBenchmark(GLFWwindow* window, const std::string& modelPath = "basics/models/backpack.obj", uint32_t frames = 200){
+    printf("Mesh Optimization Benchmark -- %s\n", modelPath.c_str());
+
+    Assimp::Importer importer;
+    const aiScene* scene = importer.ReadFile(modelPath, Model::importFlags());
+    if(!scene || !scene->mRootNode){
+        printf("  could not import model: %s\n", importer.GetErrorString());
+        return;
+    }
+
+    std::vector<const aiMesh*> sceneMeshes;
+    Model::collectMeshes(scene->mRootNode, scene, sceneMeshes);
+
+    std::vector<MeshData> meshData(sceneMeshes.size());
+    for(size_t i = 0; i < sceneMeshes.size(); i++){
+        Model::extractMeshData(sceneMeshes[i], meshData[i]);
+    }
+
+    std::vector<MeshOptimizationReport> reports(meshData.size());
+    auto start = std::chrono::steady_clock::now();
+    for(size_t i = 0; i < meshData.size(); i++){
+        OptimizeMesh(meshData[i], &reports[i]);
+    }
+    double optimizeTime = ElapsedMilliseconds(start);
+
+    PrintMeshOptimizationReport(reports);
+    printf("  optimization pass : %.2f ms (single thread)\n", optimizeTime);
+
+    Shader shader("basics/shaders/modelLoading-01/model.vert", "basics/shaders/modelLoading-01/model.frag");
+    shader.Bind();
+    shader.Set("projection", glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f));
+    shader.Set("view", glm::lookAt(glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+    shader.Set("model", glm::mat4(1.0f));
+
+    auto measure = [&](const char* label, bool optimizeMeshes){
+        ModelLoadOptions options;
+        options.optimizeMeshes = optimizeMeshes;
+        Model model(modelPath, options);
+        model.Draw(shader);
+        glFinish();
+
+        auto start = std::chrono::steady_clock::now();
+        for(uint32_t i = 0; i < frames; i++){
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            model.Draw(shader);
+        }
+        glFinish();
+        printf("  %-18s : %.3f ms/frame\n", label, ElapsedMilliseconds(start) / frames);
+    };
+
+    measure("draw (as imported)", false);
+    measure("draw (optimized)", true);
+}
+
+//! @note LOD chain generation: time spent simplifying, triangles and error per level, and the level/triangle count Model::Draw picks as the camera backs away
+void LodBenchmark(GLFWwindow* window, const std::string& modelPath = "basics/models/backpack.obj", uint32_t lodLevels = 3){
+    printf("LOD Chain Benchmark -- %s\n", modelPath.c_str());
+
+    ModelLoadOptions baseOptions;
+    auto start = std::chrono::steady_clock::now();
+    {
+        Model model(modelPath, baseOptions);
+    }
+    double baseTime = ElapsedMilliseconds(start);
+
+    ModelLoadOptions options;
+    options.lodLevels = lodLevels;
+    start = std::chrono::steady_clock::now();
+    Model model(modelPath, options);
+    double lodTime = ElapsedMilliseconds(start);
+    printf("  load without LODs : %8.2f ms\n", baseTime);
+    printf("  load with %u LODs  : %8.2f ms\n", lodLevels, lodTime);
+
+    uint32_t withoutLods = 0;
+    for(size_t i = 0; i < model.meshes.size(); i++){
+        const Mesh& mesh = model.meshes[i];
+        printf("  mesh %3zu:", i);
+        for(const MeshLod& lod : mesh.lods){
+            printf("  %7u tris (error %.5f)", lod.indexCount / 3, lod.error);
+        }
+        printf("\n");
+        withoutLods += mesh.lods.size() <= 1 ? 1 : 0;
+    }
+    printf("  meshes without LODs: %u of %zu %s\n", withoutLods, model.meshes.size(), withoutLods < model.meshes.size() ? "" : "-- NO LOD BUILT");
+
+    Shader shader("basics/shaders/modelLoading-01/model.vert", "basics/shaders/modelLoading-01/model.frag");
+    shader.Bind();
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f);
+    shader.Set("projection", projection);
+    shader.Set("model", glm::mat4(1.0f));
+
+    LodView view;
+    view.projectionScale = LodProjectionScale(glm::radians(45.0f), 600.0f);
+
+    const float distances[] = {2.0f, 5.0f, 10.0f, 20.0f, 40.0f, 80.0f};
+    for(float distance : distances){
+        view.cameraPosition = glm::vec3(0.0f, 0.0f, distance);
+        shader.Set("view", glm::lookAt(view.cameraPosition, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+
+        FrameRenderStats().Reset();
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        model.Draw(shader, view);
+        glFinish();
+
+        uint32_t deepest = 0;
+        for(const Mesh& mesh : model.meshes){
+            deepest = std::max(deepest, mesh.currentLod);
+        }
+        printf("  distance %5.1f : %8u triangles, deepest level %u\n", distance, FrameRenderStats().triangles, deepest);
+    }
+}
+
+//! @note Meshlet partitioning: build time, the CPU check that every mesh's clusters hold exactly its triangles, fill statistics, and how many clusters survive culling from a few viewpoints
+void MeshletBenchmark(GLFWwindow* window, const std::string& modelPath = "basics/models/backpack.obj"){
+    printf("Meshlet Benchmark -- %s\n", modelPath.c_str());
+
+    Assimp::Importer importer;
+    const aiScene* scene = importer.ReadFile(modelPath, Model::importFlags());
+    if(!scene || !scene->mRootNode){
+        printf("  could not import model: %s\n", importer.GetErrorString());
+        return;
+    }
+
+    std::vector<const aiMesh*> sceneMeshes;
+    Model::collectMeshes(scene->mRootNode, scene, sceneMeshes);
+
+    std::vector<MeshData> meshData(sceneMeshes.size());
+    for(size_t i = 0; i < sceneMeshes.size(); i++){
+        Model::extractMeshData(sceneMeshes[i], meshData[i]);
+        OptimizeMesh(meshData[i]);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for(MeshData& mesh : meshData){
+        BuildMeshlets(mesh.vertices.data(), mesh.vertices.size(), mesh.indices.data(), mesh.indices.size(), mesh.meshlets);
+    }
+    double buildTime = ElapsedMilliseconds(start);
+
+    bool valid = true;
+    MeshletSet combined;
+    for(size_t i = 0; i < meshData.size(); i++){
+        const MeshData& mesh = meshData[i];
+        if(!VerifyMeshlets(mesh.meshlets, mesh.indices.data(), mesh.indices.size())){
+            printf("  mesh %zu: meshlets do NOT reproduce the triangle set\n", i);
+            valid = false;
+        }
+        printf("  mesh %3zu:", i);
+        PrintMeshletStats(ComputeMeshletStats(mesh.meshlets));
+    }
+    printf("  build time    : %.2f ms\n", buildTime);
+    printf("  triangle sets : %s\n", valid ? "identical" : "MISMATCH");
+
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f);
+    const glm::vec3 viewpoints[] = {glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(3.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -3.0f), glm::vec3(0.0f, 0.5f, 1.0f)};
+    for(const glm::vec3& eye : viewpoints){
+        glm::mat4 view = glm::lookAt(eye, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        glm::vec4 planes[6];
+        ExtractFrustumPlanes(projection * view, planes);
+
+        size_t total = 0, visibleCount = 0, visibleTriangles = 0, totalTriangles = 0;
+        std::vector<uint32_t> visible;
+        start = std::chrono::steady_clock::now();
+        for(const MeshData& mesh : meshData){
+            total += mesh.meshlets.Count();
+            visibleCount += CullMeshlets(mesh.meshlets, planes, eye, visible);
+            for(uint32_t m : visible) visibleTriangles += mesh.meshlets.triangleCounts[m];
+            totalTriangles += mesh.indices.size() / 3;
+        }
+        double cullTime = ElapsedMilliseconds(start);
+
+        printf("  eye (%5.1f %5.1f %5.1f): %6zu / %6zu meshlets, %8zu / %8zu triangles kept (%.3f ms)\n",
+               eye.x, eye.y, eye.z, visibleCount, total, visibleTriangles, totalTriangles, cullTime);
+    }
+}
+
+//! @note Blocking Model construction against the streaming constructor: how long until the first frame can show part of the model, and until everything is loaded
+void StreamingLoadBenchmark(GLFWwindow* window, const std::string& modelPath = "basics/models/backpack.obj"){
+    printf("Streaming Load Benchmark -- %s\n", modelPath.c_str());
+
+    Shader shader("basics/shaders/modelLoading-01/model.vert", "basics/shaders/modelLoading-01/model.frag");
+    shader.Bind();
+    shader.Set("projection", glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f));
+    shader.Set("view", glm::lookAt(glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+    shader.Set("model", glm::mat4(1.0f));
+
+    {
+        AsyncTextureLoader textureLoader(SharedThreadPool());
+        ModelLoadOptions options;
+        options.textureLoader = &textureLoader;
+        options.extractionPool = &SharedThreadPool();
+
+        auto start = std::chrono::steady_clock::now();
+        Model model(modelPath, options);
+        double firstFrame = ElapsedMilliseconds(start);
+        while(!textureLoader.Idle()){
+            textureLoader.Update();
+        }
+        glFinish();
+        printf("  blocking  : first frame after %8.2f ms, fully loaded after %8.2f ms\n", firstFrame, ElapsedMilliseconds(start));
+    }
+
+    {
+        AsyncTextureLoader textureLoader(SharedThreadPool());
+        ModelLoadOptions options;
+        options.textureLoader = &textureLoader;
+        options.extractionPool = &SharedThreadPool();
+
+        double firstFrame = 0.0, fullyLoaded = 0.0;
+        uint32_t progressUpdates = 0;
+        ModelStreamCallbacks callbacks;
+        callbacks.onFirstFrame = [&](double milliseconds){ firstFrame = milliseconds; };
+        callbacks.onFullyLoaded = [&](double milliseconds){ fullyLoaded = milliseconds; };
+        callbacks.onProgress = [&](const ModelStreamProgress&){ progressUpdates++; };
+
+        auto start = std::chrono::steady_clock::now();
+        Model model(modelPath, options, callbacks);
+        double constructor = ElapsedMilliseconds(start);
+
+        //! @note A render loop as the example runs it, every frame draws whatever is resident so far
+        uint32_t frames = 0;
+        while(!model.updateStreaming()){
+            textureLoader.Update();
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            model.Draw(shader);
+            frames++;
+        }
+        glFinish();
+
+        printf("  streaming : constructor returned after %.3f ms\n", constructor);
+        printf("  streaming : first frame after %8.2f ms, fully loaded after %8.2f ms (%u frames rendered, %u progress updates)\n",
+               firstFrame, fullyLoaded, frames, progressUpdates);
+    }
+}
+
+//! @note Highest resident set size of the process so far, 0 where getrusage is not available
+static double PeakResidentMegabytes(){
+#if defined(__APPLE__)
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / (1024.0 * 1024.0); // bytes on macOS
+#elif defined(__unix__)
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / 1024.0; // kilobytes on Linux
+#else
+    return 0.0;
+#endif
+}
+
+//! @note Loads, draws and destroys the same model over and over. With every GL object owned by a handle, peak RSS should stop growing after the first couple of reloads.
+void ModelReloadBenchmark(GLFWwindow* window, const std::string& modelPath = "basics/models/backpack.obj", uint32_t reloads = 20){
+    printf("Model Reload Benchmark -- %s\n", modelPath.c_str());
+
+    Shader shader("basics/shaders/modelLoading-01/model.vert", "basics/shaders/modelLoading-01/model.frag");
+    shader.Bind();
+    shader.Set("projection", glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f));
+    shader.Set("view", glm::lookAt(glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+    shader.Set("model", glm::mat4(1.0f));
+
+    double startRss = PeakResidentMegabytes();
+    double firstLoad = 0.0, totalLoad = 0.0, slowestLoad = 0.0;
+    double rssAfterFirst = 0.0;
+    const GLDeletionStats& deletions = GlobalDeletionQueue().GetStats();
+    uint64_t deletedBefore = deletions.deleted;
+
+    for(uint32_t i = 0; i < reloads; i++){
+        auto start = std::chrono::steady_clock::now();
+        {
+            Model model(modelPath);
+            double loadTime = ElapsedMilliseconds(start);
+
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            model.Draw(shader);
+
+            if(i == 0){
+                firstLoad = loadTime;
+            }
+            totalLoad += loadTime;
+            slowestLoad = std::max(slowestLoad, loadTime);
+        }
+
+        //! @note Standing in for the frame boundary, the model's buffers and textures were queued above and are deleted a couple of frames later
+        glfwSwapBuffers(window);
+        GlobalDeletionQueue().EndFrame();
+
+        if(i == 0){
+            rssAfterFirst = PeakResidentMegabytes();
+        }
+    }
+
+    GlobalDeletionQueue().Flush();
+
+    printf("  load time : first %8.2f ms, average %8.2f ms, slowest %8.2f ms over %u loads\n", firstLoad, totalLoad / reloads, slowestLoad, reloads);
+    printf("  peak RSS  : %8.2f MB before, %8.2f MB after the first load, %8.2f MB after %u loads\n", startRss, rssAfterFirst, PeakResidentMegabytes(), reloads);
+    printf("  GL objects: %llu deleted through the deletion queue, %u still pending\n",
+           static_cast<unsigned long long>(deletions.deleted - deletedBefore), deletions.pending);
+}
+
+static size_t CountSceneVertices(const std::vector<const aiMesh*>& sceneMeshes){
+    size_t vertices = 0;
+    for(const aiMesh* mesh : sceneMeshes){
+        vertices += mesh->mNumVertices;
+    }
+    return vertices;
+}
+
+//! @note aiProcess_JoinIdenticalVertices inside the import, against importing without it and welding our extracted meshes in parallel (exact and with a small epsilon)
+void VertexWeldBenchmark(GLFWwindow* window, const std::string& modelPath = "basics/models/backpack.obj", float epsilon = 1e-5f){
+    printf("Vertex Weld Benchmark -- %s\n", modelPath.c_str());
+
+    double assimpTime = 0.0;
+    size_t assimpVertices = 0;
+    {
+        Assimp::Importer importer;
+        auto start = std::chrono::steady_clock::now();
+        const aiScene* scene = importer.ReadFile(modelPath, Model::importFlags() | aiProcess_JoinIdenticalVertices);
+        assimpTime = ElapsedMilliseconds(start);
+        if(!scene || !scene->mRootNode){
+            printf("  could not import model: %s\n", importer.GetErrorString());
+            return;
+        }
+
+        std::vector<const aiMesh*> sceneMeshes;
+        Model::collectMeshes(scene->mRootNode, scene, sceneMeshes);
+        assimpVertices = CountSceneVertices(sceneMeshes);
+    }
+
+    Assimp::Importer importer;
+    auto start = std::chrono::steady_clock::now();
+    const aiScene* scene = importer.ReadFile(modelPath, Model::importFlags());
+    double importTime = ElapsedMilliseconds(start);
+    if(!scene || !scene->mRootNode){
+        printf("  could not import model: %s\n", importer.GetErrorString());
+        return;
+    }
+
+    std::vector<const aiMesh*> sceneMeshes;
+    Model::collectMeshes(scene->mRootNode, scene, sceneMeshes);
+    size_t rawVertices = CountSceneVertices(sceneMeshes);
+
+    std::vector<MeshData> meshData(sceneMeshes.size());
+    SharedThreadPool().ParallelFor(static_cast<uint32_t>(sceneMeshes.size()), [&](uint32_t i){
+        Model::extractMeshData(sceneMeshes[i], meshData[i]);
+    });
+
+    printf("  no join          : %zu vertices, import %8.2f ms\n", rawVertices, importTime);
+    printf("  assimp join      : %zu vertices, import %8.2f ms (join costs %8.2f ms)\n", assimpVertices, assimpTime, assimpTime - importTime);
+
+    WeldSettings exact;
+    WeldSettings tolerant;
+    tolerant.positionEpsilon = epsilon;
+    tolerant.attributeEpsilon = epsilon;
+
+    for(const WeldSettings& settings : {exact, tolerant}){
+        std::vector<MeshData> welded = meshData;
+        std::vector<WeldStats> stats(welded.size());
+
+        start = std::chrono::steady_clock::now();
+        SharedThreadPool().ParallelFor(static_cast<uint32_t>(welded.size()), [&](uint32_t i){
+            stats[i] = WeldVertices(welded[i], settings);
+        });
+        double weldTime = ElapsedMilliseconds(start);
+
+        WeldStats total;
+        for(const WeldStats& mesh : stats){
+            total.inputVertices += mesh.inputVertices;
+            total.outputVertices += mesh.outputVertices;
+            total.removedTriangles += mesh.removedTriangles;
+        }
+
+        char label[64];
+        snprintf(label, sizeof(label), "  weld eps %-7g", settings.positionEpsilon);
+        PrintWeldStats(label, total);
+        printf("                     welded in %8.2f ms on %u threads (%.1fx faster than the assimp join)\n",
+               weldTime, SharedThreadPool().ThreadCount(), (assimpTime - importTime) / std::max(weldTime, 1e-3));
+    }
+}
+
+/**
+ * @note Checks MeshTangents.h against assimp's aiProcess_GenSmoothNormals + aiProcess_CalcTangentSpace and times both
+ * @note Normals are dropped on import so both sides really generate them. Neither side reorders vertices, so they are compared index by index.
+*/
+void TangentFrameBenchmark(GLFWwindow* window, const std::string& modelPath = "basics/models/backpack.obj", float toleranceDegrees = 5.0f, uint32_t runs = 3){
+    printf("Tangent Frame Benchmark -- %s\n", modelPath.c_str());
+
+    const unsigned int baseFlags = aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_DropNormals;
+
+    Assimp::Importer referenceImporter;
+    auto start = std::chrono::steady_clock::now();
+    const aiScene* referenceScene = referenceImporter.ReadFile(modelPath, baseFlags | aiProcess_GenSmoothNormals | aiProcess_CalcTangentSpace);
+    double referenceTime = ElapsedMilliseconds(start);
+
+    Assimp::Importer importer;
+    start = std::chrono::steady_clock::now();
+    const aiScene* scene = importer.ReadFile(modelPath, baseFlags);
+    double importTime = ElapsedMilliseconds(start);
+
+    if(!referenceScene || !referenceScene->mRootNode || !scene || !scene->mRootNode){
+        printf("  could not import model\n");
+        return;
+    }
+
+    std::vector<const aiMesh*> referenceMeshes, sceneMeshes;
+    Model::collectMeshes(referenceScene->mRootNode, referenceScene, referenceMeshes);
+    Model::collectMeshes(scene->mRootNode, scene, sceneMeshes);
+
+    std::vector<MeshData> extracted(sceneMeshes.size());
+    for(size_t i = 0; i < sceneMeshes.size(); i++){
+        Model::extractMeshData(sceneMeshes[i], extracted[i]);
+    }
+
+    //! @note Verification, one serial run compared vertex by vertex
+    TangentFrameComparison comparison;
+    for(size_t i = 0; i < sceneMeshes.size() && i < referenceMeshes.size(); i++){
+        if(!sceneMeshes[i]->HasTextureCoords(0)) continue;
+
+        MeshData ours = extracted[i];
+        GenerateTangentFrames(ours);
+
+        MeshData reference;
+        Model::extractMeshData(referenceMeshes[i], reference);
+        size_t count = std::min(reference.vertices.size(), static_cast<size_t>(sceneMeshes[i]->mNumVertices));
+        CompareTangentFrames(ours.vertices.data(), reference.vertices.data(), count, toleranceDegrees, comparison);
+    }
+    PrintTangentFrameComparison(comparison, toleranceDegrees);
+
+    auto timeRuns = [&](ThreadPool* pool){
+        double total = 0.0;
+        for(uint32_t run = 0; run < runs; run++){
+            std::vector<MeshData> meshData = extracted;
+            start = std::chrono::steady_clock::now();
+            for(MeshData& data : meshData){
+                GenerateTangentFrames(data, TangentFrameSettings(), pool);
+            }
+            total += ElapsedMilliseconds(start);
+        }
+        return total / runs;
+    };
+
+    double assimpTime = referenceTime - importTime;
+    double serialTime = timeRuns(nullptr);
+    printf("  assimp post-process : %8.2f ms\n", assimpTime);
+    printf("  serial              : %8.2f ms  (%.2fx faster than assimp)\n", serialTime, assimpTime / std::max(serialTime, 1e-3));
+
+    uint32_t maxThreads = std::thread::hardware_concurrency();
+    for(uint32_t threads = 1; threads <= maxThreads; threads *= 2){
+        ThreadPool pool(threads);
+        double parallelTime = timeRuns(&pool);
+        printf("  %2u threads          : %8.2f ms  (%.2fx serial, %.2fx assimp)\n", threads, parallelTime, serialTime / parallelTime, assimpTime / std::max(parallelTime, 1e-3));
+    }
+}
+
+/**
+ * @note Loads the same glTF/GLB file through assimp (extraction into Vertex arrays, one VBO per mesh) and through GltfLoader.h
+ * @note (buffer views uploaded straight from the mapped file). Both decode the same textures, nothing else holds them so every load starts from an empty texture cache.
+ * @note Then checks both produce the same meshes: count, vertex and index counts, texture count and types per mesh.
+*/
+void GltfLoadBenchmark(GLFWwindow* window, const std::string& modelPath = "basics/models/backpack.glb", uint32_t runs = 3){
+    printf("glTF Load Benchmark -- %s\n", modelPath.c_str());
+
+    auto timeLoads = [&](bool native){
+        ModelLoadOptions options;
+        options.nativeGltf = native;
+        double total = 0.0;
+        for(uint32_t run = 0; run < runs; run++){
+            auto start = std::chrono::steady_clock::now();
+            {
+                Model model(modelPath, options);
+                glFinish();
+                total += ElapsedMilliseconds(start);
+            }
+            glfwSwapBuffers(window);
+            GlobalDeletionQueue().EndFrame();
+        }
+        return total / runs;
+    };
+
+    double assimpTime = timeLoads(false);
+    double nativeTime = timeLoads(true);
+
+    //! @note Both paths must produce the same meshes (count, vertices, indices) with the same textures, in the same order
+    size_t assimpMeshes = 0, nativeMeshes = 0;
+    uint32_t mismatches = 0;
+    {
+        ModelLoadOptions assimpOptions, nativeOptions;
+        assimpOptions.nativeGltf = false;
+        nativeOptions.nativeGltf = true;
+        Model assimpModel(modelPath, assimpOptions);
+        Model nativeModel(modelPath, nativeOptions);
+        assimpMeshes = assimpModel.meshes.size();
+        nativeMeshes = nativeModel.meshes.size();
+        if(assimpMeshes != nativeMeshes){
+            printf("  MISMATCH: %zu meshes through assimp, %zu native\n", assimpMeshes, nativeMeshes);
+            mismatches++;
+        }
+        for(size_t i = 0; i < std::min(assimpMeshes, nativeMeshes); i++){
+            const Mesh& a = assimpModel.meshes[i];
+            const Mesh& b = nativeModel.meshes[i];
+            bool sameTextures = a.textures.size() == b.textures.size();
+            for(size_t t = 0; sameTextures && t < a.textures.size(); t++){
+                sameTextures = a.textures[t].type == b.textures[t].type;
+            }
+            if(a.VertexCount() != b.VertexCount() || a.IndexCount() != b.IndexCount() || !sameTextures){
+                printf("  MISMATCH mesh %3zu: assimp %u vertices / %u indices / %zu textures, native %u / %u / %zu\n", i,
+                       a.VertexCount(), a.IndexCount(), a.textures.size(), b.VertexCount(), b.IndexCount(), b.textures.size());
+                mismatches++;
+            }
+        }
+    }
+    GlobalDeletionQueue().Flush();
+
+    printf("  assimp : %8.2f ms  (%zu meshes)\n", assimpTime, assimpMeshes);
+    printf("  native : %8.2f ms  (%zu meshes, %.2fx faster)\n", nativeTime, nativeMeshes, assimpTime / std::max(nativeTime, 1e-3));
+    printf("  same meshes and textures: %s (%u mismatches)\n", mismatches == 0 ? "yes" : "NO", mismatches);
+}
+
+//! @note Writes a width x width grid (v, vt and vn per vertex, one quad per cell) of about the requested size, returns the bytes written
+static size_t WriteSyntheticObj(const std::string& path, double megabytes){
+    //! @note A cell costs roughly 150 bytes of text (three vertex lines plus a face line)
+    uint32_t width = static_cast<uint32_t>(std::sqrt(megabytes * 1024.0 * 1024.0 / 150.0)) + 2;
+    std::ofstream file(path, std::ios::binary);
+    std::string text;
+    char line[160];
+
+    auto flush = [&](){
+        file.write(text.data(), static_cast<std::streamsize>(text.size()));
+        text.clear();
+    };
+
+    text += "o synthetic\n";
+    for(uint32_t y = 0; y < width; y++){
+        for(uint32_t x = 0; x < width; x++){
+            float u = float(x) / float(width - 1), v = float(y) / float(width - 1);
+            float height = 0.05f * std::sin(u * 37.0f) * std::cos(v * 23.0f);
+            text.append(line, snprintf(line, sizeof(line), "v %.6f %.6f %.6f\nvt %.6f %.6f\nvn %.6f %.6f %.6f\n", u * 10.0f, height, v * 10.0f, u, v, -height, 1.0f, height * 0.5f));
+        }
+        if(text.size() > (1u << 20)) flush();
+    }
+    for(uint32_t y = 0; y + 1 < width; y++){
+        for(uint32_t x = 0; x + 1 < width; x++){
+            uint32_t a = y * width + x + 1, b = a + 1, c = a + width + 1, d = a + width;
+            text.append(line, snprintf(line, sizeof(line), "f %u/%u/%u %u/%u/%u %u/%u/%u %u/%u/%u\n", a, a, a, d, d, d, c, c, c, b, b, b));
+        }
+        if(text.size() > (1u << 20)) flush();
+    }
+    flush();
+    return static_cast<size_t>(file.tellp());
+}
+
+/**
+ * @note Checks ObjLoader.h against assimp's OBJ importer on the model (same flags, both welded exactly so vertex order is first use),
+ * @note then times both on a large synthetic OBJ, the native parser serially and on 1..N threads
+*/
+void ObjParseBenchmark(GLFWwindow* window, const std::string& modelPath = "basics/models/backpack.obj", double syntheticMegabytes = 64.0){
+    printf("OBJ Parse Benchmark -- %s\n", modelPath.c_str());
+
+    ModelLoadOptions options;
+    options.computeTangentFrames = true; // assimp only triangulates and flips uvs, like the native path
+    const unsigned int flags = Model::importFlags(options);
+
+    Assimp::Importer importer;
+    const aiScene* scene = importer.ReadFile(modelPath, flags);
+    ObjAsset asset;
+    std::string error;
+    if(!scene || !scene->mRootNode || !asset.Load(modelPath, &SharedThreadPool(), error)){
+        printf("  could not import model %s\n", error.c_str());
+        return;
+    }
+
+    std::vector<const aiMesh*> sceneMeshes;
+    Model::collectMeshes(scene->mRootNode, scene, sceneMeshes);
+
+    size_t matching = 0;
+    float positionError = 0.0f, normalError = 0.0f, uvError = 0.0f;
+    for(size_t i = 0; i < sceneMeshes.size() && i < asset.meshes.size(); i++){
+        MeshData reference;
+        Model::extractMeshData(sceneMeshes[i], reference);
+        WeldVertices(reference);
+        MeshData ours = asset.meshes[i].data;
+        WeldVertices(ours);
+
+        if(reference.vertices.size() != ours.vertices.size() || reference.indices != ours.indices) continue;
+        matching++;
+        for(size_t v = 0; v < ours.vertices.size(); v++){
+            const Vertex& a = reference.vertices[v];
+            const Vertex& b = ours.vertices[v];
+            positionError = std::max(positionError, glm::length(a.position - b.position));
+            normalError = std::max(normalError, glm::length(a.normal - b.normal));
+            uvError = std::max(uvError, glm::length(a.TexCoords - b.TexCoords));
+        }
+    }
+    printf("  meshes    : %zu assimp, %zu native, %zu with identical vertices/indices\n", sceneMeshes.size(), asset.meshes.size(), matching);
+    printf("  max error : position %g, normal %g, uv %g\n", positionError, normalError, uvError);
+
+    std::string syntheticPath = (std::filesystem::temp_directory_path() / "synthetic_benchmark.obj").string();
+    size_t bytes = WriteSyntheticObj(syntheticPath, syntheticMegabytes);
+    double megabytes = bytes / (1024.0 * 1024.0);
+    printf("  synthetic : %.1f MB\n", megabytes);
+
+    auto start = std::chrono::steady_clock::now();
+    {
+        Assimp::Importer syntheticImporter;
+        if(!syntheticImporter.ReadFile(syntheticPath, flags)){
+            printf("  assimp could not import the synthetic file\n");
+        }
+    }
+    double assimpTime = ElapsedMilliseconds(start);
+    printf("  assimp        : %8.2f ms  %8.1f MB/s\n", assimpTime, megabytes / (assimpTime / 1000.0));
+
+    auto report = [&](const char* label, ThreadPool* pool){
+        ObjAsset synthetic;
+        if(!synthetic.Load(syntheticPath, pool, error)){
+            printf("  %s: %s\n", label, error.c_str());
+            return;
+        }
+        const ObjParseStats& stats = synthetic.stats;
+        printf("  %-14s: %8.2f ms  %8.1f MB/s  (parse %.2f, merge %.2f, build %.2f ms, %u chunks, %.2fx assimp)\n", label, stats.totalMilliseconds, stats.MegabytesPerSecond(),
+               stats.parseMilliseconds, stats.mergeMilliseconds, stats.buildMilliseconds, stats.chunks, assimpTime / std::max(stats.totalMilliseconds, 1e-3));
+    };
+
+    report("serial", nullptr);
+    uint32_t maxThreads = std::thread::hardware_concurrency();
+    for(uint32_t threads = 1; threads <= maxThreads; threads *= 2){
+        ThreadPool pool(threads);
+        char label[32];
+        snprintf(label, sizeof(label), "%u threads", threads);
+        report(label, &pool);
+    }
+
+    std::filesystem::remove(syntheticPath);
+}
+
+static std::string EncodeBase64(const uint8_t* data, size_t size){
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    out.reserve((size + 2) / 3 * 4);
+    for(size_t i = 0; i < size; i += 3){
+        uint32_t chunk = uint32_t(data[i]) << 16;
+        if(i + 1 < size) chunk |= uint32_t(data[i + 1]) << 8;
+        if(i + 2 < size) chunk |= data[i + 2];
+        out += alphabet[(chunk >> 18) & 63];
+        out += alphabet[(chunk >> 12) & 63];
+        out += i + 1 < size ? alphabet[(chunk >> 6) & 63] : '=';
+        out += i + 2 < size ? alphabet[chunk & 63] : '=';
+    }
+    return out;
+}
+
+//! @note A .gltf scene where copies nodes (a flat grid) all reference one bolt mesh, like a CAD export would
+//! @note uniqueMeshes more nodes each get a bolt of their own length, meshes drawn once that instancing leaves to merging
+static void WriteRepeatedMeshGltf(const std::string& path, uint32_t copies, uint32_t uniqueMeshes = 0){
+    const uint32_t segments = 24;
+    std::vector<float> positions, normals, uvs;
+    std::vector<uint16_t> indices;
+    for(uint32_t ring = 0; ring < 2; ring++){
+        for(uint32_t s = 0; s <= segments; s++){
+            float angle = 6.2831853f * float(s) / float(segments);
+            positions.insert(positions.end(), {0.05f * std::cos(angle), ring * 0.3f, 0.05f * std::sin(angle)});
+            normals.insert(normals.end(), {std::cos(angle), 0.0f, std::sin(angle)});
+            uvs.insert(uvs.end(), {float(s) / float(segments), float(ring)});
+        }
+    }
+    for(uint16_t s = 0; s < segments; s++){
+        uint16_t a = s, b = s + 1, c = s + segments + 2, d = s + segments + 1;
+        indices.insert(indices.end(), {a, d, c, a, c, b});
+    }
+
+    std::vector<uint8_t> buffer;
+    auto append = [&](const void* data, size_t bytes){
+        size_t offset = buffer.size();
+        buffer.insert(buffer.end(), static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + bytes);
+        buffer.resize((buffer.size() + 3) & ~size_t(3));
+        return offset;
+    };
+    size_t positionOffset = append(positions.data(), positions.size() * sizeof(float));
+    size_t normalOffset = append(normals.data(), normals.size() * sizeof(float));
+    size_t uvOffset = append(uvs.data(), uvs.size() * sizeof(float));
+    size_t indexOffset = append(indices.data(), indices.size() * sizeof(uint16_t));
+    uint32_t vertexCount = static_cast<uint32_t>(positions.size() / 3);
+    std::vector<size_t> uniqueOffsets;
+    for(uint32_t u = 0; u < uniqueMeshes; u++){
+        std::vector<float> stretched = positions;
+        for(size_t v = 1; v < stretched.size(); v += 3) stretched[v] *= 1.5f + 0.25f * float(u);
+        uniqueOffsets.push_back(append(stretched.data(), stretched.size() * sizeof(float)));
+    }
+
+    std::string json = "{\"asset\":{\"version\":\"2.0\"},\"scene\":0,\"scenes\":[{\"nodes\":[";
+    for(uint32_t i = 0; i < copies + uniqueMeshes; i++){
+        json += (i ? "," : "") + std::to_string(i);
+    }
+    json += "]}],\"nodes\":[";
+    uint32_t columns = static_cast<uint32_t>(std::ceil(std::sqrt(double(copies))));
+    char node[128];
+    for(uint32_t i = 0; i < copies; i++){
+        snprintf(node, sizeof(node), "%s{\"mesh\":0,\"translation\":[%.3f,0,%.3f]}", i ? "," : "", (i % columns) * 0.2f, (i / columns) * 0.2f);
+        json += node;
+    }
+    for(uint32_t u = 0; u < uniqueMeshes; u++){
+        snprintf(node, sizeof(node), "%s{\"mesh\":%u,\"translation\":[%.3f,0,-0.5]}", copies + u ? "," : "", u + 1, u * 0.2f);
+        json += node;
+    }
+    json += "],\"meshes\":[{\"primitives\":[{\"attributes\":{\"POSITION\":0,\"NORMAL\":1,\"TEXCOORD_0\":2},\"indices\":3}]}";
+    for(uint32_t u = 0; u < uniqueMeshes; u++){
+        json += ",{\"primitives\":[{\"attributes\":{\"POSITION\":" + std::to_string(4 + u) + ",\"NORMAL\":1,\"TEXCOORD_0\":2},\"indices\":3}]}";
+    }
+    char tail[1024];
+    snprintf(tail, sizeof(tail),
+             "],"
+             "\"accessors\":["
+             "{\"bufferView\":0,\"componentType\":5126,\"count\":%u,\"type\":\"VEC3\",\"min\":[-0.05,0,-0.05],\"max\":[0.05,0.3,0.05]},"
+             "{\"bufferView\":1,\"componentType\":5126,\"count\":%u,\"type\":\"VEC3\"},"
+             "{\"bufferView\":2,\"componentType\":5126,\"count\":%u,\"type\":\"VEC2\"},"
+             "{\"bufferView\":3,\"componentType\":5123,\"count\":%zu,\"type\":\"SCALAR\"}",
+             vertexCount, vertexCount, vertexCount, indices.size());
+    json += tail;
+    for(uint32_t u = 0; u < uniqueMeshes; u++){
+        snprintf(tail, sizeof(tail), ",{\"bufferView\":%u,\"componentType\":5126,\"count\":%u,\"type\":\"VEC3\",\"min\":[-0.05,0,-0.05],\"max\":[0.05,%.3f,0.05]}",
+                 4 + u, vertexCount, 0.3f * (1.5f + 0.25f * float(u)));
+        json += tail;
+    }
+    snprintf(tail, sizeof(tail),
+             "],\"bufferViews\":[{\"buffer\":0,\"byteOffset\":%zu,\"byteLength\":%zu},{\"buffer\":0,\"byteOffset\":%zu,\"byteLength\":%zu},"
+             "{\"buffer\":0,\"byteOffset\":%zu,\"byteLength\":%zu},{\"buffer\":0,\"byteOffset\":%zu,\"byteLength\":%zu}",
+             positionOffset, positions.size() * sizeof(float), normalOffset, normals.size() * sizeof(float),
+             uvOffset, uvs.size() * sizeof(float), indexOffset, indices.size() * sizeof(uint16_t));
+    json += tail;
+    for(size_t offset : uniqueOffsets){
+        json += ",{\"buffer\":0,\"byteOffset\":" + std::to_string(offset) + ",\"byteLength\":" + std::to_string(positions.size() * sizeof(float)) + "}";
+    }
+    json += "],";
+    json += "\"buffers\":[{\"byteLength\":" + std::to_string(buffer.size()) + ",\"uri\":\"data:application/octet-stream;base64," + EncodeBase64(buffer.data(), buffer.size()) + "\"}]}";
+
+    std::ofstream file(path, std::ios::binary);
+    file << json;
+}
+
+/**
+ * @note Loads a model through assimp with and without ModelLoadOptions::instanceMeshes and compares uploads, draw calls and CPU time per frame
+ * @note Without a path a synthetic glTF with copies nodes sharing one mesh is used (imported through assimp, the native glTF path does not instance)
+*/
+void InstancingBenchmark(GLFWwindow* window, const std::string& modelPath = "", uint32_t copies = 1024, uint32_t frames = 200){
+    std::string path = modelPath;
+    if(path.empty()){
+        path = (std::filesystem::temp_directory_path() / "instancing_benchmark.gltf").string();
+        WriteRepeatedMeshGltf(path, copies);
+    }
+    printf("Instancing Benchmark -- %s\n", path.c_str());
+
+    Shader shader("basics/shaders/modelLoading-01/model.vert", "basics/shaders/modelLoading-01/model.frag");
+    Shader instancedShader("basics/shaders/modelLoading-01/modelInstanced.vert", "basics/shaders/modelLoading-01/model.frag");
+
+    auto measure = [&](bool instanced){
+        ModelLoadOptions options;
+        options.nativeGltf = false;
+        options.instanceMeshes = instanced;
+
+        auto start = std::chrono::steady_clock::now();
+        Model model(path, options);
+        double loadTime = ElapsedMilliseconds(start);
+
+        Shader& drawShader = instanced ? instancedShader : shader;
+        drawShader.Bind();
+        drawShader.Set("projection", glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f));
+        drawShader.Set("view", glm::lookAt(glm::vec3(3.0f, 4.0f, 8.0f), glm::vec3(3.0f, 0.0f, 3.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+        drawShader.Set("model", glm::mat4(1.0f));
+
+        size_t uploadedBytes = 0;
+        for(const Mesh& mesh : model.meshes){
+            uploadedBytes += mesh.vertices.size() * sizeof(Vertex) + mesh.indices.size() * sizeof(uint32_t) + mesh.InstanceCount() * sizeof(glm::mat4);
+        }
+
+        double cpuTime = 0.0;
+        uint32_t drawCalls = 0;
+        for(uint32_t frame = 0; frame < frames; frame++){
+            FrameRenderStats().Reset();
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            auto frameStart = std::chrono::steady_clock::now();
+            model.Draw(drawShader);
+            cpuTime += ElapsedMilliseconds(frameStart);
+            drawCalls = FrameRenderStats().drawCalls;
+            glfwSwapBuffers(window);
+            GlobalDeletionQueue().EndFrame();
+        }
+        glFinish();
+
+        printf("  %-10s: load %8.2f ms, %5zu meshes, %8.2f KB uploaded, %5u draw calls, %.3f ms CPU per frame\n", instanced ? "instanced" : "per node",
+               loadTime, model.meshes.size(), uploadedBytes / 1024.0, drawCalls, cpuTime / frames);
+        if(instanced){
+            PrintInstancingReport(model.instancingReport);
+        }
+    };
+
+    measure(false);
+    measure(true);
+    GlobalDeletionQueue().Flush();
+
+    if(modelPath.empty()){
+        std::filesystem::remove(path);
+    }
+}
+
+/**
+ * @note Loads a model through assimp with and without ModelLoadOptions::mergeStaticMeshes (and with instanceMeshes too) and compares draw calls and CPU time per frame
+ * @note Without a path the synthetic glTF of InstancingBenchmark is used plus 8 bolts drawn once, everything shares one material so it merges into
+ * @note a single draw, with instancing the repeated bolt stays instanced and only the 8 others merge
+ * @note Also checks that every merged triangle range still maps back to the mesh it came from (what picking relies on), and with both options
+ * @note that every mesh carries instance transforms for modelInstanced.vert
+*/
+void MeshMergeBenchmark(GLFWwindow* window, const std::string& modelPath = "", uint32_t copies = 1024, uint32_t frames = 200){
+    std::string path = modelPath;
+    if(path.empty()){
+        path = (std::filesystem::temp_directory_path() / "mesh_merge_benchmark.gltf").string();
+        WriteRepeatedMeshGltf(path, copies, 8);
+    }
+    printf("Mesh Merge Benchmark -- %s\n", path.c_str());
+
+    Shader shader("basics/shaders/modelLoading-01/model.vert", "basics/shaders/modelLoading-01/model.frag");
+    Shader instancedShader("basics/shaders/modelLoading-01/modelInstanced.vert", "basics/shaders/modelLoading-01/model.frag");
+
+    auto measure = [&](bool merged, bool instanced){
+        ModelLoadOptions options;
+        options.nativeGltf = false;
+        options.nativeObj = false;
+        options.mergeStaticMeshes = merged;
+        options.instanceMeshes = instanced;
+
+        auto start = std::chrono::steady_clock::now();
+        Model model(path, options);
+        double loadTime = ElapsedMilliseconds(start);
+
+        Shader& drawShader = instanced ? instancedShader : shader;
+        drawShader.Bind();
+        drawShader.Set("projection", glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f));
+        drawShader.Set("view", glm::lookAt(glm::vec3(3.0f, 4.0f, 8.0f), glm::vec3(3.0f, 0.0f, 3.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+        drawShader.Set("model", glm::mat4(1.0f));
+
+        double cpuTime = 0.0;
+        uint32_t drawCalls = 0;
+        for(uint32_t frame = 0; frame < frames; frame++){
+            FrameRenderStats().Reset();
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            auto frameStart = std::chrono::steady_clock::now();
+            model.Draw(drawShader);
+            cpuTime += ElapsedMilliseconds(frameStart);
+            drawCalls = FrameRenderStats().drawCalls;
+            glfwSwapBuffers(window);
+            GlobalDeletionQueue().EndFrame();
+        }
+        glFinish();
+
+        printf("  %-18s: load %8.2f ms, %5zu meshes, %5u draw calls, %.3f ms CPU per frame\n",
+               merged ? (instanced ? "merged + instanced" : "merged") : "per node", loadTime, model.meshes.size(), drawCalls, cpuTime / frames);
+        if(!merged) return;
+
+        //! @note modelInstanced.vert multiplies by the instance transform, a mesh without one would collapse to a point
+        if(instanced){
+            size_t withoutTransforms = 0;
+            for(const Mesh& mesh : model.meshes){
+                withoutTransforms += mesh.InstanceCount() == 0;
+            }
+            PrintInstancingReport(model.instancingReport);
+            printf("  %zu of %zu meshes have no instance transform %s\n", withoutTransforms, model.meshes.size(), withoutTransforms ? "-- DRAWN AS A POINT" : "");
+        }
+
+        PrintMeshMergeReport(model.mergeReport);
+        size_t checked = 0, mismatches = 0;
+        for(const Mesh& mesh : model.meshes){
+            for(const MeshMergeSource& source : mesh.mergeSources){
+                if(source.indexCount == 0) continue;
+                uint32_t first = source.firstIndex / 3, last = (source.firstIndex + source.indexCount) / 3 - 1;
+                mismatches += FindMergeSource(mesh.mergeSources, first) != static_cast<int32_t>(source.sourceMesh);
+                mismatches += FindMergeSource(mesh.mergeSources, last) != static_cast<int32_t>(source.sourceMesh);
+                checked += 2;
+            }
+        }
+        printf("  picking : %zu merged triangles traced back, %zu mismatches\n", checked, mismatches);
+    };
+
+    measure(false, false);
+    measure(true, false);
+    measure(true, true);
+    GlobalDeletionQueue().Flush();
+
+    if(modelPath.empty()){
+        std::filesystem::remove(path);
+    }
+}
+
+/**
+ * @note CPU only (window is unused): a SceneHierarchy of nodeCount nodes (8 children per node) where changedFraction of the nodes get a new
+ * @note rotation every frame, updated incrementally vs rebuilding every local and world matrix the way a flat per-object loop would
+ * @note The world matrices of both are compared at the end
+*/
+void SceneHierarchyBenchmark(GLFWwindow* window, uint32_t nodeCount = 100000, float changedFraction = 0.01f, uint32_t frames = 200){
+    printf("Scene Hierarchy Benchmark -- %u nodes, %.2f%% changed per frame\n", nodeCount, changedFraction * 100.0f);
+
+    uint32_t seed = 12345u;
+    auto random = [&seed](){
+        seed = seed * 1664525u + 1013904223u;
+        return seed >> 8;
+    };
+    auto randomRotation = [&](){
+        float angle = float(random() % 6283) * 0.001f;
+        return glm::quat(std::cos(angle * 0.5f), 0.0f, std::sin(angle * 0.5f), 0.0f);
+    };
+
+    SceneHierarchy hierarchy;
+    hierarchy.Reserve(nodeCount);
+    for(uint32_t i = 0; i < nodeCount; i++){
+        int32_t parent = i == 0 ? SceneHierarchy::NO_PARENT : static_cast<int32_t>((i - 1) / 8);
+        glm::vec3 translation(float(random() % 100) * 0.01f, 0.5f, float(random() % 100) * 0.01f);
+        hierarchy.AddNode(parent, translation, randomRotation(), glm::vec3(0.99f));
+    }
+    hierarchy.Update();
+
+    //! @note The baseline keeps its own arrays and recomputes everything each frame, with glm's TRS helpers and multiply
+    std::vector<glm::mat4> baselineWorlds(nodeCount);
+    auto rebuildAll = [&](){
+        for(uint32_t i = 0; i < nodeCount; i++){
+            glm::mat4 local = glm::translate(glm::mat4(1.0f), hierarchy.Translation(i)) * glm::mat4_cast(hierarchy.Rotation(i)) *
+                              glm::scale(glm::mat4(1.0f), hierarchy.Scale(i));
+            int32_t parent = hierarchy.Parent(i);
+            baselineWorlds[i] = parent < 0 ? local : baselineWorlds[parent] * local;
+        }
+    };
+
+    uint32_t changedPerFrame = std::max(1u, static_cast<uint32_t>(nodeCount * changedFraction));
+    double incrementalTime = 0.0, fullTime = 0.0;
+    size_t worldsUpdated = 0;
+    for(uint32_t frame = 0; frame < frames; frame++){
+        for(uint32_t i = 0; i < changedPerFrame; i++){
+            hierarchy.SetRotation(random() % nodeCount, randomRotation());
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        SceneUpdateStats stats = hierarchy.Update();
+        incrementalTime += ElapsedMilliseconds(start);
+        worldsUpdated += stats.worldsUpdated;
+
+        start = std::chrono::steady_clock::now();
+        rebuildAll();
+        fullTime += ElapsedMilliseconds(start);
+    }
+
+    float maxError = 0.0f;
+    for(uint32_t i = 0; i < nodeCount; i++){
+        for(int column = 0; column < 4; column++){
+            for(int row = 0; row < 4; row++){
+                maxError = std::max(maxError, std::abs(hierarchy.World(i)[column][row] - baselineWorlds[i][column][row]));
+            }
+        }
+    }
+
+    printf("  full rebuild : %8.3f ms per frame, %u world matrices\n", fullTime / frames, nodeCount);
+    printf("  incremental  : %8.3f ms per frame, %.0f world matrices on average (%.2fx faster)\n", incrementalTime / frames,
+           double(worldsUpdated) / frames, fullTime / std::max(incrementalTime, 1e-9));
+    printf("  max difference between the two: %g\n", maxError);
+}
+
+/**
+ * @note Bakes sourceRoot into outputRoot twice (the second run has nothing left to do, which is what an incremental no-op costs),
+ * @note then loads modelPath from its sources and from the baked tree and compares the load times. Both loads use BakedModelOptions,
+ * @note without the mesh cache and with textures uploaded synchronously, so the difference is the import, processing and image decoding skipped.
+*/
+void AssetBakeBenchmark(GLFWwindow* window, const std::string& modelPath = "basics/models/backpack.obj", const std::string& sourceRoot = "basics",
+                        const std::string& outputRoot = "baked"){
+    printf("Asset Bake Benchmark -- %s -> %s\n", sourceRoot.c_str(), outputRoot.c_str());
+
+    AssetBakeSettings settings;
+    settings.sourceRoot = sourceRoot;
+    settings.outputRoot = outputRoot;
+    settings.verbose = false;
+
+    AssetBakeReport first = BakeAssets(settings);
+    printf("  first run  : ");
+    PrintAssetBakeReport(first);
+    AssetBakeReport second = BakeAssets(settings);
+    printf("  second run : ");
+    PrintAssetBakeReport(second);
+
+    auto measure = [&](bool baked){
+        BakedAssets().SetRoots(sourceRoot, baked ? outputRoot : "");
+        ModelLoadOptions options = BakedModelOptions();
+        options.useMeshCache = false;
+        options.extractionPool = &SharedThreadPool();
+
+        auto start = std::chrono::steady_clock::now();
+        double loadTime = 0.0;
+        size_t meshCount = 0;
+        {
+            Model model(modelPath, options);
+            glFinish();
+            loadTime = ElapsedMilliseconds(start);
+            meshCount = model.meshes.size();
+        }
+        GlobalDeletionQueue().Flush();
+
+        const BakedAssetStats& stats = BakedAssets().GetStats();
+        printf("  %-7s: %8.2f ms for %zu meshes and their textures (%u baked files used, %u sources read instead)\n", baked ? "baked" : "source",
+               loadTime, meshCount, stats.found, stats.fallbacks);
+        return loadTime;
+    };
+
+    double sourceTime = measure(false);
+    double bakedTime = measure(true);
+    printf("  baked load saves %.2f ms (%.1fx faster)\n", sourceTime - bakedTime, sourceTime / std::max(bakedTime, 1e-9));
+    BakedAssets().SetRoots(sourceRoot, "");
+}
+
+//! @note read()-family syscalls issued by the process so far (syscr in /proc/self/io), 0 where that is not available
+static uint64_t ReadSyscallCount(){
+#if defined(__linux__)
+    std::ifstream io("/proc/self/io");
+    std::string key;
+    uint64_t value = 0;
+    while(io >> key >> value){
+        if(key == "syscr:") return value;
+    }
+#endif
+    return 0;
+}
+
+//! @note Asks the OS to drop path's cached pages, so the next read really goes to the disk (a no-op where posix_fadvise is not available)
+static void EvictFromPageCache(const std::filesystem::path& path){
+#if defined(__linux__)
+    int fd = open(path.c_str(), O_RDONLY);
+    if(fd >= 0){
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+#else
+    (void)path;
+#endif
+}
+
+/**
+ * @note Cold start of ModelLoadingExample's assets (its two shader programs, the six skybox faces, the model with its textures), once from
+ * @note loose files and once from a pack of sourceRoot, with the page cache dropped before every run
+ * @note Opens are counted by Assets() (one per loose file, none per pack entry), read syscalls come from /proc/self/io on Linux
+*/
+void AssetPackBenchmark(GLFWwindow* window, const std::string& modelPath = "basics/models/backpack.obj", const std::string& sourceRoot = "basics",
+                        uint32_t runs = 5){
+    printf("Asset Pack Benchmark -- %s\n", sourceRoot.c_str());
+
+    std::string packPath = sourceRoot + "-benchmark" + ASSET_PACK_EXTENSION;
+    AssetPackReport packReport;
+    std::string extension = BAKED_MESH_EXTENSION;
+    if(!WriteAssetPack(sourceRoot, packPath, &packReport, [&extension](const std::string& path){
+        return path.size() < extension.size() || path.compare(path.size() - extension.size(), extension.size(), extension) != 0;
+    })){
+        printf("  could not write %s\n", packPath.c_str());
+        return;
+    }
+    printf("  ");
+    PrintAssetPackReport(packPath, packReport);
+
+    std::vector<std::filesystem::path> files = {packPath};
+    std::error_code error;
+    for(auto it = std::filesystem::recursive_directory_iterator(sourceRoot, error); !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error)){
+        if(it->is_regular_file()) files.push_back(it->path());
+    }
+
+    std::string skyboxDirectory = sourceRoot + "/figures/skybox-daylight/";
+    const char* faces[] = {"right.bmp", "left.bmp", "top.bmp", "bottom.bmp", "front.bmp", "back.bmp"};
+    BakedAssets().SetRoots(sourceRoot, "");
+
+    struct RunResult{
+        double milliseconds = 0.0;
+        AssetFileStats files;
+        uint64_t readCalls = 0;
+    };
+
+    auto measure = [&](bool packed){
+        Assets().UnmountAll();
+        if(packed) Assets().Mount(packPath, sourceRoot);
+        for(const std::filesystem::path& file : files){
+            EvictFromPageCache(file);
+        }
+        Assets().ResetStats();
+
+        ModelLoadOptions options = BakedModelOptions();
+        options.useMeshCache = false;
+        options.extractionPool = &SharedThreadPool();
+
+        RunResult result;
+        uint64_t readCalls = ReadSyscallCount();
+        auto start = std::chrono::steady_clock::now();
+        {
+            Shader skyboxShader(sourceRoot + "/shaders/skybox/skybox.vert", sourceRoot + "/shaders/skybox/skybox.frag");
+            Shader modelShader(sourceRoot + "/shaders/modelLoading-01/model.vert", sourceRoot + "/shaders/modelLoading-01/model.frag");
+            for(const char* face : faces){
+                AssetFile file(skyboxDirectory + face);
+                int w, h, channels;
+                unsigned char* pixels = file.IsOpen() ? stbi_load_from_memory(file.data, static_cast<int>(file.size), &w, &h, &channels, 0) : nullptr;
+                stbi_image_free(pixels);
+            }
+            Model model(modelPath, options);
+            glFinish();
+            result.milliseconds = ElapsedMilliseconds(start);
+        }
+        result.readCalls = ReadSyscallCount() - readCalls;
+        result.files = Assets().GetStats();
+        GlobalDeletionQueue().Flush();
+        return result;
+    };
+
+    RunResult loose, packed;
+    for(uint32_t run = 0; run < runs; run++){
+        RunResult a = measure(false);
+        RunResult b = measure(true);
+        loose.milliseconds += a.milliseconds / runs;
+        packed.milliseconds += b.milliseconds / runs;
+        loose.files = a.files;
+        packed.files = b.files;
+        loose.readCalls = a.readCalls;
+        packed.readCalls = b.readCalls;
+    }
+    Assets().UnmountAll();
+
+    auto print = [](const char* name, const RunResult& result, uint64_t opens){
+        printf("  %-6s: %8.2f ms cold start, %llu file opens (%llu from the pack), %llu read syscalls\n", name, result.milliseconds,
+               static_cast<unsigned long long>(opens), static_cast<unsigned long long>(result.files.packHits),
+               static_cast<unsigned long long>(result.readCalls));
+    };
+    print("loose", loose, loose.files.looseOpens);
+    print("packed", packed, packed.files.looseOpens + 1); // the pack itself
+    printf("  pack saves %.2f ms (%.1fx faster), %lld opens and %lld read syscalls\n", loose.milliseconds - packed.milliseconds,
+           loose.milliseconds / std::max(packed.milliseconds, 1e-9),
+           static_cast<long long>(loose.files.looseOpens) - static_cast<long long>(packed.files.looseOpens + 1),
+           static_cast<long long>(loose.readCalls) - static_cast<long long>(packed.readCalls));
+    std::filesystem::remove(packPath, error);
+}
+
+/**
+ * @note Every image under textureDirectory compressed like the asset baker does, then loaded both ways runs times over:
+ * @note raw = decode + glTexImage2D + glGenerateMipmap (LoadTexture's path), compressed = the .dds levels through glCompressedTexImage2D
+ * @note VRAM is the full mip chain either way, PSNR is the full resolution level against the decoded source
+*/
+void TextureCompressionBenchmark(GLFWwindow* window, const std::string& textureDirectory = "basics/textures", uint32_t runs = 5){
+    printf("Texture Compression Benchmark -- %s\n", textureDirectory.c_str());
+
+    std::error_code error;
+    std::filesystem::path outputDirectory = std::filesystem::temp_directory_path(error) / "texture-compression-benchmark";
+    std::filesystem::create_directories(outputDirectory, error);
+
+    struct Entry{
+        std::string source;
+        std::string compressed;
+        TextureCompressionReport report;
+    };
+    std::vector<Entry> entries;
+    for(auto it = std::filesystem::recursive_directory_iterator(textureDirectory, error); !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error)){
+        if(!it->is_regular_file() || ClassifyBakeAsset(it->path()) != BakeAssetKind::Texture) continue;
+        Entry entry;
+        entry.source = it->path().generic_string();
+        entry.compressed = (outputDirectory / (it->path().filename().string() + COMPRESSED_TEXTURE_EXTENSION)).string();
+
+        int w, h, channels;
+        unsigned char* pixels = stbi_load(entry.source.c_str(), &w, &h, &channels, 0);
+        if(!pixels) continue;
+        auto start = std::chrono::steady_clock::now();
+        bool written = WriteCompressedTexture(entry.compressed, pixels, static_cast<uint32_t>(w), static_cast<uint32_t>(h), static_cast<uint32_t>(channels),
+                                              &entry.report, &SharedThreadPool());
+        double compressTime = ElapsedMilliseconds(start);
+        stbi_image_free(pixels);
+        if(!written) continue;
+
+        printf("  %8.2f ms  ", compressTime);
+        PrintTextureCompressionReport(entry.source, entry.report);
+        entries.push_back(entry);
+    }
+    if(entries.empty()){
+        printf("  no textures found\n");
+        return;
+    }
+
+    auto loadRaw = [](const Entry& entry){
+        AssetFile file(entry.source);
+        int w, h, channels;
+        unsigned char* pixels = file.IsOpen() ? stbi_load_from_memory(file.data, static_cast<int>(file.size), &w, &h, &channels, 0) : nullptr;
+        if(!pixels) return;
+        static const GLenum formats[] = {GL_RED, GL_RG, GL_RGB, GL_RGBA};
+        GLTexture texture = GLTexture::Create();
+        glBindTexture(GL_TEXTURE_2D, texture.Get());
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, formats[channels - 1], w, h, 0, formats[channels - 1], GL_UNSIGNED_BYTE, pixels);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        stbi_image_free(pixels);
+    };
+    auto loadCompressed = [](const Entry& entry){
+        CompressedTextureFile compressed;
+        if(!compressed.Open(entry.compressed)) return false;
+        GLTexture texture = GLTexture::Create();
+        glBindTexture(GL_TEXTURE_2D, texture.Get());
+        return UploadCompressedTexture(GL_TEXTURE_2D, compressed, false) != 0;
+    };
+
+    double rawTime = 0.0, compressedTime = 0.0;
+    bool supported = true;
+    for(uint32_t run = 0; run < runs; run++){
+        auto start = std::chrono::steady_clock::now();
+        for(const Entry& entry : entries) loadRaw(entry);
+        glFinish();
+        rawTime += ElapsedMilliseconds(start) / runs;
+        GlobalDeletionQueue().Flush();
+
+        start = std::chrono::steady_clock::now();
+        for(const Entry& entry : entries) supported = loadCompressed(entry) && supported;
+        glFinish();
+        compressedTime += ElapsedMilliseconds(start) / runs;
+        GlobalDeletionQueue().Flush();
+    }
+
+    size_t rawBytes = 0, compressedBytes = 0;
+    double psnrSum = 0.0, lowestPsnr = 99.0;
+    for(const Entry& entry : entries){
+        rawBytes += entry.report.rawBytes;
+        compressedBytes += entry.report.compressedBytes;
+        psnrSum += entry.report.psnr;
+        lowestPsnr = std::min(lowestPsnr, entry.report.psnr);
+    }
+    printf("  raw       : %8.2f ms to load %zu textures, %8.2f MB of VRAM\n", rawTime, entries.size(), rawBytes / (1024.0 * 1024.0));
+    if(supported){
+        printf("  compressed: %8.2f ms to load %zu textures, %8.2f MB of VRAM\n", compressedTime, entries.size(), compressedBytes / (1024.0 * 1024.0));
+        printf("  %.1fx faster, %.1fx less VRAM, PSNR %.2f dB average (%.2f dB lowest)\n", rawTime / std::max(compressedTime, 1e-9),
+               double(rawBytes) / std::max<double>(double(compressedBytes), 1.0), psnrSum / entries.size(), lowestPsnr);
+    }
+    else{
+        printf("  compressed: the driver lacks S3TC, the raw textures are used instead\n");
+    }
+    std::filesystem::remove_all(outputDirectory, error);
+}
+
+/**
+ * @note Skybox setup three ways, runs times each, from glGenTextures until glFinish returns:
+ * @note serial   = the faces decoded one after another with stbi_load, one glTexImage2D each, no mipmaps (the setup before CubemapLoader.h)
+ * @note parallel = LoadCubemap: faces decoded on the pool, one staging buffer, storage allocated once, glGenerateMipmap
+ * @note baked    = LoadCubemap's baked path on a container written here like the asset baker does, prefiltered mips included
+*/
+void CubemapLoadBenchmark(GLFWwindow* window, const std::string& directory = "basics/figures/skybox-daylight", const std::string& extension = ".bmp",
+                          uint32_t runs = 5){
+    printf("Cubemap Load Benchmark -- %s\n", directory.c_str());
+    std::array<std::string, 6> faces = CubemapFacePaths(directory, extension);
+
+    auto loadSerial = [&faces](){
+        uint32_t textureID;
+        glGenTextures(1, &textureID);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+        for(uint32_t i = 0; i < 6; i++){
+            int w, h, channels;
+            unsigned char* data = stbi_load(faces[i].c_str(), &w, &h, &channels, 0);
+            if(data){
+                glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, w, h, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
+                stbi_image_free(data);
+            }
+        }
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        return GLTexture(textureID);
+    };
+
+    //! @note The container the baker would write for this directory, into a temporary file
+    std::error_code error;
+    std::filesystem::path containerPath = std::filesystem::temp_directory_path(error) / "cubemap-load-benchmark.cubemap.dds";
+    unsigned char* pixels[6] = {};
+    int w = 0, h = 0, channels = 0;
+    bool decoded = true;
+    for(uint32_t i = 0; i < 6; i++){
+        pixels[i] = stbi_load(faces[i].c_str(), &w, &h, &channels, 0);
+        decoded = decoded && pixels[i];
+    }
+    TextureCompressionReport report;
+    auto start = std::chrono::steady_clock::now();
+    bool baked = decoded && WriteCompressedImages(containerPath.string(), pixels, 6, static_cast<uint32_t>(w), static_cast<uint32_t>(h),
+                                                  static_cast<uint32_t>(channels), &report, &SharedThreadPool());
+    double bakeTime = ElapsedMilliseconds(start);
+    for(unsigned char* face : pixels) stbi_image_free(face);
+    if(!decoded){
+        printf("  could not decode the faces\n");
+        return;
+    }
+    if(baked){
+        printf("  baked the container in %.2f ms: ", bakeTime);
+        PrintTextureCompressionReport(containerPath.filename().string(), report);
+    }
+
+    double serialTime = 0.0, parallelTime = 0.0, bakedTime = 0.0;
+    CubemapLoadStats parallelStats, bakedStats;
+    bool bakedSupported = baked;
+    for(uint32_t run = 0; run < runs; run++){
+        start = std::chrono::steady_clock::now();
+        {
+            GLTexture texture = loadSerial();
+            glFinish();
+        }
+        serialTime += ElapsedMilliseconds(start) / runs;
+        GlobalDeletionQueue().Flush();
+
+        start = std::chrono::steady_clock::now();
+        {
+            CubemapLoadOptions options;
+            options.useBaked = false;
+            GLTexture texture = LoadCubemap(faces, options, &parallelStats);
+            glFinish();
+        }
+        parallelTime += ElapsedMilliseconds(start) / runs;
+        GlobalDeletionQueue().Flush();
+
+        if(!bakedSupported) continue;
+        start = std::chrono::steady_clock::now();
+        {
+            GLTexture texture = LoadBakedCubemap(containerPath.string(), CubemapLoadOptions(), bakedStats);
+            bakedSupported = static_cast<bool>(texture);
+            glFinish();
+        }
+        bakedTime += ElapsedMilliseconds(start) / runs;
+        GlobalDeletionQueue().Flush();
+    }
+
+    size_t faceBytes = size_t(w) * h * channels;
+    printf("  serial  : %8.2f ms, 1 level,   %8.2f MB of VRAM\n", serialTime, faceBytes * 6 / (1024.0 * 1024.0));
+    printf("  parallel: %8.2f ms, %u levels, %8.2f MB of VRAM (%.2f ms decoding, %.2f ms uploading), %.1fx faster\n", parallelTime, parallelStats.levels,
+           faceBytes * 6 * 4.0 / 3.0 / (1024.0 * 1024.0), parallelStats.decodeMilliseconds, parallelStats.uploadMilliseconds,
+           serialTime / std::max(parallelTime, 1e-9));
+    if(bakedSupported){
+        printf("  baked   : %8.2f ms, %u levels, %8.2f MB of VRAM, %.1fx faster\n", bakedTime, bakedStats.levels, bakedStats.bytes / (1024.0 * 1024.0),
+               serialTime / std::max(bakedTime, 1e-9));
+    }
+    else{
+        printf("  baked   : the driver lacks the container's format, LoadCubemap decodes the faces instead\n");
+    }
+    std::filesystem::remove(containerPath, error);
+}
+
+/**
+ * @note Loads a model with and without ModelLoadOptions::textureArrays and compares texture binds and CPU time per frame
+ * @note Then packs count generated textures of mixed small sizes into atlases and reads every one back out of its layer and UV rectangle,
+ * @note checking the atlas holds exactly the source pixels
+*/
+void TextureArrayBenchmark(GLFWwindow* window, const std::string& modelPath = "basics/models/backpack.obj", uint32_t frames = 200, uint32_t count = 64){
+    printf("Texture Array Benchmark -- %s\n", modelPath.c_str());
+
+    Shader shader("basics/shaders/modelLoading-01/model.vert", "basics/shaders/modelLoading-01/model.frag");
+    Shader arrayShader("basics/shaders/modelLoading-01/model.vert", "basics/shaders/modelLoading-01/modelArray.frag");
+
+    auto measure = [&](bool arrays){
+        ModelLoadOptions options;
+        options.textureArrays = arrays;
+
+        auto start = std::chrono::steady_clock::now();
+        Model model(modelPath, options);
+        double loadTime = ElapsedMilliseconds(start);
+
+        Shader& drawShader = arrays ? arrayShader : shader;
+        drawShader.Bind();
+        drawShader.Set("projection", glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f));
+        drawShader.Set("view", glm::lookAt(glm::vec3(0.0f, 0.0f, 5.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+        drawShader.Set("model", glm::mat4(1.0f));
+
+        double cpuTime = 0.0;
+        uint32_t textureBinds = 0, drawCalls = 0;
+        for(uint32_t frame = 0; frame < frames; frame++){
+            FrameRenderStats().Reset();
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            auto frameStart = std::chrono::steady_clock::now();
+            model.Draw(drawShader);
+            cpuTime += ElapsedMilliseconds(frameStart);
+            textureBinds = FrameRenderStats().textureBinds;
+            drawCalls = FrameRenderStats().drawCalls;
+            glfwSwapBuffers(window);
+            GlobalDeletionQueue().EndFrame();
+        }
+        glFinish();
+
+        printf("  %-14s: load %8.2f ms, %5u draw calls, %5u texture binds per frame, %.3f ms CPU per frame\n", arrays ? "texture arrays" : "2D textures",
+               loadTime, drawCalls, textureBinds, cpuTime / frames);
+        if(arrays){
+            printf("  ");
+            PrintTextureArrayReport(model.textureArrayReport);
+        }
+    };
+    measure(false);
+    measure(true);
+    GlobalDeletionQueue().Flush();
+
+    //! @note Generated textures, each pixel encodes its texture and position so a misplaced or bleeding copy shows up
+    static const uint32_t sizes[] = {16, 32, 48, 64, 100, 128, 200, 256};
+    std::vector<GLTexture> sources;
+    std::vector<std::vector<uint8_t>> pixels;
+    std::vector<std::pair<uint32_t, uint32_t>> dimensions;
+    std::vector<TextureArrayInput> inputs;
+    for(uint32_t i = 0; i < count; i++){
+        uint32_t width = sizes[i % 8], height = sizes[(i * 3 + 1) % 8];
+        std::vector<uint8_t> image(size_t(width) * height * 4);
+        for(uint32_t y = 0; y < height; y++){
+            for(uint32_t x = 0; x < width; x++){
+                uint8_t* pixel = &image[(size_t(y) * width + x) * 4];
+                pixel[0] = static_cast<uint8_t>(i * 37);
+                pixel[1] = static_cast<uint8_t>(x);
+                pixel[2] = static_cast<uint8_t>(y);
+                pixel[3] = 255;
+            }
+        }
+        sources.push_back(GLTexture::Create());
+        glBindTexture(GL_TEXTURE_2D, sources.back().Get());
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.data());
+        pixels.push_back(std::move(image));
+        dimensions.push_back({width, height});
+        inputs.push_back({sources.back().Get(), false, true});
+    }
+
+    TextureArraySet set;
+    std::vector<TextureArraySlot> slots;
+    TextureArrayReport report = set.Build(inputs, TextureArraySettings(), slots);
+    printf("  atlas check: ");
+    PrintTextureArrayReport(report);
+
+    uint32_t mismatches = 0;
+    std::map<uint32_t, std::vector<uint8_t>> readBack; // array -> every layer of level 0
+    for(uint32_t i = 0; i < count; i++){
+        const TextureArraySlot& slot = slots[i];
+        GLint size = 0, layers = 0;
+        glBindTexture(GL_TEXTURE_2D_ARRAY, slot.array);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D_ARRAY, 0, GL_TEXTURE_WIDTH, &size);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D_ARRAY, 0, GL_TEXTURE_DEPTH, &layers);
+        std::vector<uint8_t>& layerPixels = readBack[slot.array];
+        if(layerPixels.empty()){
+            layerPixels.resize(size_t(size) * size * layers * 4);
+            glGetTexImage(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA, GL_UNSIGNED_BYTE, layerPixels.data());
+        }
+        uint32_t originX = static_cast<uint32_t>(std::lround(slot.uvRect.x * size)), originY = static_cast<uint32_t>(std::lround(slot.uvRect.y * size));
+        const uint8_t* layer = layerPixels.data() + size_t(slot.layer) * size * size * 4;
+        for(uint32_t y = 0; y < dimensions[i].second; y++){
+            if(std::memcmp(layer + (size_t(originY + y) * size + originX) * 4, &pixels[i][size_t(y) * dimensions[i].first * 4], size_t(dimensions[i].first) * 4) != 0){
+                mismatches++;
+                break;
+            }
+        }
+    }
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    printf("  %u of %u textures read back from their atlas rectangle %s\n", count - mismatches, count, mismatches ? "-- MISMATCH" : "exactly");
+    sources.clear();
+    set.Clear();
+    GlobalDeletionQueue().Flush();
+}
+
+/**
+ * @note Streams texturePath as a virtual texture onto a large ground plane while the camera flies low over it, with a cache of cachePages x cachePages tiles
+ * @note Uses the baked .vtex when there is one, otherwise tiles the texture once into <texturePath>.vtex next to it
+ * @note Reports how many of the tiles the feedback asked for were missing, the streaming and feedback costs and the VRAM against the full texture,
+ * @note then checks the cache and page table against the file (VirtualTexture::Verify)
+*/
+void VirtualTextureBenchmark(GLFWwindow* window, const std::string& texturePath = "basics/figures/skybox/earthIllumination.jpg", uint32_t frames = 300,
+                             uint32_t cachePages = 8){
+    printf("Virtual Texture Benchmark -- %s\n", texturePath.c_str());
+
+    std::string path = BakedAssets().Find(texturePath, VIRTUAL_TEXTURE_EXTENSION);
+    if(path.empty()){
+        path = texturePath + VIRTUAL_TEXTURE_EXTENSION;
+        std::error_code error;
+        if(!std::filesystem::is_regular_file(path, error)){
+            auto start = std::chrono::steady_clock::now();
+            std::string buildError;
+            if(!BuildVirtualTexture(texturePath, path, buildError)){
+                printf("  could not tile %s: %s\n", texturePath.c_str(), buildError.c_str());
+                return;
+            }
+            printf("  tiled into %s in %.2f ms\n", path.c_str(), ElapsedMilliseconds(start));
+        }
+    }
+
+    VirtualTextureSettings settings;
+    settings.cachePages = cachePages;
+    VirtualTexture texture;
+    if(!texture.Open(path, settings)){
+        return;
+    }
+    const VirtualTextureHeader& header = texture.Header();
+    printf("  %u x %u, %u levels of %u texel tiles, %u x %u page cache\n", header.width, header.height, header.levelCount, header.tileSize,
+           texture.CachePages(), texture.CachePages());
+
+    //! @note Ground plane with the texture's aspect ratio, positions then normal then uv like the model vertices (model.vert)
+    float halfWidth = 50.0f * float(header.width) / float(header.height), halfDepth = 50.0f;
+    float vertices[] = {
+        -halfWidth, 0.0f, -halfDepth,  0.0f, 1.0f, 0.0f,  0.0f, 0.0f,
+         halfWidth, 0.0f, -halfDepth,  0.0f, 1.0f, 0.0f,  1.0f, 0.0f,
+         halfWidth, 0.0f,  halfDepth,  0.0f, 1.0f, 0.0f,  1.0f, 1.0f,
+        -halfWidth, 0.0f, -halfDepth,  0.0f, 1.0f, 0.0f,  0.0f, 0.0f,
+         halfWidth, 0.0f,  halfDepth,  0.0f, 1.0f, 0.0f,  1.0f, 1.0f,
+        -halfWidth, 0.0f,  halfDepth,  0.0f, 1.0f, 0.0f,  0.0f, 1.0f,
+    };
+    GLVertexArray vertexArray = GLVertexArray::Create();
+    GLBuffer vertexBuffer = GLBuffer::Create();
+    glBindVertexArray(vertexArray.Get());
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer.Get());
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+    glBindVertexArray(0);
+
+    Shader shader("basics/shaders/modelLoading-01/model.vert", "basics/shaders/modelLoading-01/virtualTexture.frag");
+    Shader feedbackShader("basics/shaders/modelLoading-01/model.vert", "basics/shaders/modelLoading-01/virtualTextureFeedback.frag");
+    VirtualTextureFeedback feedback;
+    VirtualTexture* textures[] = {&texture};
+
+    int width = 0, height = 0;
+    glfwGetFramebufferSize(window, &width, &height);
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), float(width) / float(std::max(height, 1)), 0.1f, 200.0f);
+    glEnable(GL_DEPTH_TEST);
+
+    uint64_t requested = 0, missing = 0;
+    double updateTime = 0.0, resolveTime = 0.0, frameTime = 0.0;
+    for(uint32_t frame = 0; frame < frames; frame++){
+        auto frameStart = std::chrono::steady_clock::now();
+        //! @note Diagonal pass across the plane, two units up and looking ahead and down
+        float t = float(frame) / float(std::max(frames - 1, 1u));
+        glm::vec3 eye(glm::mix(-0.8f * halfWidth, 0.8f * halfWidth, t), 2.0f, glm::mix(0.6f * halfDepth, -0.6f * halfDepth, t));
+        glm::mat4 view = glm::lookAt(eye, eye + glm::vec3(0.8f, -0.25f, -0.6f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+        feedback.Begin(static_cast<uint32_t>(width), static_cast<uint32_t>(height));
+        feedbackShader.Bind();
+        feedbackShader.Set("projection", projection);
+        feedbackShader.Set("view", view);
+        feedbackShader.Set("model", glm::mat4(1.0f));
+        feedbackShader.Set("virtualTextureID", 1);
+        feedbackShader.Set("virtualLodBias", feedback.LodBias());
+        texture.Bind(feedbackShader.program.Get());
+        glBindVertexArray(vertexArray.Get());
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+        feedback.End();
+
+        feedback.Resolve(textures, 1);
+
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        shader.Bind();
+        shader.Set("projection", projection);
+        shader.Set("view", view);
+        shader.Set("model", glm::mat4(1.0f));
+        texture.Bind(shader.program.Get());
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+        glBindVertexArray(0);
+        frameTime += ElapsedMilliseconds(frameStart);
+
+        glfwSwapBuffers(window);
+        GlobalDeletionQueue().EndFrame();
+
+        const VirtualTextureStats& stats = texture.GetStats();
+        requested += stats.requested;
+        missing += stats.missing;
+        updateTime += stats.updateMilliseconds;
+        resolveTime += feedback.GetStats().resolveMilliseconds;
+        if(frame % 60 == 0){
+            printf("  frame %3u: ", frame);
+            PrintVirtualTextureStats(texture, feedback.GetStats());
+        }
+    }
+    glFinish();
+
+    const VirtualTextureStats& stats = texture.GetStats();
+    printf("  %.1f%% of requested tiles missing on average, %llu uploads (%.2f MB), %llu evictions\n", requested ? 100.0 * missing / requested : 0.0,
+           static_cast<unsigned long long>(stats.totalUploads), stats.uploadedBytes / (1024.0 * 1024.0), static_cast<unsigned long long>(stats.totalEvictions));
+    printf("  per frame: %.3f ms update, %.3f ms feedback resolve, %.3f ms CPU total\n", updateTime / frames, resolveTime / frames, frameTime / frames);
+    printf("  VRAM: %.2f MB cache and page table vs %.2f MB for the whole texture with mips\n", texture.ResidentBytes() / (1024.0 * 1024.0),
+           texture.FullTextureBytes() / (1024.0 * 1024.0));
+    uint32_t mismatches = texture.Verify();
+    printf("  cache and page table %s (%u mismatches)\n", mismatches ? "DO NOT match the file" : "match the file", mismatches);
+    GlobalDeletionQueue().Flush();
+}
+
+/**
+ * @note Draws modelPath under a budgetMegabytes texture budget (GlobalTextureResidency()) while it moves from far away to right in front of the
+ * @note camera and back, printing resident bytes, pending loads and evictions as the levels stream in and out
+ * @note Then lets streaming settle up close and checks the GL levels against the manager's bookkeeping (TextureResidency::Verify)
+*/
+void TextureResidencyBenchmark(GLFWwindow* window, const std::string& modelPath = "basics/models/backpack.obj", uint32_t budgetMegabytes = 64,
+                               uint32_t frames = 360){
+    printf("Texture Residency Benchmark -- %s, %u MB budget\n", modelPath.c_str(), budgetMegabytes);
+
+    TextureResidencySettings settings;
+    settings.budgetBytes = size_t(budgetMegabytes) << 20;
+    GlobalTextureResidency().Enable(settings);
+
+    auto start = std::chrono::steady_clock::now();
+    Model model(modelPath);
+    printf("  load: %.2f ms, %.2f MB of textures resident after loading\n", ElapsedMilliseconds(start),
+           GlobalTextureCache().GetStats().residentBytes / (1024.0 * 1024.0));
+
+    Shader shader("basics/shaders/modelLoading-01/model.vert", "basics/shaders/modelLoading-01/model.frag");
+    shader.Bind();
+    int width = 0, height = 0;
+    glfwGetFramebufferSize(window, &width, &height);
+    shader.Set("projection", glm::perspective(glm::radians(45.0f), float(width) / float(std::max(height, 1)), 0.1f, 200.0f));
+    shader.Set("model", glm::mat4(1.0f));
+    LodView view;
+    view.projectionScale = LodProjectionScale(glm::radians(45.0f), float(std::max(height, 1)));
+
+    size_t peakResident = 0;
+    uint64_t uploads = 0, evictions = 0, loadsStarted = 0;
+    double managerTime = 0.0;
+    auto drawFrame = [&](float distance){
+        view.cameraPosition = glm::vec3(0.0f, 0.0f, distance);
+        shader.Bind();
+        shader.Set("view", glm::lookAt(view.cameraPosition, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        model.Draw(shader, view);
+        glfwSwapBuffers(window);
+        GlobalDeletionQueue().EndFrame();
+        GlobalTextureResidency().EndFrame();
+
+        const TextureResidencyStats& stats = GlobalTextureResidency().GetFrameStats();
+        peakResident = std::max(peakResident, stats.residentBytes);
+        uploads += stats.uploads;
+        evictions += stats.evictions;
+        loadsStarted += stats.loadsStarted;
+        managerTime += stats.milliseconds;
+        return stats;
+    };
+
+    //! @note 60 units away, in to 1.5 and back out
+    for(uint32_t frame = 0; frame < frames; frame++){
+        float t = float(frame) / float(std::max(frames - 1, 1u));
+        float distance = glm::mix(1.5f, 60.0f, 0.5f + 0.5f * std::cos(t * glm::radians(360.0f)));
+        drawFrame(distance);
+        if(frame % 30 == 0){
+            printf("  frame %3u, distance %5.1f: ", frame, distance);
+            GlobalTextureResidency().PrintFrameStats();
+        }
+    }
+    printf("  %llu loads, %llu levels uploaded, %llu levels evicted, %.3f ms per frame in the manager\n", static_cast<unsigned long long>(loadsStarted),
+           static_cast<unsigned long long>(uploads), static_cast<unsigned long long>(evictions), managerTime / frames);
+    printf("  peak resident %.2f MB of %u MB budget %s, %.2f MB with every level\n", peakResident / (1024.0 * 1024.0), budgetMegabytes,
+           peakResident <= settings.budgetBytes ? "(within budget)" : "-- OVER BUDGET", GlobalTextureResidency().GetFrameStats().fullBytes / (1024.0 * 1024.0));
+
+    uint32_t settleFrames = 0;
+    for(; settleFrames < 600; settleFrames++){
+        const TextureResidencyStats& stats = drawFrame(1.5f);
+        if(stats.pending == 0 && stats.loadsStarted == 0 && stats.evictions == 0) break;
+    }
+    glFinish();
+    printf("  up close after %u more frames: ", settleFrames);
+    GlobalTextureResidency().PrintFrameStats();
+    uint32_t mismatches = GlobalTextureResidency().Verify();
+    printf("  GL levels %s the residency bookkeeping (%u mismatches)\n", mismatches ? "DO NOT match" : "match", mismatches);
+
+    GlobalTextureResidency().Disable();
+    GlobalDeletionQueue().Flush();
+}
@@ -1,6 +1,8 @@
 #pragma once
 #include <string>
 #include <cmath>
+#include <cfloat>
+#include <cstring>
 #include <fstream>
 #include <unordered_map>
 #include <sstream>
@@ -15,11 +17,37 @@
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
+#undef STB_IMAGE_IMPLEMENTATION // NEW ---- the headers below include stb_image.h again, for its declarations only
 
 #include <assimp/mesh.h>
 #include <assimp/scene.h>
 #include <assimp/Importer.hpp>
 #include <assimp/postprocess.h>
+#include <assimp/DefaultIOSystem.h>
+
+#include "MeshData.h"
+#include "MeshCache.h"
+#include "ThreadPool.h"
+#include "AsyncTextureLoader.h"
+#include "TextureCache.h"
+#include "CubemapLoader.h"
+#include "TextureArrays.h"
+#include "TextureResidency.h"
+#include "RenderStats.h"
+#include "GeometryArena.h"
+#include "GLResources.h"
+#include "PackedVertex.h"
+#include "MeshWelder.h"
+#include "MeshTangents.h"
+#include "GltfLoader.h"
+#include "ObjLoader.h"
+#include "MeshInstancing.h"
+#include "MeshMerging.h"
+#include "SceneHierarchy.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "Meshlets.h"
+#include "ModelStreaming.h"
 
 /**
  * @example Model Loading Tutorial #1 - Context for Loading Models (with OpenGL)
@@ -50,34 +78,26 @@ struct Shader{
         std::string vertexShaderCode;
         std::string fragmentShaderCode;
 
-        std::ifstream vertexIns(vertex, std::ios::binary | std::ios::app);
-        std::ifstream fragmentIns(fragment, std::ios::binary | std::ios::app);
+        //! @note NEW ---- the baked (comment stripped) sources when the asset baker's output is registered, see BakedAssets.h
+        //! @note NEW ---- read through Assets(), a span into a mounted asset pack or the loose file mapped (AssetPack.h), instead of two ifstreams
+        AssetFile vertexFile(BakedAssets().Resolve(vertex));
+        AssetFile fragmentFile(BakedAssets().Resolve(fragment));
 
-        if(!vertexIns){
+        if(!vertexFile.IsOpen()){
             printf("Could not load vertex shader source!\n");
             // assert(false);
         }
 
-        if(!fragmentIns){
+        if(!fragmentFile.IsOpen()){
             printf("Could not load fragment shader source!\n");
             // assert(false);
         }
 
-        // vertexIns.open(vertex);
-        // fragmentIns.open(fragment);
+        vertexShaderCode = std::string(vertexFile.Text());
+        fragmentShaderCode = std::string(fragmentFile.Text());
 
-        std::stringstream vertexSS, fragmentSS;
-        vertexSS << vertexIns.rdbuf();
-        fragmentSS << fragmentIns.rdbuf();
-
-        vertexIns.close();
-        fragmentIns.close();
-
-        vertexShaderCode = vertexSS.str();
-        fragmentShaderCode = fragmentSS.str();
-
-        sources[GL_VERTEX_SHADER] = vertexSS.str();
-        sources[GL_FRAGMENT_SHADER] = fragmentSS.str();
+        sources[GL_VERTEX_SHADER] = vertexShaderCode;
+        sources[GL_FRAGMENT_SHADER] = fragmentShaderCode;
         return sources;
     }
 
@@ -87,7 +107,7 @@ struct Shader{
         std::array<int, 2> shaderIDs;
 
         // uint32_t shaderID = 0;
-        programID = glCreateProgram();
+        program = GLProgram::Create();
         int success;
         char infoLog[512];
         uint32_t index = 0;
@@ -116,11 +136,11 @@ struct Shader{
         //! @note We then attach all of our ID's for the shader
         //! @note Instead of manually attaching both our fragment and vertex we store them in our array and then we attach them once they've compiled successfully
         for(auto id : shaderIDs){
-            glAttachShader(programID, id);
+            glAttachShader(program.Get(), id);
         }
 
         //! @note Then we link them to our program, and then we delete them
-        glLinkProgram(programID);
+        glLinkProgram(program.Get());
 
         for(auto id : shaderIDs){
             glDeleteShader(id);
@@ -128,7 +148,7 @@ struct Shader{
     }
 
     void Bind() const{
-        glUseProgram(programID);
+        glUseProgram(program.Get());
     }
 
     void Unbind(){
@@ -136,7 +156,7 @@ struct Shader{
     }
 
     const uint32_t Get(const std::string& name) const{
-        return glGetUniformLocation(programID, name.c_str());
+        return glGetUniformLocation(program.Get(), name.c_str());
     }
 
     void Set(const std::string& name, bool value) {
@@ -184,7 +204,7 @@ struct Shader{
         glUniformMatrix4fv(location, 1, GL_FALSE, &value[0][0]);
     }
 
-    uint32_t programID;
+    GLProgram program; // NEW ---- deleted through the deletion queue once the Shader goes away
 };
 
 struct Camera{
@@ -279,11 +299,23 @@ struct Camera{
 };
 
 static uint32_t LoadTexture(const std::string& filepath, GLenum TextureType){
+    //! @note NEW ---- 2D textures go through the global texture cache, so the same image is only ever uploaded once
+    //! @note The cache keeps them pinned since callers only get the raw id back
+    if(TextureType == GL_TEXTURE_2D){
+        uint32_t textureID = GlobalTextureCache().AcquirePinned(filepath);
+        if(!textureID){
+            printf("Unable to load textures ====> %s\n", filepath.c_str());
+            assert(false);
+        }
+        return textureID;
+    }
+
     uint32_t textureID;
     glGenTextures(1, &textureID);
 
     int w, h, channels;
-    unsigned char* data = stbi_load(filepath.c_str(), &w, &h, &channels, 0);
+    AssetFile file(filepath); // NEW ---- from a mounted asset pack when there is one (AssetPack.h)
+    unsigned char* data = file.IsOpen() ? stbi_load_from_memory(file.data, static_cast<int>(file.size), &w, &h, &channels, 0) : nullptr;
 
     if(!data){
         printf("Unable to load textures ====> %s\n", filepath.c_str());
@@ -319,171 +351,1646 @@ static uint32_t LoadTextureFromFileAsset(const char* file, const std::string& di
     std::string filename(file);
     filename = dir + "/" + filename;
 
-    uint32_t textureID;
-    glGenTextures(1, &textureID);
-    
-    int w, h, channels;
-    unsigned char* data = stbi_load(filename.c_str(), &w, &h, &channels, 0);
-    
-    if(!data){
-        printf("Could not load imaged texture ====> %s\n", filename.c_str());
+    //! @note NEW ---- Same as LoadTexture, shared through the global texture cache (see TextureCache.h for the decode + upload)
+    TextureLoadParams params;
+    params.gamma = isGammaEnabled;
+    uint32_t textureID = GlobalTextureCache().AcquirePinned(filename, params);
+
+    if(!textureID){
         assert(false);
         return 0;
     }
-    GLenum TextureType = GL_TEXTURE_2D;
-    GLenum format;
-    if(channels == 1){
-        format = GL_RED;
+
+    return textureID;
+}
+
+// NEW ---- How a Mesh lays its data out on the GPU
+struct MeshUploadOptions{
+    GeometryArena* arena = nullptr; // append to a shared arena instead of owning a VAO/VBO/IBO
+    bool packedVertices = false;    // upload 20 byte PackedVertex's (+ 16-bit indices when they fit), drawn with modelPacked.vert. Packed meshes always own their buffers.
+};
+
+// NEW ---- Where a Model is seen from, for picking levels of detail
+struct LodView{
+    glm::mat4 model = glm::mat4(1.0f);
+    glm::vec3 cameraPosition = glm::vec3(0.0f);
+    float projectionScale = 1.0f; // pixels per unit at distance 1, see LodProjectionScale()
+};
+
+// NEW ---- LOD selection thresholds, tuned against the per-level errors in Mesh::lods
+struct LodSettings{
+    float thresholdPixels = 1.0f;   // the coarsest level whose error projects to at most this many pixels is drawn
+    float hysteresis = 0.25f;       // going coarser needs the error below thresholdPixels * (1 - hysteresis), so meshes near a boundary do not flicker between levels
+};
+
+static float LodProjectionScale(float fovYRadians, float viewportHeight){
+    return viewportHeight / (2.0f * std::tan(fovYRadians * 0.5f));
+}
+
+// NEW ---- A vertex attribute that already sits in a GL buffer in its file format (ex. a glTF accessor), read in place by the buffer view Mesh constructor
+struct MeshAttributeView{
+    uint32_t location = 0;
+    int32_t components = 3;
+    GLenum type = GL_FLOAT;
+    bool normalized = false;
+    uint32_t stride = 0;
+    size_t offset = 0; // bytes into MeshBufferView::vertexBuffer
+};
+
+// NEW ---- Where a mesh's data lives inside buffers somebody else owns (Model::sharedBuffers), nothing is copied or converted
+struct MeshBufferView{
+    uint32_t vertexBuffer = 0;
+    uint32_t indexBuffer = 0;
+    std::vector<MeshAttributeView> attributes;
+    uint32_t vertexCount = 0;
+    size_t indexOffset = 0; // bytes into indexBuffer
+    uint32_t indexCount = 0;
+    GLenum indexType = GL_UNSIGNED_INT; // GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+    glm::vec3 boundsMin = glm::vec3(0.0f);
+    glm::vec3 boundsMax = glm::vec3(0.0f);
+};
+
+static size_t IndexTypeSize(GLenum indexType){
+    return indexType == GL_UNSIGNED_BYTE ? sizeof(uint8_t) : indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+}
+
+// NEW ---- Creating Mesh Class
+class Mesh{
+public:
+    Mesh(std::vector<Vertex> vertices, std::vector<uint32_t> indices, std::vector<Texture> textures, const MeshUploadOptions& upload = {}, std::vector<MeshLod> lods = {}){
+        this->vertices = std::move(vertices);
+        this->indices = std::move(indices);
+        this->textures = std::move(textures);
+        this->lods = std::move(lods);
+
+        SetupMesh(this->vertices.data(), this->vertices.size(), this->indices.data(), this->indices.size(), upload);
     }
-    else if(channels == 4){
-        format = GL_RGBA;
+
+    //! @note NEW ---- Uploads vertex/index data owned by someone else (ex. a memory mapped mesh cache) without keeping a CPU-side copy
+    Mesh(const Vertex* vertexData, uint32_t vertexCount, const uint32_t* indexData, uint32_t indexCount, std::vector<Texture> textures, const MeshUploadOptions& upload = {}, std::vector<MeshLod> lods = {}){
+        this->textures = std::move(textures);
+        this->lods = std::move(lods);
+
+        SetupMesh(vertexData, vertexCount, indexData, indexCount, upload);
     }
-    else if(channels == 3){
-        format = GL_RGB;
+
+    //! @note NEW ---- Draws attributes/indices straight out of shared buffers (ex. a glTF file's buffer views), only the VAO belongs to this mesh
+    Mesh(const MeshBufferView& view, std::vector<Texture> textures){
+        this->textures = std::move(textures);
+        vertexCount = view.vertexCount;
+        indexCount = view.indexCount;
+        indexType = view.indexType;
+        indexByteOffset = view.indexOffset;
+        lods.push_back({0, indexCount, 0.0f});
+
+        boundsCenter = (view.boundsMin + view.boundsMax) * 0.5f;
+        boundsRadius = glm::length(view.boundsMax - view.boundsMin) * 0.5f;
+
+        vao = GLVertexArray::Create();
+        glBindVertexArray(vao.Get());
+        glBindBuffer(GL_ARRAY_BUFFER, view.vertexBuffer);
+        for(const MeshAttributeView& attribute : view.attributes){
+            glEnableVertexAttribArray(attribute.location);
+            glVertexAttribPointer(attribute.location, attribute.components, attribute.type, attribute.normalized ? GL_TRUE : GL_FALSE, attribute.stride, (void*)attribute.offset);
+        }
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, view.indexBuffer);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    //! @note NEW ---- A Mesh owns its GL objects (GLResources.h), so it can be moved into Model::meshes but never copied
+    Mesh(Mesh&&) noexcept = default;
+    Mesh& operator=(Mesh&&) noexcept = default;
+    Mesh(const Mesh&) = delete;
+    Mesh& operator=(const Mesh&) = delete;
+
+    /**
+     * @note NEW ---- Picks currentLod from how large each level's error would appear on screen
+     * @note The error is projected at the nearest point of the mesh's bounding sphere, so a mesh the camera is inside always gets level 0
+    */
+    uint32_t SelectLod(const LodView& view, const LodSettings& settings){
+        if(lods.size() < 2) return currentLod = 0;
+
+        float pixelsPerUnit = ProjectedPixelsPerUnit(view);
+        while(currentLod > 0 && lods[currentLod].error * pixelsPerUnit > settings.thresholdPixels){
+            currentLod--;
+        }
+        while(currentLod + 1 < lods.size() && lods[currentLod + 1].error * pixelsPerUnit <= settings.thresholdPixels * (1.0f - settings.hysteresis)){
+            currentLod++;
+        }
+        return currentLod;
+    }
+
+    //! @note NEW ---- Screen pixels covered by one model unit at the mesh's bounding sphere, multiply a MeshLod::error by it to get its size on screen
+    float ProjectedPixelsPerUnit(const LodView& view) const{
+        glm::vec3 center = glm::vec3(view.model * glm::vec4(boundsCenter, 1.0f));
+        float scale = std::max(glm::length(glm::vec3(view.model[0])), std::max(glm::length(glm::vec3(view.model[1])), glm::length(glm::vec3(view.model[2]))));
+        float distance = glm::length(center - view.cameraPosition) - boundsRadius * scale;
+        return view.projectionScale * scale / std::max(distance, 1e-4f);
+    }
+
+    /**
+     * @note NEW ---- Tells residency how large this mesh's textures appear on screen: the bounding sphere's projected diameter over the part of
+     * @note the texture the mesh covers (its UV range, taken as the whole texture when unknown)
+    */
+    void RequestTextureResidency(const LodView& view, TextureResidency& residency) const{
+        float extent = uvMin.x == -FLT_MAX ? 1.0f : std::max(uvMax.x - uvMin.x, uvMax.y - uvMin.y);
+        float screenSize = 2.0f * boundsRadius * ProjectedPixelsPerUnit(view) / std::max(extent, 1e-3f);
+        for(const Texture& texture : textures){
+            residency.Request(texture.handle, screenSize);
+        }
+    }
+
+    /**
+     * @note NEW ---- Draws the mesh once per transform with glDrawElementsInstanced, modelInstanced.vert reads them at locations 5-8
+     * @note Needs the mesh's own VAO (not an arena), Model::loadModel takes care of that when ModelLoadOptions::instanceMeshes is set
+    */
+    void SetInstances(const std::vector<glm::mat4>& transforms){
+        instanceCount = static_cast<uint32_t>(transforms.size());
+        instanceBuffer = GLBuffer::Create();
+
+        glBindVertexArray(vao.Get());
+        glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer.Get());
+        glBufferData(GL_ARRAY_BUFFER, transforms.size() * sizeof(glm::mat4), transforms.data(), GL_STATIC_DRAW);
+
+        //! @note A mat4 attribute takes four consecutive locations, one column each, advancing once per instance
+        for(uint32_t column = 0; column < 4; column++){
+            glEnableVertexAttribArray(5 + column);
+            glVertexAttribPointer(5 + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(column * sizeof(glm::vec4)));
+            glVertexAttribDivisor(5 + column, 1);
+        }
+
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    uint32_t InstanceCount() const { return instanceCount; }
+
+    //! @note NEW ---- what was uploaded, also for meshes that keep no CPU-side copy (mesh caches, glTF buffer views). The index count
+    //! @note includes the LOD levels, lods[0].indexCount is the full detail level alone.
+    uint32_t VertexCount() const { return vertexCount; }
+    uint32_t IndexCount() const { return indexCount; }
+
+    void Draw(Shader& shader, TextureBindState* bindState = nullptr){
+        BindTextures(shader, bindState);
+
+        //! @note NEW ---- Packed vertices are stored relative to the mesh bounds, the shader needs those to decode them
+        if(packed){
+            shader.Set("positionMin", packedBounds.positionMin);
+            shader.Set("positionExtent", packedBounds.positionExtent);
+            shader.Set("uvMin", packedBounds.uvMin);
+            shader.Set("uvExtent", packedBounds.uvExtent);
+        }
+
+        // Drawing Mesh
+        if(arena){
+            arena->Bind();
+            arena->Draw(LodRange());
+            glBindVertexArray(0);
+            return;
+        }
+
+        //! @note NEW ---- Every level lives in the same index buffer, only the offset and count change
+        const MeshLod& lod = lods[currentLod];
+        size_t indexSize = IndexTypeSize(indexType);
+        glBindVertexArray(vao.Get());
+        if(instanceCount > 0){
+            glDrawElementsInstanced(GL_TRIANGLES, lod.indexCount, indexType, (void*)(indexByteOffset + lod.firstIndex * indexSize), instanceCount);
+        }
+        else{
+            glDrawElements(GL_TRIANGLES, lod.indexCount, indexType, (void*)(indexByteOffset + lod.firstIndex * indexSize));
+        }
+        glBindVertexArray(0);
+        FrameRenderStats().vertexArrayBinds++;
+        FrameRenderStats().drawCalls++;
+        FrameRenderStats().triangles += lod.indexCount / 3 * std::max(instanceCount, 1u);
+    }
+
+    //! @note NEW ---- Draws out of a shared GeometryArena whose VAO the caller already bound (Model::Draw binds it once for all of its meshes)
+    void DrawFromBoundArena(Shader& shader, TextureBindState* bindState = nullptr){
+        BindTextures(shader, bindState);
+        arena->Draw(LodRange());
+    }
+
+    //! @note NEW ---- bindState (optional) is shared by every mesh of one draw, so texture arrays a unit already holds are not bound again
+    void BindTextures(Shader& shader, TextureBindState* bindState = nullptr){
+        if(packedTextures){
+            TextureBindState local;
+            BindTextureArrays(shader, bindState ? *bindState : local);
+            local.Finish();
+            return;
+        }
+
+        uint32_t diffuseIDs = 1;
+        uint32_t specularIDs = 1;
+
+        for(uint32_t i = 0; i < textures.size(); i++){
+            glActiveTexture(GL_TEXTURE0 + i); // NEW ------ Activate proper texture before retrieving texture id (the N in diffuse textures of N size)
+            std::string number;
+            std::string name = textures[i].type;
+
+            if(name == "texture_diffuse"){
+                number = std::to_string(diffuseIDs++);
+            }
+            else if(name == "texture_specular"){
+                number = std::to_string(specularIDs++);
+            }
+
+            std::string foo("material." + name + number);
+            shader.Set(foo.c_str(), (int)i);
+            glBindTexture(GL_TEXTURE_2D, textures[i].id);
+            FrameRenderStats().textureBinds++;
+        }
+
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    //! @note NEW ---- textures packed by Model::packTextureArrays, every one is a sampler2DArray plus its layer and UV rectangle (see modelArray.frag).
+    //! @note One that was left out (block compressed, or unreadable) binds as a plain 2D texture on its fallback unit instead.
+    void BindTextureArrays(Shader& shader, TextureBindState& bindState){
+        uint32_t diffuseIDs = 1;
+        uint32_t specularIDs = 1;
+
+        for(uint32_t i = 0; i < textures.size(); i++){
+            std::string number;
+            const std::string& name = textures[i].type;
+
+            if(name == "texture_diffuse"){
+                number = std::to_string(diffuseIDs++);
+            }
+            else if(name == "texture_specular"){
+                number = std::to_string(specularIDs++);
+            }
+
+            std::string uniform = name + number;
+            bool packed = textures[i].arrayID != 0;
+            shader.Set(uniform, (int)i);
+            shader.Set(uniform + "Plain", (int)(TextureBindState::PLAIN_UNIT + i)); // always set, two sampler types must never share a unit
+            shader.Set(uniform + "Packed", packed);
+            if(packed){
+                shader.Set(uniform + "Layer", textures[i].layer);
+                shader.Set(uniform + "Rect", textures[i].uvRect);
+                bindState.BindArray(i, textures[i].arrayID);
+            }
+            else{
+                bindState.BindPlain(i, textures[i].id);
+            }
+        }
+    }
+
+    //! @note NEW ---- range of the texture coordinates, meshes drawn from buffer views (glTF) do not know theirs and report an unbounded one
+    void UvBounds(glm::vec2& minimum, glm::vec2& maximum) const{
+        minimum = uvMin;
+        maximum = uvMax;
+    }
+
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    std::vector<Texture> textures;
+    std::vector<MeshLod> lods; // NEW ---- level 0 is the full mesh, always at least one entry
+    uint32_t currentLod = 0;
+    MeshletSet meshlets; // NEW ---- clusters of the full detail level for finer culling, empty unless ModelLoadOptions::buildMeshlets is set
+    bool packedTextures = false; // NEW ---- set by Model::packTextureArrays, textures then bind through BindTextureArrays (drawn with modelArray.frag)
+    std::vector<MeshMergeSource> mergeSources; // NEW ---- when this mesh is several merged ones (ModelLoadOptions::mergeStaticMeshes), which triangles came from which, see FindMergeSource
+private:
+    GLVertexArray vao;
+    GLBuffer vbo, ibo;
+    uint32_t vertexCount = 0;
+    uint32_t indexCount = 0;
+    GLenum indexType = GL_UNSIGNED_INT;
+    size_t indexByteOffset = 0; // NEW ---- where this mesh's indices start in a shared index buffer
+    GLBuffer instanceBuffer; // NEW ---- one mat4 per instance, see SetInstances
+    uint32_t instanceCount = 0; // 0 = not instanced, plain glDrawElements
+    GeometryArena* arena = nullptr;
+    GeometryRange range;
+    bool packed = false;
+    PackedMeshBounds packedBounds;
+    glm::vec3 boundsCenter = glm::vec3(0.0f);
+    float boundsRadius = 0.0f;
+    glm::vec2 uvMin = glm::vec2(-FLT_MAX);
+    glm::vec2 uvMax = glm::vec2(FLT_MAX);
+
+    GeometryRange LodRange() const{
+        GeometryRange lodRange = range;
+        lodRange.firstIndex += lods[currentLod].firstIndex;
+        lodRange.indexCount = lods[currentLod].indexCount;
+        return lodRange;
+    }
+
+    void ComputeBounds(const Vertex* vertexData, size_t vertexCount){
+        if(vertexCount == 0) return;
+
+        glm::vec3 minimum = vertexData[0].position, maximum = vertexData[0].position;
+        uvMin = uvMax = vertexData[0].TexCoords;
+        for(size_t i = 1; i < vertexCount; i++){
+            minimum = glm::min(minimum, vertexData[i].position);
+            maximum = glm::max(maximum, vertexData[i].position);
+            uvMin = glm::min(uvMin, vertexData[i].TexCoords);
+            uvMax = glm::max(uvMax, vertexData[i].TexCoords);
+        }
+
+        boundsCenter = (minimum + maximum) * 0.5f;
+        for(size_t i = 0; i < vertexCount; i++){
+            boundsRadius = std::max(boundsRadius, glm::length(vertexData[i].position - boundsCenter));
+        }
+    }
+
+    void SetupMesh(const Vertex* vertexData, size_t vertexCount, const uint32_t* indexData, size_t indexCount, const MeshUploadOptions& upload){
+        this->vertexCount = static_cast<uint32_t>(vertexCount);
+        this->indexCount = static_cast<uint32_t>(indexCount);
+        if(lods.empty()){
+            lods.push_back({0, this->indexCount, 0.0f});
+        }
+        ComputeBounds(vertexData, vertexCount);
+
+        if(upload.packedVertices){
+            SetupPackedMesh(vertexData, vertexCount, indexData, indexCount);
+            return;
+        }
+
+        //! @note NEW ---- With an arena the data is appended to its shared buffers instead of getting a VAO/VBO/IBO of our own
+        if(upload.arena){
+            arena = upload.arena;
+            range = arena->Add(vertexData, vertexCount, indexData, indexCount);
+            return;
+        }
+
+        vao = GLVertexArray::Create();
+        vbo = GLBuffer::Create();
+        ibo = GLBuffer::Create();
+
+        glBindVertexArray(vao.Get());
+        glBindBuffer(GL_ARRAY_BUFFER, vbo.Get());
+        glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(Vertex), vertexData, GL_STATIC_DRAW);
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo.Get());
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(uint32_t), indexData, GL_STATIC_DRAW);
+
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)0);
+
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)offsetof(Vertex, normal));
+
+        // vertex texture coords
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
+
+        glBindVertexArray(0);
+    }
+
+    //! @note NEW ---- Compact layout, see PackedVertex.h. Meshes below 65536 vertices also get 16-bit indices.
+    void SetupPackedMesh(const Vertex* vertexData, size_t vertexCount, const uint32_t* indexData, size_t indexCount){
+        std::vector<PackedVertex> packedVertices(vertexCount);
+        packedBounds = PackVertices(vertexData, vertexCount, packedVertices.data());
+        packed = true;
+
+        vao = GLVertexArray::Create();
+        vbo = GLBuffer::Create();
+        ibo = GLBuffer::Create();
+
+        glBindVertexArray(vao.Get());
+        glBindBuffer(GL_ARRAY_BUFFER, vbo.Get());
+        glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(PackedVertex), packedVertices.data(), GL_STATIC_DRAW);
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo.Get());
+        if(vertexCount < 65536){
+            std::vector<uint16_t> packedIndices = PackIndices16(indexData, indexCount);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(uint16_t), packedIndices.data(), GL_STATIC_DRAW);
+            indexType = GL_UNSIGNED_SHORT;
+        }
+        else{
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(uint32_t), indexData, GL_STATIC_DRAW);
+        }
+
+        // positions (unorm16 within the mesh bounds)
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, position));
+
+        // octahedral normal (snorm16)
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, normal));
+
+        // texture coords (unorm16 within the uv bounds)
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, uv));
+
+        // octahedral tangent (snorm16) + bitangent handedness
+        glEnableVertexAttribArray(3);
+        glVertexAttribPointer(3, 2, GL_SHORT, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, tangent));
+        glEnableVertexAttribArray(4);
+        glVertexAttribPointer(4, 1, GL_SHORT, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, bitangentSign));
+
+        glBindVertexArray(0);
+    }
+};
+
+// NEW ---- assimp stream over an AssetFile (AssetPack.h), reads come straight out of the pack mapping or the mapped loose file
+struct AssetIOStream : public Assimp::IOStream
+{
+    explicit AssetIOStream(AssetFile assetFile) : file(std::move(assetFile)) {}
+
+    size_t Read(void* buffer, size_t size, size_t count) override
+    {
+        if (size == 0) return 0;
+        size_t elements = std::min(count, (file.size - position) / size);
+        std::memcpy(buffer, file.data + position, elements * size);
+        position += elements * size;
+        return elements;
+    }
+
+    size_t Write(const void*, size_t, size_t) override { return 0; }
+
+    aiReturn Seek(size_t offset, aiOrigin origin) override
+    {
+        size_t base = origin == aiOrigin_SET ? 0 : origin == aiOrigin_CUR ? position : file.size;
+        if (base + offset > file.size) return aiReturn_FAILURE;
+        position = base + offset;
+        return aiReturn_SUCCESS;
+    }
+
+    size_t Tell() const override { return position; }
+    size_t FileSize() const override { return file.size; }
+    void Flush() override {}
+
+    AssetFile file;
+    size_t position = 0;
+};
+
+// NEW ---- assimp file system on top of Assets(), so models and the files they reference (.mtl, .bin) come out of a mounted pack too
+struct AssetIOSystem : public Assimp::DefaultIOSystem
+{
+    bool Exists(const char* file) const override
+    {
+        return Assets().Exists(file);
+    }
+
+    Assimp::IOStream* Open(const char* file, const char* mode = "rb") override
+    {
+        if (std::strchr(mode, 'w') || std::strchr(mode, 'a'))
+            return DefaultIOSystem::Open(file, mode);
+        AssetFile asset(file);
+        return asset.IsOpen() ? new AssetIOStream(std::move(asset)) : nullptr;
+    }
+};
+
+// NEW ---- Options for how a Model gets imported
+struct ModelLoadOptions{
+    bool useMeshCache = false; // read (or write on the first load) a binary mesh cache next to the model file, see MeshCache.h
+    GeometryArena* geometryArena = nullptr; // when set, every mesh is packed into this arena's shared buffers (one VAO for the whole model, or for several models)
+    bool packedVertices = false; // upload the compact PackedVertex format (draw with modelPacked.vert), takes precedence over geometryArena
+    ThreadPool* extractionPool = nullptr; // when set, every mesh's vertex/index arrays are built in parallel on this pool, only the GL uploads stay on this thread
+    AsyncTextureLoader* textureLoader = nullptr; // when set, textures start as 1x1 placeholders and are decoded in the background (call textureLoader->Update() every frame)
+    bool optimizeMeshes = false; // reorder triangles/vertices for the post-transform cache and overdraw after import, see MeshOptimizer.h (the result is what gets cached)
+    uint32_t lodLevels = 0; // simplified levels generated per mesh, each with about half the triangles of the one before (50%, 25%, 12.5%, ...), see MeshSimplifier.h. Implies weldVertices (with weld's tolerances).
+    bool buildMeshlets = false; // split every mesh's full detail level into 64 vertex / 124 triangle clusters with bounds and normal cones, see Meshlets.h
+    bool weldVertices = false; // merge duplicated vertices right after extraction (instead of aiProcess_JoinIdenticalVertices), see MeshWelder.h
+    WeldSettings weld; // tolerances for weldVertices, 0 = bit-identical only
+    bool computeTangentFrames = false; // smooth normals (when the file has none) and tangents computed by MeshTangents.h instead of aiProcess_GenSmoothNormals/CalcTangentSpace
+    bool nativeObj = false; // .obj files are parsed by ObjLoader.h (chunks in parallel on extractionPool or the shared pool) instead of assimp, normals/tangents then always come from MeshTangents.h
+    bool instanceMeshes = false; // meshes repeated in the file (one aiMesh under many nodes, or identical content and material) are uploaded once and drawn instanced with their node transforms, draw with modelInstanced.vert. See MeshInstancing.h, every mesh then owns its buffers (no arena or packed vertices) and the mesh cache and streaming are skipped.
+    bool mergeStaticMeshes = false; // meshes sharing a material are merged into one draw (vertices pre-transformed by their node transforms), see MeshMerging.h. With instanceMeshes, meshes drawn more than once stay instanced and merged meshes get one identity instance (modelInstanced.vert draws everything). Skips the mesh cache and streaming like instanceMeshes.
+    bool nativeGltf = true; // .gltf/.glb files skip assimp and upload their buffer views as they are, see GltfLoader.h (false imports them through assimp like any other format)
+    bool textureArrays = false; // after loading, textures are packed into texture arrays and atlases (Model::packTextureArrays, TextureArrays.h), draw with modelArray.frag. Needs synchronous texture loads (no textureLoader), otherwise call packTextureArrays() once they are all uploaded. Block compressed textures (TextureCompression.h) are not packed, they would grow 4-8x as RGBA8 layers; they stay 2D and under TextureResidency. Packed textures drop their handle, so TextureResidency stops managing them.
+    TextureArraySettings textureArraySettings; // atlas page size, which textures count as small and their padding
+};
+
+class Model
+{
+public:
+    // model data 
+    std::vector<Mesh>    meshes;
+    std::string directory;
+    bool gammaCorrection;
+    ModelLoadOptions options;
+    std::vector<MeshOptimizationReport> optimizationReports; // NEW ---- one per mesh when options.optimizeMeshes is set and the meshes came from assimp (cached meshes are already optimized)
+    LodSettings lodSettings; // NEW ---- thresholds used by Draw(shader, view)
+    std::shared_ptr<ModelStreamState> stream; // NEW ---- only set while a streaming load is in progress
+    InstancingReport instancingReport; // NEW ---- filled when options.instanceMeshes is set
+    MeshMergeReport mergeReport; // NEW ---- filled when options.mergeStaticMeshes is set
+    std::vector<GLBuffer> sharedBuffers; // NEW ---- buffers several meshes draw from (the buffer views of a glTF file), see loadGltf
+    SceneHierarchy nodes; // NEW ---- the file's node tree with its transforms (without instancing or merging, also restored from mesh caches and baked meshes), move nodes by setting their TRS
+    std::vector<uint32_t> meshNodes; // NEW ---- node of every mesh, same order as meshes (empty when nodes is)
+    TextureArraySet textureArraySet; // NEW ---- the arrays holding every mesh's textures once packTextureArrays ran
+    TextureArrayReport textureArrayReport; // NEW ---- filled by packTextureArrays
+
+    // constructor, expects a filepath to a 3D model.
+    Model(const std::string& path, bool gamma = false) : gammaCorrection(gamma)
+    {
+        loadModel(path);
+    }
+
+    Model(const std::string& path, const ModelLoadOptions& loadOptions, bool gamma = false) : gammaCorrection(gamma), options(loadOptions)
+    {
+        loadModel(path);
+        if (options.textureArrays && !options.textureLoader)
+            packTextureArrays();
+    }
+
+    // NEW ---- streaming constructor, returns right away. Parsing and mesh building run on options.extractionPool (or the shared pool),
+    // call updateStreaming() every frame: meshes are appended to `meshes` as they get uploaded, so Draw only ever sees resident geometry
+    Model(const std::string& path, const ModelLoadOptions& loadOptions, ModelStreamCallbacks callbacks, bool gamma = false) : gammaCorrection(gamma), options(loadOptions)
+    {
+        startStreaming(path, std::move(callbacks));
+    }
+
+    // NEW ---- uploads up to meshBudget finished meshes (in file order) and fires the stream callbacks, returns true once fully loaded
+    bool updateStreaming(uint32_t meshBudget = 4)
+    {
+        if (!stream)
+            return true;
+
+        ModelStreamState& state = *stream;
+        uint32_t uploaded = 0;
+        while (uploaded < meshBudget)
+        {
+            uint32_t i = state.nextUpload;
+            {
+                std::lock_guard<std::mutex> lock(state.mutex);
+                if (!state.parsed || i >= state.totalMeshes || !state.ready[i])
+                    break;
+            }
+
+            // NEW ---- the node tree is known once the file is parsed, DrawHierarchy places meshes by it as they arrive
+            if (i == 0)
+            {
+                if (state.fromCache)
+                    state.cache.ReadNodes(nodes, meshNodes);
+                else if (!state.fromObj && state.scene)
+                    buildNodeHierarchy(state.scene->mRootNode, SceneHierarchy::NO_PARENT, nodes, meshNodes);
+            }
+
+            if (state.fromCache)
+            {
+                meshes.push_back(meshFromCache(state.cache, i));
+                meshes.back().meshlets = std::move(state.meshData[i].meshlets);
+            }
+            else
+            {
+                if (state.fromObj)
+                    meshes.push_back(meshFromObj(std::move(state.meshData[i]), state.obj, state.obj.meshes[i]));
+                else
+                    meshes.push_back(meshFromData(std::move(state.meshData[i]), state.sceneMeshes[i], state.scene));
+                if (options.optimizeMeshes)
+                    optimizationReports.push_back(state.reports[i]);
+            }
+
+            state.nextUpload++;
+            uploaded++;
+        }
+
+        double elapsed = state.ElapsedMilliseconds();
+        bool failed, geometryDone;
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+            failed = state.failed;
+            geometryDone = failed || (state.parsed && state.nextUpload == state.totalMeshes);
+        }
+
+        if (uploaded > 0)
+        {
+            if (!state.firstFrameReported && state.callbacks.onFirstFrame)
+                state.callbacks.onFirstFrame(elapsed);
+            state.firstFrameReported = true;
+
+            if (state.callbacks.onProgress)
+                state.callbacks.onProgress({state.nextUpload, state.totalMeshes, elapsed});
+        }
+
+        if (geometryDone && !state.geometryFinished)
+        {
+            state.geometryFinished = true;
+            if (failed)
+                std::cout << (state.fromObj ? "ERROR::OBJ:: " : "ERROR::ASSIMP:: ") << state.error << std::endl;
+            else if (!state.fromCache && state.cacheKey != 0)
+                writeMeshCache(MeshCachePath(state.path, state.cacheKey), state.cacheKey, state.dependencies);
+
+            // every mesh is on the GPU now, the parsed scene / mapped cache are no longer needed
+            state.cache.Close();
+            state.importer.FreeScene();
+            state.obj = ObjAsset();
+        }
+
+        if (geometryDone && (!options.textureLoader || options.textureLoader->Idle()))
+        {
+            if (state.callbacks.onFullyLoaded)
+                state.callbacks.onFullyLoaded(elapsed);
+            stream.reset();
+            return true;
+        }
+        return false;
+    }
+
+    // NEW ---- moves the textures of every mesh into texture arrays and atlases (TextureArrays.h) and drops their 2D textures, the meshes then
+    // carry an array, layer and UV rectangle per texture and draw with modelArray.frag. Textures are atlased only when no mesh using them
+    // samples outside [0, 1] (meshes from glTF buffer views never know, so theirs get layers of their own). Textures the arrays leave out
+    // (block compressed ones) keep their 2D texture and handle, modelArray.frag samples them through its fallback sampler.
+    TextureArrayReport packTextureArrays()
+    {
+        std::vector<TextureArrayInput> inputs;
+        std::unordered_map<uint32_t, uint32_t> inputIndex; // GL texture -> its input
+        for (const Mesh& mesh : meshes)
+        {
+            glm::vec2 uvMin, uvMax;
+            mesh.UvBounds(uvMin, uvMax);
+            const float epsilon = 1e-3f;
+            bool unitSquare = uvMin.x >= -epsilon && uvMin.y >= -epsilon && uvMax.x <= 1.0f + epsilon && uvMax.y <= 1.0f + epsilon;
+            for (const Texture& texture : mesh.textures)
+            {
+                if (!texture.id)
+                    continue;
+                auto [found, inserted] = inputIndex.try_emplace(texture.id, static_cast<uint32_t>(inputs.size()));
+                if (inserted)
+                    inputs.push_back({texture.id, texture.handle && texture.handle->key.params.gamma, true});
+                inputs[found->second].atlasable = inputs[found->second].atlasable && unitSquare;
+            }
+        }
+
+        std::vector<TextureArraySlot> slots;
+        textureArrayReport = textureArraySet.Build(inputs, options.textureArraySettings, slots);
+        for (Mesh& mesh : meshes)
+        {
+            mesh.packedTextures = true;
+            for (Texture& texture : mesh.textures)
+            {
+                auto found = inputIndex.find(texture.id);
+                if (found == inputIndex.end() || !slots[found->second].array)
+                    continue;
+                const TextureArraySlot& slot = slots[found->second];
+                texture.arrayID = slot.array;
+                texture.layer = slot.layer;
+                texture.uvRect = slot.uvRect;
+            }
+        }
+        // the 2D textures go once nothing looks them up by id anymore (other models may still hold them through the cache)
+        for (Mesh& mesh : meshes)
+        {
+            for (Texture& texture : mesh.textures)
+            {
+                if (!texture.arrayID)
+                    continue;
+                texture.id = 0;
+                texture.handle.reset();
+            }
+        }
+        return textureArrayReport;
+    }
+
+    // NEW ---- false while a streaming load still has meshes (or textures) on the way
+    bool isFullyLoaded() const
+    {
+        return !stream;
+    }
+
+    // draws the model, and thus all its meshes
+    void Draw(Shader& shader)
+    {
+        // NEW ---- meshes packed in one arena share its VAO, so it only needs binding once
+        // NEW ---- and meshes sharing a texture array share its bind (see TextureArrays.h)
+        TextureBindState bindState;
+        if (options.geometryArena && !options.packedVertices)
+        {
+            options.geometryArena->Bind();
+            for (unsigned int i = 0; i < meshes.size(); i++)
+                meshes[i].DrawFromBoundArena(shader, &bindState);
+            glBindVertexArray(0);
+            bindState.Finish();
+            return;
+        }
+
+        for (unsigned int i = 0; i < meshes.size(); i++)
+            meshes[i].Draw(shader, &bindState);
+        bindState.Finish();
+    }
+
+    // NEW ---- draws every mesh with model * its node's world matrix (sets the shader's "model" uniform), updating the hierarchy first so
+    // only nodes changed since the last frame get their matrices recomputed. Without a node tree every mesh just gets model.
+    void DrawHierarchy(Shader& shader, const glm::mat4& model)
+    {
+        if (meshNodes.size() < meshes.size() || meshes.empty()) // a streaming model knows every mesh's node before the meshes arrive
+        {
+            shader.Set("model", model);
+            Draw(shader);
+            return;
+        }
+
+        nodes.Update();
+        TextureBindState bindState;
+        bool boundArena = options.geometryArena && !options.packedVertices;
+        if (boundArena)
+            options.geometryArena->Bind();
+        for (unsigned int i = 0; i < meshes.size(); i++)
+        {
+            shader.Set("model", model * nodes.World(meshNodes[i]));
+            if (boundArena)
+                meshes[i].DrawFromBoundArena(shader, &bindState);
+            else
+                meshes[i].Draw(shader, &bindState);
+        }
+        if (boundArena)
+            glBindVertexArray(0);
+        bindState.Finish();
+    }
+
+    // NEW ---- picks every mesh's level of detail for this view first, then draws as usual
+    void Draw(Shader& shader, const LodView& view)
+    {
+        for (unsigned int i = 0; i < meshes.size(); i++)
+            meshes[i].SelectLod(view, lodSettings);
+        if (GlobalTextureResidency().Enabled())
+            for (const Mesh& mesh : meshes)
+                mesh.RequestTextureResidency(view, GlobalTextureResidency()); // NEW ---- textures stream to the size they are drawn at
+        Draw(shader);
+    }
+
+    MeshUploadOptions meshUploadOptions() const
+    {
+        MeshUploadOptions upload;
+        upload.arena = options.packedVertices ? nullptr : options.geometryArena;
+        upload.packedVertices = options.packedVertices;
+        return upload;
+    }
+
+    // NEW ---- extraction plus the optional optimization, LOD and meshlet passes, touches no GL or Model state so worker threads can run it
+    static void buildMeshData(const aiMesh* mesh, MeshData& data, MeshOptimizationReport& report, const ModelLoadOptions& options)
+    {
+        extractMeshData(mesh, data);
+        if (options.computeTangentFrames)
+        {
+            TangentFrameSettings tangentSettings;
+            tangentSettings.generateNormals = !mesh->HasNormals();
+            tangentSettings.generateTangents = mesh->HasTextureCoords(0);
+            GenerateTangentFrames(data, tangentSettings, tangentPool(options)); // fine from a pool job too, ParallelFor helps instead of waiting
+        }
+        processMeshData(data, report, options);
+    }
+
+    // NEW ---- same as buildMeshData for a mesh ObjLoader.h already extracted. There is no assimp post-processing on this path, so the tangent frames are always ours.
+    static void buildObjMeshData(ObjMesh& mesh, MeshData& data, MeshOptimizationReport& report, const ModelLoadOptions& options)
+    {
+        data = std::move(mesh.data);
+        TangentFrameSettings tangentSettings;
+        tangentSettings.generateNormals = !mesh.hasNormals;
+        tangentSettings.generateTangents = mesh.hasTexCoords;
+        GenerateTangentFrames(data, tangentSettings, tangentPool(options));
+        processMeshData(data, report, options);
+    }
+
+    // NEW ---- pool the tangent frame phases split across, the extraction pool when there is one
+    static ThreadPool* tangentPool(const ModelLoadOptions& options)
+    {
+        return options.extractionPool ? options.extractionPool : &SharedThreadPool();
+    }
+
+    // NEW ---- the optional passes that run on extracted vertex/index arrays, whichever importer produced them
+    static void processMeshData(MeshData& data, MeshOptimizationReport& report, const ModelLoadOptions& options)
+    {
+        // NEW ---- extracted meshes are unwelded (every corner its own vertex), which would lock every vertex for the simplifier, so LODs always weld first
+        if (options.weldVertices || options.lodLevels > 0)
+            WeldVertices(data, options.weld);
+        if (options.optimizeMeshes)
+            OptimizeMesh(data, &report);
+        if (options.lodLevels > 0)
+            BuildLodChain(data, options.lodLevels, 0.5f, options.optimizeMeshes);
+        if (options.buildMeshlets)
+        {
+            size_t fullDetailCount = data.lods.empty() ? data.indices.size() : data.lods.front().indexCount;
+            BuildMeshlets(data.vertices.data(), data.vertices.size(), data.indices.data(), fullDetailCount, data.meshlets);
+        }
+    }
+
+    // NEW ---- our own processing steps that change the mesh data, part of the mesh cache key
+    uint32_t processFlags() const
+    {
+        return processFlags(options);
+    }
+
+    static uint32_t processFlags(const ModelLoadOptions& loadOptions)
+    {
+        uint32_t flags = loadOptions.optimizeMeshes ? MESH_PROCESS_OPTIMIZE : 0;
+        flags |= (loadOptions.lodLevels & 0xff) << MESH_PROCESS_LOD_SHIFT;
+        if (loadOptions.weldVertices || loadOptions.lodLevels > 0)
+        {
+            flags |= MESH_PROCESS_WELD;
+            flags |= static_cast<uint32_t>(HashBytes(&loadOptions.weld, sizeof(WeldSettings)) & 0xffff) << MESH_PROCESS_WELD_SHIFT;
+        }
+        if (loadOptions.nativeObj)
+            flags |= MESH_PROCESS_NATIVE_OBJ;
+        return flags;
+    }
+
+    // NEW ---- whether path goes through ObjLoader.h instead of assimp
+    static bool usesNativeObj(const std::string& path, const ModelLoadOptions& loadOptions)
+    {
+        return loadOptions.nativeObj && ObjAsset::IsObjPath(path);
+    }
+
+    static unsigned int importFlags(const ModelLoadOptions& loadOptions = ModelLoadOptions())
+    {
+        // NEW ---- normals and tangents are left to MeshTangents.h when computeTangentFrames is set
+        if (loadOptions.computeTangentFrames)
+            return aiProcess_Triangulate | aiProcess_FlipUVs;
+        return aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace;
+    }
+
+    // NEW ---- type and path (relative to the model) of every texture a mesh uses, without loading them. Same types, in the same order, as loadMeshTextures.
+    static std::vector<Texture> meshTextureReferences(const aiMesh* mesh, const aiScene* scene)
+    {
+        static const std::pair<aiTextureType, const char*> types[] = {
+            {aiTextureType_DIFFUSE, "texture_diffuse"}, {aiTextureType_SPECULAR, "texture_specular"},
+            {aiTextureType_HEIGHT, "texture_normal"}, {aiTextureType_AMBIENT, "texture_height"}};
+
+        std::vector<Texture> textures;
+        const aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
+        for (const auto& [type, typeName] : types)
+        {
+            for (unsigned int i = 0; i < material->GetTextureCount(type); i++)
+            {
+                aiString str;
+                material->GetTexture(type, i, &str);
+                textures.push_back({0, typeName, str.C_Str(), nullptr});
+            }
+        }
+        return textures;
+    }
+
+    // NEW ---- same for a mesh ObjLoader.h parsed, in the same order again
+    static std::vector<Texture> objTextureReferences(const ObjAsset& asset, const ObjMesh& mesh)
+    {
+        std::vector<Texture> textures;
+        if (mesh.material < 0)
+            return textures;
+
+        const ObjMaterial& material = asset.materials[mesh.material];
+        if (!material.diffuseMap.empty())
+            textures.push_back({0, "texture_diffuse", material.diffuseMap, nullptr});
+        if (!material.specularMap.empty())
+            textures.push_back({0, "texture_specular", material.specularMap, nullptr});
+        if (!material.normalMap.empty())
+            textures.push_back({0, "texture_normal", material.normalMap, nullptr});
+        if (!material.ambientMap.empty())
+            textures.push_back({0, "texture_height", material.ambientMap, nullptr});
+        return textures;
+    }
+
+    // NEW ---- assimp file system that remembers every file an import opened (the model plus ex. its .mtl or .bin), for the baker's dependency list
+    // and the mesh cache's dependency table
+    struct RecordingIOSystem : public AssetIOSystem
+    {
+        std::vector<std::string> opened;
+
+        // every opened file except the model itself
+        std::vector<std::string> Dependencies(const std::string& modelPath) const
+        {
+            std::vector<std::string> files;
+            for (const std::string& file : opened)
+                if (file != modelPath)
+                    files.push_back(file);
+            return files;
+        }
+
+        Assimp::IOStream* Open(const char* file, const char* mode = "rb") override
+        {
+            Assimp::IOStream* stream = AssetIOSystem::Open(file, mode);
+            if (stream && std::find(opened.begin(), opened.end(), file) == opened.end())
+                opened.push_back(file);
+            return stream;
+        }
+    };
+
+    /**
+     * @note NEW ---- the GL free half of loadModel, for the asset baker (AssetBaker.h). Imports path, runs the same processing loadModel would with
+     * @note loadOptions and writes the meshes as a mesh cache under ComputeBakedMeshKey, which loadModel picks up through BakedAssets().
+     * @note dependencies receives every file the result was built from (path included). Returns false and fills error when the import fails.
+    */
+    static bool bakeMeshCache(const std::string& path, const ModelLoadOptions& loadOptions, const std::string& destination, ThreadPool& pool,
+                              std::vector<std::string>& dependencies, std::string& error)
+    {
+        std::vector<MeshData> meshData;
+        std::vector<std::vector<Texture>> textures;
+        std::vector<MeshOptimizationReport> reports;
+        dependencies.clear();
+
+        // both importers are kept alive until the cache is written, the vectors below may point into them
+        SceneHierarchy bakedHierarchy; // node tree of an assimp import, OBJ has none
+        std::vector<uint32_t> bakedNodes;
+        ObjAsset asset;
+        Assimp::Importer importer;
+        if (usesNativeObj(path, loadOptions))
+        {
+            if (!asset.Load(path, &pool, error))
+                return false;
+            meshData.resize(asset.meshes.size());
+            reports.resize(asset.meshes.size());
+            for (const ObjMesh& mesh : asset.meshes)
+                textures.push_back(objTextureReferences(asset, mesh));
+            pool.ParallelFor(static_cast<uint32_t>(asset.meshes.size()), [&](uint32_t i){
+                buildObjMeshData(asset.meshes[i], meshData[i], reports[i], loadOptions);
+            });
+
+            dependencies = objLibraryPaths(path, asset);
+            dependencies.insert(dependencies.begin(), path);
+        }
+        else
+        {
+            RecordingIOSystem* files = new RecordingIOSystem(); // owned by the importer
+            importer.SetIOHandler(files);
+            const aiScene* scene = importer.ReadFile(path, importFlags(loadOptions));
+            if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+            {
+                error = importer.GetErrorString();
+                return false;
+            }
+
+            std::vector<const aiMesh*> sceneMeshes;
+            collectMeshes(scene->mRootNode, scene, sceneMeshes);
+            buildNodeHierarchy(scene->mRootNode, SceneHierarchy::NO_PARENT, bakedHierarchy, bakedNodes);
+            meshData.resize(sceneMeshes.size());
+            reports.resize(sceneMeshes.size());
+            for (const aiMesh* mesh : sceneMeshes)
+                textures.push_back(meshTextureReferences(mesh, scene));
+            pool.ParallelFor(static_cast<uint32_t>(sceneMeshes.size()), [&](uint32_t i){
+                buildMeshData(sceneMeshes[i], meshData[i], reports[i], loadOptions);
+            });
+
+            dependencies = files->opened;
+            if (std::find(dependencies.begin(), dependencies.end(), path) == dependencies.end())
+                dependencies.insert(dependencies.begin(), path);
+        }
+
+        MeshCacheWriter writer;
+        if (!bakedNodes.empty())
+            writer.SetNodes(bakedHierarchy);
+        for (size_t i = 0; i < meshData.size(); i++)
+            writer.AddMesh(meshData[i].vertices, meshData[i].indices, meshData[i].lods, textures[i], bakedNodes.empty() ? 0 : bakedNodes[i]);
+        if (!writer.Write(destination, ComputeBakedMeshKey(importFlags(loadOptions), processFlags(loadOptions))))
+        {
+            error = "could not write " + destination;
+            return false;
+        }
+        return true;
+    }
+
+    // NEW ---- the material libraries an OBJ pulled in, resolved the way ObjAsset::Load looks them up
+    static std::vector<std::string> objLibraryPaths(const std::string& path, const ObjAsset& asset)
+    {
+        std::string modelDirectory = path.substr(0, path.find_last_of('/'));
+        std::vector<std::string> paths;
+        for (const std::string& library : asset.libraries)
+            paths.push_back(modelDirectory + "/" + library);
+        return paths;
+    }
+
+    // collects the meshes of a node tree in the same depth-first order processNode visits them
+    static void collectMeshes(const aiNode* node, const aiScene* scene, std::vector<const aiMesh*>& out)
+    {
+        for (unsigned int i = 0; i < node->mNumMeshes; i++)
+            out.push_back(scene->mMeshes[node->mMeshes[i]]);
+        for (unsigned int i = 0; i < node->mNumChildren; i++)
+            collectMeshes(node->mChildren[i], scene, out);
+    }
+
+    // copies the vertex and index data out of an assimp mesh. Touches no GL or Model state, so it is safe to run on worker threads.
+    static void extractMeshData(const aiMesh* mesh, MeshData& data)
+    {
+        std::vector<Vertex>& vertices = data.vertices;
+        std::vector<uint32_t>& indices = data.indices;
+        vertices.reserve(mesh->mNumVertices);
+        indices.reserve(mesh->mNumFaces * 3);
+
+        // walk through each of the mesh's vertices
+        for (unsigned int i = 0; i < mesh->mNumVertices; i++)
+        {
+            Vertex vertex{};
+            glm::vec3 vector; // we declare a placeholder vector since assimp uses its own vector class that doesn't directly convert to glm's vec3 class so we transfer the data to this placeholder glm::vec3 first.
+            // positions
+            vector.x = mesh->mVertices[i].x;
+            vector.y = mesh->mVertices[i].y;
+            vector.z = mesh->mVertices[i].z;
+            vertex.position = vector;
+            // normals
+            if (mesh->HasNormals())
+            {
+                vector.x = mesh->mNormals[i].x;
+                vector.y = mesh->mNormals[i].y;
+                vector.z = mesh->mNormals[i].z;
+                vertex.normal = vector;
+            }
+            // texture coordinates
+            if (mesh->mTextureCoords[0]) // does the mesh contain texture coordinates?
+            {
+                glm::vec2 vec;
+                // a vertex can contain up to 8 different texture coordinates. We thus make the assumption that we won't 
+                // use models where a vertex can have multiple texture coordinates so we always take the first set (0).
+                vec.x = mesh->mTextureCoords[0][i].x;
+                vec.y = mesh->mTextureCoords[0][i].y;
+                vertex.TexCoords = vec;
+                // tangent (not there when computeTangentFrames left aiProcess_CalcTangentSpace out)
+                if (mesh->HasTangentsAndBitangents())
+                {
+                    vector.x = mesh->mTangents[i].x;
+                    vector.y = mesh->mTangents[i].y;
+                    vector.z = mesh->mTangents[i].z;
+                    vertex.Tangent = vector;
+                    // bitangent
+                    vector.x = mesh->mBitangents[i].x;
+                    vector.y = mesh->mBitangents[i].y;
+                    vector.z = mesh->mBitangents[i].z;
+                    vertex.BitTangent = vector;
+                }
+            }
+            else
+                vertex.TexCoords = glm::vec2(0.0f, 0.0f);
+
+            vertices.push_back(vertex);
+        }
+        // now wak through each of the mesh's faces (a face is a mesh its triangle) and retrieve the corresponding vertex indices.
+        for (unsigned int i = 0; i < mesh->mNumFaces; i++)
+        {
+            const aiFace& face = mesh->mFaces[i];
+            // retrieve all indices of the face and store them in the indices vector
+            for (unsigned int j = 0; j < face.mNumIndices; j++)
+                indices.push_back(face.mIndices[j]);
+        }
+    }
+
+private:
+    // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
+    void loadModel(std::string const& path)
+    {
+        // retrieve the directory path of the filepath
+        directory = path.substr(0, path.find_last_of('/'));
+
+        // NEW ---- glTF is already GPU-ready, it skips assimp (and the mesh cache) altogether
+        if (options.nativeGltf && GltfAsset::IsGltfPath(path))
+        {
+            loadGltf(path);
+            return;
+        }
+
+        // NEW ---- instanced meshes need a VAO of their own for the per-instance transforms
+        if (options.instanceMeshes)
+        {
+            options.geometryArena = nullptr;
+            options.packedVertices = false;
+        }
+
+        bool usesNodeTransforms = options.instanceMeshes || options.mergeStaticMeshes;
+
+        // NEW ---- meshes the asset baker (AssetBaker.h) already processed with these options, nothing to import or process at all
+        if (!usesNodeTransforms)
+        {
+            std::string bakedPath = BakedAssets().Find(path, BAKED_MESH_EXTENSION);
+            if (!bakedPath.empty() && loadFromMeshCache(bakedPath, ComputeBakedMeshKey(importFlags(options), processFlags())))
+                return;
+        }
+
+        // NEW ---- warm starts skip assimp entirely and read the meshes back from the binary cache
+        uint64_t cacheKey = 0;
+        if (options.useMeshCache && !usesNodeTransforms) // the cache stores meshes, not the node transforms (or merge sources) these need
+        {
+            cacheKey = ComputeMeshCacheKey(path, importFlags(options), processFlags());
+            if (cacheKey != 0 && loadFromMeshCache(MeshCachePath(path, cacheKey), cacheKey))
+                return;
+        }
+
+        // NEW ---- our own chunked OBJ parser instead of assimp's single threaded one
+        if (usesNativeObj(path, options))
+        {
+            std::vector<std::string> dependencies;
+            if (loadObj(path, dependencies) && cacheKey != 0)
+                writeMeshCache(MeshCachePath(path, cacheKey), cacheKey, dependencies);
+            return;
+        }
+
+        // read file via ASSIMP
+        Assimp::Importer importer;
+        RecordingIOSystem* files = new RecordingIOSystem(); // NEW ---- owned by the importer, reads through Assets() (AssetPack.h)
+        importer.SetIOHandler(files);
+        const aiScene* scene = importer.ReadFile(path, importFlags(options));
+        // check for errors
+        if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if is Not Zero
+        {
+            std::cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << std::endl;
+            return;
+        }
+
+        // process ASSIMP's root node recursively
+        if (usesNodeTransforms)
+            processNodesStatic(scene);
+        else if (options.extractionPool)
+            processNodesParallel(scene, *options.extractionPool);
+        else
+            processNode(scene->mRootNode, scene);
+
+        // NEW ---- meshes above come out in node order, so the node of each one can be recorded by walking the tree the same way
+        if (!usesNodeTransforms)
+            buildNodeHierarchy(scene->mRootNode, SceneHierarchy::NO_PARENT, nodes, meshNodes);
+
+        if (cacheKey != 0)
+            writeMeshCache(MeshCachePath(path, cacheKey), cacheKey, files->Dependencies(path));
+    }
+
+    // NEW ---- parses the OBJ on the pool (see ObjLoader.h), then builds every mesh's arrays in parallel like processNodesParallel.
+    // dependencies receives the material libraries it read
+    bool loadObj(const std::string& path, std::vector<std::string>& dependencies)
+    {
+        ThreadPool& pool = options.extractionPool ? *options.extractionPool : SharedThreadPool();
+        ObjAsset asset;
+        std::string error;
+        if (!asset.Load(path, &pool, error))
+        {
+            std::cout << "ERROR::OBJ:: " << error << std::endl;
+            return false;
+        }
+        dependencies = objLibraryPaths(path, asset);
+
+        std::vector<MeshData> meshData(asset.meshes.size());
+        std::vector<MeshOptimizationReport> reports(asset.meshes.size());
+        pool.ParallelFor(static_cast<uint32_t>(asset.meshes.size()), [&](uint32_t i){
+            buildObjMeshData(asset.meshes[i], meshData[i], reports[i], options);
+        });
+        if (options.optimizeMeshes)
+            optimizationReports.insert(optimizationReports.end(), reports.begin(), reports.end());
+
+        // OBJ has no node transforms, every object is placed where the file put it
+        if (options.instanceMeshes || options.mergeStaticMeshes)
+        {
+            std::vector<uint32_t> materials(asset.meshes.size());
+            std::vector<std::vector<glm::mat4>> transforms(asset.meshes.size(), std::vector<glm::mat4>(1, glm::mat4(1.0f)));
+            std::vector<std::vector<uint32_t>> occurrenceIds(asset.meshes.size());
+            for (size_t i = 0; i < asset.meshes.size(); i++)
+            {
+                materials[i] = static_cast<uint32_t>(asset.meshes[i].material);
+                occurrenceIds[i].push_back(static_cast<uint32_t>(i));
+            }
+            addStaticMeshes(meshData, materials, transforms, occurrenceIds, [&](MeshData&& data, size_t i){
+                return meshFromObj(std::move(data), asset, asset.meshes[i]);
+            });
+            return true;
+        }
+
+        meshes.reserve(meshes.size() + asset.meshes.size());
+        for (size_t i = 0; i < asset.meshes.size(); i++)
+            meshes.push_back(meshFromObj(std::move(meshData[i]), asset, asset.meshes[i]));
+        return true;
+    }
+
+    Mesh meshFromObj(MeshData&& data, const ObjAsset& asset, const ObjMesh& mesh)
+    {
+        Mesh result(std::move(data.vertices), std::move(data.indices), loadObjTextures(asset, mesh), meshUploadOptions(), std::move(data.lods));
+        result.meshlets = std::move(data.meshlets);
+        return result;
+    }
+
+    std::vector<Texture> loadObjTextures(const ObjAsset& asset, const ObjMesh& mesh)
+    {
+        std::vector<Texture> textures;
+        for (const Texture& reference : objTextureReferences(asset, mesh))
+            textures.push_back(loadTexture(reference.path, reference.type));
+        return textures;
     }
 
-    glBindTexture(TextureType, textureID);
-    glTexImage2D(TextureType, 0, format, w, h, 0, format, GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(TextureType);
+    // NEW ---- native glTF 2.0 / GLB path (GltfLoader.h). The buffer views the meshes use are uploaded straight from the mapped file into one
+    // shared GL buffer and every primitive becomes a Mesh whose VAO points into it, so no vertex is ever touched on the CPU.
+    // The processing options (weld, tangents, optimizer, LODs, meshlets, arena, packed vertices) work on Vertex arrays and do not apply here.
+    void loadGltf(const std::string& path)
+    {
+        std::shared_ptr<GltfAsset> asset = std::make_shared<GltfAsset>();
+        std::string error;
+        if (!asset->Load(path, error))
+        {
+            std::cout << "ERROR::GLTF:: " << error << std::endl;
+            return;
+        }
+        options.geometryArena = nullptr;
+        options.packedVertices = false;
+
+        // which buffer views the drawn primitives read from, and how many indices non-indexed primitives need generated
+        std::vector<uint8_t> viewUsed(asset->bufferViews.size(), 0);
+        size_t generatedIndices = 0;
+        auto useAccessor = [&](int32_t accessor) {
+            if (accessor >= 0 && asset->accessors[accessor].bufferView >= 0)
+                viewUsed[asset->accessors[accessor].bufferView] = 1;
+        };
+        for (uint32_t meshIndex : asset->meshOrder)
+            for (const GltfPrimitive& primitive : asset->meshes[meshIndex].primitives)
+            {
+                if (primitive.mode != GLTF_MODE_TRIANGLES)
+                    continue;
+                useAccessor(primitive.position);
+                useAccessor(primitive.normal);
+                useAccessor(primitive.texcoord);
+                useAccessor(primitive.indices);
+                if (primitive.indices < 0)
+                    generatedIndices += asset->accessors[primitive.position].count;
+            }
 
-    glTexParameteri(TextureType, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(TextureType, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(TextureType, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(TextureType, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        // one GL buffer holding every used view, each keeping its offset modulo 4 so accessor alignment is preserved
+        std::vector<size_t> viewOffsets(asset->bufferViews.size(), 0);
+        size_t totalBytes = 0;
+        for (size_t view = 0; view < viewUsed.size(); view++)
+        {
+            if (!viewUsed[view])
+                continue;
+            totalBytes = (totalBytes + 3) & ~size_t(3);
+            totalBytes += asset->bufferViews[view].byteOffset & 3;
+            viewOffsets[view] = totalBytes;
+            totalBytes += asset->bufferViews[view].byteLength;
+        }
+        totalBytes = (totalBytes + 3) & ~size_t(3);
+        size_t generatedOffset = totalBytes;
+        totalBytes += generatedIndices * sizeof(uint32_t);
+
+        GLBuffer buffer = GLBuffer::Create();
+        glBindBuffer(GL_ARRAY_BUFFER, buffer.Get());
+        glBufferData(GL_ARRAY_BUFFER, totalBytes, nullptr, GL_STATIC_DRAW);
+        for (size_t view = 0; view < viewUsed.size(); view++)
+            if (viewUsed[view])
+                glBufferSubData(GL_ARRAY_BUFFER, viewOffsets[view], asset->bufferViews[view].byteLength, asset->ViewData(static_cast<uint32_t>(view)));
+
+        if (generatedIndices)
+        {
+            std::vector<uint32_t> sequence;
+            sequence.reserve(generatedIndices);
+            for (uint32_t meshIndex : asset->meshOrder)
+                for (const GltfPrimitive& primitive : asset->meshes[meshIndex].primitives)
+                    if (primitive.mode == GLTF_MODE_TRIANGLES && primitive.indices < 0)
+                        for (uint32_t i = 0; i < asset->accessors[primitive.position].count; i++)
+                            sequence.push_back(i);
+            glBufferSubData(GL_ARRAY_BUFFER, generatedOffset, sequence.size() * sizeof(uint32_t), sequence.data());
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-    stbi_image_free(data);
+        std::vector<std::vector<Texture>> imageTextures = loadGltfImages(*asset, asset, path);
 
-    return textureID;
-}
+        // NEW ---- the default scene's node tree, every primitive is drawn at the node that references its mesh (DrawHierarchy)
+        for (const GltfSceneNode& sceneNode : asset->sceneNodes)
+        {
+            const GltfNode& node = asset->nodes[sceneNode.node];
+            nodes.AddNode(sceneNode.parent, node.translation, node.rotation, node.scale);
+        }
 
-// NEW ---- Creating our vertex
-struct Vertex{
-    glm::vec3 position;
-    glm::vec3 normal;
-    glm::vec2 TexCoords;
-    // tangent
-    glm::vec3 Tangent;
-    // tangent
-    glm::vec3 BitTangent;
-};
+        size_t generatedCursor = generatedOffset;
+        for (size_t order = 0; order < asset->meshOrder.size(); order++)
+            for (const GltfPrimitive& primitive : asset->meshes[asset->meshOrder[order]].primitives)
+            {
+                if (primitive.mode != GLTF_MODE_TRIANGLES)
+                {
+                    printf("glTF: skipping a primitive with mode %u in %s, only triangle lists are drawn\n", primitive.mode, path.c_str());
+                    continue;
+                }
 
-// NEW ---- Creating our texture class
-struct Texture{
-    uint32_t id;
-    std::string type;
-    std::string path; // Storing path of our texture in comparison to other textures
-};
+                const GltfAccessor& position = asset->accessors[primitive.position];
+                MeshBufferView view;
+                view.vertexBuffer = buffer.Get();
+                view.indexBuffer = buffer.Get();
+                view.vertexCount = position.count;
+                view.boundsMin = position.min;
+                view.boundsMax = position.max;
+
+                auto addAttribute = [&](int32_t accessorIndex, uint32_t location) {
+                    if (accessorIndex < 0 || asset->accessors[accessorIndex].bufferView < 0)
+                        return;
+                    const GltfAccessor& accessor = asset->accessors[accessorIndex];
+                    MeshAttributeView attribute;
+                    attribute.location = location;
+                    attribute.components = static_cast<int32_t>(accessor.components);
+                    attribute.type = accessor.componentType;
+                    attribute.normalized = accessor.normalized;
+                    attribute.stride = asset->Stride(accessor);
+                    attribute.offset = viewOffsets[accessor.bufferView] + accessor.byteOffset;
+                    view.attributes.push_back(attribute);
+                };
+                addAttribute(primitive.position, 0);
+                addAttribute(primitive.normal, 1);
+                addAttribute(primitive.texcoord, 2);
+
+                if (primitive.indices >= 0 && asset->accessors[primitive.indices].bufferView >= 0)
+                {
+                    const GltfAccessor& indices = asset->accessors[primitive.indices];
+                    view.indexOffset = viewOffsets[indices.bufferView] + indices.byteOffset;
+                    view.indexCount = indices.count;
+                    view.indexType = indices.componentType;
+                }
+                else
+                {
+                    view.indexOffset = generatedCursor;
+                    view.indexCount = position.count;
+                    view.indexType = GL_UNSIGNED_INT;
+                    generatedCursor += position.count * sizeof(uint32_t);
+                }
 
-// NEW ---- Creating Mesh Class
-class Mesh{
-public:
-    Mesh(std::vector<Vertex> vertices, std::vector<uint32_t> indices, std::vector<Texture> textures){
-        this->vertices = vertices;
-        this->indices = indices;
-        this->textures = textures;
+                std::vector<Texture> textures;
+                if (primitive.material >= 0 && primitive.material < static_cast<int32_t>(asset->materials.size()))
+                {
+                    const GltfMaterial& material = asset->materials[primitive.material];
+                    int32_t baseColor = asset->TextureImage(material.baseColorTexture);
+                    int32_t normal = asset->TextureImage(material.normalTexture);
+                    if (baseColor >= 0 && !imageTextures[baseColor].empty())
+                        textures.push_back(imageTextures[baseColor][0]);
+                    if (normal >= 0 && imageTextures[normal].size() > 1)
+                        textures.push_back(imageTextures[normal][1]);
+                }
 
-        SetupMesh();
-    }
+                meshes.emplace_back(view, std::move(textures));
+                if (!asset->meshOrderNodes.empty())
+                    meshNodes.push_back(asset->meshOrderNodes[order]);
+            }
 
-    void Draw(Shader& shader){
-        uint32_t diffuseIDs = 1;
-        uint32_t specularIDs = 1;
+        sharedBuffers.push_back(std::move(buffer));
+    }
 
-        for(uint32_t i = 0; i < textures.size(); i++){
-            glActiveTexture(GL_TEXTURE0 + i); // NEW ------ Activate proper texture before retrieving texture id (the N in diffuse textures of N size)
-            std::string number;
-            std::string name = textures[i].type;
+    // NEW ---- textures of a glTF asset, per image: [0] as texture_diffuse (gamma corrected if enabled), [1] as texture_normal (linear).
+    // Only the variants some material uses are created. Embedded images are decoded on worker threads, by the texture loader when
+    // there is one (the asset stays alive until its decodes finish), otherwise all at once on the shared pool before uploading.
+    std::vector<std::vector<Texture>> loadGltfImages(const GltfAsset& asset, std::shared_ptr<const void> keepAlive, const std::string& path)
+    {
+        std::vector<uint8_t> usage(asset.images.size(), 0); // bit 0 = diffuse, bit 1 = normal
+        for (const GltfMaterial& material : asset.materials)
+        {
+            int32_t baseColor = asset.TextureImage(material.baseColorTexture);
+            int32_t normal = asset.TextureImage(material.normalTexture);
+            if (baseColor >= 0 && baseColor < static_cast<int32_t>(usage.size()))
+                usage[baseColor] |= 1;
+            if (normal >= 0 && normal < static_cast<int32_t>(usage.size()))
+                usage[normal] |= 2;
+        }
 
-            if(name == "texture_diffuse"){
-                number = std::to_string(diffuseIDs++);
-            }
-            else if(name == "texture_specular"){
-                number = std::to_string(specularIDs++);
+        auto paramsFor = [&](uint32_t variant) {
+            TextureLoadParams params;
+            params.gamma = variant == 0 && gammaCorrection;
+            return params;
+        };
+        auto imageName = [&](size_t image) { return TextureCache::NormalizePath(path) + "#image" + std::to_string(image); };
+
+        // synchronous path: decode every embedded image the cache does not hold yet in parallel
+        struct Decoded { unsigned char* pixels = nullptr; int width = 0, height = 0, channels = 0; };
+        std::vector<Decoded> decoded(asset.images.size());
+        if (!options.textureLoader)
+        {
+            std::vector<uint32_t> pending;
+            for (uint32_t image = 0; image < asset.images.size(); image++)
+            {
+                if (!usage[image] || asset.images[image].bufferView < 0)
+                    continue;
+                bool cached = true;
+                for (uint32_t variant = 0; variant < 2; variant++)
+                    if (usage[image] & (1u << variant))
+                        cached = cached && GlobalTextureCache().Contains(imageName(image), paramsFor(variant));
+                if (!cached)
+                    pending.push_back(image);
             }
 
-            std::string foo("material." + name + number);
-            shader.Set(foo.c_str(), (int)i);
-            glBindTexture(GL_TEXTURE_2D, textures[i].id);
+            SharedThreadPool().ParallelFor(static_cast<uint32_t>(pending.size()), [&](uint32_t i) {
+                const GltfImage& image = asset.images[pending[i]];
+                const GltfBufferView& view = asset.bufferViews[image.bufferView];
+                Decoded& result = decoded[pending[i]];
+                result.pixels = stbi_load_from_memory(asset.ViewData(image.bufferView), static_cast<int>(view.byteLength), &result.width, &result.height, &result.channels, 0);
+            });
         }
 
-        glActiveTexture(GL_TEXTURE0);
-
-        // Drawing Mesh
-        glBindVertexArray(vao);
-        glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
-    }
-
-    std::vector<Vertex> vertices;
-    std::vector<uint32_t> indices;
-    std::vector<Texture> textures;
-private:
-    uint32_t vao, vbo, ibo;
-    void SetupMesh(){
-        glGenVertexArrays(1, &vao);
-        glGenBuffers(1, &vbo);
-        glGenBuffers(1, &ibo);
+        std::vector<std::vector<Texture>> textures(asset.images.size());
+        for (uint32_t image = 0; image < asset.images.size(); image++)
+        {
+            if (!usage[image])
+                continue;
 
-        glBindVertexArray(vao);
-        glBindBuffer(GL_ARRAY_BUFFER, vbo);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+            const GltfImage& source = asset.images[image];
+            textures[image].resize(2);
+            for (uint32_t variant = 0; variant < 2; variant++)
+            {
+                if (!(usage[image] & (1u << variant)))
+                    continue;
 
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), &indices[0], GL_STATIC_DRAW);
+                TextureLoadParams params = paramsFor(variant);
+                Texture& texture = textures[image][variant];
+                if (source.bufferView < 0)
+                {
+                    texture.handle = GlobalTextureCache().Acquire(directory + "/" + source.uri, params, options.textureLoader);
+                    texture.path = source.uri;
+                }
+                else if (options.textureLoader)
+                {
+                    const GltfBufferView& view = asset.bufferViews[source.bufferView];
+                    texture.handle = GlobalTextureCache().AcquireEncoded(imageName(image), asset.ViewData(source.bufferView), view.byteLength, keepAlive, params, options.textureLoader);
+                    texture.path = imageName(image);
+                }
+                else
+                {
+                    // the pixels go to the first variant that needs them, a second variant decodes its own copy only in the rare image-used-twice case
+                    Decoded& pixels = decoded[image];
+                    if (!pixels.pixels && !GlobalTextureCache().Contains(imageName(image), params))
+                    {
+                        const GltfBufferView& view = asset.bufferViews[source.bufferView];
+                        pixels.pixels = stbi_load_from_memory(asset.ViewData(source.bufferView), static_cast<int>(view.byteLength), &pixels.width, &pixels.height, &pixels.channels, 0);
+                    }
+                    texture.handle = GlobalTextureCache().AcquireDecoded(imageName(image), pixels.pixels, pixels.width, pixels.height, pixels.channels, params);
+                    pixels.pixels = nullptr;
+                    texture.path = imageName(image);
+                }
 
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)0);
+                texture.id = texture.handle ? texture.handle->texture.Get() : 0;
+                texture.type = variant == 0 ? "texture_diffuse" : "texture_normal";
+            }
+        }
+        return textures;
+    }
 
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)offsetof(Vertex, normal));
+    // creates every mesh straight from the mapped cache file, only the texture images still have to be decoded
+    bool loadFromMeshCache(const std::string& cachePath, uint64_t key)
+    {
+        MeshCacheReader cache;
+        if (!cache.Open(cachePath, key))
+            return false;
 
-        // vertex texture coords
-        glEnableVertexAttribArray(2);
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
+        meshes.reserve(cache.MeshCount());
+        for (uint32_t i = 0; i < cache.MeshCount(); i++)
+            meshes.push_back(meshFromCache(cache, i));
+        cache.ReadNodes(nodes, meshNodes); // NEW ---- same node tree as the import that wrote the cache
 
-        glBindVertexArray(0);
+        // NEW ---- meshlets are not part of the cache, they are rebuilt from the mapped data (on the pool when there is one)
+        if (options.buildMeshlets)
+        {
+            auto build = [&](uint32_t i){
+                const MeshCacheMesh& entry = cache.GetMesh(i);
+                uint32_t fullDetailCount = meshes[i].lods.front().indexCount;
+                BuildMeshlets(cache.GetVertices(entry), entry.vertexCount, cache.GetIndices(entry), fullDetailCount, meshes[i].meshlets);
+            };
+            if (options.extractionPool)
+                options.extractionPool->ParallelFor(cache.MeshCount(), build);
+            else
+                for (uint32_t i = 0; i < cache.MeshCount(); i++)
+                    build(i);
+        }
+        return true;
     }
-};
-class Model
-{
-public:
-    // model data 
-    std::vector<Texture> textures_loaded;	// stores all the textures loaded so far, optimization to make sure textures aren't loaded more than once.
-    std::vector<Mesh>    meshes;
-    std::string directory;
-    bool gammaCorrection;
 
-    // constructor, expects a filepath to a 3D model.
-    Model(const std::string& path, bool gamma = false) : gammaCorrection(gamma)
+    // uploads mesh i of an opened cache, with its textures and LOD table
+    Mesh meshFromCache(const MeshCacheReader& cache, uint32_t i)
     {
-        loadModel(path);
+        const MeshCacheMesh& entry = cache.GetMesh(i);
+        std::vector<Texture> textures;
+        for (uint32_t j = 0; j < entry.textureCount; j++)
+        {
+            const MeshCacheTexture& texture = cache.GetTexture(entry.firstTexture + j);
+            textures.push_back(loadTexture(cache.GetString(texture.pathOffset, texture.pathLength), cache.GetString(texture.typeOffset, texture.typeLength)));
+        }
+        std::vector<MeshLod> lods;
+        for (uint32_t j = 0; j < entry.lodCount; j++)
+            lods.push_back(cache.GetLod(entry.firstLod + j));
+        return Mesh(cache.GetVertices(entry), entry.vertexCount, cache.GetIndices(entry), entry.indexCount, std::move(textures), meshUploadOptions(), std::move(lods));
     }
 
-    // draws the model, and thus all its meshes
-    void Draw(Shader& shader)
+    // uploads one finished MeshData together with its material's textures
+    Mesh meshFromData(MeshData&& data, const aiMesh* mesh, const aiScene* scene)
     {
-        for (unsigned int i = 0; i < meshes.size(); i++)
-            meshes[i].Draw(shader);
+        Mesh result(std::move(data.vertices), std::move(data.indices), loadMeshTextures(mesh, scene), meshUploadOptions(), std::move(data.lods));
+        result.meshlets = std::move(data.meshlets);
+        return result;
     }
 
-private:
-    // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
-    void loadModel(std::string const& path)
+    // NEW ---- kicks off the background part of a streaming load, see ModelStreaming.h
+    void startStreaming(const std::string& path, ModelStreamCallbacks callbacks)
     {
-        // read file via ASSIMP
-        Assimp::Importer importer;
-        const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
-        // check for errors
-        if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if is Not Zero
+        directory = path.substr(0, path.find_last_of('/'));
+
+        // glTF loads are a handful of buffer uploads, they finish right here (textures still stream through options.textureLoader).
+        // Instancing and merging have to see every mesh before uploading the first one, so they load here as well.
+        // Baked meshes (BakedAssets.h) are only a mapped file away, nothing is left to stream.
+        bool baked = !BakedAssets().Find(path, BAKED_MESH_EXTENSION).empty();
+        if ((options.nativeGltf && GltfAsset::IsGltfPath(path)) || options.instanceMeshes || options.mergeStaticMeshes || baked)
         {
-            std::cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << std::endl;
+            auto start = std::chrono::steady_clock::now();
+            loadModel(path);
+            double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            if (callbacks.onProgress)
+                callbacks.onProgress(ModelStreamProgress{static_cast<uint32_t>(meshes.size()), static_cast<uint32_t>(meshes.size()), elapsed});
+            if (callbacks.onFirstFrame)
+                callbacks.onFirstFrame(elapsed);
+            if (callbacks.onFullyLoaded)
+                callbacks.onFullyLoaded(elapsed);
             return;
         }
-        // retrieve the directory path of the filepath
-        directory = path.substr(0, path.find_last_of('/'));
 
-        // process ASSIMP's root node recursively
-        processNode(scene->mRootNode, scene);
+        stream = std::make_shared<ModelStreamState>();
+        stream->path = path;
+        stream->callbacks = std::move(callbacks);
+        stream->start = std::chrono::steady_clock::now();
+
+        ThreadPool* pool = options.extractionPool ? options.extractionPool : &SharedThreadPool();
+        std::shared_ptr<ModelStreamState> state = stream;
+        ModelLoadOptions jobOptions = options;
+        uint32_t flags = processFlags();
+
+        pool->Submit([state, jobOptions, flags, pool](){
+            auto markReady = [state](uint32_t i){
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->ready[i] = 1;
+            };
+
+            if (jobOptions.useMeshCache)
+            {
+                state->cacheKey = ComputeMeshCacheKey(state->path, importFlags(jobOptions), flags);
+                if (state->cacheKey != 0 && state->cache.Open(MeshCachePath(state->path, state->cacheKey), state->cacheKey))
+                {
+                    uint32_t count = state->cache.MeshCount();
+                    state->meshData.resize(count);
+                    {
+                        std::lock_guard<std::mutex> lock(state->mutex);
+                        state->fromCache = true;
+                        state->totalMeshes = count;
+                        state->ready.assign(count, jobOptions.buildMeshlets ? 0 : 1);
+                        state->parsed = true;
+                    }
+
+                    // meshlets are not cached, everything else is ready to upload straight from the mapped file
+                    if (jobOptions.buildMeshlets)
+                        for (uint32_t i = 0; i < count; i++)
+                            pool->Submit([state, i, markReady](){
+                                const MeshCacheMesh& entry = state->cache.GetMesh(i);
+                                uint32_t fullDetailCount = entry.lodCount ? state->cache.GetLod(entry.firstLod).indexCount : entry.indexCount;
+                                BuildMeshlets(state->cache.GetVertices(entry), entry.vertexCount, state->cache.GetIndices(entry), fullDetailCount, state->meshData[i].meshlets);
+                                markReady(i);
+                            });
+                    return;
+                }
+            }
+
+            // NEW ---- the OBJ parser splits its own work across the pool, which is fine from inside this job
+            if (usesNativeObj(state->path, jobOptions))
+            {
+                std::string error;
+                bool loaded = state->obj.Load(state->path, pool, error);
+                uint32_t count = static_cast<uint32_t>(state->obj.meshes.size());
+                state->meshData.resize(count);
+                state->reports.resize(count);
+                state->dependencies = objLibraryPaths(state->path, state->obj);
+                {
+                    std::lock_guard<std::mutex> lock(state->mutex);
+                    state->fromObj = true;
+                    state->failed = !loaded;
+                    state->error = error;
+                    state->totalMeshes = count;
+                    state->ready.assign(count, 0);
+                    state->parsed = loaded;
+                }
+
+                for (uint32_t i = 0; i < count; i++)
+                    pool->Submit([state, i, jobOptions, markReady](){
+                        buildObjMeshData(state->obj.meshes[i], state->meshData[i], state->reports[i], jobOptions);
+                        markReady(i);
+                    });
+                return;
+            }
+
+            RecordingIOSystem* files = new RecordingIOSystem(); // owned by the importer
+            state->importer.SetIOHandler(files);
+            const aiScene* scene = state->importer.ReadFile(state->path, importFlags(jobOptions));
+            if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->error = state->importer.GetErrorString();
+                state->failed = true;
+                return;
+            }
+
+            state->scene = scene;
+            state->dependencies = files->Dependencies(state->path);
+            collectMeshes(scene->mRootNode, scene, state->sceneMeshes);
+            uint32_t count = static_cast<uint32_t>(state->sceneMeshes.size());
+            state->meshData.resize(count);
+            state->reports.resize(count);
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->totalMeshes = count;
+                state->ready.assign(count, 0);
+                state->parsed = true;
+            }
+
+            //! @note One job per mesh, so the first meshes can be uploaded while later ones are still being built
+            for (uint32_t i = 0; i < count; i++)
+                pool->Submit([state, i, jobOptions, markReady](){
+                    buildMeshData(state->sceneMeshes[i], state->meshData[i], state->reports[i], jobOptions);
+                    markReady(i);
+                });
+        });
+    }
+
+    // dependencies are the files besides the model the meshes were built from, a change to any of them invalidates the cache
+    void writeMeshCache(const std::string& cachePath, uint64_t key, const std::vector<std::string>& dependencies)
+    {
+        MeshCacheWriter writer;
+        for (const std::string& dependency : dependencies)
+            writer.AddDependency(dependency);
+        bool hasNodes = meshNodes.size() == meshes.size() && nodes.Size() > 0;
+        if (hasNodes)
+            writer.SetNodes(nodes); // NEW ---- warm loads get the node tree back, see MeshCacheReader::ReadNodes
+        for (size_t i = 0; i < meshes.size(); i++)
+            writer.AddMesh(meshes[i].vertices, meshes[i].indices, meshes[i].lods, meshes[i].textures, hasNodes ? meshNodes[i] : 0);
+
+        if (!writer.Write(cachePath, key))
+            printf("Could not write mesh cache ====> %s\n", cachePath.c_str());
     }
 
     // processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
@@ -505,64 +2012,216 @@ private:
 
     }
 
-    Mesh processMesh(aiMesh* mesh, const aiScene* scene)
+    // NEW ---- copies the node tree into hierarchy (parents first, as SceneHierarchy wants) and the node of every mesh into meshNodes,
+    // meshes in the order processNode and collectMeshes visit them. Static so the baker can store the tree in baked mesh caches too.
+    static void buildNodeHierarchy(const aiNode* node, int32_t parent, SceneHierarchy& hierarchy, std::vector<uint32_t>& meshNodes)
     {
-        // data to fill
-        std::vector<Vertex> vertices;
-        std::vector<unsigned int> indices;
-        std::vector<Texture> textures;
+        aiVector3D scaling, position;
+        aiQuaternion rotation;
+        node->mTransformation.Decompose(scaling, rotation, position);
+        uint32_t index = hierarchy.AddNode(parent, glm::vec3(position.x, position.y, position.z), glm::quat(rotation.w, rotation.x, rotation.y, rotation.z),
+                                           glm::vec3(scaling.x, scaling.y, scaling.z));
+        for (unsigned int i = 0; i < node->mNumMeshes; i++)
+            meshNodes.push_back(index);
+        for (unsigned int i = 0; i < node->mNumChildren; i++)
+            buildNodeHierarchy(node->mChildren[i], static_cast<int32_t>(index), hierarchy, meshNodes);
+    }
 
-        // walk through each of the mesh's vertices
-        for (unsigned int i = 0; i < mesh->mNumVertices; i++)
+    // NEW ---- every place the node tree draws a mesh, with the accumulated node transform
+    struct MeshOccurrence
+    {
+        const aiMesh* mesh;
+        glm::mat4 transform;
+    };
+
+    static glm::mat4 toGlm(const aiMatrix4x4& m)
+    {
+        // assimp matrices are row major, glm's are column major
+        return glm::mat4(glm::vec4(m.a1, m.b1, m.c1, m.d1), glm::vec4(m.a2, m.b2, m.c2, m.d2),
+                         glm::vec4(m.a3, m.b3, m.c3, m.d3), glm::vec4(m.a4, m.b4, m.c4, m.d4));
+    }
+
+    static void collectMeshOccurrences(const aiNode* node, const aiScene* scene, const glm::mat4& parent, std::vector<MeshOccurrence>& out)
+    {
+        glm::mat4 transform = parent * toGlm(node->mTransformation);
+        for (unsigned int i = 0; i < node->mNumMeshes; i++)
+            out.push_back({scene->mMeshes[node->mMeshes[i]], transform});
+        for (unsigned int i = 0; i < node->mNumChildren; i++)
+            collectMeshOccurrences(node->mChildren[i], scene, transform, out);
+    }
+
+    // NEW ---- builds every distinct aiMesh once (on the extraction pool when there is one), then hands them to addStaticMeshes
+    // with the transforms of all of their occurrences
+    void processNodesStatic(const aiScene* scene)
+    {
+        std::vector<MeshOccurrence> occurrences;
+        collectMeshOccurrences(scene->mRootNode, scene, glm::mat4(1.0f), occurrences);
+
+        std::vector<const aiMesh*> sceneMeshes;
+        std::unordered_map<const aiMesh*, uint32_t> meshIndices;
+        std::vector<uint32_t> occurrenceMesh(occurrences.size());
+        for (size_t i = 0; i < occurrences.size(); i++)
         {
-            Vertex vertex;
-            glm::vec3 vector; // we declare a placeholder vector since assimp uses its own vector class that doesn't directly convert to glm's vec3 class so we transfer the data to this placeholder glm::vec3 first.
-            // positions
-            vector.x = mesh->mVertices[i].x;
-            vector.y = mesh->mVertices[i].y;
-            vector.z = mesh->mVertices[i].z;
-            vertex.position = vector;
-            // normals
-            if (mesh->HasNormals())
+            auto inserted = meshIndices.emplace(occurrences[i].mesh, static_cast<uint32_t>(sceneMeshes.size()));
+            if (inserted.second)
+                sceneMeshes.push_back(occurrences[i].mesh);
+            occurrenceMesh[i] = inserted.first->second;
+        }
+
+        std::vector<MeshData> meshData(sceneMeshes.size());
+        std::vector<MeshOptimizationReport> reports(sceneMeshes.size());
+        auto build = [&](uint32_t i){ buildMeshData(sceneMeshes[i], meshData[i], reports[i], options); };
+        if (options.extractionPool)
+            options.extractionPool->ParallelFor(static_cast<uint32_t>(sceneMeshes.size()), build);
+        else
+            for (uint32_t i = 0; i < sceneMeshes.size(); i++)
+                build(i);
+        if (options.optimizeMeshes)
+            optimizationReports.insert(optimizationReports.end(), reports.begin(), reports.end());
+
+        std::vector<uint32_t> materials(sceneMeshes.size());
+        std::vector<std::vector<glm::mat4>> transforms(sceneMeshes.size());
+        std::vector<std::vector<uint32_t>> occurrenceIds(sceneMeshes.size());
+        for (size_t i = 0; i < sceneMeshes.size(); i++)
+            materials[i] = sceneMeshes[i]->mMaterialIndex;
+        for (size_t i = 0; i < occurrences.size(); i++)
+        {
+            transforms[occurrenceMesh[i]].push_back(occurrences[i].transform);
+            occurrenceIds[occurrenceMesh[i]].push_back(static_cast<uint32_t>(i));
+        }
+
+        addStaticMeshes(meshData, materials, transforms, occurrenceIds, [&](MeshData&& data, size_t i){
+            return meshFromData(std::move(data), sceneMeshes[i], scene);
+        });
+    }
+
+    // NEW ---- merges (MeshMerging.h) and/or instances (MeshInstancing.h) meshes as the options ask. transforms[i] and occurrenceIds[i] list every
+    // place mesh i is drawn, the ids being the index that occurrence would have had in meshes without either option (what merge sources refer to).
+    // makeMesh(data, i) creates a Mesh with mesh i's material.
+    template<typename MakeMesh>
+    void addStaticMeshes(std::vector<MeshData>& meshData, const std::vector<uint32_t>& materials, const std::vector<std::vector<glm::mat4>>& transforms,
+                         const std::vector<std::vector<uint32_t>>& occurrenceIds, MakeMesh&& makeMesh)
+    {
+        std::vector<uint32_t> leaders;
+        if (options.instanceMeshes)
+            leaders = FindIdenticalMeshes(meshData, materials);
+
+        std::vector<std::vector<glm::mat4>> instanced = transforms;
+        if (options.mergeStaticMeshes)
+        {
+            // meshes drawn more than once are cheaper instanced, only the rest are merged
+            std::vector<size_t> groupOccurrences(meshData.size(), 0);
+            if (options.instanceMeshes)
+                for (size_t i = 0; i < meshData.size(); i++)
+                    groupOccurrences[leaders[i]] += transforms[i].size();
+
+            std::vector<MeshMergeInput> inputs;
+            std::vector<uint32_t> inputMesh;
+            for (size_t i = 0; i < meshData.size(); i++)
             {
-                vector.x = mesh->mNormals[i].x;
-                vector.y = mesh->mNormals[i].y;
-                vector.z = mesh->mNormals[i].z;
-                vertex.normal = vector;
+                if (options.instanceMeshes && groupOccurrences[leaders[i]] > 1)
+                    continue;
+                for (size_t k = 0; k < transforms[i].size(); k++)
+                {
+                    inputs.push_back({&meshData[i], transforms[i][k], materials[i], occurrenceIds[i][k]});
+                    inputMesh.push_back(static_cast<uint32_t>(i));
+                }
+                instanced[i].clear();
             }
-            // texture coordinates
-            if (mesh->mTextureCoords[0]) // does the mesh contain texture coordinates?
+
+            std::vector<MergedMesh> merged = MergeMeshesByMaterial(inputs);
+            mergeReport.inputMeshes += inputs.size();
+            mergeReport.outputMeshes += merged.size();
+            for (MergedMesh& mesh : merged)
             {
-                glm::vec2 vec;
-                // a vertex can contain up to 8 different texture coordinates. We thus make the assumption that we won't 
-                // use models where a vertex can have multiple texture coordinates so we always take the first set (0).
-                vec.x = mesh->mTextureCoords[0][i].x;
-                vec.y = mesh->mTextureCoords[0][i].y;
-                vertex.TexCoords = vec;
-                // tangent
-                vector.x = mesh->mTangents[i].x;
-                vector.y = mesh->mTangents[i].y;
-                vector.z = mesh->mTangents[i].z;
-                vertex.Tangent = vector;
-                // bitangent
-                vector.x = mesh->mBitangents[i].x;
-                vector.y = mesh->mBitangents[i].y;
-                vector.z = mesh->mBitangents[i].z;
-                vertex.BitTangent = vector;
+                mergeReport.vertices += mesh.data.vertices.size();
+                if (options.buildMeshlets)
+                {
+                    size_t fullDetailCount = mesh.data.lods.empty() ? mesh.data.indices.size() : mesh.data.lods.front().indexCount;
+                    BuildMeshlets(mesh.data.vertices.data(), mesh.data.vertices.size(), mesh.data.indices.data(), fullDetailCount, mesh.data.meshlets);
+                }
+                meshes.push_back(makeMesh(std::move(mesh.data), inputMesh[mesh.firstInput]));
+                meshes.back().mergeSources = std::move(mesh.sources);
+                // the model is drawn with modelInstanced.vert, merged vertices are already transformed so they get a single identity instance
+                if (options.instanceMeshes)
+                    meshes.back().SetInstances({glm::mat4(1.0f)});
             }
-            else
-                vertex.TexCoords = glm::vec2(0.0f, 0.0f);
+        }
 
-            vertices.push_back(vertex);
+        if (options.instanceMeshes)
+            addInstancedMeshes(meshData, leaders, instanced, makeMesh);
+    }
+
+    // NEW ---- uploads each group of identical meshes (leaders from FindIdenticalMeshes) once with every transform of the group and fills instancingReport.
+    // Meshes without transforms (ex. merged ones) are left out.
+    template<typename MakeMesh>
+    void addInstancedMeshes(std::vector<MeshData>& meshData, const std::vector<uint32_t>& leaders, const std::vector<std::vector<glm::mat4>>& transforms, MakeMesh&& makeMesh)
+    {
+        std::vector<std::vector<glm::mat4>> groupTransforms(meshData.size());
+        for (size_t i = 0; i < meshData.size(); i++)
+        {
+            std::vector<glm::mat4>& group = groupTransforms[leaders[i]];
+            group.insert(group.end(), transforms[i].begin(), transforms[i].end());
         }
-        // now wak through each of the mesh's faces (a face is a mesh its triangle) and retrieve the corresponding vertex indices.
-        for (unsigned int i = 0; i < mesh->mNumFaces; i++)
+
+        InstancingReport& report = instancingReport;
+        for (size_t i = 0; i < meshData.size(); i++)
         {
-            aiFace face = mesh->mFaces[i];
-            // retrieve all indices of the face and store them in the indices vector
-            for (unsigned int j = 0; j < face.mNumIndices; j++)
-                indices.push_back(face.mIndices[j]);
+            if (transforms[i].empty())
+                continue;
+            size_t bytes = meshData[i].vertices.size() * sizeof(Vertex) + meshData[i].indices.size() * sizeof(uint32_t);
+            report.occurrences += transforms[i].size();
+            // every occurrence but the group's very first one would have been a copy of its own
+            report.savedVertexBytes += bytes * (transforms[i].size() - (leaders[i] == i ? 1 : 0));
+        }
+
+        for (size_t i = 0; i < meshData.size(); i++)
+        {
+            if (leaders[i] != i || groupTransforms[i].empty())
+                continue;
+            meshes.push_back(makeMesh(std::move(meshData[i]), i));
+            meshes.back().SetInstances(groupTransforms[i]);
+            report.uniqueMeshes++;
+            report.instanceBytes += groupTransforms[i].size() * sizeof(glm::mat4);
         }
+    }
+
+    // NEW ---- same result as processNode, but the vertex/index arrays of every mesh are built at once on the pool.
+    // Textures and GL buffers are then created here on the context thread, in the original mesh order.
+    void processNodesParallel(const aiScene* scene, ThreadPool& pool)
+    {
+        std::vector<const aiMesh*> sceneMeshes;
+        collectMeshes(scene->mRootNode, scene, sceneMeshes);
+
+        std::vector<MeshData> meshData(sceneMeshes.size());
+        std::vector<MeshOptimizationReport> reports(sceneMeshes.size());
+        pool.ParallelFor(static_cast<uint32_t>(sceneMeshes.size()), [&](uint32_t i){
+            buildMeshData(sceneMeshes[i], meshData[i], reports[i], options);
+        });
+        if (options.optimizeMeshes)
+            optimizationReports.insert(optimizationReports.end(), reports.begin(), reports.end());
+
+        meshes.reserve(meshes.size() + sceneMeshes.size());
+        for (size_t i = 0; i < sceneMeshes.size(); i++)
+            meshes.push_back(meshFromData(std::move(meshData[i]), sceneMeshes[i], scene));
+    }
+
+    Mesh processMesh(aiMesh* mesh, const aiScene* scene)
+    {
+        // data to fill
+        MeshData data;
+        MeshOptimizationReport report;
+        buildMeshData(mesh, data, report, options);
+        if (options.optimizeMeshes)
+            optimizationReports.push_back(report);
+
+        // return a mesh object created from the extracted mesh data
+        return meshFromData(std::move(data), mesh, scene);
+    }
+
+    std::vector<Texture> loadMeshTextures(const aiMesh* mesh, const aiScene* scene)
+    {
+        std::vector<Texture> textures;
         // process materials
         aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
         // we assume a convention for sampler names in the shaders. Each diffuse texture should be named
@@ -584,9 +2243,7 @@ private:
         // 4. height maps
         std::vector<Texture> heightMaps = loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height");
         textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
-
-        // return a mesh object created from the extracted mesh data
-        return Mesh(vertices, indices, textures);
+        return textures;
     }
 
     // checks all material textures of a given type and loads the textures if they're not loaded yet.
@@ -598,29 +2255,25 @@ private:
         {
             aiString str;
             mat->GetTexture(type, i, &str);
-            // check if texture was loaded before and if so, continue to next iteration: skip loading a new texture
-            bool skip = false;
-            for (unsigned int j = 0; j < textures_loaded.size(); j++)
-            {
-                if (std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0)
-                {
-                    textures.push_back(textures_loaded[j]);
-                    skip = true; // a texture with the same filepath has already been loaded, continue to next one. (optimization)
-                    break;
-                }
-            }
-            if (!skip)
-            {   // if texture hasn't been loaded already, load it
-                Texture texture;
-                texture.id = LoadTextureFromFileAsset(str.C_Str(), this->directory);
-                texture.type = typeName;
-                texture.path = str.C_Str();
-                textures.push_back(texture);
-                textures_loaded.push_back(texture);  // store it as texture loaded for entire model, to ensure we won't unnecessary load duplicate textures.
-            }
+            textures.push_back(loadTexture(str.C_Str(), typeName));
         }
         return textures;
     }
+
+    // loads a single texture relative to the model directory.
+    // NEW ---- textures are de-duplicated by the global texture cache (one hash lookup, shared with every other Model)
+    Texture loadTexture(const std::string& path, const std::string& typeName)
+    {
+        TextureLoadParams params;
+        params.gamma = gammaCorrection && typeName == "texture_diffuse"; // only color maps are stored in sRGB
+
+        Texture texture;
+        texture.handle = GlobalTextureCache().Acquire(this->directory + "/" + path, params, options.textureLoader);
+        texture.id = texture.handle ? texture.handle->texture.Get() : 0;
+        texture.type = typeName;
+        texture.path = path;
+        return texture;
+    }
 };
 
 static float deltaTime = 0.0f;	// time between current frame and last frame
@@ -812,42 +2465,21 @@ void ModelLoadingExample(GLFWwindow* window){
     glBindVertexArray(0);
 
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-    std::string parentPath = "basics/figures/skybox-daylight/";
-    std::string singleFile = "whiteClouds.jpg";
-    std::string faces[] = {
-        parentPath + "right.bmp",
-        parentPath + "left.bmp",
-        parentPath + "top.bmp",
-        parentPath + "bottom.bmp",
-        parentPath + "front.bmp",
-        parentPath + "back.bmp"
-    };
-
-    uint32_t cubemapTextureID;
-    glGenTextures(1, &cubemapTextureID);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTextureID);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-    glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
-
-    for(uint32_t i = 0; i < 6; i++){
-        int w, h, channels;
-        unsigned char* data = stbi_load(faces[i].c_str(), &w, &h, &channels, 0);
-
-        if(data){
-            stbi_set_flip_vertically_on_load(false);
-            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, w, h, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-
-            stbi_image_free(data);
-        }
-        else{
-            printf("Tried to load texture filepath at ===> %s\n", faces[i].c_str());
-            printf("Could not load textures!\n");
-        }
+    //! @note NEW ---- textures, shaders, models and the cubemap come from the asset baker's output when there is one (see AssetBaker.h)
+    BakedAssets().SetRoots("basics", "baked");
+    //! @note NEW ---- and out of the packs the baker writes with --pack when those exist, two mappings instead of an open per file (AssetPack.h)
+    Assets().Mount("basics.pack", "basics");
+    Assets().Mount("baked.pack", "baked");
+
+    //! @note NEW ---- the six faces are decoded in parallel and uploaded through one staging buffer, or come prefiltered from the baked
+    //! @note basics/figures/skybox-daylight.cubemap.dds (see CubemapLoader.h)
+    CubemapLoadStats skyboxStats;
+    GLTexture cubemapTexture = LoadCubemap(CubemapFacePaths("basics/figures/skybox-daylight", ".bmp"), CubemapLoadOptions(), &skyboxStats);
+    if(!cubemapTexture){
+        printf("Could not load textures!\n");
     }
+    PrintCubemapLoadStats("Skybox", skyboxStats);
+    uint32_t cubemapTextureID = cubemapTexture.Get();
 
     Shader skyboxShader("basics/shaders/skybox/skybox.vert", "basics/shaders/skybox/skybox.frag");
     glm::vec3 lightVector = {-2.0f, -1.0f, -0.3f};
@@ -856,12 +2488,34 @@ void ModelLoadingExample(GLFWwindow* window){
 
     //! @note NEW ---- LOADING MODELS
     Shader modelShader("basics/shaders/modelLoading-01/model.vert", "basics/shaders/modelLoading-01/model.frag");
-    Model model1("basics/models/backpack.obj");
+    AsyncTextureLoader textureLoader(SharedThreadPool());
+    GeometryArena geometryArena;
+    ModelLoadOptions loadOptions;
+    loadOptions.useMeshCache = true; // NEW ---- after the first run, the meshes are read back from the binary mesh cache instead of assimp
+    loadOptions.extractionPool = &SharedThreadPool(); // NEW ---- cold loads build the mesh arrays on every core
+    loadOptions.textureLoader = &textureLoader; // NEW ---- textures decode in the background while we already render
+    loadOptions.geometryArena = &geometryArena; // NEW ---- all meshes share one VAO and draw with base vertex offsets
+    loadOptions.computeTangentFrames = true; // NEW ---- normals/tangents from MeshTangents.h instead of assimp's single threaded post-processing
+    loadOptions.nativeObj = true; // NEW ---- backpack.obj is parsed by ObjLoader.h on every core instead of assimp's OBJ importer
+    loadOptions.weldVertices = true; // NEW ---- duplicated corners merged after extraction, so each mesh keeps about a third of its vertices
+    loadOptions.optimizeMeshes = true; // NEW ---- triangles and vertices reordered for the GPU vertex cache, stored that way in the mesh cache
+    loadOptions.lodLevels = 3; // NEW ---- 50%/25%/12.5% simplified index lists sharing each mesh's vertices
+    // NEW ---- the model streams in while the loop below is already rendering
+    ModelStreamCallbacks streamCallbacks;
+    streamCallbacks.onFirstFrame = [](double milliseconds){
+        printf("Model: first mesh on screen after %.2f ms\n", milliseconds);
+    };
+    streamCallbacks.onFullyLoaded = [](double milliseconds){
+        printf("Model: fully loaded after %.2f ms\n", milliseconds);
+        GlobalTextureCache().PrintStats();
+    };
+    Model model1("basics/models/backpack.obj", loadOptions, streamCallbacks);
     printf("Loading Model!\n");
 
     while(!glfwWindowShouldClose(window)){
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        FrameRenderStats().Reset();
 
         float time = static_cast<float>(glfwGetTime());
         deltaTime = time - lastFrame;
@@ -870,6 +2524,10 @@ void ModelLoadingExample(GLFWwindow* window){
 
         if(glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) break;
 
+        //! @note NEW ---- Uploading whatever textures finished decoding since last frame
+        textureLoader.Update();
+        model1.updateStreaming(); // NEW ---- and whatever meshes finished building
+
         float x = std::sin(time) * 2.0f;
         float z = std::cos(time) * 2.0f;
         float y = 0.0f;
@@ -963,7 +2621,13 @@ void ModelLoadingExample(GLFWwindow* window){
         model = glm::translate(model, glm::vec3(0.0f, 0.0f, 0.0f)); // translate it down so it's at the center of the scene
         model = glm::scale(model, glm::vec3(1.0f, 1.0f, 1.0f));	// it's a bit too big for our scene, so scale it down
         modelShader.Set("model", model);
-        model1.Draw(modelShader);
+
+        // NEW ---- farther away the model switches to its simplified levels
+        LodView lodView;
+        lodView.model = model;
+        lodView.cameraPosition = camera.cameraPos;
+        lodView.projectionScale = LodProjectionScale(glm::radians(camera.zoom), 600.0f);
+        model1.Draw(modelShader, lodView);
 
         // lightShader.Set("projection", projection);
         // lightShader.Set("view", view);
@@ -1057,6 +2721,8 @@ void ModelLoadingExample(GLFWwindow* window){
 
 
         glfwSwapBuffers(window);
+        GlobalDeletionQueue().EndFrame(); // NEW ---- GL objects released this frame get deleted once the GPU is past it
+        GlobalTextureResidency().EndFrame(); // NEW ---- streams texture levels in and out for what was drawn, nothing until Enable()
         glfwPollEvents();
     }
 }